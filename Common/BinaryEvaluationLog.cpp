@@ -0,0 +1,258 @@
+#include "StdAfx.h"
+#include "BinaryEvaluationLog.h"
+#include "BufferedLogWriter.h"
+#include "../Evaluation/Spectrometer.h"
+#include <algorithm>
+
+using namespace FileHandler;
+
+extern CCriticalSection g_evalLogCritSect; // <-- synchronization access to evaluation-log files
+extern CBufferedLogWriter g_logFiles; // <-- the open log files
+
+static_assert(sizeof(CBinaryEvaluationLogScanHeader) % sizeof(double) == 0, "The columns following the scan header must be aligned");
+
+const char CBinaryEvaluationLog::FILE_IDENTIFIER[8] = { 'N', 'O', 'V', 'E', 'V', 'L', '0', '1' };
+
+/** @return the time of day, in seconds since midnight */
+static int SecondsSinceMidnight(const CDateTime &time)
+{
+    return time.hour * 3600 + time.minute * 60 + time.second;
+}
+
+CString CBinaryEvaluationLog::FileNameFor(const CString &evaluationLogFileName)
+{
+    CString fileName(evaluationLogFileName);
+    if (fileName.Right(4).CompareNoCase(".txt") == 0)
+    {
+        fileName = fileName.Left(fileName.GetLength() - 4);
+    }
+    fileName.Append(".bin");
+    return fileName;
+}
+
+RETURN_CODE CBinaryEvaluationLog::AppendScan(const CString &fileName, const Evaluation::CScanResult &result, const Evaluation::CSpectrometer &spectrometer, const CWindField &windField)
+{
+    const size_t spectrumNum = result.GetEvaluatedNum();
+    const size_t specieNum = (spectrumNum > 0) ? (size_t)std::min(result.GetSpecieNum(0), MAX_N_REFERENCES) : 0;
+    const size_t columnNum = BINLOG_FIXED_COLUMN_NUM + specieNum * BINLOG_SPECIE_COLUMN_NUM;
+
+    // 1. The scan header
+    CBinaryEvaluationLogScanHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.marker, "SCAN", 4);
+    header.blockSize = (uint32_t)(sizeof(header) + columnNum * spectrumNum * sizeof(double));
+    header.spectrumNum = (uint32_t)spectrumNum;
+    header.specieNum = (uint32_t)specieNum;
+
+    CDateTime startTime;
+    result.GetSkyStartTime(startTime);
+    header.year = startTime.year;
+    header.month = startTime.month;
+    header.day = startTime.day;
+    header.startTime = SecondsSinceMidnight(startTime);
+
+    if (result.IsDirectSunMeasurement())
+        header.mode = MODE_DIRECT_SUN;
+    else if (result.IsLunarMeasurement())
+        header.mode = MODE_LUNAR;
+    else if (result.IsWindMeasurement())
+        header.mode = MODE_WINDSPEED;
+    else if (result.IsStratosphereMeasurement())
+        header.mode = MODE_STRATOSPHERE;
+    else if (result.IsCompositionMeasurement())
+        header.mode = MODE_COMPOSITION;
+    else
+        header.mode = MODE_FLUX;
+    header.channel = spectrometer.m_channel;
+    header.windSpeedSource = windField.GetWindSpeedSource();
+    header.windDirectionSource = windField.GetWindDirectionSource();
+    header.plumeHeightSource = windField.GetPlumeHeightSource();
+
+    header.flux = result.GetFlux();
+    header.windSpeed = windField.GetWindSpeed();
+    header.windDirection = windField.GetWindDirection();
+    header.plumeHeight = windField.GetPlumeHeight();
+    header.plumeCompleteness = result.GetCalculatedPlumeCompleteness();
+    header.plumeCentre = result.GetCalculatedPlumeCentre(0);
+    result.GetCalculatedPlumeEdges(header.plumeEdge1, header.plumeEdge2);
+    header.compass = spectrometer.m_scanner.compass;
+    header.coneAngle = spectrometer.m_scanner.coneAngle;
+    header.tilt = spectrometer.m_scanner.tilt;
+    header.latitude = spectrometer.m_scanner.gps.m_latitude;
+    header.longitude = spectrometer.m_scanner.gps.m_longitude;
+    header.altitude = spectrometer.m_scanner.gps.m_altitude;
+    header.batteryVoltage = result.GetBatteryVoltage();
+    header.temperature = result.GetTemperature();
+    header.offset = result.GetOffset();
+
+    strncpy(header.serial, (LPCSTR)spectrometer.SerialNumber(), sizeof(header.serial) - 1);
+    for (size_t specieIndex = 0; specieIndex < specieNum; ++specieIndex)
+    {
+        strncpy(header.specieName[specieIndex], result.GetSpecieName(0, (unsigned long)specieIndex).c_str(), sizeof(header.specieName[specieIndex]) - 1);
+    }
+
+    // 2. The columns
+    std::vector<double> columns(columnNum * spectrumNum);
+    for (unsigned long k = 0; k < spectrumNum; ++k)
+    {
+        const CSpectrumInfo &info = result.GetSpectrumInfo(k);
+        int flags = 0;
+        if (result.IsBad(k))
+        {
+            flags |= BINLOG_FLAG_BADFIT;
+        }
+        if (result.IsDarkSpectrum(k))
+        {
+            flags |= BINLOG_FLAG_DARK;
+        }
+
+        columns[BINLOG_STARTTIME * spectrumNum + k] = SecondsSinceMidnight(info.m_startTime);
+        columns[BINLOG_STOPTIME * spectrumNum + k] = SecondsSinceMidnight(info.m_stopTime);
+        columns[BINLOG_SCANANGLE * spectrumNum + k] = info.m_scanAngle;
+        columns[BINLOG_SCANANGLE2 * spectrumNum + k] = info.m_scanAngle2;
+        columns[BINLOG_PEAKINTENSITY * spectrumNum + k] = info.m_peakIntensity;
+        columns[BINLOG_FITINTENSITY * spectrumNum + k] = info.m_fitIntensity;
+        columns[BINLOG_EXPOSURETIME * spectrumNum + k] = info.m_exposureTime;
+        columns[BINLOG_NUMSPEC * spectrumNum + k] = info.m_numSpec;
+        columns[BINLOG_DELTA * spectrumNum + k] = result.GetDelta(k);
+        columns[BINLOG_CHISQUARE * spectrumNum + k] = result.GetChiSquare(k);
+        columns[BINLOG_FLAGS * spectrumNum + k] = flags;
+
+        for (size_t specieIndex = 0; specieIndex < specieNum; ++specieIndex)
+        {
+            const unsigned long s = (unsigned long)specieIndex;
+            columns[SpecieColumnIndex(specieIndex, BINLOG_COLUMN) * spectrumNum + k] = result.GetColumn(k, s);
+            columns[SpecieColumnIndex(specieIndex, BINLOG_COLUMNERROR) * spectrumNum + k] = result.GetColumnError(k, s);
+            columns[SpecieColumnIndex(specieIndex, BINLOG_SHIFT) * spectrumNum + k] = result.GetShift(k, s);
+            columns[SpecieColumnIndex(specieIndex, BINLOG_SHIFTERROR) * spectrumNum + k] = result.GetShiftError(k, s);
+            columns[SpecieColumnIndex(specieIndex, BINLOG_SQUEEZE) * spectrumNum + k] = result.GetSqueeze(k, s);
+            columns[SpecieColumnIndex(specieIndex, BINLOG_SQUEEZEERROR) * spectrumNum + k] = result.GetSqueezeError(k, s);
+        }
+    }
+
+    // 3. Append the block to the file, with the file-header if the file is new.
+    //      This goes through the same writer and lock as the text evaluation-log.
+    std::string block((const char *)&header, sizeof(header));
+    block.append((const char *)columns.data(), columns.size() * sizeof(double));
+
+    std::string fileHeader(FILE_HEADER_SIZE, '\0');
+    memcpy(&fileHeader[0], FILE_IDENTIFIER, sizeof(FILE_IDENTIFIER));
+
+    return g_logFiles.AppendBinary(fileName, block, fileHeader, &g_evalLogCritSect) ? SUCCESS : FAIL;
+}
+
+CBinaryEvaluationLogReader::CBinaryEvaluationLogReader()
+    : m_file(INVALID_HANDLE_VALUE), m_mapping(NULL), m_data(nullptr), m_size(0)
+{
+}
+
+CBinaryEvaluationLogReader::~CBinaryEvaluationLogReader()
+{
+    Close();
+}
+
+bool CBinaryEvaluationLogReader::Open(const CString &fileName)
+{
+    Close();
+
+    m_file = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart < (LONGLONG)CBinaryEvaluationLog::FILE_HEADER_SIZE)
+    {
+        Close();
+        return false;
+    }
+    m_size = (unsigned long long)fileSize.QuadPart;
+
+    // Only map the part of the file which exists now, scans may be appended while we read
+    m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, fileSize.HighPart, fileSize.LowPart, NULL);
+    if (m_mapping == NULL)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = (const char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, (SIZE_T)m_size);
+    if (m_data == nullptr || 0 != memcmp(m_data, CBinaryEvaluationLog::FILE_IDENTIFIER, sizeof(CBinaryEvaluationLog::FILE_IDENTIFIER)))
+    {
+        Close();
+        return false;
+    }
+
+    BuildScanIndex();
+    return true;
+}
+
+void CBinaryEvaluationLogReader::Close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mapping != NULL)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+    m_scanOffsets.clear();
+}
+
+void CBinaryEvaluationLogReader::BuildScanIndex()
+{
+    m_scanOffsets.clear();
+
+    size_t offset = CBinaryEvaluationLog::FILE_HEADER_SIZE;
+    while (offset + sizeof(CBinaryEvaluationLogScanHeader) <= m_size)
+    {
+        const CBinaryEvaluationLogScanHeader *header = (const CBinaryEvaluationLogScanHeader *)(m_data + offset);
+        if (0 != memcmp(header->marker, "SCAN", 4) || header->specieNum > MAX_N_REFERENCES)
+        {
+            break;
+        }
+
+        const size_t columnNum = BINLOG_FIXED_COLUMN_NUM + header->specieNum * BINLOG_SPECIE_COLUMN_NUM;
+        const size_t expectedSize = sizeof(CBinaryEvaluationLogScanHeader) + columnNum * header->spectrumNum * sizeof(double);
+        if (header->blockSize != expectedSize || offset + expectedSize > m_size)
+        {
+            break; // this scan was not completely written
+        }
+
+        m_scanOffsets.push_back(offset);
+        offset += expectedSize;
+    }
+}
+
+const CBinaryEvaluationLogScanHeader &CBinaryEvaluationLogReader::ScanHeader(size_t scanIndex) const
+{
+    return *(const CBinaryEvaluationLogScanHeader *)(m_data + m_scanOffsets[scanIndex]);
+}
+
+const double *CBinaryEvaluationLogReader::Column(size_t scanIndex, BINARY_EVALLOG_COLUMN column) const
+{
+    const CBinaryEvaluationLogScanHeader &header = ScanHeader(scanIndex);
+    const double *columns = (const double *)(m_data + m_scanOffsets[scanIndex] + sizeof(CBinaryEvaluationLogScanHeader));
+    return columns + (size_t)column * header.spectrumNum;
+}
+
+const double *CBinaryEvaluationLogReader::SpecieColumn(size_t scanIndex, size_t specieIndex, BINARY_EVALLOG_SPECIE_COLUMN column) const
+{
+    const CBinaryEvaluationLogScanHeader &header = ScanHeader(scanIndex);
+    if (specieIndex >= header.specieNum)
+    {
+        return nullptr;
+    }
+    const double *columns = (const double *)(m_data + m_scanOffsets[scanIndex] + sizeof(CBinaryEvaluationLogScanHeader));
+    return columns + CBinaryEvaluationLog::SpecieColumnIndex(specieIndex, column) * header.spectrumNum;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Common.h"
+#include "../Evaluation/ScanResult.h"
+#include "../Meteorology/WindField.h"
+
+namespace Evaluation
+{
+    class CSpectrometer;
+}
+
+namespace FileHandler
+{
+    /** The per-spectrum columns stored for every scan in a binary evaluation log */
+    enum BINARY_EVALLOG_COLUMN
+    {
+        BINLOG_STARTTIME = 0,   // the start time of the spectrum, in seconds since midnight (UTC)
+        BINLOG_STOPTIME,        // the stop time of the spectrum, in seconds since midnight (UTC)
+        BINLOG_SCANANGLE,
+        BINLOG_SCANANGLE2,
+        BINLOG_PEAKINTENSITY,
+        BINLOG_FITINTENSITY,
+        BINLOG_EXPOSURETIME,
+        BINLOG_NUMSPEC,
+        BINLOG_DELTA,
+        BINLOG_CHISQUARE,
+        BINLOG_FLAGS,           // a combination of BINLOG_FLAG_*
+        BINLOG_FIXED_COLUMN_NUM
+    };
+
+    /** The per-spectrum columns stored for every specie in every scan in a binary evaluation log */
+    enum BINARY_EVALLOG_SPECIE_COLUMN
+    {
+        BINLOG_COLUMN = 0,
+        BINLOG_COLUMNERROR,
+        BINLOG_SHIFT,
+        BINLOG_SHIFTERROR,
+        BINLOG_SQUEEZE,
+        BINLOG_SQUEEZEERROR,
+        BINLOG_SPECIE_COLUMN_NUM
+    };
+
+    /** The flags stored in the BINLOG_FLAGS column */
+    const int BINLOG_FLAG_BADFIT = 1;   // the evaluation of the spectrum was not good
+    const int BINLOG_FLAG_DARK = 2;     // the spectrum is a dark or offset measurement
+
+    /** The header of one scan in a binary evaluation log. All fields have fixed width
+        such that the header can be read directly from the (memory mapped) file. */
+    struct CBinaryEvaluationLogScanHeader
+    {
+        char     marker[4];         // always "SCAN"
+        uint32_t blockSize;         // the size of this header and the columns following it, in bytes
+        uint32_t spectrumNum;       // the number of values in each column
+        uint32_t specieNum;         // the number of species, each has BINLOG_SPECIE_COLUMN_NUM columns
+
+        int32_t  year;
+        int32_t  month;
+        int32_t  day;
+        int32_t  startTime;         // the start time of the scan, in seconds since midnight (UTC)
+
+        int32_t  mode;              // the MEASUREMENT_MODE of the scan
+        int32_t  channel;
+        int32_t  windSpeedSource;   // the MET_SOURCE of the wind speed
+        int32_t  windDirectionSource;
+        int32_t  plumeHeightSource;
+        int32_t  reserved;
+
+        double   flux;
+        double   windSpeed;
+        double   windDirection;
+        double   plumeHeight;
+        double   plumeCompleteness;
+        double   plumeCentre;
+        double   plumeEdge1;
+        double   plumeEdge2;
+        double   compass;
+        double   coneAngle;
+        double   tilt;
+        double   latitude;
+        double   longitude;
+        double   altitude;
+        double   batteryVoltage;
+        double   temperature;
+        double   offset;
+
+        char     serial[16];
+        char     specieName[MAX_N_REFERENCES][16];
+    };
+
+    /** The <b>CBinaryEvaluationLog</b> is an optional, binary, companion to the text evaluation-log.
+        It holds the same evaluation results as the text file but in a layout which can be loaded
+        without any parsing: the file is a short file-header followed by one block per scan.
+        Each block is a fixed size CBinaryEvaluationLogScanHeader followed by the per-spectrum
+        values stored column by column, each column being 'spectrumNum' doubles.
+        The file is only appended to, one block per evaluated scan, through g_logFiles and under
+        g_evalLogCritSect as the text evaluation-log, such that both are written to disk together. */
+    class CBinaryEvaluationLog
+    {
+    public:
+        /** @return the name of the binary evaluation log which accompanies the given text evaluation-log */
+        static CString FileNameFor(const CString &evaluationLogFileName);
+
+        /** Appends the result of one scan to the end of the binary evaluation log.
+            The file is created if it does not exist.
+            @return SUCCESS if the file could be opened. */
+        static RETURN_CODE AppendScan(const CString &fileName, const Evaluation::CScanResult &result, const Evaluation::CSpectrometer &spectrometer, const CWindField &windField);
+
+        /** @return the index of the given column of the given specie in a scan block */
+        static size_t SpecieColumnIndex(size_t specieIndex, BINARY_EVALLOG_SPECIE_COLUMN column) { return BINLOG_FIXED_COLUMN_NUM + specieIndex * BINLOG_SPECIE_COLUMN_NUM + column; }
+
+        /** The identifier at the beginning of every binary evaluation log */
+        static const char FILE_IDENTIFIER[8];
+
+        /** The size of the file-header, in bytes */
+        static const size_t FILE_HEADER_SIZE = 16;
+    };
+
+    /** The <b>CBinaryEvaluationLogReader</b> gives read access to a binary evaluation log.
+        The file is memory mapped and the columns are accessed directly in the mapped memory,
+        no data is copied or parsed when the file is opened. Only the scan headers are walked 
+        through once to build the index of where each scan starts.
+        A scan which was not completely written (e.g. since the program was closed while 
+        writing it) ends the file. */
+    class CBinaryEvaluationLogReader
+    {
+    public:
+        CBinaryEvaluationLogReader();
+        ~CBinaryEvaluationLogReader();
+
+        /** Opens and maps the given binary evaluation log.
+            @return false if the file does not exist or is not a binary evaluation log. */
+        bool Open(const CString &fileName);
+
+        /** Unmaps and closes the file. Any pointer retrieved from this object is invalid after this. */
+        void Close();
+
+        /** @return the number of scans in the file */
+        size_t ScanNum() const { return m_scanOffsets.size(); }
+
+        /** @return the header of the scan with the given index */
+        const CBinaryEvaluationLogScanHeader &ScanHeader(size_t scanIndex) const;
+
+        /** @return the values of the given column in the given scan,
+            there are ScanHeader(scanIndex).spectrumNum values in the column. */
+        const double *Column(size_t scanIndex, BINARY_EVALLOG_COLUMN column) const;
+
+        /** @return the values of the given column of the given specie in the given scan,
+            there are ScanHeader(scanIndex).spectrumNum values in the column.
+            @return nullptr if the specie does not exist in the scan. */
+        const double *SpecieColumn(size_t scanIndex, size_t specieIndex, BINARY_EVALLOG_SPECIE_COLUMN column) const;
+
+    private:
+        HANDLE m_file;
+        HANDLE m_mapping;
+        const char *m_data;
+        unsigned long long m_size;
+
+        /** The position of each scan block in the file */
+        std::vector<size_t> m_scanOffsets;
+
+        /** Walks through the scan blocks of the mapped file and fills in 'm_scanOffsets' */
+        void BuildScanIndex();
+    };
+}
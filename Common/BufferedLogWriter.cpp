@@ -0,0 +1,243 @@
+#include "StdAfx.h"
+#include "BufferedLogWriter.h"
+#include "../Configuration/Configuration.h"
+#include <algorithm>
+
+using namespace FileHandler;
+
+CBufferedLogWriter::~CBufferedLogWriter()
+{
+    CloseAll();
+}
+
+void CBufferedLogWriter::SetFlushPolicy(int flushPolicy, int flushInterval, size_t bufferSize)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_flushPolicy = flushPolicy;
+    m_flushInterval = std::max(flushInterval, 1);
+    m_bufferSize = std::max(bufferSize, (size_t)1024);
+}
+
+bool CBufferedLogWriter::Append(const CString &fileName, const CString &text, CCriticalSection *readerLock, bool writeNow)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    COpenFile *file = Open(fileName, false);
+    if (file == nullptr)
+    {
+        return false;
+    }
+    if (readerLock != nullptr)
+    {
+        file->readerLock = readerLock;
+    }
+
+    AppendToBuffer(*file, (LPCSTR)text, (size_t)text.GetLength(), writeNow);
+
+    return true;
+}
+
+bool CBufferedLogWriter::AppendBinary(const CString &fileName, const std::string &data, const std::string &fileHeader, CCriticalSection *readerLock)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    COpenFile *file = Open(fileName, true);
+    if (file == nullptr)
+    {
+        return false;
+    }
+    if (readerLock != nullptr)
+    {
+        file->readerLock = readerLock;
+    }
+
+    // The header and the first data are one piece, such that a reader never sees the header alone
+    if (!file->hasContents)
+    {
+        AppendToBuffer(*file, (fileHeader + data).data(), fileHeader.size() + data.size(), false);
+    }
+    else
+    {
+        AppendToBuffer(*file, data.data(), data.size(), false);
+    }
+
+    return true;
+}
+
+void CBufferedLogWriter::Flush(const CString &fileName)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    CString key(fileName);
+    key.MakeLower();
+
+    auto it = m_files.find(key);
+    if (it != m_files.end())
+    {
+        Write(it->second);
+    }
+}
+
+void CBufferedLogWriter::FlushAll()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    for (auto &entry : m_files)
+    {
+        Write(entry.second);
+    }
+}
+
+void CBufferedLogWriter::ScanCompleted()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    if (m_flushPolicy == CConfigurationSetting::LOGFLUSH_PER_SCAN)
+    {
+        for (auto &entry : m_files)
+        {
+            Write(entry.second);
+        }
+    }
+    else if (m_flushPolicy == CConfigurationSetting::LOGFLUSH_TIMED)
+    {
+        WriteOverdue();
+    }
+}
+
+void CBufferedLogWriter::CloseAll()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    for (auto &entry : m_files)
+    {
+        Close(entry.second);
+    }
+    m_files.clear();
+}
+
+CBufferedLogWriter::COpenFile *CBufferedLogWriter::Open(const CString &fileName, bool binary)
+{
+    CString key(fileName);
+    key.MakeLower();
+
+    auto it = m_files.find(key);
+    if (it == m_files.end())
+    {
+        // Close the least recently used file if there are too many files open
+        if (m_files.size() >= MAX_OPEN_FILES)
+        {
+            auto oldest = std::min_element(m_files.begin(), m_files.end(),
+                [](const std::pair<const CString, COpenFile> &first, const std::pair<const CString, COpenFile> &second) { return first.second.lastUsed < second.second.lastUsed; });
+            Close(oldest->second);
+            m_files.erase(oldest);
+        }
+
+        FILE *f = fopen(fileName, binary ? "ab" : "a");
+        if (f == nullptr)
+        {
+            return nullptr;
+        }
+
+        it = m_files.emplace(key, COpenFile()).first;
+        it->second.file = f;
+        it->second.fileName = fileName;
+        _fseeki64(f, 0, SEEK_END);
+        it->second.hasContents = (_ftelli64(f) > 0);
+    }
+
+    it->second.lastUsed = ++m_useCounter;
+    return &it->second;
+}
+
+void CBufferedLogWriter::AppendToBuffer(COpenFile &file, const char *data, size_t length, bool writeNow)
+{
+    // Make room for the new data, the data in the buffer is only ever written in the pieces it was appended in
+    if (!file.buffer.empty() && file.buffer.size() + length > m_bufferSize)
+    {
+        Write(file);
+    }
+
+    if (file.buffer.empty())
+    {
+        file.bufferedSince = time(nullptr);
+    }
+    file.buffer.append(data, length);
+    file.hasContents = true;
+
+    // A piece of data larger than the buffer, or which should not wait, is written directly
+    if (writeNow || file.buffer.size() >= m_bufferSize)
+    {
+        Write(file);
+    }
+
+    if (m_flushPolicy == CConfigurationSetting::LOGFLUSH_TIMED)
+    {
+        WriteOverdue();
+    }
+}
+
+bool CBufferedLogWriter::Write(COpenFile &file)
+{
+    if (file.buffer.empty())
+    {
+        return true;
+    }
+
+    // The lock order is m_mutex, which the caller holds, then the reader lock
+    size_t written = 0;
+    bool flushed = false;
+    if (file.readerLock != nullptr)
+    {
+        CSingleLock singleLock(file.readerLock, TRUE);
+        written = fwrite(file.buffer.data(), 1, file.buffer.size(), file.file);
+        flushed = (0 == fflush(file.file));
+    }
+    else
+    {
+        written = fwrite(file.buffer.data(), 1, file.buffer.size(), file.file);
+        flushed = (0 == fflush(file.file));
+    }
+
+    // Keep what could not be written, it is written together with the next text
+    file.buffer.erase(0, written);
+    if (file.buffer.empty() && flushed)
+    {
+        file.writeFailed = false;
+        return true;
+    }
+
+    clearerr(file.file);
+    if (!file.writeFailed)
+    {
+        file.writeFailed = true;
+        CString message;
+        message.Format("Could not write to %s, %u bytes are kept in memory and written later", (LPCSTR)file.fileName, (unsigned int)file.buffer.size());
+        ShowMessage(message);
+    }
+    return false;
+}
+
+void CBufferedLogWriter::Close(COpenFile &file)
+{
+    if (!Write(file))
+    {
+        CString message;
+        message.Format("Could not write to %s, %u bytes are lost", (LPCSTR)file.fileName, (unsigned int)file.buffer.size());
+        ShowMessage(message);
+    }
+    fclose(file.file);
+    file.file = nullptr;
+}
+
+void CBufferedLogWriter::WriteOverdue()
+{
+    const time_t now = time(nullptr);
+    for (auto &entry : m_files)
+    {
+        if (!entry.second.buffer.empty() && difftime(now, entry.second.bufferedSince) >= m_flushInterval)
+        {
+            Write(entry.second);
+        }
+    }
+}
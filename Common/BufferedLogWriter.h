@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Common.h"
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace FileHandler
+{
+    /** The <b>CBufferedLogWriter</b> appends text to the log files of the program, and data to the binary logs.
+        The log files are kept open and the text appended to each file is collected in a buffer
+        in memory, such that a log which receives many small messages is not opened and closed
+        for every message. The buffered text is written to disk according to the flush policy,
+        when the buffer of a file is full and when the file is closed. Text which cannot be written,
+        e.g. because the disk is full, is kept in the buffer and written later.
+
+        The text is always written to disk in the same pieces as it was appended, such that a
+        reader never sees half a message or half a scan. Files which are read by other threads
+        can be given the lock which the readers hold, the lock is then held while the text is written.
+
+        Lock order: the lock given for a file is taken while the internal lock of this class is held,
+        never the other way around. No method of this class may therefore be called while holding
+        such a lock (e.g. g_evalLogCritSect), that would deadlock with a thread writing the file.
+
+        At most MAX_OPEN_FILES files are kept open, the file which was least recently written
+        to is closed when another one is needed. All files are closed by CloseAll(), which is called
+        when the date changes and when the program stops. */
+    class CBufferedLogWriter
+    {
+    public:
+        CBufferedLogWriter() = default;
+        ~CBufferedLogWriter();
+
+        /** Sets when the buffered text is written to disk.
+            @param flushPolicy One of the CConfigurationSetting::LOGFLUSH_ constants.
+            @param flushInterval The longest time, in seconds, the text is kept in memory with the LOGFLUSH_TIMED policy.
+            @param bufferSize The size of the buffer of each file, in bytes. */
+        void SetFlushPolicy(int flushPolicy, int flushInterval, size_t bufferSize);
+
+        /** Appends the given text to the end of the given file. The file is created if it does not exist.
+            @param readerLock If not null, then this lock is held while the text is written to disk.
+                This is kept for the file until it is closed.
+            @param writeNow If true, then the text is written to disk at once regardless of the flush policy,
+                together with any text buffered before it. Used for the messages of the error and result logs,
+                which must not wait for the next scan or the shutdown.
+            @return true if the file could be opened. */
+        bool Append(const CString &fileName, const CString &text, CCriticalSection *readerLock = nullptr, bool writeNow = false);
+
+        /** Appends the given bytes to the end of the given binary file, which is written without any
+            translation of line endings. The file is created if it does not exist.
+            @param fileHeader Written before the data if the file is empty, e.g. the identifier of the file format.
+            @param readerLock As in Append.
+            @return true if the file could be opened. */
+        bool AppendBinary(const CString &fileName, const std::string &data, const std::string &fileHeader, CCriticalSection *readerLock = nullptr);
+
+        /** Writes the buffered text of the given file to disk, e.g. before the file is uploaded. */
+        void Flush(const CString &fileName);
+
+        /** Writes the buffered text of all files to disk */
+        void FlushAll();
+
+        /** Called when the evaluation of one scan has been completed and its results appended
+            to the logs. Writes the buffered text to disk if the flush policy says so. */
+        void ScanCompleted();
+
+        /** Writes the buffered text of all files to disk and closes the files. */
+        void CloseAll();
+
+        /** The maximum number of files which are kept open at the same time */
+        static const size_t MAX_OPEN_FILES = 64;
+
+    private:
+        CBufferedLogWriter(const CBufferedLogWriter&) = delete;
+        CBufferedLogWriter& operator=(const CBufferedLogWriter&) = delete;
+
+        /** One open log file */
+        struct COpenFile
+        {
+            FILE *file = nullptr;
+
+            /** The text which has been appended to the file but not yet written to disk */
+            std::string buffer;
+
+            /** The time when the oldest text in the buffer was appended */
+            time_t bufferedSince = 0;
+
+            /** Incremented on every use of any file, the file with the lowest value is closed first */
+            unsigned long long lastUsed = 0;
+
+            /** The lock to hold while writing to the file, may be null */
+            CCriticalSection *readerLock = nullptr;
+
+            /** True if the file was not empty when it was opened, or anything has been appended to it since */
+            bool hasContents = false;
+
+            /** The name of the file, as given when it was opened */
+            CString fileName;
+
+            /** True if the last write to the file failed, such that the failure is only reported once */
+            bool writeFailed = false;
+        };
+
+        int m_flushPolicy = 0; // CConfigurationSetting::LOGFLUSH_PER_SCAN
+        int m_flushInterval = 60;
+        size_t m_bufferSize = 65536;
+
+        /** The open files, the key is the lower-case file name */
+        std::map<CString, COpenFile> m_files;
+
+        unsigned long long m_useCounter = 0;
+
+        /** Protects all the members */
+        std::mutex m_mutex;
+
+        /** @return the open file with the given name, opening it in the given mode if necessary, or null if it cannot be opened */
+        COpenFile *Open(const CString &fileName, bool binary);
+
+        /** Adds the given data to the buffer of the given file and writes it to disk if the buffer is full.
+            Must be called with m_mutex held. */
+        void AppendToBuffer(COpenFile &file, const char *data, size_t length, bool writeNow);
+
+        /** Writes the buffered text of the given file to disk.
+            If not all of it can be written, e.g. when the disk is full, then the rest is kept in the buffer
+            and written the next time. The user is told the first time the file cannot be written.
+            This takes the reader lock of the file, and must be called with m_mutex held.
+            @return true if all the buffered text was written. */
+        static bool Write(COpenFile &file);
+
+        /** Writes the buffered text of the given file to disk and closes it.
+            The user is told if any text could not be written. Must be called with m_mutex held. */
+        static void Close(COpenFile &file);
+
+        /** Writes the buffered text of the files which have been kept in memory for longer than the flush interval */
+        void WriteOverdue();
+    };
+}
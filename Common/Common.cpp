@@ -164,31 +164,36 @@ void UploadToNOVACServer(const CString &fileName, int volcanoIndex, bool deleteF
 	return;
 }
 
-void UpdateMessage(const CString &message){
-	CString *msg = new CString();
+/** Shows the message in the message list of the main window, the window deletes the message.
+	Without a window, e.g. when the program runs from the command line, the message is written to stdout. */
+static void PostToView(UINT messageType, const CString &message){
+	if(pView != NULL){
+		CString *msg = new CString(message);
+		pView->PostMessage(messageType, (WPARAM)msg, NULL);
+	}else{
+		printf("%s\n", (LPCSTR)message);
+	}
+}
 
-	msg->Format("%s", (LPCSTR)message);
-	if(pView != NULL)
-		pView->PostMessage(WM_UPDATE_MESSAGE, (WPARAM)msg, NULL);
+void UpdateMessage(const CString &message){
+	PostToView(WM_UPDATE_MESSAGE, message);
 }
 
 void ShowMessage(const CString &message){
-	CString *msg = new CString();
+	CString msg;
 	CString timeTxt;
 	Common commonObj;
 	commonObj.GetDateTimeText(timeTxt);
-	msg->Format("%s -- %s", (LPCSTR)message , (LPCSTR)timeTxt);
-	if(pView != NULL)
-		pView->PostMessage(WM_SHOW_MESSAGE, (WPARAM)msg, NULL);
+	msg.Format("%s -- %s", (LPCSTR)message , (LPCSTR)timeTxt);
+	PostToView(WM_SHOW_MESSAGE, msg);
 }
 void ShowMessage(const CString &message,CString connectionID){
-	CString *msg = new CString();
+	CString msg;
 	CString timeTxt;
 	Common commonObj;
 	commonObj.GetDateTimeText(timeTxt);
-	msg->Format("<%s> : %s   -- %s", (LPCSTR)connectionID, (LPCSTR)message, (LPCSTR)timeTxt);
-	if(pView != NULL)
-		pView->PostMessage(WM_SHOW_MESSAGE, (WPARAM)msg, NULL);
+	msg.Format("<%s> : %s   -- %s", (LPCSTR)connectionID, (LPCSTR)message, (LPCSTR)timeTxt);
+	PostToView(WM_SHOW_MESSAGE, msg);
 }
 
 void ShowMessage(const TCHAR message[]){
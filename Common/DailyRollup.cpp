@@ -0,0 +1,277 @@
+#include "StdAfx.h"
+#include "DailyRollup.h"
+#include "SnapshotFile.h"
+#include "EvaluationLogFileHandler.h"
+#include "FluxLogFileHandler.h"
+#include "BinaryEvaluationLog.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace FileHandler;
+
+#define COLUMN_ROLLUP_IDENTIFIER "NOVCRL01"
+#define FLUX_ROLLUP_IDENTIFIER "NOVFRL01"
+
+CString CDailyRollup::FileNameFor(const CString &logFileName)
+{
+    CString fileName(logFileName);
+    if (fileName.Right(4).CompareNoCase(".txt") == 0)
+    {
+        fileName = fileName.Left(fileName.GetLength() - 4);
+    }
+    fileName.Append(".rollup");
+    return fileName;
+}
+
+bool CDailyRollup::ReadColumns(const CString &evaluationLog)
+{
+    const long long logSize = FileSize(evaluationLog);
+    if (logSize < 0)
+    {
+        Clear();
+        return false;
+    }
+
+    const CString rollupFile = FileNameFor(evaluationLog);
+    if (Load(rollupFile, COLUMN_ROLLUP_IDENTIFIER, logSize))
+    {
+        return true;
+    }
+
+    if (!BuildFromEvaluationLog(evaluationLog))
+    {
+        return false;
+    }
+    Save(rollupFile, COLUMN_ROLLUP_IDENTIFIER, logSize);
+    return true;
+}
+
+bool CDailyRollup::ReadFluxes(const CString &fluxLog)
+{
+    const long long logSize = FileSize(fluxLog);
+    if (logSize < 0)
+    {
+        Clear();
+        return false;
+    }
+
+    const CString rollupFile = FileNameFor(fluxLog);
+    if (Load(rollupFile, FLUX_ROLLUP_IDENTIFIER, logSize))
+    {
+        return true;
+    }
+
+    if (!BuildFromFluxLog(fluxLog))
+    {
+        return false;
+    }
+    Save(rollupFile, FLUX_ROLLUP_IDENTIFIER, logSize);
+    return true;
+}
+
+void CDailyRollup::Clear()
+{
+    m_good.clear();
+    m_bad.clear();
+    m_goodNum = 0;
+    m_badNum = 0;
+}
+
+static bool ReadPoints(CSnapshotReader &reader, std::vector<CRollupPoint> &points)
+{
+    uint32_t number = 0;
+    if (!reader.Read(number) || (size_t)number * sizeof(CRollupPoint) > reader.Remaining())
+    {
+        return false;
+    }
+    points.resize(number);
+    return reader.Read(points.data(), points.size() * sizeof(CRollupPoint));
+}
+
+static void WritePoints(CSnapshotWriter &writer, const std::vector<CRollupPoint> &points)
+{
+    writer.Write((uint32_t)points.size());
+    writer.Write(points.data(), points.size() * sizeof(CRollupPoint));
+}
+
+bool CDailyRollup::Load(const CString &fileName, const char identifier[8], long long logSize)
+{
+    Clear();
+
+    CSnapshotReader reader;
+    if (!reader.Open(fileName, identifier))
+    {
+        return false;
+    }
+
+    int64_t builtFromSize = 0;
+    if (!reader.Read(builtFromSize) || builtFromSize != logSize)
+    {
+        return false;
+    }
+
+    uint32_t goodNum = 0, badNum = 0;
+    reader.Read(goodNum);
+    reader.Read(badNum);
+    if (!reader.Ok() || !ReadPoints(reader, m_good) || !ReadPoints(reader, m_bad))
+    {
+        Clear();
+        return false;
+    }
+
+    m_goodNum = goodNum;
+    m_badNum = badNum;
+    return true;
+}
+
+bool CDailyRollup::Save(const CString &fileName, const char identifier[8], long long logSize) const
+{
+    CSnapshotWriter writer;
+    if (!writer.Open(fileName, identifier))
+    {
+        return false;
+    }
+
+    writer.Write((int64_t)logSize);
+    writer.Write(m_goodNum);
+    writer.Write(m_badNum);
+    WritePoints(writer, m_good);
+    WritePoints(writer, m_bad);
+    return writer.Commit();
+}
+
+bool CDailyRollup::BuildFromEvaluationLog(const CString &evaluationLog)
+{
+    Clear();
+
+    // If there is a binary evaluation log which holds all the scans of the evaluation log, then take the columns directly from it.
+    //  The binary log may be missing scans, e.g. if it was enabled during the day, and is then not used.
+    CBinaryEvaluationLogReader binaryLogReader;
+    if (binaryLogReader.Open(CBinaryEvaluationLog::FileNameFor(evaluationLog)) && binaryLogReader.ScanNum() == CountScans(evaluationLog))
+    {
+        for (size_t j = 0; j < binaryLogReader.ScanNum(); ++j)
+        {
+            const double *col = binaryLogReader.SpecieColumn(j, 0, BINLOG_COLUMN); //Assumes SO2 ref is at index 0
+            if (col == nullptr)
+            {
+                continue;
+            }
+            const double *startTime = binaryLogReader.Column(j, BINLOG_STARTTIME);
+            const double *flags = binaryLogReader.Column(j, BINLOG_FLAGS);
+            const unsigned long spectrumNum = binaryLogReader.ScanHeader(j).spectrumNum;
+            for (unsigned long k = 0; k < spectrumNum; ++k)
+            {
+                const int flag = (int)flags[k];
+                if (flag & BINLOG_FLAG_DARK)
+                {
+                    continue;
+                }
+                if (flag & BINLOG_FLAG_BADFIT)
+                {
+                    ++m_badNum;
+                    continue;
+                }
+                m_good.push_back(CRollupPoint{ startTime[k], col[k] });
+                ++m_goodNum;
+            }
+        }
+        return true;
+    }
+
+    // Otherwise read the evaluation log
+    CEvaluationLogFileHandler evalLogReader;
+    evalLogReader.m_evaluationLog.Format(evaluationLog);
+    if (FAIL == evalLogReader.ReadEvaluationLog())
+    {
+        return false;
+    }
+
+    for (long j = 0; j < evalLogReader.m_scanNum; ++j)
+    {
+        Evaluation::CScanResult &sr = evalLogReader.m_scan[j];
+        for (unsigned long k = 0; k < sr.GetEvaluatedNum(); ++k)
+        {
+            // Check if this is a dark measurement, if so then don't include it...
+            if (sr.IsDarkSpectrum(k))
+            {
+                continue;
+            }
+
+            if (sr.IsBad(k))
+            {
+                ++m_badNum;
+                continue;
+            }
+
+            CDateTime st;
+            sr.GetStartTime(k, st);
+            const double startsec = st.hour * 3600 + st.minute * 60 + st.second;
+            m_good.push_back(CRollupPoint{ startsec, sr.GetColumn(k, 0) }); //Assumes SO2 ref is at index 0
+            ++m_goodNum;
+        }
+    }
+    return true;
+}
+
+size_t CDailyRollup::CountScans(const CString &evaluationLog)
+{
+    FILE *f = fopen(evaluationLog, "r");
+    if (f == nullptr)
+    {
+        return 0;
+    }
+
+    // Each scan begins with a line holding only the scan-information tag
+    size_t scanNum = 0;
+    char buffer[4096];
+    while (nullptr != fgets(buffer, sizeof(buffer), f))
+    {
+        if (0 == strncmp(buffer, "<scaninformation>", 17))
+        {
+            ++scanNum;
+        }
+    }
+
+    fclose(f);
+    return scanNum;
+}
+
+bool CDailyRollup::BuildFromFluxLog(const CString &fluxLog)
+{
+    Clear();
+
+    CFluxLogFileHandler fluxLogReader;
+    fluxLogReader.m_fluxLog.Format(fluxLog);
+    if (FAIL == fluxLogReader.ReadFluxLog())
+    {
+        return false;
+    }
+
+    for (int j = 0; j < fluxLogReader.m_fluxesNum; ++j)
+    {
+        const Evaluation::CFluxResult &fr = fluxLogReader.m_fluxes[j];
+        const CDateTime &st = fr.m_startTime;
+        const CRollupPoint point{ (double)(st.hour * 3600 + st.minute * 60 + st.second), fr.m_flux };
+        if (fr.m_fluxOk)
+        {
+            m_good.push_back(point);
+            ++m_goodNum;
+        }
+        else
+        {
+            m_bad.push_back(point);
+            ++m_badNum;
+        }
+    }
+    return true;
+}
+
+long long CDailyRollup::FileSize(const CString &fileName)
+{
+    struct __stat64 fileStatus;
+    if (0 != _stat64(fileName, &fileStatus))
+    {
+        return -1;
+    }
+    return (long long)fileStatus.st_size;
+}
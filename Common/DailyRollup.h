@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Common.h"
+
+namespace FileHandler
+{
+    /** One point in a daily rollup */
+    struct CRollupPoint
+    {
+        /** The start time of the measurement, in seconds since midnight (UTC) */
+        double secondOfDay;
+
+        /** The column or the flux, in the unit of the log */
+        double value;
+    };
+
+    /** The <b>CDailyRollup</b> is a small summary of the evaluation-log or the flux-log of one
+        instrument for one day, holding only what the 10 and 30 day history plots show.
+        The columns of the good fits, excluding the dark measurements, are taken from the evaluation-log
+        and the good and bad fluxes are taken from the flux-log, together with the number of good and bad values.
+        The values are stored in the units of the logs, the conversion to the units chosen by the user is
+        done when the values are plotted.
+
+        The rollup is built once from the log, when the day has closed, and saved next to the log.
+        Later, the rollup is read instead of the log with one sequential read of the whole file.
+        The size of the log is stored in the rollup, a rollup of a log which has changed since is built again. */
+    class CDailyRollup
+    {
+    public:
+        /** The good columns or fluxes, in the order they appear in the log */
+        std::vector<CRollupPoint> m_good;
+
+        /** The bad fluxes, in the order they appear in the log. Empty for the columns. */
+        std::vector<CRollupPoint> m_bad;
+
+        /** The number of good and bad values in the log, the dark measurements are not counted */
+        uint32_t m_goodNum = 0;
+        uint32_t m_badNum = 0;
+
+        /** @return the name and path of the rollup of the given evaluation-log or flux-log */
+        static CString FileNameFor(const CString &logFileName);
+
+        /** Reads the columns of the given evaluation-log. The rollup is built first if it does not exist
+            or if the log has changed since it was built.
+            @return false if the evaluation-log could not be read. */
+        bool ReadColumns(const CString &evaluationLog);
+
+        /** Reads the fluxes of the given flux-log. The rollup is built first if it does not exist
+            or if the log has changed since it was built.
+            @return false if the flux-log could not be read. */
+        bool ReadFluxes(const CString &fluxLog);
+
+    private:
+        void Clear();
+
+        /** Reads the rollup from file.
+            @return false if the file does not exist, is damaged or was built from a log of another size. */
+        bool Load(const CString &fileName, const char identifier[8], long long logSize);
+
+        /** Saves the rollup to file */
+        bool Save(const CString &fileName, const char identifier[8], long long logSize) const;
+
+        /** Takes the columns from the evaluation-log, or from the binary evaluation-log if there is one
+            and it holds the same scans as the evaluation-log */
+        bool BuildFromEvaluationLog(const CString &evaluationLog);
+
+        /** @return the number of scans in the given evaluation-log, counted without parsing them */
+        static size_t CountScans(const CString &evaluationLog);
+
+        /** Takes the fluxes from the flux-log */
+        bool BuildFromFluxLog(const CString &fluxLog);
+
+        /** @return the size of the given file, or -1 if it does not exist */
+        static long long FileSize(const CString &fileName);
+    };
+}
@@ -7,6 +7,10 @@
 // Include synchronization classes
 #include <afxmt.h>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+
 // Global variables;
 extern CCriticalSection g_evalLogCritSect; // synchronization access to evaluation-log files
 
@@ -40,6 +44,8 @@ CEvaluationLogFileHandler::CEvaluationLogFileHandler(void)
         m_col.squeezeError[i] = 12;
     }
     m_scanNum = 0;
+    m_endPosition = 0;
+    m_endWriteTime = 0;
     m_scan.SetSize(ORIGINAL_ARRAY_LENGTH);
     m_windField.SetSize(ORIGINAL_ARRAY_LENGTH);
 }
@@ -53,17 +59,12 @@ CEvaluationLogFileHandler::~CEvaluationLogFileHandler(void)
 }
 
 
-void CEvaluationLogFileHandler::ParseScanHeader(const char szLine[8192]) {
+void CEvaluationLogFileHandler::ParseScanHeader(char *szLine) {
     // reset some old information
     ResetColumns();
 
-    char str[8192];
-    if (szLine[0] == '#')
-        strncpy(str, szLine + 1, 8191 * sizeof(char));
-    else
-        strncpy(str, szLine, 8192 * sizeof(char));
-
-    char* szToken = (char*)(LPCSTR)str;
+    // the line is tokenized in place, so there is no limit on its length
+    char* szToken = (szLine[0] == '#') ? szLine + 1 : szLine;
     int curCol = -1;
     char elevation[] = _T("elevation");
     char scanAngle[] = _T("scanangle");
@@ -263,14 +264,15 @@ void CEvaluationLogFileHandler::ParseScanHeader(const char szLine[8192]) {
     return;
 }
 
-RETURN_CODE CEvaluationLogFileHandler::ReadEvaluationLog() {
+RETURN_CODE CEvaluationLogFileHandler::ReadEvaluationLog(long long startPosition) {
     char  expTimeStr[] = _T("exposuretime");         // this string only exists in the header line.
     char  scanInformation[] = _T("<scaninformation>");    // this string only exists in the scan-information section before the scan-data
     char  fluxInformation[] = _T("<fluxinfo>");           // this string only exists in the flux-information section before the scan-data
     char  spectralData[] = _T("<spectraldata>");
     char  endofSpectralData[] = _T("</spectraldata>");
     CString str;
-    char szLine[8192];
+    char *szLine = NULL;
+    size_t lineLength = 0;
     int measNr = 0;
     double fValue;
     m_scanNum = -1;
@@ -281,400 +283,466 @@ RETURN_CODE CEvaluationLogFileHandler::ReadEvaluationLog() {
     if (strlen(m_evaluationLog) <= 1)
         return FAIL;
 
-    // First count the number of scans in the file.
-    //	This to speed up the initialization of the arrays
-    CArray<CDateTime*, CDateTime*> allStartTimes;
-    CArray<unsigned int, unsigned int&> sortOrder;
-    long nScans = GetScanStartTimes(allStartTimes);
-    if (nScans > 0) {
-        m_scan.SetSize(nScans);
-        m_windField.SetSize(nScans + 1);
-    }
-    else {
-        MessageBox(NULL, "No scans found in file", "No scans", MB_OK);
-        return FAIL;
-    }
-    SortScanStartTimes(allStartTimes, sortOrder);
-
-    // Open the evaluation log
+    // Read the evaluation log into memory. The lock is only held while finding out how much
+    //  of the file has been written. The file is only appended to, so everything up to this
+    //  length can then be read and parsed without blocking the writers of the evaluation logs.
+    long long fileSize = -1;
+    __time64_t lastWriteTime = 0;
     CSingleLock singleLock(&g_evalLogCritSect);
     singleLock.Lock();
     if (singleLock.IsLocked()) {
-        FILE *f = fopen(m_evaluationLog, "r");
-        if (NULL == f) {
-            singleLock.Unlock();
-            return FAIL;
+        struct __stat64 fileStatus;
+        if (0 == _stat64(m_evaluationLog, &fileStatus)) {
+            fileSize = fileStatus.st_size;
+            lastWriteTime = fileStatus.st_mtime;
         }
+        singleLock.Unlock();
+    }
 
-        // Reset the column- and spectrum info
-        ResetColumns();
-        ResetScanInformation();
+    CLogBuffer buffer;
+    if (fileSize < 0 || !buffer.Read(m_evaluationLog, std::min(startPosition, fileSize), fileSize)) {
+        return FAIL;
+    }
+    m_endPosition = fileSize;
+    m_endWriteTime = lastWriteTime;
 
-        // Read the file, one line at a time
-        while (fgets(szLine, 8192, f)) {
+    // The start time of each scan, used to sort the scans in order of collection.
+    //  Scans without a scan-information section have no start time.
+    std::vector<CDateTime> scanStartTimes;
+    std::vector<bool> scanHasStartTime;
 
-            // ignore empty lines
-            if (strlen(szLine) < 2) {
-                if (fReadingScan) {
-                    fReadingScan = false;
-                    // Reset the column- and spectrum-information
-                    ResetColumns();
-                    ResetScanInformation();
-                }
-                continue;
-            }
+    // Reset the column- and spectrum info
+    ResetColumns();
+    ResetScanInformation();
 
-            // convert the string to all lower-case letters
-            for (unsigned int it = 0; it < strlen(szLine); ++it) {
-                szLine[it] = tolower(szLine[it]);
-            }
+    // Read the file, one line at a time
+    while (NULL != (szLine = buffer.NextLine(lineLength))) {
 
-            // find the next scan-information section
-            if (NULL != strstr(szLine, scanInformation)) {
-                ParseScanInformation(m_specInfo, flux, f);
-                continue;
+        // ignore empty lines
+        if (lineLength == 0) {
+            if (fReadingScan) {
+                fReadingScan = false;
+                // Reset the column- and spectrum-information
+                ResetColumns();
+                ResetScanInformation();
             }
+            continue;
+        }
 
-            // find the next flux-information section
-            if (NULL != strstr(szLine, fluxInformation)) {
-                ParseFluxInformation(m_windField[sortOrder[m_scanNum + 1]], flux, f);
-                continue;
-            }
+        // convert the string to all lower-case letters
+        for (size_t it = 0; it < lineLength; ++it) {
+            szLine[it] = (char)tolower(szLine[it]);
+        }
 
-            if (NULL != strstr(szLine, spectralData)) {
-                fReadingScan = true;
-                continue;
-            }
-            else if (NULL != strstr(szLine, endofSpectralData)) {
-                fReadingScan = false;
-                continue;
+        // find the next scan-information section
+        if (NULL != strstr(szLine, scanInformation)) {
+            ParseScanInformation(m_specInfo, flux, buffer);
+
+            // This is the information about the next scan
+            if ((int)scanStartTimes.size() < m_scanNum + 2) {
+                scanStartTimes.resize(m_scanNum + 2);
+                scanHasStartTime.resize(m_scanNum + 2, false);
             }
+            scanStartTimes[m_scanNum + 1] = m_specInfo.m_startTime;
+            scanHasStartTime[m_scanNum + 1] = true;
+            continue;
+        }
 
-            // find the next start of a scan 
-            if (NULL != strstr(szLine, expTimeStr)) {
+        // find the next flux-information section
+        if (NULL != strstr(szLine, fluxInformation)) {
+            ParseFluxInformation(m_windField[m_scanNum + 1], flux, buffer);
+            continue;
+        }
 
-                // check so that there was some information in the last scan read
-                //	if not the re-use the memory space
-                if ((measNr > 0) || (measNr == 0 && m_scanNum < 0)) {
+        if (NULL != strstr(szLine, spectralData)) {
+            fReadingScan = true;
+            continue;
+        }
+        else if (NULL != strstr(szLine, endofSpectralData)) {
+            fReadingScan = false;
+            continue;
+        }
 
-                    // The current measurement position inside the scan
-                    measNr = 0;
+        // find the next start of a scan 
+        if (NULL != strstr(szLine, expTimeStr)) {
 
-                    // before we start the next scan, calculate some information about
-                    // the old one
+            // check so that there was some information in the last scan read
+            //	if not the re-use the memory space
+            if ((measNr > 0) || (measNr == 0 && m_scanNum < 0)) {
 
-                    // 1. If the sky and dark were specified, remove them from the measurement
-                    if (m_scanNum >= 0 && fabs(m_scan[sortOrder[m_scanNum]].GetScanAngle(1) - 180.0) < 1) {
-                        m_scan[sortOrder[m_scanNum]].RemoveResult(0); // remove sky
-                        m_scan[sortOrder[m_scanNum]].RemoveResult(0); // remove dark
-                    }
+                // The current measurement position inside the scan
+                measNr = 0;
 
-                    // 2. Calculate the offset
-                    if (m_scanNum >= 0 && m_scan[sortOrder[m_scanNum]].m_spec.size() > 0) {
-                        const Evaluation::CEvaluationResult& evResult = m_scan[sortOrder[m_scanNum]].m_spec.front();
-                        if(evResult.m_referenceResult.size() > 0) {
-                            m_scan[sortOrder[m_scanNum]].CalculateOffset(evResult.m_referenceResult.front().m_specieName);
-                        }
-                    }
+                // before we start the next scan, calculate some information about
+                // the old one
 
-                    // start the next scan.
-                    ++m_scanNum;
-                    if (m_scanNum >= m_scan.GetSize()) {
-                        m_scan.SetSize(m_scanNum + 1);
-                        m_windField.SetSize(m_scanNum + 2);
-                    }
+                // 1. If the sky and dark were specified, remove them from the measurement
+                if (m_scanNum >= 0 && fabs(m_scan[m_scanNum].GetScanAngle(1) - 180.0) < 1) {
+                    m_scan[m_scanNum].RemoveResult(0); // remove sky
+                    m_scan[m_scanNum].RemoveResult(0); // remove dark
                 }
 
-                // This line is the header line which says what each column represents.
-                //  Read it and parse it to find out how to interpret the rest of the 
-                //  file. 
-                ParseScanHeader(szLine);
-
-                // start parsing the lines
-                fReadingScan = true;
+                // 2. Calculate the offset
+                if (m_scanNum >= 0 && m_scan[m_scanNum].m_spec.size() > 0) {
+                    const Evaluation::CEvaluationResult& evResult = m_scan[m_scanNum].m_spec.front();
+                    if(evResult.m_referenceResult.size() > 0) {
+                        m_scan[m_scanNum].CalculateOffset(evResult.m_referenceResult.front().m_specieName);
+                    }
+                }
 
-                // read the next line, which is the first line in the scan
-                continue;
+                // start the next scan.
+                ++m_scanNum;
+                if (m_scanNum >= m_scan.GetSize()) {
+                    m_scan.SetSize(m_scanNum + 1);
+                    m_windField.SetSize(m_scanNum + 2);
+                }
             }
 
-            // ignore comment lines
-            if (szLine[0] == '#')
-                continue;
+            // This line is the header line which says what each column represents.
+            //  Read it and parse it to find out how to interpret the rest of the 
+            //  file. 
+            ParseScanHeader(szLine);
 
-            // if we're not reading a scan, let's read the next line
-            if (!fReadingScan)
-                continue;
+            // start parsing the lines
+            fReadingScan = true;
 
-            // Split the scan information up into tokens and parse them. 
-            char* szToken = (char*)(LPCSTR)szLine;
-            int curCol = -1;
-            while (szToken = strtok(szToken, " \t")) {
-                ++curCol;
-
-                // First check the starttime
-                if (curCol == m_col.starttime) {
-                    int fValue1, fValue2, fValue3, ret;
-                    if (strstr(szToken, ":")) {
-                        ret = sscanf(szToken, "%d:%d:%d", &fValue1, &fValue2, &fValue3);
-                    }
-                    else {
-                        ret = sscanf(szToken, "%d.%d.%d", &fValue1, &fValue2, &fValue3);
-                    }
-                    if (ret == 3) {
-                        m_specInfo.m_startTime.hour = fValue1;
-                        m_specInfo.m_startTime.minute = fValue2;
-                        m_specInfo.m_startTime.second = fValue3;
-                        szToken = NULL;
-                    }
-                    continue;
-                }
-
-                // Then check the stoptime
-                if (curCol == m_col.stoptime) {
-                    int fValue1, fValue2, fValue3, ret;
-                    if (strstr(szToken, ":")) {
-                        ret = sscanf(szToken, "%d:%d:%d", &fValue1, &fValue2, &fValue3);
-                    }
-                    else {
-                        ret = sscanf(szToken, "%d.%d.%d", &fValue1, &fValue2, &fValue3);
-                    }
-                    if (ret == 3) {
-                        m_specInfo.m_stopTime.hour = fValue1;
-                        m_specInfo.m_stopTime.minute = fValue2;
-                        m_specInfo.m_stopTime.second = fValue3;
-                        szToken = NULL;
-                    }
-                    continue;
-                }
+            // read the next line, which is the first line in the scan
+            continue;
+        }
 
-                // Also check the name...
-                if (curCol == m_col.name) {
-                    m_specInfo.m_name = std::string(szToken);
-                    szToken = NULL;
-                    continue;
-                }
+        // ignore comment lines
+        if (szLine[0] == '#')
+            continue;
 
-                // ignore columns whose value cannot be parsed into a float
-                if (1 != sscanf(szToken, "%lf", &fValue)) {
-                    szToken = NULL;
-                    continue;
-                }
+        // if we're not reading a scan, let's read the next line
+        if (!fReadingScan)
+            continue;
 
-                if (curCol == m_col.position) {
-                    m_specInfo.m_scanAngle = (float)fValue;
-                    szToken = NULL;
-                    continue;
+        // Split the scan information up into tokens and parse them. 
+        char* szToken = (char*)(LPCSTR)szLine;
+        int curCol = -1;
+        while (szToken = strtok(szToken, " \t")) {
+            ++curCol;
+
+            // First check the starttime
+            if (curCol == m_col.starttime) {
+                int fValue1, fValue2, fValue3, ret;
+                if (strstr(szToken, ":")) {
+                    ret = sscanf(szToken, "%d:%d:%d", &fValue1, &fValue2, &fValue3);
                 }
-
-                if (curCol == m_col.position2) {
-                    m_specInfo.m_scanAngle2 = (float)fValue;
-                    szToken = NULL;
-                    continue;
+                else {
+                    ret = sscanf(szToken, "%d.%d.%d", &fValue1, &fValue2, &fValue3);
                 }
-
-                if (curCol == m_col.intensity) {
-                    m_specInfo.m_peakIntensity = (float)fValue;
+                if (ret == 3) {
+                    m_specInfo.m_startTime.hour = fValue1;
+                    m_specInfo.m_startTime.minute = fValue2;
+                    m_specInfo.m_startTime.second = fValue3;
                     szToken = NULL;
-                    continue;
                 }
+                continue;
+            }
 
-                if (curCol == m_col.fitIntensity) {
-                    m_specInfo.m_fitIntensity = (float)fValue;
-                    szToken = NULL;
-                    continue;
+            // Then check the stoptime
+            if (curCol == m_col.stoptime) {
+                int fValue1, fValue2, fValue3, ret;
+                if (strstr(szToken, ":")) {
+                    ret = sscanf(szToken, "%d:%d:%d", &fValue1, &fValue2, &fValue3);
                 }
-
-                if (curCol == m_col.fitSaturation) {
-                    m_specInfo.m_fitIntensity = (float)fValue;
-                    szToken = NULL;
-                    continue;
+                else {
+                    ret = sscanf(szToken, "%d.%d.%d", &fValue1, &fValue2, &fValue3);
                 }
-
-                if (curCol == m_col.peakSaturation) {
-                    m_specInfo.m_peakIntensity = (float)fValue;
+                if (ret == 3) {
+                    m_specInfo.m_stopTime.hour = fValue1;
+                    m_specInfo.m_stopTime.minute = fValue2;
+                    m_specInfo.m_stopTime.second = fValue3;
                     szToken = NULL;
-                    continue;
                 }
+                continue;
+            }
 
-                if (curCol == m_col.offset) {
-                    m_specInfo.m_offset = (float)fValue;
-                    szToken = NULL;
-                    continue;
-                }
+            // Also check the name...
+            if (curCol == m_col.name) {
+                m_specInfo.m_name = std::string(szToken);
+                szToken = NULL;
+                continue;
+            }
 
-                if (curCol == m_col.delta) {
-                    m_evResult.m_delta = (float)fValue;
-                    szToken = NULL;
-                    continue;
-                }
+            // ignore columns whose value cannot be parsed into a float
+            if (1 != sscanf(szToken, "%lf", &fValue)) {
+                szToken = NULL;
+                continue;
+            }
 
-                if (curCol == m_col.chiSquare) {
-                    m_evResult.m_chiSquare = (float)fValue;
-                    szToken = NULL;
-                    continue;
-                }
+            if (curCol == m_col.position) {
+                m_specInfo.m_scanAngle = (float)fValue;
+                szToken = NULL;
+                continue;
+            }
 
-                if (curCol == m_col.nSpec) {
-                    m_specInfo.m_numSpec = (long)fValue;
-                    szToken = NULL;
-                    continue;
-                }
+            if (curCol == m_col.position2) {
+                m_specInfo.m_scanAngle2 = (float)fValue;
+                szToken = NULL;
+                continue;
+            }
 
-                if (curCol == m_col.expTime) {
-                    m_specInfo.m_exposureTime = (long)fValue;
-                    szToken = NULL;
-                    continue;
-                }
+            if (curCol == m_col.intensity) {
+                m_specInfo.m_peakIntensity = (float)fValue;
+                szToken = NULL;
+                continue;
+            }
 
-                for (int k = 0; k < m_col.nSpecies; ++k) {
-                    if (curCol == m_col.column[k]) {
-                        m_evResult.m_referenceResult[k].m_column = (float)fValue;
-                        break;
-                    }
-                    if (curCol == m_col.columnError[k]) {
-                        m_evResult.m_referenceResult[k].m_columnError = (float)fValue;
-                        break;
-                    }
-                    if (curCol == m_col.shift[k]) {
-                        m_evResult.m_referenceResult[k].m_shift = (float)fValue;
-                        break;
-                    }
-                    if (curCol == m_col.shiftError[k]) {
-                        m_evResult.m_referenceResult[k].m_shiftError = (float)fValue;
-                        break;
-                    }
-                    if (curCol == m_col.squeeze[k]) {
-                        m_evResult.m_referenceResult[k].m_squeeze = (float)fValue;
-                        break;
-                    }
-                    if (curCol == m_col.squeezeError[k]) {
-                        m_evResult.m_referenceResult[k].m_squeezeError = (float)fValue;
-                        break;
-                    }
-                }
+            if (curCol == m_col.fitIntensity) {
+                m_specInfo.m_fitIntensity = (float)fValue;
                 szToken = NULL;
+                continue;
             }
 
-            // start reading the next line in the evaluation log (i.e. the next
-            //  spectrum in the scan). Insert the data from this spectrum into the 
-            //  CScanResult structure
+            if (curCol == m_col.fitSaturation) {
+                m_specInfo.m_fitIntensity = (float)fValue;
+                szToken = NULL;
+                continue;
+            }
 
-            // If this is the first spectrum in the new scan, then make
-            //	an initial guess for how large the arrays are going to be...
-            if (measNr == 0 && m_scanNum > 1) {
-                // If this is the first spectrum in a new scan, then initialize the 
-                //	size of the arrays, to save some time on re-allocating memory
-                m_scan[sortOrder[m_scanNum]].InitializeArrays(m_scan[m_scanNum - 1].GetEvaluatedNum());
+            if (curCol == m_col.peakSaturation) {
+                m_specInfo.m_peakIntensity = (float)fValue;
+                szToken = NULL;
+                continue;
             }
 
-            m_specInfo.m_scanIndex = measNr;
-            if (EqualsIgnoringCase(m_specInfo.m_name, "sky")) {
-                m_scan[sortOrder[m_scanNum]].SetSkySpecInfo(m_specInfo);
+            if (curCol == m_col.offset) {
+                m_specInfo.m_offset = (float)fValue;
+                szToken = NULL;
+                continue;
             }
-            else if (EqualsIgnoringCase(m_specInfo.m_name, "dark")) {
-                m_scan[sortOrder[m_scanNum]].SetDarkSpecInfo(m_specInfo);
+
+            if (curCol == m_col.delta) {
+                m_evResult.m_delta = (float)fValue;
+                szToken = NULL;
+                continue;
             }
-            else if (EqualsIgnoringCase(m_specInfo.m_name, "offset")) {
-                m_scan[sortOrder[m_scanNum]].SetOffsetSpecInfo(m_specInfo);
+
+            if (curCol == m_col.chiSquare) {
+                m_evResult.m_chiSquare = (float)fValue;
+                szToken = NULL;
+                continue;
             }
-            else if (EqualsIgnoringCase(m_specInfo.m_name, "dark_cur")) {
-                m_scan[sortOrder[m_scanNum]].SetDarkCurrentSpecInfo(m_specInfo);
+
+            if (curCol == m_col.nSpec) {
+                m_specInfo.m_numSpec = (long)fValue;
+                szToken = NULL;
+                continue;
             }
-            else {
-                m_scan[sortOrder[m_scanNum]].AppendResult(m_evResult, m_specInfo);
-                m_scan[sortOrder[m_scanNum]].SetFlux(flux);
+
+            if (curCol == m_col.expTime) {
+                m_specInfo.m_exposureTime = (long)fValue;
+                szToken = NULL;
+                continue;
             }
 
-            double dynamicRange = 1.0; // <-- unknown
-            if (m_col.peakSaturation != -1) { // If the intensity is specified as a saturation ratio...
-                dynamicRange = CSpectrometerDatabase::GetInstance().GetModel(m_specInfo.m_specModelName).maximumIntensity;
+            for (int k = 0; k < m_col.nSpecies; ++k) {
+                if (curCol == m_col.column[k]) {
+                    m_evResult.m_referenceResult[k].m_column = (float)fValue;
+                    break;
+                }
+                if (curCol == m_col.columnError[k]) {
+                    m_evResult.m_referenceResult[k].m_columnError = (float)fValue;
+                    break;
+                }
+                if (curCol == m_col.shift[k]) {
+                    m_evResult.m_referenceResult[k].m_shift = (float)fValue;
+                    break;
+                }
+                if (curCol == m_col.shiftError[k]) {
+                    m_evResult.m_referenceResult[k].m_shiftError = (float)fValue;
+                    break;
+                }
+                if (curCol == m_col.squeeze[k]) {
+                    m_evResult.m_referenceResult[k].m_squeeze = (float)fValue;
+                    break;
+                }
+                if (curCol == m_col.squeezeError[k]) {
+                    m_evResult.m_referenceResult[k].m_squeezeError = (float)fValue;
+                    break;
+                }
             }
-            m_scan[sortOrder[m_scanNum]].CheckGoodnessOfFit(m_specInfo);
-            ++measNr;
+            szToken = NULL;
         }
 
-        // close the evaluation log
-        fclose(f);
+        // start reading the next line in the evaluation log (i.e. the next
+        //  spectrum in the scan). Insert the data from this spectrum into the 
+        //  CScanResult structure
+
+        // If this is the first spectrum in the new scan, then make
+        //	an initial guess for how large the arrays are going to be...
+        if (measNr == 0 && m_scanNum > 1) {
+            // If this is the first spectrum in a new scan, then initialize the 
+            //	size of the arrays, to save some time on re-allocating memory
+            m_scan[m_scanNum].InitializeArrays(m_scan[m_scanNum - 1].GetEvaluatedNum());
+        }
+
+        m_specInfo.m_scanIndex = measNr;
+        if (EqualsIgnoringCase(m_specInfo.m_name, "sky")) {
+            m_scan[m_scanNum].SetSkySpecInfo(m_specInfo);
+        }
+        else if (EqualsIgnoringCase(m_specInfo.m_name, "dark")) {
+            m_scan[m_scanNum].SetDarkSpecInfo(m_specInfo);
+        }
+        else if (EqualsIgnoringCase(m_specInfo.m_name, "offset")) {
+            m_scan[m_scanNum].SetOffsetSpecInfo(m_specInfo);
+        }
+        else if (EqualsIgnoringCase(m_specInfo.m_name, "dark_cur")) {
+            m_scan[m_scanNum].SetDarkCurrentSpecInfo(m_specInfo);
+        }
+        else {
+            m_scan[m_scanNum].AppendResult(m_evResult, m_specInfo);
+            m_scan[m_scanNum].SetFlux(flux);
+        }
+
+        double dynamicRange = 1.0; // <-- unknown
+        if (m_col.peakSaturation != -1) { // If the intensity is specified as a saturation ratio...
+            dynamicRange = CSpectrometerDatabase::GetInstance().GetModel(m_specInfo.m_specModelName).maximumIntensity;
+        }
+        m_scan[m_scanNum].CheckGoodnessOfFit(m_specInfo);
+        ++measNr;
     }
-    singleLock.Unlock();
 
     // If the sky and dark were specified, remove them from the measurement
-    if (m_scanNum >= 0 && fabs(m_scan[sortOrder[m_scanNum]].GetScanAngle(1) - 180.0) < 1) {
-        m_scan[sortOrder[m_scanNum]].RemoveResult(0); // remove sky
-        m_scan[sortOrder[m_scanNum]].RemoveResult(0); // remove dark
+    if (m_scanNum >= 0 && fabs(m_scan[m_scanNum].GetScanAngle(1) - 180.0) < 1) {
+        m_scan[m_scanNum].RemoveResult(0); // remove sky
+        m_scan[m_scanNum].RemoveResult(0); // remove dark
     }
 
     // Calculate the offset
     if (m_scanNum >= 0) {
-        m_scan[sortOrder[m_scanNum]].CalculateOffset(m_evResult.m_referenceResult[0].m_specieName);
+        m_scan[m_scanNum].CalculateOffset(m_evResult.m_referenceResult[0].m_specieName);
     }
 
     // make sure that scan num is correct
     ++m_scanNum;
 
+    if (m_scanNum <= 0) {
+        // Nothing has been appended since the given position, this is not an error
+        if (startPosition > 0) {
+            m_scanNum = 0;
+            return SUCCESS;
+        }
+        MessageBox(NULL, "No scans found in file", "No scans", MB_OK);
+        return FAIL;
+    }
+
     // Sort the scans in order of collection
-//	SortScans();
+    SortScansByStartTime(scanStartTimes, scanHasStartTime);
 
     return SUCCESS;
 }
 
-/** Makes a quick scan through the evaluation-log
-    to count the number of scans in it */
-long CEvaluationLogFileHandler::CountScansInFile() {
-    char  expTimeStr[] = _T("exposuretime"); // this string only exists in the header line.
-    char szLine[8192];
-    long  nScans = 0;
+/** Sorts the first m_scanNum scans, and their wind fields, in order of the given start times.
+    The scans without a start time keep their place in the file. */
+void CEvaluationLogFileHandler::SortScansByStartTime(std::vector<CDateTime> &scanStartTimes, std::vector<bool> &scanHasStartTime) {
+    scanStartTimes.resize(m_scanNum);
+    scanHasStartTime.resize(m_scanNum, false);
 
-    // If no evaluation log selected, quit
-    if (strlen(m_evaluationLog) <= 1)
-        return 0;
+    // Only the scans with a start time are sorted, among the places which they have in the file
+    std::vector<unsigned int> places;
+    std::vector<CDateTime> startTimes;
+    for (long k = 0; k < m_scanNum; ++k) {
+        if (scanHasStartTime[k]) {
+            places.push_back((unsigned int)k);
+            startTimes.push_back(scanStartTimes[k]);
+        }
+    }
 
-    CSingleLock singleLock(&g_evalLogCritSect);
-    singleLock.Lock();
-    if (singleLock.IsLocked()) {
+    std::vector<unsigned int> sortOrder;
+    if (FindSortOrder(startTimes, sortOrder)) {
+        return; // already in order
+    }
 
-        // Open the evaluation log
-        FILE *f = fopen(m_evaluationLog, "r");
-        if (NULL == f) {
-            singleLock.Unlock();
-            return 0;
-        }
+    std::vector<unsigned int> fileOrder((size_t)m_scanNum);
+    for (size_t k = 0; k < fileOrder.size(); ++k) {
+        fileOrder[k] = (unsigned int)k;
+    }
+    for (size_t k = 0; k < places.size(); ++k) {
+        fileOrder[places[k]] = places[sortOrder[k]];
+    }
 
-        // Read the file, one line at a time
-        while (fgets(szLine, 8192, f)) {
-            // convert the string to all lower-case letters
-            for (unsigned int it = 0; it < strlen(szLine); ++it) {
-                szLine[it] = tolower(szLine[it]);
-            }
+    MoveToSortOrder(m_scan, fileOrder);
+    MoveToSortOrder(m_windField, fileOrder);
+}
 
-            // find the next start of a scan 
-            if (NULL != strstr(szLine, expTimeStr)) {
-                ++nScans;
-            }
-        }
+bool CEvaluationLogFileHandler::FindSortOrder(const std::vector<CDateTime> &startTimes, std::vector<unsigned int> &sortOrder, bool ascending) {
+    sortOrder.clear();
 
-        fclose(f);
+    // In the most common case the scans are already in order, which we can check in one go.
+    bool isSorted = true;
+    for (size_t k = 1; k < startTimes.size() && isSorted; ++k) {
+        isSorted = ascending ? !(startTimes[k] < startTimes[k - 1]) : !(startTimes[k - 1] < startTimes[k]);
+    }
+    if (isSorted) {
+        return true;
+    }
 
+    // Sort the indices of the start times, the scans with the same start time keep their order
+    sortOrder.resize(startTimes.size());
+    for (size_t k = 0; k < startTimes.size(); ++k) {
+        sortOrder[k] = (unsigned int)k;
     }
-    singleLock.Unlock();
+    std::stable_sort(begin(sortOrder), end(sortOrder), [&](unsigned int first, unsigned int second) {
+        return ascending ? (startTimes[first] < startTimes[second]) : (startTimes[second] < startTimes[first]);
+    });
 
-    // Return the number of scans found in the file
-    return nScans;
+    return false;
+}
+
+bool CEvaluationLogFileHandler::CLogBuffer::Read(const CString &fileName, long long startPosition, long long size) {
+    m_data.clear();
+    m_position = 0;
+
+    FILE *f = fopen(fileName, "rb");
+    if (NULL == f) {
+        return false;
+    }
+    if (startPosition > 0) {
+        _fseeki64(f, startPosition, SEEK_SET);
+    }
+
+    // the extra byte makes sure that the last line is always null-terminated
+    m_data.resize((size_t)(size - startPosition) + 1);
+    const size_t bytesRead = fread(m_data.data(), 1, (size_t)(size - startPosition), f);
+    fclose(f);
+
+    m_data.resize(bytesRead + 1);
+    m_data[bytesRead] = '\0';
+    return true;
+}
+
+char *CEvaluationLogFileHandler::CLogBuffer::NextLine(size_t &length) {
+    if (m_data.empty() || m_position + 1 >= m_data.size()) {
+        length = 0;
+        return NULL;
+    }
+    const size_t end = m_data.size() - 1; // the position of the terminating null-character
+
+    char *line = m_data.data() + m_position;
+    const char *lineBreak = (const char *)memchr(line, '\n', end - m_position);
+    size_t lineEnd = (lineBreak != NULL) ? (size_t)(lineBreak - m_data.data()) : end;
+    m_position = (lineBreak != NULL) ? lineEnd + 1 : end;
+
+    // remove the line-break and terminate the line
+    if (lineEnd > (size_t)(line - m_data.data()) && m_data[lineEnd - 1] == '\r') {
+        --lineEnd;
+    }
+    m_data[lineEnd] = '\0';
+
+    length = lineEnd - (size_t)(line - m_data.data());
+    return line;
 }
 
 /** Makes a quick scan through the evaluation-log
-    to get the start-times of each scan.
-    @return the number of scans in the file */
-long CEvaluationLogFileHandler::GetScanStartTimes(CArray<CDateTime*, CDateTime*> &array) {
-    char  scanInfoStart[] = _T("<scaninformation>"); // this string indicates the beginning of a 'scanInformation' section
-    char  scanInfoStop[] = _T("</scaninformation>"); // this string indicates the beginning of a 'scanInformation' section
+    to count the number of scans in it */
+long CEvaluationLogFileHandler::CountScansInFile() {
+    char  expTimeStr[] = _T("exposuretime"); // this string only exists in the header line.
     char szLine[8192];
     long  nScans = 0;
-    char *pt = NULL;
-    bool inScanInfoSection = false;
-    CDateTime scanStartTime;
-    int tmpInt[3];
-    bool foundDate = false, foundTime = false;
 
     // If no evaluation log selected, quit
     if (strlen(m_evaluationLog) <= 1)
@@ -694,47 +762,19 @@ long CEvaluationLogFileHandler::GetScanStartTimes(CArray<CDateTime*, CDateTime*>
         // Read the file, one line at a time
         while (fgets(szLine, 8192, f)) {
             // convert the string to all lower-case letters
-            for (unsigned int it = 0; it < strlen(szLine); ++it) {
-                szLine[it] = tolower(szLine[it]);
+            const size_t lineLength = strlen(szLine);
+            for (size_t it = 0; it < lineLength; ++it) {
+                szLine[it] = (char)tolower(szLine[it]);
             }
 
             // find the next start of a scan 
-            if (NULL != strstr(szLine, scanInfoStart)) {
-                inScanInfoSection = true;
-            }
-
-            if (NULL != strstr(szLine, scanInfoStop)) {
-                if (foundDate && foundTime) {
-                    array.SetAtGrow(nScans, new CDateTime(scanStartTime));
-                }
-                inScanInfoSection = false;
-                foundDate = false;
-                foundTime = false;
+            if (NULL != strstr(szLine, expTimeStr)) {
                 ++nScans;
             }
-
-            if (inScanInfoSection) {
-                if (pt = strstr(szLine, "date=")) {
-                    if (3 == sscanf(pt + 5, "%d.%d.%d", &tmpInt[0], &tmpInt[1], &tmpInt[2])) {
-                        scanStartTime.day = tmpInt[0];
-                        scanStartTime.month = tmpInt[1];
-                        scanStartTime.year = tmpInt[2];
-                        foundDate = true;
-                        continue;
-                    }
-                }
-                if (pt = strstr(szLine, "starttime=")) {
-                    if (3 == sscanf(pt + 10, "%d:%d:%d", &tmpInt[0], &tmpInt[1], &tmpInt[2])) {
-                        scanStartTime.hour = tmpInt[0];
-                        scanStartTime.minute = tmpInt[1];
-                        scanStartTime.second = tmpInt[2];
-                        foundTime = true;
-                    }
-                    continue;
-                }
-            }
         }
+
         fclose(f);
+
     }
     singleLock.Unlock();
 
@@ -743,8 +783,9 @@ long CEvaluationLogFileHandler::GetScanStartTimes(CArray<CDateTime*, CDateTime*>
 }
 
 /** Reads and parses the 'scanInfo' header before the scan */
-void CEvaluationLogFileHandler::ParseScanInformation(CSpectrumInfo &scanInfo, double &flux, FILE *f) {
-    char szLine[8192];
+void CEvaluationLogFileHandler::ParseScanInformation(CSpectrumInfo &scanInfo, double &flux, CLogBuffer &buffer) {
+    char *szLine = NULL;
+    size_t lineLength = 0;
     char *pt = NULL;
     int tmpInt[3];
     double tmpDouble;
@@ -754,11 +795,11 @@ void CEvaluationLogFileHandler::ParseScanInformation(CSpectrumInfo &scanInfo, do
     ResetScanInformation();
 
     // read the additional scan-information, line by line
-    while (fgets(szLine, 8192, f)) {
+    while (NULL != (szLine = buffer.NextLine(lineLength))) {
 
         // convert to lower-case
-        for (unsigned int it = 0; it < strlen(szLine); ++it) {
-            szLine[it] = tolower(szLine[it]);
+        for (size_t it = 0; it < lineLength; ++it) {
+            szLine[it] = (char)tolower(szLine[it]);
         }
 
         if (pt = strstr(szLine, "</scaninformation>")) {
@@ -887,8 +928,9 @@ void CEvaluationLogFileHandler::ParseScanInformation(CSpectrumInfo &scanInfo, do
     }
 }
 
-void CEvaluationLogFileHandler::ParseFluxInformation(CWindField &windField, double &flux, FILE *f) {
-    char szLine[8192];
+void CEvaluationLogFileHandler::ParseFluxInformation(CWindField &windField, double &flux, CLogBuffer &buffer) {
+    char *szLine = NULL;
+    size_t lineLength = 0;
     char *pt = NULL;
     double windSpeed = 10, windDirection = 0, plumeHeight = 1000;
     MET_SOURCE windSpeedSource = MET_USER;
@@ -897,7 +939,7 @@ void CEvaluationLogFileHandler::ParseFluxInformation(CWindField &windField, doub
     char source[512];
 
     // read the additional scan-information, line by line
-    while (fgets(szLine, 8192, f)) {
+    while (NULL != (szLine = buffer.NextLine(lineLength))) {
         if (pt = strstr(szLine, "</fluxinfo>")) {
             // save all the values
             windField.SetPlumeHeight(plumeHeight, plumeHeightSource);
@@ -1033,88 +1075,18 @@ void CEvaluationLogFileHandler::SortScans() {
     // make sure that the array is just big enough...
     m_scan.SetSize(m_scanNum);
 
-    // If the scans are already in order then we don't need to sort them
-    //	or if there is only one scan then we don't need to fix it.
-    if (IsSorted() || m_scanNum <= 1) {
+    // If there is only one scan then we don't need to sort anything
+    if (m_scanNum <= 1) {
         return;
     }
 
     // Then sort the array
-    //	CEvaluationLogFileHandler::SortScans(m_scan);
-    CEvaluationLogFileHandler::BubbleSortScans(m_scan);
+    CEvaluationLogFileHandler::SortScans(m_scan);
 
     return;
 }
 
 /** Returns true if the scans are already ordered */
-bool	CEvaluationLogFileHandler::IsSorted() {
-    CDateTime time1, time2;
-
-    for (int k = 0; k < m_scanNum - 1; ++k) {
-        // Get the start-times
-        m_scan[k].GetStartTime(0, time1);
-        m_scan[k + 1].GetStartTime(0, time2);
-
-        // If the second scan has started before the first, 
-        //	then change the order, otherwise don't do anything
-        if (time2 < time1) {
-            return false;
-        }
-        else {
-            continue;
-        }
-    }
-
-    return true; // no un-ordered scans were found
-}
-
-/** Sorts the CDateTime-objects in the given array.
-        Algorithm based on bubble sort (~O(N2)) */
-void CEvaluationLogFileHandler::SortScanStartTimes(CArray<CDateTime*, CDateTime*> &allStartTimes, CArray<unsigned int, unsigned int&> &sortOrder) {
-    bool change;
-    unsigned int k, tmpIndex;
-    unsigned int nElements = allStartTimes.GetSize();
-    CDateTime *tmpTime = NULL;
-    CArray<unsigned int, unsigned int&> tmpOrder;
-
-    if (nElements == 0)
-        return;
-
-    // fill up the sort-order array with the original indices
-    for (k = 0; k < nElements; ++k)
-        tmpOrder.SetAtGrow(k, k);
-
-    // Sort the start-times using bubble sort
-    do {
-        change = false;
-        for (k = 0; k < nElements - 1; ++k) {
-            // If the second scan has started before the first, 
-            //	then change the order, otherwise don't do anything
-            if (*allStartTimes[k + 1] < *allStartTimes[k]) {
-                tmpTime = allStartTimes[k];
-                tmpIndex = tmpOrder[k];
-
-                allStartTimes[k] = allStartTimes[k + 1];
-                tmpOrder[k] = tmpOrder[k + 1];
-
-                allStartTimes[k + 1] = tmpTime;
-                tmpOrder[k + 1] = tmpIndex;
-
-                change = true;
-            }
-            else {
-                continue;
-            }
-        }
-    } while (change);
-
-    // create the array sortOrder
-    for (k = 0; k < nElements; ++k)
-        sortOrder.SetAtGrow(tmpOrder[k], k);
-
-    return;
-}
-
 
 /** Writes the contents of the array 'm_scan' to a new evaluation-log file */
 RETURN_CODE CEvaluationLogFileHandler::WriteEvaluationLog(const CString fileName) {
@@ -1315,174 +1287,20 @@ RETURN_CODE CEvaluationLogFileHandler::FormatEvaluationResult(const CSpectrumInf
     return SUCCESS;
 }
 
-/** Sorts the CDateTime-objects in the given array.
-        Algorithm based on MergeSort (~O(NlogN)) */
 void FileHandler::CEvaluationLogFileHandler::SortScans(CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array, bool ascending) {
-    unsigned long nElements = (unsigned long)array.GetSize(); // number of elements
-    unsigned long it = 0; // <-- iterator
-    unsigned long halfSize = nElements / 2;
-
+    const size_t nElements = (size_t)array.GetSize();
     if (nElements <= 1) {
         return; // <-- We're actually already done
     }
-    else if (nElements <= 7) {
-        // For small lists, its much faster to do a bubble sorting of the 
-        //	list since this does not require so much copying back and forth
-        BubbleSortScans(array, ascending);
-        return;
-    }
-    else {
-        CArray <Evaluation::CScanResult, Evaluation::CScanResult&> left;
-        CArray <Evaluation::CScanResult, Evaluation::CScanResult&> right;
-        left.SetSize(halfSize);
-        right.SetSize(halfSize);
-
-        // Make two copies of the array, one of the first half and one of the second half
-        while (it < halfSize) {
-            left.SetAtGrow(it, array.GetAt(it));
-            ++it;
-        }
-        while (it < nElements) {
-            right.SetAtGrow(it - halfSize, array.GetAt(it));
-            ++it;
-        }
-
-        // Sort each of the two halves
-        SortScans(left, ascending);
-        SortScans(right, ascending);
-
-        // Merge the two...
-        MergeArrays(left, right, array, ascending);
-    }
-}
-
-/** Merges the two arrays in a sorted way and stores the
-        result in the output-array 'result' */
-void FileHandler::CEvaluationLogFileHandler::MergeArrays(CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array1, CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array2, CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &result, bool ascending) {
-    CDateTime	time1, time2;
-    unsigned long it1 = 0; // iterator for array1
-    unsigned long it2 = 0; // iterator for array2
-    unsigned long itr = 0; // iterator for result
-    unsigned long nE1 = (unsigned long)array1.GetSize();
-    unsigned long nE2 = (unsigned long)array2.GetSize();
-
-    // Clear the output-array
-    result.RemoveAll();
-    result.SetSize(nE1 + nE2); // we can just as well set the size of the array from the start
-
-    // 1. As long as there are elements in both arrays, do this
-    while (it1 < nE1 && it2 < nE2) {
-        // Get the times of the first and the second
-        array1.GetAt(it1).GetStartTime(0, time1);
-        array2.GetAt(it2).GetStartTime(0, time2);
-
-        // Compare the two start-times
-        if (time1 == time2) {
-            // if equal
-            result.SetAt(itr++, array1.GetAt(it1++));
-            continue;
-        }
-        else if (time1 < time2) {
-            // time1 < time2
-            if (ascending) {
-                result.SetAt(itr++, array1.GetAt(it1++));
-                continue;
-            }
-            else {
-                result.SetAt(itr++, array2.GetAt(it2++));
-                continue;
-            }
-        }
-        else {
-            // time1 > time2
-            if (ascending) {
-                result.SetAt(itr++, array2.GetAt(it2++));
-                continue;
-            }
-            else {
-                result.SetAt(itr++, array1.GetAt(it1++));
-                continue;
-            }
-        }
-    }
 
-    // 2. If we're out of elements in array2 but not in array1, do this
-    while (it1 < nE1) {
-        result.SetAt(itr++, array1.GetAt(it1++));
-    }
-
-    // 3. If we're out of elements in array1 but not in array2, do this
-    while (it2 < nE2) {
-        result.SetAt(itr++, array2.GetAt(it2++));
-    }
-}
-
-/** Sorts the CScanResult-objects in the given array.
-        Algorithm based on BubbleSort (~O(N2))
-        Quite efficient for small arrays since the elements does not have to be copied
-            and thus uses very little memory */
-void FileHandler::CEvaluationLogFileHandler::BubbleSortScans(CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array, bool ascending) {
-    CDateTime time1, time2;
-    bool change;
-    unsigned long nElements = (unsigned long)array.GetSize(); // number of elements
-    unsigned int k;
-    CDateTime tmpTime;
-    int tmpIndex;
-    CArray<Evaluation::CScanResult, Evaluation::CScanResult&> copiedArray;
-
-    // 1. Find the start-time of all the scans
-    CDateTime *allStartTimes = new CDateTime[nElements];
-    unsigned int *sortOrder = new unsigned int[nElements];
-    for (k = 0; k < nElements; ++k) {
+    // Sort the start-times and then move the scans into their place
+    std::vector<CDateTime> allStartTimes(nElements);
+    for (size_t k = 0; k < nElements; ++k) {
         array[k].GetStartTime(0, allStartTimes[k]);
-        sortOrder[k] = k;
     }
 
-    // 2. Sort the start-times using bubble sort
-    do {
-        change = false;
-        for (k = 0; k < nElements - 1; ++k) {
-            // If the second scan has started before the first, 
-            //	then change the order, otherwise don't do anything
-            if (allStartTimes[k + 1] < allStartTimes[k]) {
-                tmpTime = allStartTimes[k];
-                tmpIndex = sortOrder[k];
-
-                allStartTimes[k] = allStartTimes[k + 1];
-                sortOrder[k] = sortOrder[k + 1];
-
-                allStartTimes[k + 1] = tmpTime;
-                sortOrder[k + 1] = tmpIndex;
-
-                change = true;
-            }
-            else {
-                continue;
-            }
-        }
-    } while (change);
-
-    // 3. Sort the array using the indices found in 'sortOrder'
-
-    // 3a. Copy all items to a backup-list
-    copiedArray.SetSize(nElements);
-    for (k = 0; k < nElements; ++k) {
-        if (sortOrder[k] != k) {
-            copiedArray[k] = array[k];
-        }
-    }
-
-    // 3b. Put the items back in the correct order
-    for (k = 0; k < nElements; ++k) {
-        if (sortOrder[k] != k) {
-            array[k] = copiedArray[sortOrder[k]];
-        }
+    std::vector<unsigned int> sortOrder;
+    if (!FindSortOrder(allStartTimes, sortOrder, ascending)) {
+        MoveToSortOrder(array, sortOrder);
     }
-
-    // 4. Clean up!
-    copiedArray.RemoveAll();
-    delete[] allStartTimes;
-    delete[] sortOrder;
-
-    return;
-}
\ No newline at end of file
+}
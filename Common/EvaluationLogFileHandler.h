@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "Common.h"
 #include "../Evaluation/ScanResult.h"
 #include "../Meteorology/WindField.h"
@@ -22,8 +23,12 @@ namespace FileHandler
 
 		// ------------------- PUBLIC METHODS -------------------------
 
-		/** Reads the evaluation log */
-		RETURN_CODE ReadEvaluationLog();
+		/** Reads the evaluation log.
+			@param startPosition - the position in the file, in bytes, where reading starts.
+				This must be the start of a scan, e.g. the size of the file at an earlier time,
+				only the scans written after that are then read. If nothing has been written after
+				a 'startPosition' larger than zero then this succeeds with 'm_scanNum' zero. */
+		RETURN_CODE ReadEvaluationLog(long long startPosition = 0);
 
 		/** Writes the contents of the array 'm_scan' to a new evaluation-log file */
 		RETURN_CODE WriteEvaluationLog(const CString fileName);
@@ -50,6 +55,13 @@ namespace FileHandler
 		/** How many scans that have been read from the evaluation log */
 		long  m_scanNum;
 
+		/** The position in the file, in bytes, up to which the last call to ReadEvaluationLog read.
+			Passing this as the startPosition of the next call reads only the scans written since. */
+		long long m_endPosition;
+
+		/** The last time the file was written, measured together with 'm_endPosition' */
+		__time64_t m_endWriteTime;
+
 		/** The species that were found in this evaluation log */
 		CString m_specie[20];
 
@@ -94,14 +106,33 @@ namespace FileHandler
 		Evaluation::CEvaluationResult m_evResult;
 
 		/** Reads the header line for the scan information and retrieves which 
-			column represents which value. */
-		void ParseScanHeader(const char szLine[8192]);
+			column represents which value. The line is split up in place. */
+		void ParseScanHeader(char *szLine);
+
+		/** The contents of an evaluation log which has been read into memory.
+			The lines are split up and terminated in place, without being copied. */
+		class CLogBuffer
+		{
+		public:
+			/** Reads the bytes from 'startPosition' up to 'size' of the given file.
+				@return false if the file could not be opened. */
+			bool Read(const CString &fileName, long long startPosition, long long size);
+
+			/** @return the next line, null-terminated and without the line-break.
+				@param length - will on return be filled with the length of the line.
+				@return NULL if there are no more lines. */
+			char *NextLine(size_t &length);
+
+		private:
+			std::vector<char> m_data;
+			size_t m_position = 0;
+		};
 
 		/** Reads and parses the XML-shaped 'scanInfo' header before the scan */
-		void ParseScanInformation(CSpectrumInfo &scanInfo, double &flux, FILE *f);
+		void ParseScanInformation(CSpectrumInfo &scanInfo, double &flux, CLogBuffer &buffer);
 
 		/** Reads and parses the XML-shaped 'fluxInfo' header before the scan */
-		void ParseFluxInformation(CWindField &windField, double &flux, FILE *f);
+		void ParseFluxInformation(CWindField &windField, double &flux, CLogBuffer &buffer);
 
 		/** Resets the information about which column data is stored in */
 		void ResetColumns();
@@ -113,33 +144,37 @@ namespace FileHandler
 			to count the number of scans in it */
 		long CountScansInFile();
 
-		/** Makes a quick scan through the evaluation-log 
-			to get the start-times of each scan.
-			@return the number of scans in the file */
-		long GetScanStartTimes(CArray<CDateTime*, CDateTime*> &array);
-
 		/** Sorts the scans in order of collection */
 		void SortScans();
 
-		/** Returns true if the scans are already ordered */
-		bool IsSorted();
-
-		/** Sorts the CDateTime-objects in the given array.
-				Algorithm based on bubble sort (~O(NlogN)) */
-		void SortScanStartTimes(CArray<CDateTime*, CDateTime*> &array, CArray<unsigned int, unsigned int&> &sortOrder);
-
-		/** Sorts the CScanResult-objects in the given array.
-				Algorithm based on MergeSort (~O(NlogN)) */
+		/** Sorts the first 'm_scanNum' scans, and their wind fields, in order of the given start times.
+				The scans for which 'scanHasStartTime' is false keep their place in the file. */
+		void SortScansByStartTime(std::vector<CDateTime> &scanStartTimes, std::vector<bool> &scanHasStartTime);
+
+		/** Finds the order in which the given start times should be sorted.
+				@param sortOrder - will on return be filled with the index of the start time which should
+					be placed in each position, i.e. sortOrder[k] is the index of the k:th start time in order.
+					Left empty if the start times already are in order.
+				@return true if the start times already are in order. */
+		static bool FindSortOrder(const std::vector<CDateTime> &startTimes, std::vector<unsigned int> &sortOrder, bool ascending = true);
+
+		/** Moves the elements of the given array into the order given by 'sortOrder',
+				as returned from FindSortOrder. Each element is moved once, not copied. */
+		template<class TYPE, class ARG_TYPE>
+		static void MoveToSortOrder(CArray<TYPE, ARG_TYPE> &array, const std::vector<unsigned int> &sortOrder) {
+			std::vector<TYPE> sorted;
+			sorted.reserve(sortOrder.size());
+			for (unsigned int index : sortOrder) {
+				sorted.push_back(std::move(array[index]));
+			}
+			for (size_t k = 0; k < sorted.size(); ++k) {
+				array[k] = std::move(sorted[k]);
+			}
+		}
+
+		/** Sorts the CScanResult-objects in the given array by their start times.
+				The already sorted case is detected in one pass, otherwise an index sort (~O(NlogN))
+				is made and each scan is moved once to its place. */
 		static void SortScans(CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array, bool ascending = true);
-
-		/** Sorts the CScanResult-objects in the given array.
-				Algorithm based on BubbleSort (~O(N2))
-				Quite efficient for small arrays since the elements does not have to be copied
-					and thus uses very little memory */
-		static void BubbleSortScans(CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array, bool ascending = true);
-
-		/** Merges the two arrays in a sorted way and stores the
-				result in the output-array 'result' */
-		static void MergeArrays(CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array1, CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &array2, CArray<Evaluation::CScanResult, Evaluation::CScanResult&> &result, bool ascending = true);
 	};
 }
\ No newline at end of file
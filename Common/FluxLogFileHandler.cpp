@@ -1,11 +1,21 @@
 #include "StdAfx.h"
 #include "fluxlogfilehandler.h"
 
+// Include synchronization classes
+#include <afxmt.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// Global variables;
+extern CCriticalSection g_evalLogCritSect; // synchronization access to evaluation-log files
+
 using namespace FileHandler;
 
 CFluxLogFileHandler::CFluxLogFileHandler(void)
 {
 	m_fluxesNum = 0;
+	m_endPosition = 0;
 }
 
 CFluxLogFileHandler::~CFluxLogFileHandler(void)
@@ -13,7 +23,7 @@ CFluxLogFileHandler::~CFluxLogFileHandler(void)
 }
 
 /** Reads the flux log */
-RETURN_CODE CFluxLogFileHandler::ReadFluxLog(){
+RETURN_CODE CFluxLogFileHandler::ReadFluxLog(long long startPosition){
 	char  scanstarttime[]				= _T("scanstarttime");						// this string only exists in the header line.
 	CString str;
 	char szLine[8192];
@@ -31,13 +41,35 @@ RETURN_CODE CFluxLogFileHandler::ReadFluxLog(){
 	if(strlen(m_fluxLog) <= 1)
 		return FAIL;
 
-	// Open the flux log
-	FILE *f = fopen(m_fluxLog, "r");
+	// Find out how much of the file has been written. The fluxes are appended one whole line
+	//	at a time while holding the lock, so everything up to this length can be read.
+	long long fileSize = -1;
+	CSingleLock singleLock(&g_evalLogCritSect);
+	singleLock.Lock();
+	if(singleLock.IsLocked()){
+		struct __stat64 fileStatus;
+		if(0 == _stat64(m_fluxLog, &fileStatus)){
+			fileSize = fileStatus.st_size;
+		}
+		singleLock.Unlock();
+	}
+	if(fileSize < 0)
+		return FAIL;
+
+	// Open the flux log. This is opened in binary mode such that the position
+	//	in the file can be compared to its size
+	FILE *f = fopen(m_fluxLog, "rb");
 	if(NULL == f)
 		return FAIL;
 
-	// Reset the column info
-	ResetColumns();
+	if(startPosition > 0 && startPosition <= fileSize){
+		// Continue after the fluxes read before, with the columns of the header read then
+		_fseeki64(f, startPosition, SEEK_SET);
+		fReadingScan = true;
+	}else{
+		// Reset the column info
+		ResetColumns();
+	}
 
 	// Reset the data
 	this->m_fluxes.RemoveAll();
@@ -45,7 +77,14 @@ RETURN_CODE CFluxLogFileHandler::ReadFluxLog(){
 	this->m_fluxesNum = 0;
 
 	// Read the file, one line at a time
-	while(fgets(szLine, 8192, f)){
+	while(_ftelli64(f) < fileSize && fgets(szLine, 8192, f)){
+
+		// treat a windows line-break as a single line-break
+		size_t length = strlen(szLine);
+		if(length >= 2 && szLine[length - 2] == '\r' && szLine[length - 1] == '\n'){
+			szLine[length - 2] = '\n';
+			szLine[length - 1] = '\0';
+		}
 
 		// ignore empty lines
 		if(strlen(szLine) < 2){
@@ -273,6 +312,8 @@ RETURN_CODE CFluxLogFileHandler::ReadFluxLog(){
 
     fclose(f);
 
+	m_endPosition = fileSize;
+
 	return SUCCESS;
 }
 
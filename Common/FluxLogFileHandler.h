@@ -20,8 +20,12 @@ namespace FileHandler
 
 		// ------------------- PUBLIC METHODS -------------------------
 
-		/** Reads the flux log */
-		RETURN_CODE ReadFluxLog();
+		/** Reads the flux log.
+			@param startPosition - the position in the file, in bytes, where reading starts.
+				If this is not zero, then it must be the m_endPosition of an earlier call
+				with this object, such that the header of the log has already been read.
+				Only the fluxes written after that are then read. */
+		RETURN_CODE ReadFluxLog(long long startPosition = 0);
 
 		// ------------------- PUBLIC DATA -------------------------
 
@@ -34,6 +38,9 @@ namespace FileHandler
 		/** How many fluxes have been read in */
 		int	m_fluxesNum;
 
+		/** The position in the file, in bytes, up to which the last call to ReadFluxLog read */
+		long long m_endPosition;
+
 	protected:
 		// ------------------- PROTECTED DATA -------------------------
 
@@ -1,8 +1,11 @@
 #include "StdAfx.h"
 #include "logfilewriter.h"
+#include "BufferedLogWriter.h"
 
 using namespace FileHandler;
 
+extern CBufferedLogWriter g_logFiles; // <-- the open log files
+
 CLogFileWriter::CLogFileWriter(void)
 {
 }
@@ -87,33 +90,26 @@ int CLogFileWriter::WriteResultMessage(const CString &text, unsigned int resultL
 
 int CLogFileWriter::WriteToFile(const CString &str, const int file, bool timeStamp) const
 {
-	static CString newLine = TEXT("\n");
-
-	FILE *f = NULL;
+	const CString *fileName = NULL;
 	switch(file){
-		case ERROR_LOG:		
-			f = fopen(m_errorFile,		 "a+"); break;
-		case RESULT_LOG1:
-			f = fopen(m_resultFile[0],		 "a+"); break;
-		case RESULT_LOG2:
-			f = fopen(m_resultFile[1],		 "a+"); break;
+		case ERROR_LOG:		fileName = &m_errorFile; break;
+		case RESULT_LOG1:	fileName = &m_resultFile[0]; break;
+		case RESULT_LOG2:	fileName = &m_resultFile[1]; break;
 		default: return 1;
 	}
-	if(f == NULL)
-		return 1;
 
+	// the whole line is appended at once, the file is kept open by g_logFiles.
+	//	The messages are written to disk at once, such that they are not lost if the program stops
+	CString line;
 	if(timeStamp){
-		CString time;
-		Common::GetTimeText(time);
-		fprintf(f, time);
-		fprintf(f, TEXT("\t"));
+		Common::GetTimeText(line);
+		line.Append(TEXT("\t"));
 	}
-	int ret = fprintf(f, str);
-	fprintf(f, "\n"); // add a new-line character
-
-	fclose(f);
+	line.Append(str);
+	line.Append(TEXT("\n")); // add a new-line character
 
-	return (ret >= 0);
+	// 1 when the line has been written, 0 if the file could not be opened
+	return g_logFiles.Append(*fileName, line, nullptr, true) ? 1 : 0;
 }
 
 /** Common handler to create the first, comment, line in the newly created file.
@@ -0,0 +1,193 @@
+#include "StdAfx.h"
+#include "LogTail.h"
+#include "EvaluationLogFileHandler.h"
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace FileHandler;
+
+std::shared_ptr<const CEvaluationLogView> CLogTail::FollowEvaluationLog(const CString &fileName)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    CFollowedLog &log = Find(fileName);
+    std::shared_ptr<const CEvaluationLogView> oldView = log.evaluationLog;
+
+    long long fileSize = 0;
+    __time64_t lastWriteTime = 0;
+    if (!GetFileStatus(fileName, fileSize, lastWriteTime))
+    {
+        return nullptr;
+    }
+
+    if (oldView != nullptr)
+    {
+        // Nothing has been appended since the log was last read. The size is compared on its own since
+        //  the log may have been touched without growing, and there are then no new scans to read.
+        if (fileSize == oldView->m_endPosition)
+        {
+            return oldView;
+        }
+
+        // A log which has been replaced is read from the start
+        if (0 == UsablePosition(fileName, oldView->m_endPosition, log.evaluationLogState, fileSize, lastWriteTime))
+        {
+            oldView.reset();
+        }
+    }
+
+    CEvaluationLogFileHandler reader;
+    reader.m_evaluationLog.Format("%s", (LPCSTR)fileName);
+    if (SUCCESS != reader.ReadEvaluationLog((oldView != nullptr) ? oldView->m_endPosition : 0))
+    {
+        return oldView;
+    }
+
+    std::shared_ptr<CEvaluationLogView> newView = (oldView != nullptr) ? std::make_shared<CEvaluationLogView>(*oldView) : std::make_shared<CEvaluationLogView>();
+    newView->m_scans.reserve(newView->m_scans.size() + reader.m_scanNum);
+    for (long k = 0; k < reader.m_scanNum; ++k)
+    {
+        std::shared_ptr<CFollowedScan> scan = std::make_shared<CFollowedScan>();
+        scan->scan = std::move(reader.m_scan[k]);
+        scan->windField = reader.m_windField[k];
+        newView->m_scans.push_back(scan);
+    }
+    newView->m_specInfo = reader.m_specInfo;
+    newView->m_endPosition = reader.m_endPosition;
+
+    // The time the log was last written is the one measured together with the size read,
+    //  the log may have been written again since 'lastWriteTime' was measured
+    log.evaluationLog = newView;
+    log.evaluationLogState = ReadFileState(fileName, newView->m_endPosition, reader.m_endWriteTime);
+    return newView;
+}
+
+std::shared_ptr<const CFluxLogView> CLogTail::FollowFluxLog(const CString &fileName)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    CFollowedLog &log = Find(fileName);
+    std::shared_ptr<const CFluxLogView> oldView = log.fluxLog;
+
+    long long fileSize = 0;
+    __time64_t lastWriteTime = 0;
+    if (!GetFileStatus(fileName, fileSize, lastWriteTime))
+    {
+        return nullptr;
+    }
+
+    // Nothing has been appended since the log was last read
+    if (oldView != nullptr && fileSize == oldView->m_endPosition)
+    {
+        return oldView;
+    }
+
+    // A log which has not been read before, or which has been replaced, is read from the start with a new reader
+    if (oldView == nullptr || log.fluxLogReader == nullptr || 0 == UsablePosition(fileName, oldView->m_endPosition, log.fluxLogState, fileSize, lastWriteTime))
+    {
+        oldView.reset();
+        log.fluxLogReader.reset(new CFluxLogFileHandler());
+        log.fluxLogReader->m_fluxLog.Format("%s", (LPCSTR)fileName);
+    }
+
+    CFluxLogFileHandler &reader = *log.fluxLogReader;
+    if (SUCCESS != reader.ReadFluxLog((oldView != nullptr) ? oldView->m_endPosition : 0))
+    {
+        return oldView;
+    }
+
+    std::shared_ptr<CFluxLogView> newView = (oldView != nullptr) ? std::make_shared<CFluxLogView>(*oldView) : std::make_shared<CFluxLogView>();
+    for (int k = 0; k < reader.m_fluxesNum; ++k)
+    {
+        newView->m_fluxes.push_back(reader.m_fluxes[k]);
+        newView->m_scanInfo.push_back(reader.m_scanInfo[k]);
+    }
+    newView->m_endPosition = reader.m_endPosition;
+
+    log.fluxLog = newView;
+    log.fluxLogState = ReadFileState(fileName, newView->m_endPosition, lastWriteTime);
+    return newView;
+}
+
+void CLogTail::Clear()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    m_logs.clear();
+}
+
+CLogTail::CFollowedLog &CLogTail::Find(const CString &fileName)
+{
+    CString key(fileName);
+    key.MakeLower();
+
+    auto it = m_logs.find(key);
+    if (it == m_logs.end())
+    {
+        // Forget the least recently used log if there are too many logs followed
+        if (m_logs.size() >= MAX_FOLLOWED_LOGS)
+        {
+            auto oldest = std::min_element(m_logs.begin(), m_logs.end(),
+                [](const std::pair<const CString, CFollowedLog> &first, const std::pair<const CString, CFollowedLog> &second) { return first.second.lastUsed < second.second.lastUsed; });
+            m_logs.erase(oldest);
+        }
+
+        it = m_logs.emplace(key, CFollowedLog()).first;
+    }
+
+    it->second.lastUsed = ++m_useCounter;
+    return it->second;
+}
+
+bool CLogTail::GetFileStatus(const CString &fileName, long long &size, __time64_t &lastWriteTime)
+{
+    struct __stat64 fileStatus;
+    if (0 != _stat64(fileName, &fileStatus))
+    {
+        return false;
+    }
+    size = (long long)fileStatus.st_size;
+    lastWriteTime = fileStatus.st_mtime;
+    return true;
+}
+
+long long CLogTail::UsablePosition(const CString &fileName, long long endPosition, const CFileState &state, long long size, __time64_t lastWriteTime)
+{
+    // A log which is smaller than when it was last read has been replaced
+    if (size < endPosition)
+    {
+        return 0;
+    }
+
+    // A log which has not been written since it was read is unchanged
+    if (lastWriteTime == state.lastWriteTime)
+    {
+        return endPosition;
+    }
+
+    // The log has been written. If it was only appended to then the bytes last read are still there
+    const CFileState current = ReadFileState(fileName, endPosition, lastWriteTime);
+    return (current.lastBytes == state.lastBytes) ? endPosition : 0;
+}
+
+CLogTail::CFileState CLogTail::ReadFileState(const CString &fileName, long long endPosition, __time64_t lastWriteTime)
+{
+    CFileState state;
+    state.lastWriteTime = lastWriteTime;
+
+    const long long start = std::max(0LL, endPosition - (long long)COMPARED_BYTES);
+    FILE *f = fopen(fileName, "rb");
+    if (f == nullptr)
+    {
+        return state;
+    }
+    if (0 == _fseeki64(f, start, SEEK_SET))
+    {
+        state.lastBytes.resize((size_t)(endPosition - start));
+        state.lastBytes.resize(fread(&state.lastBytes[0], 1, state.lastBytes.size(), f));
+    }
+    fclose(f);
+
+    return state;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Common.h"
+#include "FluxLogFileHandler.h"
+#include "../Evaluation/ScanResult.h"
+#include "../Meteorology/WindField.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace FileHandler
+{
+    /** One scan read from an evaluation log, together with the wind field used to calculate its flux */
+    struct CFollowedScan
+    {
+        Evaluation::CScanResult scan;
+        CWindField windField;
+    };
+
+    /** The scans read so far from one evaluation log.
+        A view is never changed once it has been handed out. The scans appended to the log
+        later are added to a new view, which shares the scans already read with this one. */
+    class CEvaluationLogView
+    {
+    public:
+        /** The scans, in the order they were appended to the log */
+        std::vector<std::shared_ptr<const CFollowedScan>> m_scans;
+
+        /** The information of the last spectrum read from the log, as CEvaluationLogFileHandler::m_specInfo */
+        CSpectrumInfo m_specInfo;
+
+        /** The position in the log, in bytes, up to which it has been read */
+        long long m_endPosition = 0;
+    };
+
+    /** The fluxes read so far from one flux log.
+        As the CEvaluationLogView, this is never changed once it has been handed out. */
+    class CFluxLogView
+    {
+    public:
+        /** The fluxes, in the order they were appended to the log */
+        std::vector<Evaluation::CFluxResult> m_fluxes;
+
+        /** The information of the instrument at the time of each flux */
+        std::vector<CSpectrumInfo> m_scanInfo;
+
+        /** The position in the log, in bytes, up to which it has been read */
+        long long m_endPosition = 0;
+    };
+
+    /** The <b>CLogTail</b> caches the evaluation logs and flux logs which are read by the program.
+        The position up to which each log has been read is remembered together with what was read.
+        A log which has not been written since is not read again, and a log which has been appended to
+        is only read from where it was last read. All readers of a log share the same parsed scans.
+
+        A log which has been replaced, e.g. the evaluation logs of single scans which are written
+        again with every scan, is read again from the start. A log has been replaced if it is smaller
+        than when it was last read, or if it has been written and the last bytes read are not the same any more.
+
+        The writers of the logs append whole scans while holding g_evalLogCritSect, so the size
+        of a log measured while holding the lock is always at the end of a scan.
+
+        At most MAX_FOLLOWED_LOGS logs are followed at the same time, the log which was least recently
+        asked for is forgotten when another one is needed. */
+    class CLogTail
+    {
+    public:
+        CLogTail() = default;
+
+        /** @return the scans in the given evaluation log, including those appended since the last call.
+            Null if the log could not be read. */
+        std::shared_ptr<const CEvaluationLogView> FollowEvaluationLog(const CString &fileName);
+
+        /** @return the fluxes in the given flux log, including those appended since the last call.
+            Null if the log could not be read. */
+        std::shared_ptr<const CFluxLogView> FollowFluxLog(const CString &fileName);
+
+        /** Forgets all the logs, e.g. when the date changes */
+        void Clear();
+
+        /** The maximum number of logs which are followed at the same time */
+        static const size_t MAX_FOLLOWED_LOGS = 32;
+
+    private:
+        CLogTail(const CLogTail&) = delete;
+        CLogTail& operator=(const CLogTail&) = delete;
+
+        /** What is remembered about a file when it is read, to tell if it has been changed since */
+        struct CFileState
+        {
+            /** The last time the file was written, zero if it has not been read */
+            __time64_t lastWriteTime = 0;
+
+            /** The last bytes read from the file, which are still there if the file has only been appended to */
+            std::string lastBytes;
+        };
+
+        /** The number of bytes at the end of what was read, which are compared to tell if a log was replaced */
+        static const size_t COMPARED_BYTES = 256;
+
+        /** One followed log */
+        struct CFollowedLog
+        {
+            std::shared_ptr<const CEvaluationLogView> evaluationLog;
+
+            std::shared_ptr<const CFluxLogView> fluxLog;
+
+            /** The reader of the flux log, which remembers the columns of the header of the log */
+            std::unique_ptr<CFluxLogFileHandler> fluxLogReader;
+
+            /** The state of the file when 'evaluationLog' and 'fluxLog' were read */
+            CFileState evaluationLogState;
+            CFileState fluxLogState;
+
+            /** Incremented on every use of any log, the log with the lowest value is forgotten first */
+            unsigned long long lastUsed = 0;
+        };
+
+        /** The followed logs, the key is the lower-case file name */
+        std::map<CString, CFollowedLog> m_logs;
+
+        unsigned long long m_useCounter = 0;
+
+        /** Protects all the members. This is held while a log is read, such that one log is never read twice at the same time. */
+        std::mutex m_mutex;
+
+        /** @return the followed log with the given name, which is created if it is not followed yet */
+        CFollowedLog &Find(const CString &fileName);
+
+        /** Gets the size and the last time the given file was written.
+            @return false if the file does not exist */
+        static bool GetFileStatus(const CString &fileName, long long &size, __time64_t &lastWriteTime);
+
+        /** Decides how much of the given log can be kept from when it was last read, up to 'endPosition'.
+            @return 'endPosition' if nothing has changed or the log has only been appended to,
+                zero if the log has been replaced and must be read from the start. */
+        static long long UsablePosition(const CString &fileName, long long endPosition, const CFileState &state, long long size, __time64_t lastWriteTime);
+
+        /** @return the state of the given file after it has been read up to 'endPosition' */
+        static CFileState ReadFileState(const CString &fileName, long long endPosition, __time64_t lastWriteTime);
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string.h>
+#include <type_traits>
+#include <vector>
+
+/** <b>CRingBuffer</b> is a fixed-capacity first-in-first-out buffer, used to store
+    time-series of values where the oldest values are removed as new ones arrive.
+    The values are stored in one contiguous array, appending a value and removing
+    the oldest values are constant-time operations which never moves the stored values.
+    The value type must be trivially copyable, the values are copied out with memcpy. */
+template<class T>
+class CRingBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "CRingBuffer can only hold trivially copyable values");
+
+public:
+    /** Creates a buffer which can hold at most 'capacity' values */
+    explicit CRingBuffer(size_t capacity)
+        : m_values(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    /** @return the maximum number of values which can be stored in the buffer */
+    size_t Capacity() const { return m_values.size(); }
+
+    /** @return the number of values in the buffer */
+    size_t Size() const { return m_size; }
+
+    /** @return true if there are no values in the buffer */
+    bool Empty() const { return m_size == 0; }
+
+    /** @return true if the buffer is full, the next appended value will then replace the oldest one */
+    bool Full() const { return m_size == m_values.size(); }
+
+    /** Removes all values from the buffer */
+    void Clear()
+    {
+        m_head = 0;
+        m_size = 0;
+    }
+
+    /** Appends the value to the end of the buffer. If the buffer is full
+        then the oldest value is removed. */
+    void PushBack(const T& value)
+    {
+        if (Full())
+        {
+            PopFront();
+        }
+        m_values[Position(m_size)] = value;
+        ++m_size;
+    }
+
+    /** Removes the 'number' oldest values from the buffer */
+    void PopFront(size_t number = 1)
+    {
+        if (number >= m_size)
+        {
+            Clear();
+            return;
+        }
+        m_head = Position(number);
+        m_size -= number;
+    }
+
+    /** @return the oldest value in the buffer. The buffer must not be empty */
+    const T& Front() const { return m_values[m_head]; }
+
+    /** @return the newest value in the buffer. The buffer must not be empty */
+    const T& Back() const { return m_values[Position(m_size - 1)]; }
+    T& Back() { return m_values[Position(m_size - 1)]; }
+
+    /** @return the value with the given index, counted from the oldest value in the buffer */
+    const T& operator[](size_t index) const { return m_values[Position(index)]; }
+    T& operator[](size_t index) { return m_values[Position(index)]; }
+
+    /** Copies the (at most) 'maxNumber' oldest values in the buffer to 'dest', in order.
+        This is at most two memcpy:s, one for each side of the wrap-around.
+        @return the number of values copied. */
+    size_t CopyTo(T* dest, size_t maxNumber) const
+    {
+        const size_t number = (maxNumber < m_size) ? maxNumber : m_size;
+        const size_t firstPart = (number < m_values.size() - m_head) ? number : (m_values.size() - m_head);
+
+        if (firstPart > 0)
+        {
+            memcpy(dest, m_values.data() + m_head, firstPart * sizeof(T));
+        }
+        if (number > firstPart)
+        {
+            memcpy(dest + firstPart, m_values.data(), (number - firstPart) * sizeof(T));
+        }
+        return number;
+    }
+
+private:
+    /** The stored values */
+    std::vector<T> m_values;
+
+    /** The position of the oldest value in 'm_values' */
+    size_t m_head = 0;
+
+    /** The number of values in the buffer */
+    size_t m_size = 0;
+
+    /** @return the position in 'm_values' of the value with the given index */
+    size_t Position(size_t index) const
+    {
+        const size_t position = m_head + index;
+        return (position < m_values.size()) ? position : (position - m_values.size());
+    }
+};
@@ -0,0 +1,145 @@
+#include "StdAfx.h"
+#include "SnapshotFile.h"
+
+using namespace FileHandler;
+
+CSnapshotWriter::~CSnapshotWriter()
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+        DeleteFile(m_fileName + ".tmp");
+    }
+}
+
+bool CSnapshotWriter::Open(const CString &fileName, const char identifier[8])
+{
+    m_fileName = fileName;
+    m_file = fopen(fileName + ".tmp", "wb");
+    if (m_file == nullptr)
+    {
+        return false;
+    }
+    m_ok = true;
+
+    Write(identifier, 8);
+    Write((int64_t)time(nullptr));
+    return m_ok;
+}
+
+bool CSnapshotWriter::Commit()
+{
+    if (m_file == nullptr)
+    {
+        return false;
+    }
+
+    m_ok = (0 == fclose(m_file)) && m_ok;
+    m_file = nullptr;
+
+    const CString temporaryFile = m_fileName + ".tmp";
+    if (!m_ok || !MoveFileEx(temporaryFile, m_fileName, MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFile(temporaryFile);
+        return false;
+    }
+    return true;
+}
+
+void CSnapshotWriter::Write(const void *data, size_t size)
+{
+    if (m_ok && size > 0)
+    {
+        m_ok = (1 == fwrite(data, size, 1, m_file));
+    }
+}
+
+void CSnapshotWriter::WriteString(const CString &str)
+{
+    Write((uint32_t)str.GetLength());
+    Write((LPCSTR)str, (size_t)str.GetLength());
+}
+
+void CSnapshotWriter::WriteTime(const CDateTime &time)
+{
+    const int16_t values[6] = { (int16_t)time.year, (int16_t)time.month, (int16_t)time.day, (int16_t)time.hour, (int16_t)time.minute, (int16_t)time.second };
+    Write(values);
+}
+
+bool CSnapshotReader::Open(const CString &fileName, const char identifier[8])
+{
+    m_data.clear();
+    m_position = 0;
+    m_ok = false;
+
+    FILE *f = fopen(fileName, "rb");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    _fseeki64(f, 0, SEEK_END);
+    const long long size = _ftelli64(f);
+    _fseeki64(f, 0, SEEK_SET);
+    if (size > 0)
+    {
+        m_data.resize((size_t)size);
+        m_data.resize(fread(m_data.data(), 1, m_data.size(), f));
+    }
+    fclose(f);
+
+    m_ok = true;
+    char fileIdentifier[8];
+    int64_t savedTime = 0;
+    if (!Read(fileIdentifier, sizeof(fileIdentifier)) || 0 != memcmp(fileIdentifier, identifier, sizeof(fileIdentifier)) || !Read(savedTime))
+    {
+        m_ok = false;
+        return false;
+    }
+    m_savedTime = (time_t)savedTime;
+    return true;
+}
+
+bool CSnapshotReader::Read(void *data, size_t size)
+{
+    if (!m_ok || size > m_data.size() - m_position)
+    {
+        m_ok = false;
+        return false;
+    }
+    if (size > 0)
+    {
+        memcpy(data, m_data.data() + m_position, size);
+        m_position += size;
+    }
+    return true;
+}
+
+bool CSnapshotReader::ReadString(CString &str)
+{
+    uint32_t length = 0;
+    if (!Read(length) || length > m_data.size() - m_position)
+    {
+        m_ok = false;
+        return false;
+    }
+    str = CString(m_data.data() + m_position, (int)length);
+    m_position += length;
+    return true;
+}
+
+bool CSnapshotReader::ReadTime(CDateTime &time)
+{
+    int16_t values[6];
+    if (!Read(values))
+    {
+        return false;
+    }
+    time.year = values[0];
+    time.month = values[1];
+    time.day = values[2];
+    time.hour = values[3];
+    time.minute = values[4];
+    time.second = values[5];
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <type_traits>
+#include <vector>
+#include "Common.h"
+#include "RingBuffer.h"
+#include <SpectralEvaluation/DateTime.h>
+
+namespace FileHandler
+{
+    /** The <b>CSnapshotWriter</b> writes a snapshot of the in-memory state of the program
+        to a compact binary file, such that the state can be restored when the program starts
+        instead of being rebuilt from the log files.
+        The file starts with an eight character identifier, which also holds the version of the
+        layout, followed by the time the snapshot was taken. The rest of the file is written by the
+        objects in the snapshot, in the order they are written, as raw values in the byte order of the machine.
+        The snapshot is written to a temporary file which replaces the old snapshot in Commit(), such
+        that a snapshot which is interrupted while being written never replaces a complete one. */
+    class CSnapshotWriter
+    {
+    public:
+        CSnapshotWriter() = default;
+        ~CSnapshotWriter();
+
+        /** Creates the temporary file and writes the identifier and the current time to it.
+            @return false if the file could not be created. */
+        bool Open(const CString &fileName, const char identifier[8]);
+
+        /** Closes the file and replaces the snapshot with it.
+            @return false if anything could not be written, the old snapshot is then kept. */
+        bool Commit();
+
+        void Write(const void *data, size_t size);
+
+        /** Writes one value of a type without pointers, e.g. an integer or a double */
+        template<class T>
+        void Write(const T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only values without pointers can be written to a snapshot");
+            Write(&value, sizeof(T));
+        }
+
+        void WriteString(const CString &str);
+
+        void WriteTime(const CDateTime &time);
+
+        /** Writes the number of values in the buffer followed by the values, oldest first */
+        template<class T>
+        void WriteRingBuffer(const CRingBuffer<T> &buffer)
+        {
+            std::vector<T> values(buffer.Size());
+            buffer.CopyTo(values.data(), values.size());
+            Write((uint32_t)values.size());
+            Write(values.data(), values.size() * sizeof(T));
+        }
+
+    private:
+        CSnapshotWriter(const CSnapshotWriter&) = delete;
+        CSnapshotWriter& operator=(const CSnapshotWriter&) = delete;
+
+        FILE *m_file = nullptr;
+        CString m_fileName;
+        bool m_ok = false;
+    };
+
+    /** The <b>CSnapshotReader</b> reads a snapshot written by the CSnapshotWriter.
+        The whole file is read into memory when it is opened. Reading past the end
+        of the file fails and makes all following reads fail, such that a truncated or
+        damaged snapshot is detected by checking Ok() once all values have been read. */
+    class CSnapshotReader
+    {
+    public:
+        /** Reads the file into memory and checks its identifier.
+            @return false if the file does not exist or has another identifier. */
+        bool Open(const CString &fileName, const char identifier[8]);
+
+        /** @return the time (epoch) when the snapshot was taken */
+        time_t SavedTime() const { return m_savedTime; }
+
+        /** @return true if all values so far could be read */
+        bool Ok() const { return m_ok; }
+
+        /** @return the number of bytes which have not yet been read */
+        size_t Remaining() const { return m_data.size() - m_position; }
+
+        bool Read(void *data, size_t size);
+
+        template<class T>
+        bool Read(T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only values without pointers can be read from a snapshot");
+            return Read(&value, sizeof(T));
+        }
+
+        bool ReadString(CString &str);
+
+        bool ReadTime(CDateTime &time);
+
+        /** Replaces the contents of the buffer with the values written by WriteRingBuffer.
+            If more values were written than the buffer can hold, then only the newest are kept. */
+        template<class T>
+        bool ReadRingBuffer(CRingBuffer<T> &buffer)
+        {
+            uint32_t number = 0;
+            if (!Read(number) || (size_t)number * sizeof(T) > m_data.size() - m_position)
+            {
+                m_ok = false;
+                return false;
+            }
+            buffer.Clear();
+            for (uint32_t k = 0; k < number; ++k)
+            {
+                T value;
+                Read(value);
+                buffer.PushBack(value);
+            }
+            return m_ok;
+        }
+
+    private:
+        std::vector<char> m_data;
+        size_t m_position = 0;
+        time_t m_savedTime = 0;
+        bool m_ok = false;
+    };
+}
@@ -1,5 +1,7 @@
 #include "StdAfx.h"
 #include "pakfilehandler.h"
+#include "PakFileIndex.h"
+#include "ScanFileWriter.h"
 #include <SpectralEvaluation/StringUtils.h>
 #include <SpectralEvaluation/File/ScanFileHandler.h>
 
@@ -58,101 +60,70 @@ void CPakFileHandler::InitializeDirectories(const CString &serialNumber, const C
     }
 }
 
-int CPakFileHandler::FindFirstScanStart(const CString &fileName, const CString &fileForLost) {
-    int specNum = 0;
-    CSpectrum spec;
-    CString message;
-    SpectrumIO::CSpectrumIO reader;
-    SpectrumIO::CSpectrumIO writer;
-
-    const std::string fileNameStr((LPCSTR)fileName);
-    const std::string fileNameForLost((LPCSTR)fileForLost);
+int CPakFileHandler::FindFirstScanStart(const CPakFileIndex &index, const CString &fileForLost) {
+    const size_t firstScanStart = index.FindNextScanStart(0);
 
-    while (SUCCESS == reader.ReadSpectrum(fileNameStr, specNum++, spec))
+    // Add the spectra before the first scan-start to the 'lost' file, exactly as they are in the downloaded file
+    if (fileForLost.GetLength() > 3 || fileForLost.GetLength() < MAX_PATH)
     {
-        if (spec.ScanIndex() != 0)
-        {
-            // Add the spectrum to the 'lost' file
-            if (fileForLost.GetLength() > 3 || fileForLost.GetLength() < MAX_PATH)
-            {
-                writer.AddSpectrumToFile(fileNameForLost, spec);
-            }
-        }
-        else
+        CScanFileWriter lostWriter;
+        lostWriter.SetFileName(fileForLost);
+        for (size_t specNum = 0; specNum < firstScanStart; ++specNum)
         {
-            // We found what we were looking for, jump out of the loop
-            --specNum;
-            break;
+            lostWriter.AddRecord(index.Record(specNum), index.RecordSize(specNum));
         }
+        lostWriter.Flush();
     }
 
-    return specNum;
+    return (int)firstScanStart;
 }
 
-/** Finds the next spectrum in the already opened file, which is the first
+/** Finds the next spectrum in the downloaded file, starting at 'specIndex', which is the first
         spectrum of a scan. The ignored spectra are saved in the 'incomplete' folder.
-        On succesful return the function will return SUCCESS and the provided
-        spectrum 'curSpec' will be the next first spectrum of a scan.
-        If there is no more scan-start spectrum in the file, this function will
-        return FAIL. */
-RETURN_CODE CPakFileHandler::FindNextScanStart(FILE *pakFile, CSpectrum &curSpec) {
-    SpectrumIO::CSpectrumIO reader;
-    SpectrumIO::CSpectrumIO writer;
+        @return the index of the found spectrum,
+        @return index.SpectrumNum() if there is no more scan-start spectrum in the file. */
+size_t CPakFileHandler::FindNextScanStart(const CPakFileIndex &index, size_t specIndex) {
+    CSpectrum curSpec;
     CString incompleteFileName, serialNumber, message;
-    char *spectrumHeader = (char*)calloc(HEADER_BUF_SIZE, sizeof(char)); // <-- the spectrum header, in binary format
-    int specHeaderSize = 0;
-    int originalSpectrumNumber = m_spectrumNumber;
 
-    // Get the serial-number of the spectrometer
+    // The serial-number and start-time of the first ignored spectrum gives the name of the incomplete-file
+    index.ReadSpectrum(specIndex, curSpec);
     serialNumber.Format("%s", curSpec.m_info.m_device.c_str());
-
-    // Get the spectrum's position in the scan
-    int scanIndex = curSpec.ScanIndex();
-    int originalScanIndex = scanIndex;
-
-    // Save this spectrum in a file in the 'incomplete' - folder
     CDateTime *starttid = &curSpec.m_info.m_startTime;
     incompleteFileName.Format("%s\\%s_%02d.%02d.%02d.pak", (LPCSTR)m_incompleteDir, (LPCSTR)serialNumber, starttid->hour, starttid->minute, starttid->second);
 
-    // Continue reading spectra until we find one which has scan-index = 0
-    while (scanIndex > 0) {
-        // write the spectrum to an incomplete-file and store it...
-        const std::string incompleteFileNameStr((LPCSTR)incompleteFileName);
-        writer.AddSpectrumToFile(incompleteFileNameStr, curSpec, spectrumHeader, specHeaderSize);
-
-        // Read the next spectrum from the file and see if this is the beginning
-        //	of a scan...
-        const bool success = reader.ReadNextSpectrum(pakFile, curSpec, specHeaderSize, spectrumHeader, HEADER_BUF_SIZE);
-        if (!success) {
-            if (SUCCESS != HandleCorruptSpectrum(reader, pakFile)) {
-                free(spectrumHeader);
-                return FAIL;
-            }
-        }
-        else {
-            ++m_spectrumNumber;
-        }
+    // Get the spectrum's position in the scan
+    const int originalScanIndex = index.ScanIndex(specIndex);
 
-        // Get the spectrums position in the scan
-        scanIndex = curSpec.ScanIndex();
+    // Continue until we find one spectrum which has scan-index = 0,
+    //  the spectra before it are copied to the incomplete-file exactly as they are in the downloaded file
+    CScanFileWriter incompleteWriter;
+    incompleteWriter.SetFileName(incompleteFileName);
+    size_t nextScanStart = specIndex;
+    while (nextScanStart < index.SpectrumNum() && index.ScanIndex(nextScanStart) > 0) {
+        incompleteWriter.AddRecord(index.Record(nextScanStart), index.RecordSize(nextScanStart));
+        ++nextScanStart;
+    }
+    incompleteWriter.Flush();
+
+    if (nextScanStart >= index.SpectrumNum()) {
+        return index.SpectrumNum();
     }
 
     // Tell the user what just happened
-    int nSkipped = m_spectrumNumber - originalSpectrumNumber;
+    const size_t nSkipped = nextScanStart - specIndex;
     if (originalScanIndex > 1)
         message.Format("Recieved a scan where the first %d spectra were missing. ", originalScanIndex);
     else
         message.Format("Recieved a scan where the first spectrum was missing. ");
     if (nSkipped > 1)
-        message.AppendFormat("%d spectra ignored and moved to the incomplete folder", nSkipped);
+        message.AppendFormat("%d spectra ignored and moved to the incomplete folder", (int)nSkipped);
     else
         message.AppendFormat("1 spectrum ignored and moved to the incomplete folder");
 
     ShowMessage(message);
 
-    free(spectrumHeader);
-
-    return SUCCESS;
+    return nextScanStart;
 }
 
 RETURN_CODE CPakFileHandler::EvaluateScan(const CString &fileName, const CString &serialNumber)
@@ -194,16 +165,12 @@ RETURN_CODE CPakFileHandler::EvaluateScan(const CString &fileName, const CString
         ShowMessage(message);
     }
 
-    Sleep(100); // make a small break between each spectrum to be evaluated
-
     return SUCCESS;
 }
 
 int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakFile, bool evaluate, const CString *outputDir)
 {
     CString message;
-    SpectrumIO::CSpectrumIO reader;
-    SpectrumIO::CSpectrumIO writer;
     CSpectrum curSpec;
     CString lostFile[MAX_CHANNEL_NUM]; // <-- Where to move the lost spectra
     int numSpecRead[MAX_CHANNEL_NUM];  // <-- The number of read spectra in the last started scan
@@ -214,9 +181,10 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
     unsigned char channel;
     int nEvaluatedScans = 0;
     bool isMultiChannelSpec = false;
+    size_t lastSpectrum = 0; // <-- the index of the last spectrum which was added to a scan-file
 
-    std::vector<char> spectrumHeader = std::vector<char>(HEADER_BUF_SIZE); // <-- the spectrum header, in binary format
-    int specHeaderSize = 0;
+    // The spectra of the scan being read from each channel, written to the scan-file when the scan is complete
+    CScanFileWriter scanWriter[MAX_CHANNEL_NUM];
 
     // An array of spectra, needed if an multichannel spectrum is coming in.
     std::vector<CSpectrum> spectrumFromChannel{ MAX_CHANNEL_NUM };
@@ -237,9 +205,15 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
         ShowMessage(message);
     }
 
-    // 2. Read the first spectrum in the file
+    // 2. Read the whole file into memory, once. The spectra are checked and copied to the scan-files 
+    //      from the in-memory copy, the file is only read again for the few spectra which have to be
+    //      fully read by CSpectrumIO, e.g. the multichannel spectra which have to be split up.
     const std::string fileNameStr((LPCSTR)fileName);
-    if (SUCCESS != reader.ReadSpectrum(fileNameStr, 0, curSpec))
+    CPakFileIndex pakFile;
+    pakFile.Load(fileNameStr);
+
+    // 2b. Read the first spectrum in the file
+    if (!pakFile.ReadSpectrum(0, curSpec))
     {
         ShowMessage("Cannot read first spectrum from the downloaded file.");
         channel = 0; // assumption
@@ -247,13 +221,7 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
     }
     else
     {
-        channel = curSpec.Channel();
-        if (channel < 0)
-        {
-            // There's something wrong with this channel number
-            ShowMessage("Received file with illegal channel number");
-            channel = 0;
-        }
+        channel = (unsigned char)curSpec.Channel();
         serialNumber.Format("%s", curSpec.m_info.m_device.c_str());
         if (serialNumber.GetLength() < 6 || serialNumber.GetLength() > 11)
         {
@@ -276,6 +244,7 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
             m_scanFile[i].Format("%s\\Scan_%05d_%1d.pak", (LPCSTR)m_tempDir, tmpInt++, i); // the file containing the spectra from one channel
         }
         lostFile[i].Format("%s\\Incomplete_%s_%1d.pak", (LPCSTR)m_lostDir, (LPCSTR)serialNumber, i);
+        scanWriter[i].SetFileName(m_scanFile[i]);
         numSpecRead[i] = 0;
         nSpecPerScan[i] = 0;
         mSpec[i] = &spectrumFromChannel[i];
@@ -285,142 +254,138 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
     //		The spectra before that will be thrown away to 'lostFile[channel]'
     if (channel < MAX_CHANNEL_NUM)
     {
-        m_spectrumNumber = FindFirstScanStart(fileName, lostFile[channel]);
+        m_spectrumNumber = FindFirstScanStart(pakFile, lostFile[channel]);
     }
     else
     {
-        m_spectrumNumber = FindFirstScanStart(fileName, lostFile[0]);
+        m_spectrumNumber = FindFirstScanStart(pakFile, lostFile[0]);
     }
-    // 6. Read all the spectra in the newly recieved file and when 
-    //		we've read a full scan, evaluate it.
+
+    // 6. Go through all the spectra in the newly recieved file, starting at the first scan-start, 
+    //      and when we've read a full scan, evaluate it.
+    //      The spectra of each channel are collected in memory and the scan-file is 
+    //      written once, when the scan is complete.
+    //      If there is no scan-start then all the spectra are already in the 'lost' file.
     memset(old_scanIndex, -1, MAX_CHANNEL_NUM * sizeof(int));
     memset(repetitions, 0, MAX_CHANNEL_NUM * sizeof(int));
-    FILE *pakFile = fopen(fileName, "rb");
-    if (pakFile == nullptr)
+    while ((size_t)m_spectrumNumber < pakFile.SpectrumNum())
     {
-        message.Format("CPakFileHandler: Could not open .pak-file %s", (LPCSTR)fileName);
-        ShowMessage(message);
-    }
-    else
-    {
-        while (true)
+        const size_t specIndex = (size_t)m_spectrumNumber++;
+
+        // 6a. Check the spectrum, corrupt spectra are skipped
+        if (!CheckSpectrum(pakFile, specIndex))
         {
-            const bool success = reader.ReadNextSpectrum(pakFile, curSpec, specHeaderSize, spectrumHeader.data(), HEADER_BUF_SIZE);
-            if (!success)
-            {
-                // If the spectrum is corrupt, save it to the 'corrupted' - folder
-                if (reader.m_lastError == SpectrumIO::CSpectrumIO::ERROR_CHECKSUM_MISMATCH)
-                {
-                    SaveCorruptSpectrum(curSpec, specHeaderSize, spectrumHeader.data());
-                }
-                if (SUCCESS != HandleCorruptSpectrum(reader, pakFile))
-                {
-                    break;
-                }
-            }
-            else
-            {
-                ++m_spectrumNumber;
-            }
+            continue;
+        }
 
-            // 6a. Get the channel the spectrum was collected with
-            channel = curSpec.Channel();
-            isMultiChannelSpec = CorrectChannelNumber(channel);
+        // 6b. Get the channel the spectrum was collected with
+        channel = pakFile.Entry(specIndex).channel;
+        isMultiChannelSpec = CorrectChannelNumber(channel);
 
-            if (channel >= MAX_CHANNEL_NUM)
-            {
-                // This is not handled by the program
-                message.Format("Recieved spectrum with channel %d. Program not able to handle more than %d channels.", channel, MAX_CHANNEL_NUM);
-                ShowMessage(message);
-                continue;
-            }
+        if (channel >= MAX_CHANNEL_NUM)
+        {
+            // This is not handled by the program
+            message.Format("Recieved spectrum with channel %d. Program not able to handle more than %d channels.", channel, MAX_CHANNEL_NUM);
+            ShowMessage(message);
+            continue;
+        }
 
-            // 6b. Get the scan index
-            short scanIndex = curSpec.ScanIndex();
+        // 6c. Get the scan index
+        const int scanIndex = pakFile.ScanIndex(specIndex);
 
-            // 6c. Get the range of channels that are contained in this spectrum.
-            if (isMultiChannelSpec)
+        // 6d. Get the range of channels that are contained in this spectrum.
+        //      The multichannel spectra have to be read and split up
+        if (isMultiChannelSpec)
+        {
+            if (!pakFile.ReadSpectrum(specIndex, curSpec))
             {
-                channelFrom = 0;
-                channelTo = curSpec.Split(mSpec);
+                continue;
             }
-            else
+            channelFrom = 0;
+            channelTo = curSpec.Split(mSpec);
+        }
+        else
+        {
+            channelFrom = channel;
+            channelTo = channel + 1;
+        }
+        lastSpectrum = specIndex;
+
+        // 6e. Loop through all the channel-numbers that are stored in this spectrum.
+        for (int k = channelFrom; k < channelTo; ++k)
+        {
+            // Make sure that we don't go out of bounds here...
+            if (k < 0 || k >= MAX_CHANNEL_NUM)
             {
-                channelFrom = channel;
-                channelTo = channel + 1;
+                ShowMessage("Illegal channel number in CPakFileHandler::ReadDownloadedFile");
+                continue;
             }
 
-            // 6d. Loop through all the channel-numbers that are stored in this spectrum.
-            for (int k = channelFrom; k < channelTo; ++k)
+            // 6e1. If this spectrum is the beginning of a scan, then
+            //			the files that we've read is a complete scan. 
+            //			Evaluate it, move the scan file and start filling up a scan-file
+            // 6e2. Also, if the scan-index of this spectrum is lower
+            //			than the scan-index of the spectrum before, then we've probably
+            //			started on a scan.
+            if ((numSpecRead[k] > 0 && scanIndex == 0) || scanIndex < old_scanIndex[k])
             {
-                // Make sure that we don't go out of bounds here...
-                if (k < 0 || k > MAX_CHANNEL_NUM)
+                if (!scanWriter[k].Flush())
                 {
-                    ShowMessage("Illegal channel number in CPakFileHandler::ReadDownloadedFile");
-                    continue;
+                    message.Format("CPakFileHandler: Could not write scan-file %s", (LPCSTR)m_scanFile[k]);
+                    ShowMessage(message);
                 }
+                if (evaluate)
+                    EvaluateScan(m_scanFile[k], serialNumber);
+                else
+                    ArchiveScan(m_scanFile[k]);
+                numSpecRead[k] = 0;
+                old_scanIndex[k] = -1;
+                ++nEvaluatedScans;
 
-                // 6d1. If this spectrum is the beginning of a scan, then
-                //			the files that we've read is a complete scan. 
-                //			Evaluate it, move the scan file and start filling up a scan-file
-                // 6d2. Also, if the scan-index of this spectrum is lower
-                //			than the scan-index of the spectrum before, then we've probably
-                //			started on a scan.
-                if ((numSpecRead[k] > 0 && scanIndex == 0) || scanIndex < old_scanIndex[k])
+                // This should be the beginning of a scan, if not so then skip forwards 
+                //  to the next sky-spectrum, which is then read as any other spectrum
+                if (scanIndex > 0)
                 {
-                    if (evaluate)
-                        EvaluateScan(m_scanFile[k], serialNumber);
-                    else
-                        ArchiveScan(m_scanFile[k]);
-                    numSpecRead[k] = 0;
-                    ++nEvaluatedScans;
-
-                    // This should be the beginning of a scan, if not so then
-                    //	loop forwards until we find one sky-spectrum
-                    if (scanIndex > 0)
-                    {
-                        if (SUCCESS != FindNextScanStart(pakFile, curSpec)) // <-- this changes the 'm_spectrumNumber' - variable
-                            break;
-                        else
-                            scanIndex = 0;
-                    }
+                    m_spectrumNumber = (long)FindNextScanStart(pakFile, specIndex);
+                    break;
                 }
+            }
 
-                // 6d3. Add the spectrum to the scan-file
-                const std::string scanFileName((LPCSTR)m_scanFile[k]);
-                if (isMultiChannelSpec)
-                {
-                    writer.AddSpectrumToFile(scanFileName, *mSpec[k]);
-                }
-                else
-                {
-                    if (specHeaderSize > 0)
-                    {
-                        writer.AddSpectrumToFile(scanFileName, curSpec, spectrumHeader.data(), specHeaderSize);
-                    }
-                    else
-                    {
-                        writer.AddSpectrumToFile(scanFileName, curSpec);
-                    }
-                }
+            // 6e3. Add the spectrum to the scan-file. Spectra which are not split up are copied
+            //      exactly as they are in the downloaded file.
+            if (isMultiChannelSpec)
+            {
+                scanWriter[k].AddSpectrum(*mSpec[k], pakFile.Record(specIndex), pakFile.Entry(specIndex).headerSize);
+            }
+            else
+            {
+                scanWriter[k].AddRecord(pakFile.Record(specIndex), pakFile.RecordSize(specIndex));
+            }
 
-                // 6d4. If this measurement represents a 'new' measurement-line
-                //			then increase the number of spectra read.
-                //			(Don't count repetitions on the same measurement - line)
-                if (old_scanIndex[k] != scanIndex)
-                {
-                    ++numSpecRead[k];
-                    old_scanIndex[k] = scanIndex;
-                }
-                else
-                {
-                    ++repetitions[k];
-                }
+            // 6e4. If this measurement represents a 'new' measurement-line
+            //			then increase the number of spectra read.
+            //			(Don't count repetitions on the same measurement - line)
+            if (old_scanIndex[k] != scanIndex)
+            {
+                ++numSpecRead[k];
+                old_scanIndex[k] = scanIndex;
+            }
+            else
+            {
+                ++repetitions[k];
             }
         }
+    }
 
-        fclose(pakFile);
-    }//endif
+    // 6f. Write out the spectra of the scans which are still being collected
+    for (i = 0; i < MAX_CHANNEL_NUM; ++i)
+    {
+        if (!scanWriter[i].Flush())
+        {
+            message.Format("CPakFileHandler: Could not write scan-file %s", (LPCSTR)m_scanFile[i]);
+            ShowMessage(message);
+        }
+    }
 
     // 7. If we've read equally many spectra as measurement-lines in the 
     //		cfg.txt-file, then assume that this is a full scan
@@ -441,8 +406,8 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
         } // endif(nChannels...
     }
     else {
-        // 7b. The last spectrum was a normal spectrum
-        if (channel >= 0 && channel < MAX_CHANNEL_NUM) {
+        // 7b. The last spectrum was a normal spectrum, read it to get the number of spectra per scan
+        if (channel >= 0 && channel < MAX_CHANNEL_NUM && numSpecRead[channel] > 0 && pakFile.ReadSpectrum(lastSpectrum, curSpec)) {
             if (numSpecRead[channel] == curSpec.SpectraPerScan()) {
                 if (evaluate)
                     EvaluateScan(m_scanFile[channel], serialNumber);
@@ -453,7 +418,6 @@ int CPakFileHandler::ReadDownloadedFile(const CString &fileName, bool deletePakF
             }
         }
     }
-
     // 8. If no scans were evaluated, tell the user...
     if (nEvaluatedScans == 0) {
         ShowMessage("Downloaded file does not contain a complete scan.");
@@ -892,16 +856,18 @@ bool CPakFileHandler::IsCompositionMeasurement(CScanFileHandler& file)
 
 /** Takes a scan file and renames it to an approprate name */
 RETURN_CODE	CPakFileHandler::ArchiveScan(const CString &scanFileName) {
-    SpectrumIO::CSpectrumIO reader;
-
     CSpectrum tmpSpec;
     CString serialNumber, dateStr, timeStr, nowStr, pakFile;
 
     // 1. Read one spectrum in the scan
-    int specIndex = 0;
     const std::string fileNameStr((LPCSTR)scanFileName);
-    while (SUCCESS != reader.ReadSpectrum(fileNameStr, specIndex++, tmpSpec)) {
-        if (reader.m_lastError == SpectrumIO::CSpectrumIO::ERROR_SPECTRUM_NOT_FOUND)
+    CPakFileIndex index;
+    if (!index.Build(fileNameStr)) {
+        return FAIL;
+    }
+    size_t specIndex = 0;
+    while (!index.ReadSpectrum(specIndex++, tmpSpec)) {
+        if (specIndex >= index.SpectrumNum())
             return FAIL;
     }
     CSpectrumInfo &info = tmpSpec.m_info;
@@ -957,30 +923,40 @@ bool CPakFileHandler::CorrectChannelNumber(unsigned char &channel)
     return false;
 }
 
-/** Takes appropriate action when a corrupt spectrum has been found */
-RETURN_CODE CPakFileHandler::HandleCorruptSpectrum(SpectrumIO::CSpectrumIO &reader, FILE *pakFile)
+bool CPakFileHandler::CheckSpectrum(const CPakFileIndex &pakFile, size_t specIndex)
 {
-    CString str;
-    if (reader.m_lastError == SpectrumIO::CSpectrumIO::ERROR_EOF || reader.m_lastError == SpectrumIO::CSpectrumIO::ERROR_COULD_NOT_OPEN_FILE || reader.m_lastError == SpectrumIO::CSpectrumIO::ERROR_SPECTRUM_NOT_FOUND)
-        return FAIL;
-    switch (reader.m_lastError) {
-    case SpectrumIO::CSpectrumIO::ERROR_CHECKSUM_MISMATCH:
-        str.Format("Spectrum %d in pak file is corrupt, checksum mismatch", m_spectrumNumber);
-        ShowMessage(str); break;
-    case SpectrumIO::CSpectrumIO::ERROR_DECOMPRESS:
-        str.Format("Spectrum %d in pak file is corrupt, spectrum could not be decompressed", m_spectrumNumber);
-        ShowMessage(str); break;
+    // Decompress the spectrum from the in-memory copy of the file and compare it to its checksum
+    std::vector<long> values;
+    if (pakFile.Decompress(specIndex, values))
+    {
+        return true;
     }
 
-    ++m_spectrumNumber;
-    if (SUCCESS != reader.FindSpectrumNumber(pakFile, m_spectrumNumber))
+    // The spectrum did not pass, let CSpectrumIO read it which also tells what is wrong with it
+    CSpectrum spec;
+    std::vector<char> spectrumHeader(HEADER_BUF_SIZE); // <-- the spectrum header, in binary format
+    int specHeaderSize = 0;
+    int lastError = 0;
+    if (pakFile.ReadSpectrum(specIndex, spec, spectrumHeader.data(), HEADER_BUF_SIZE, &specHeaderSize, &lastError))
     {
-        return FAIL;
+        return true;
     }
 
-    return SUCCESS;
-}
+    CString str;
+    switch (lastError) {
+    case SpectrumIO::CSpectrumIO::ERROR_CHECKSUM_MISMATCH:
+        str.Format("Spectrum %d in pak file is corrupt, checksum mismatch", (int)specIndex);
+        ShowMessage(str);
+        SaveCorruptSpectrum(spec, specHeaderSize, spectrumHeader.data());
+        break;
+    case SpectrumIO::CSpectrumIO::ERROR_DECOMPRESS:
+        str.Format("Spectrum %d in pak file is corrupt, spectrum could not be decompressed", (int)specIndex);
+        ShowMessage(str);
+        break;
+    }
 
+    return false;
+}
 RETURN_CODE CPakFileHandler::SaveCorruptSpectrum(const CSpectrum &curSpec, int specHeaderSize, const char *spectrumHeader)
 {
     CString fileName, serial, date, time;
@@ -8,6 +8,7 @@
 namespace FileHandler
 {
     class CScanFileHandler;
+    class CPakFileIndex;
 
     /** The <b>CPakFileHandler</b> takes care of the downloaded pak-files from the scanning instrument
         and splits them up into several pak-files, each containing the data from one single scan. */
@@ -92,19 +93,18 @@ namespace FileHandler
 
         /** Finds the first spectrum in the checked file, which is the first
                 spectrum of a scan.
-                @param reader - The CSpectrumIO object which takes care of this .pak-file
+                @param index - The index of the .pak-file
                 @param fileForLost - The spectra before the first scan-start will be outputed
-                    to this filem if fileForLost is NULL then the spectra will not be saved. */
-        int FindFirstScanStart(const CString &fileName, const CString &fileForLost);
-
-        /** Finds the next spectrum in the already opened file, which is the first
-                spectrum of a scan. The ignored spectra are saved in the 'incomplete' folder.
-                On succesful return the function will return SUCCESS and the provided
-                spectrum 'curSpec' will be the next first spectrum of a scan.
-                If there is no more scan-start spectrum in the file, this function will
-                return FAIL.
-                This function alters the member variable 'm_spectrumNumber' */
-        RETURN_CODE FindNextScanStart(FILE *file, CSpectrum &curSpec);
+                    to this filem if fileForLost is NULL then the spectra will not be saved.
+                @return the index of the first spectrum of the first scan in the file. */
+        int FindFirstScanStart(const CPakFileIndex &index, const CString &fileForLost);
+
+        /** Finds the next spectrum in the file, after the spectrum 'specIndex', which is the first
+                spectrum of a scan. The ignored spectra, starting with 'specIndex', are saved in the 'incomplete' folder.
+                @param index - The index of the .pak-file, with the file loaded into memory
+                @return the index of the next first spectrum of a scan,
+                    or index.SpectrumNum() if there is no more scan-start spectrum in the file. */
+        size_t FindNextScanStart(const CPakFileIndex &index, size_t specIndex);
 
         /** Sends a message to the evaluation thread that this scan-file should
                 be evaluated. The file will first be moved to a temporary file
@@ -119,8 +119,9 @@ namespace FileHandler
         /** Takes a scan file and renames it to an approprate name */
         RETURN_CODE	ArchiveScan(const CString &scanFileName);
 
-        /** Takes appropriate action when a corrupt spectrum has been found */
-        RETURN_CODE HandleCorruptSpectrum(SpectrumIO::CSpectrumIO &reader, FILE *pakFile);
+        /** Checks one spectrum in the loaded file and takes appropriate action if it is corrupt.
+                @return true if the spectrum is ok. */
+        bool CheckSpectrum(const CPakFileIndex &pakFile, size_t specIndex);
 
         /** Saves a newly found corrupted spectrum into the appropriate folder */
         RETURN_CODE SaveCorruptSpectrum(const CSpectrum &curSpec, int specHeaderSie, const char *spectrumHeader);
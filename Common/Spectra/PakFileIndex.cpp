@@ -0,0 +1,434 @@
+#include "StdAfx.h"
+#include "PakFileIndex.h"
+#include "../SnapshotFile.h"
+#include "../mk_pack.h"
+#include <SpectralEvaluation/File/SpectrumIO.h>
+#include <SpectralEvaluation/File/MKPack.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+using namespace FileHandler;
+
+// The identifier of the cache-files, and the version of the format of them
+static const char CACHE_IDENTIFIER[8] = { 'P', 'A', 'K', 'I', 'D', 'X', '0', '2' };
+
+// The number of bytes of one spectrum in the cache-file, see WriteCache
+static const size_t CACHE_ENTRY_SIZE = sizeof(int64_t) + 2 * sizeof(uint16_t) + sizeof(int32_t) + sizeof(uint8_t);
+
+// The marker at the start of every spectrum header in the .pak-files
+static const char SPECTRUM_MARKER[4] = { 'M', 'K', 'Z', 'Y' };
+
+// The size of the blocks read when searching for the next spectrum header
+static const int SEARCH_BUFFER_SIZE = 4096;
+
+/** Searches for the next spectrum header in the file, starting at 'offset'.
+    @return true, and updates 'offset' to the position of the header, if one was found. */
+static bool FindSpectrumMarker(FILE* f, long long& offset)
+{
+    char buffer[SEARCH_BUFFER_SIZE];
+
+    while (0 == _fseeki64(f, offset, SEEK_SET))
+    {
+        const size_t bytesRead = fread(buffer, 1, SEARCH_BUFFER_SIZE, f);
+        if (bytesRead < sizeof(SPECTRUM_MARKER))
+        {
+            return false;
+        }
+
+        for (size_t k = 0; k + sizeof(SPECTRUM_MARKER) <= bytesRead; ++k)
+        {
+            if (0 == memcmp(buffer + k, SPECTRUM_MARKER, sizeof(SPECTRUM_MARKER)))
+            {
+                offset += k;
+                return true;
+            }
+        }
+
+        // continue the search, the marker may span two blocks
+        offset += bytesRead - (sizeof(SPECTRUM_MARKER) - 1);
+    }
+
+    return false;
+}
+
+/** The result of reading the spectrum header at a found marker */
+enum class HeaderStatus { OK, NOT_A_HEADER, TRUNCATED };
+
+/** Reads the spectrum header starting at 'data', which is at position 'offset' in a file of 'fileSize' bytes.
+    @param available - the number of bytes which can be read from 'data'.
+    @return HeaderStatus::OK, and fills in 'entry', if this is the header of a complete spectrum. */
+static HeaderStatus ParseHeader(const char* data, size_t available, long long offset, long long fileSize, CPakFileIndexEntry& entry)
+{
+    // the scan index is only part of the newer versions of the header
+    const size_t minimumSizeWithScanIndex = offsetof(SpectrumIO::MKZYhdr, measureidx) + sizeof(SpectrumIO::MKZYhdr::measureidx);
+
+    SpectrumIO::MKZYhdr header;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, data, std::min(available, sizeof(header)));
+    if (available < offsetof(SpectrumIO::MKZYhdr, channel) + sizeof(header.channel))
+    {
+        return HeaderStatus::TRUNCATED; // the file ends in the middle of the header
+    }
+
+    if (header.hdrsize < sizeof(SPECTRUM_MARKER) || offset + header.hdrsize + header.size > fileSize)
+    {
+        return HeaderStatus::NOT_A_HEADER; // this is not a real header, or the spectrum is truncated
+    }
+
+    entry.offset = offset;
+    entry.headerSize = header.hdrsize;
+    entry.dataSize = header.size;
+    entry.channel = header.channel;
+    entry.scanIndex = (header.hdrsize >= minimumSizeWithScanIndex) ? (int)header.measureidx : -1;
+    return HeaderStatus::OK;
+}
+
+CPakFileIndex::CPakFileIndex()
+    : m_fileSize(0), m_modificationTime(0)
+{
+}
+
+bool CPakFileIndex::Build(const std::string& fileName, const std::string& cacheDirectory)
+{
+    m_fileName = fileName;
+    m_entries.clear();
+    m_contents.clear();
+
+    struct _stat64 fileStatus;
+    if (0 != _stat64(fileName.c_str(), &fileStatus))
+    {
+        return false;
+    }
+    m_fileSize = fileStatus.st_size;
+    m_modificationTime = fileStatus.st_mtime;
+
+    const std::string cacheFileName = cacheDirectory.empty() ? std::string() : CacheFileName(fileName, cacheDirectory);
+    if (!cacheFileName.empty() && ReadCache(cacheFileName))
+    {
+        return true;
+    }
+
+    if (!ReadHeaders())
+    {
+        return false;
+    }
+
+    if (!cacheFileName.empty())
+    {
+        WriteCache(cacheFileName);
+    }
+
+    return true;
+}
+
+bool CPakFileIndex::Load(const std::string& fileName)
+{
+    m_fileName = fileName;
+    m_entries.clear();
+    m_contents.clear();
+
+    FILE* f = fopen(fileName.c_str(), "rb");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    struct _stat64 fileStatus;
+    bool success = (0 == _fstat64(_fileno(f), &fileStatus));
+    if (success)
+    {
+        m_fileSize = fileStatus.st_size;
+        m_modificationTime = fileStatus.st_mtime;
+        m_contents.resize((size_t)m_fileSize);
+        success = (m_contents.size() == fread(m_contents.data(), 1, m_contents.size(), f));
+    }
+    fclose(f);
+
+    if (!success)
+    {
+        m_contents.clear();
+        return false;
+    }
+
+    // Index the in-memory copy
+    const char* data = m_contents.data();
+    const size_t size = m_contents.size();
+    size_t offset = 0;
+    while (offset + sizeof(SPECTRUM_MARKER) <= size)
+    {
+        const char* marker = std::search(data + offset, data + size, SPECTRUM_MARKER, SPECTRUM_MARKER + sizeof(SPECTRUM_MARKER));
+        if (marker == data + size)
+        {
+            break;
+        }
+        offset = marker - data;
+
+        CPakFileIndexEntry entry;
+        const HeaderStatus status = ParseHeader(marker, size - offset, (long long)offset, m_fileSize, entry);
+        if (status == HeaderStatus::TRUNCATED)
+        {
+            break;
+        }
+        else if (status == HeaderStatus::NOT_A_HEADER)
+        {
+            offset += sizeof(SPECTRUM_MARKER); // continue searching after the marker
+            continue;
+        }
+
+        m_entries.push_back(entry);
+        offset += entry.headerSize + entry.dataSize;
+    }
+
+    return true;
+}
+
+bool CPakFileIndex::ReadHeaders()
+{
+    FILE* f = fopen(m_fileName.c_str(), "rb");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    long long offset = 0;
+    while (FindSpectrumMarker(f, offset))
+    {
+        char header[sizeof(SpectrumIO::MKZYhdr)];
+
+        _fseeki64(f, offset, SEEK_SET);
+        const size_t bytesRead = fread(header, 1, sizeof(header), f);
+
+        CPakFileIndexEntry entry;
+        const HeaderStatus status = ParseHeader(header, bytesRead, offset, m_fileSize, entry);
+        if (status == HeaderStatus::TRUNCATED)
+        {
+            break;
+        }
+        else if (status == HeaderStatus::NOT_A_HEADER)
+        {
+            offset += sizeof(SPECTRUM_MARKER); // continue searching after the marker
+            continue;
+        }
+
+        m_entries.push_back(entry);
+        offset += entry.headerSize + entry.dataSize;
+    }
+
+    fclose(f);
+
+    return true;
+}
+
+const char* CPakFileIndex::Record(size_t spectrumIndex) const
+{
+    if (spectrumIndex >= m_entries.size() || m_contents.empty())
+    {
+        return nullptr;
+    }
+    return m_contents.data() + m_entries[spectrumIndex].offset;
+}
+
+SpectrumIO::MKZYhdr CPakFileIndex::Header(size_t spectrumIndex) const
+{
+    SpectrumIO::MKZYhdr header;
+    memset(&header, 0, sizeof(header));
+
+    const char* record = Record(spectrumIndex);
+    if (record != nullptr)
+    {
+        memcpy(&header, record, std::min((size_t)m_entries[spectrumIndex].headerSize, sizeof(header)));
+    }
+    return header;
+}
+
+bool CPakFileIndex::Decompress(size_t spectrumIndex, std::vector<long>& values) const
+{
+    values.clear();
+
+    const char* record = Record(spectrumIndex);
+    if (record == nullptr)
+    {
+        return false;
+    }
+
+    const CPakFileIndexEntry& entry = m_entries[spectrumIndex];
+    const SpectrumIO::MKZYhdr header = Header(spectrumIndex);
+
+    values.resize(header.pixels);
+    const long valueNum = UnPackChecked((const unsigned char*)record + entry.headerSize, entry.dataSize, header.pixels, values.data(), header.pixels);
+    if (valueNum != (long)header.pixels)
+    {
+        values.clear();
+        return false;
+    }
+
+    return header.checksum == Checksum(values);
+}
+
+unsigned short CPakFileIndex::Checksum(const std::vector<long>& values)
+{
+    unsigned short checksum = 0;
+    for (long value : values)
+    {
+        checksum = (unsigned short)(checksum + value);
+    }
+    return checksum;
+}
+
+int CPakFileIndex::ScanIndex(size_t spectrumIndex) const
+{
+    if (spectrumIndex >= m_entries.size())
+    {
+        return -1;
+    }
+    if (m_entries[spectrumIndex].scanIndex >= 0)
+    {
+        return m_entries[spectrumIndex].scanIndex;
+    }
+
+    // the header does not tell the scan index, the spectrum has to be read
+    CSpectrum spec;
+    return ReadSpectrum(spectrumIndex, spec) ? spec.ScanIndex() : -1;
+}
+
+bool CPakFileIndex::ReadSpectrum(size_t spectrumIndex, CSpectrum& spec, char* headerBuffer, int headerBufferSize, int* headerSize, int* lastError) const
+{
+    if (spectrumIndex >= m_entries.size())
+    {
+        return false;
+    }
+
+    FILE* f = fopen(m_fileName.c_str(), "rb");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    bool success = false;
+    if (0 == _fseeki64(f, m_entries[spectrumIndex].offset, SEEK_SET))
+    {
+        SpectrumIO::CSpectrumIO reader;
+        std::vector<char> localHeaderBuffer;
+        if (headerBuffer == nullptr)
+        {
+            localHeaderBuffer.resize(std::max((size_t)m_entries[spectrumIndex].headerSize, sizeof(SpectrumIO::MKZYhdr)));
+            headerBuffer = localHeaderBuffer.data();
+            headerBufferSize = (int)localHeaderBuffer.size();
+        }
+
+        int sizeOfHeader = 0;
+        success = reader.ReadNextSpectrum(f, spec, sizeOfHeader, headerBuffer, headerBufferSize);
+
+        if (headerSize != nullptr)
+        {
+            *headerSize = sizeOfHeader;
+        }
+        if (lastError != nullptr)
+        {
+            *lastError = (int)reader.m_lastError;
+        }
+    }
+
+    fclose(f);
+
+    return success;
+}
+
+size_t CPakFileIndex::FindNextScanStart(size_t startIndex) const
+{
+    for (size_t k = startIndex; k < m_entries.size(); ++k)
+    {
+        if (ScanIndex(k) == 0)
+        {
+            return k;
+        }
+    }
+
+    return m_entries.size();
+}
+
+std::string CPakFileIndex::CacheFileName(const std::string& pakFileName, const std::string& cacheDirectory)
+{
+    std::string fullPath = pakFileName;
+    std::transform(fullPath.begin(), fullPath.end(), fullPath.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+    const size_t nameStart = pakFileName.find_last_of("\\/");
+    const std::string name = (nameStart == std::string::npos) ? pakFileName : pakFileName.substr(nameStart + 1);
+
+    char hash[32];
+    sprintf_s(hash, "_%08x.idx", (unsigned int)std::hash<std::string>()(fullPath));
+
+    std::string cacheFileName = cacheDirectory;
+    if (!cacheFileName.empty() && cacheFileName.back() != '\\' && cacheFileName.back() != '/')
+    {
+        cacheFileName += '\\';
+    }
+    return cacheFileName + name + hash;
+}
+
+bool CPakFileIndex::ReadCache(const std::string& cacheFileName)
+{
+    CSnapshotReader reader;
+    if (!reader.Open(cacheFileName.c_str(), CACHE_IDENTIFIER))
+    {
+        return false;
+    }
+
+    int64_t fileSize = 0;
+    int64_t modificationTime = 0;
+    uint32_t spectrumNum = 0;
+    reader.Read(fileSize);
+    reader.Read(modificationTime);
+    reader.Read(spectrumNum);
+    if (!reader.Ok() || fileSize != m_fileSize || modificationTime != m_modificationTime || (size_t)spectrumNum * CACHE_ENTRY_SIZE > reader.Remaining())
+    {
+        return false;
+    }
+
+    m_entries.resize(spectrumNum);
+    for (CPakFileIndexEntry& entry : m_entries)
+    {
+        int64_t offset = 0;
+        int32_t scanIndex = 0;
+        reader.Read(offset);
+        reader.Read(entry.headerSize);
+        reader.Read(entry.dataSize);
+        reader.Read(scanIndex);
+        reader.Read(entry.channel);
+        entry.offset = offset;
+        entry.scanIndex = scanIndex;
+    }
+
+    if (!reader.Ok())
+    {
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool CPakFileIndex::WriteCache(const std::string& cacheFileName) const
+{
+    CSnapshotWriter writer;
+    if (!writer.Open(cacheFileName.c_str(), CACHE_IDENTIFIER))
+    {
+        return false;
+    }
+
+    writer.Write((int64_t)m_fileSize);
+    writer.Write((int64_t)m_modificationTime);
+    writer.Write((uint32_t)m_entries.size());
+    for (const CPakFileIndexEntry& entry : m_entries)
+    {
+        writer.Write((int64_t)entry.offset);
+        writer.Write((uint16_t)entry.headerSize);
+        writer.Write((uint16_t)entry.dataSize);
+        writer.Write((int32_t)entry.scanIndex);
+        writer.Write((uint8_t)entry.channel);
+    }
+
+    return writer.Commit();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <SpectralEvaluation/Spectra/Spectrum.h>
+#include <SpectralEvaluation/File/SpectrumIO.h>
+
+namespace FileHandler
+{
+    /** One spectrum (one MKZY-record) in a .pak-file */
+    struct CPakFileIndexEntry
+    {
+        /** The position of the first byte of the spectrum header in the file */
+        long long offset = 0;
+
+        /** The size of the spectrum header, in bytes */
+        unsigned short headerSize = 0;
+
+        /** The size of the compressed spectrum data following the header, in bytes */
+        unsigned short dataSize = 0;
+
+        /** The index of the spectrum in the scan. 
+            This is -1 if the header is too old to contain the scan index. */
+        int scanIndex = -1;
+
+        /** The channel of the spectrometer which collected the spectrum */
+        unsigned char channel = 0;
+    };
+
+    /** The <b>CPakFileIndex</b> is a table of contents of a .pak-file, giving the position 
+        of every spectrum in the file. The index is built in one pass through the file where 
+        only the spectrum headers are read, no spectrum is decompressed. The spectra can then be 
+        read in any order by seeking directly to them, instead of reading the file from the 
+        start for every spectrum as CSpectrumIO::ReadSpectrum does.
+        Load() instead reads the whole file into memory once and indexes the in-memory copy, such that
+        the spectra can be taken from memory, as binary records or decompressed, without reading the file again.
+        The index can optionally be cached in a file in a directory chosen by the caller, the cache is 
+        only used as long as the size and the modification time of the .pak-file are unchanged. */
+    class CPakFileIndex
+    {
+    public:
+        CPakFileIndex();
+
+        /** Builds the index of the given .pak-file.
+            @param cacheDirectory - if not empty then the index is read from the cache-file in this 
+                directory, if it is up to date, and the cache-file is (re-)written if it was not.
+            @return true if the file could be read. */
+        bool Build(const std::string& fileName, const std::string& cacheDirectory = "");
+
+        /** Reads the whole .pak-file into memory and builds the index from the in-memory copy.
+            The index is never cached.
+            @return true if the file could be read. */
+        bool Load(const std::string& fileName);
+
+        /** @return the name of the indexed .pak-file */
+        const std::string& FileName() const { return m_fileName; }
+
+        /** @return the number of spectra in the file */
+        size_t SpectrumNum() const { return m_entries.size(); }
+
+        /** @return the position of the spectrum with the given index in the file */
+        const CPakFileIndexEntry& Entry(size_t spectrumIndex) const { return m_entries[spectrumIndex]; }
+
+        /** @return the binary record (header followed by the compressed data) of the spectrum with the given index.
+            This is only available after Load(), null otherwise. */
+        const char* Record(size_t spectrumIndex) const;
+
+        /** @return the size of the binary record of the spectrum with the given index, in bytes */
+        size_t RecordSize(size_t spectrumIndex) const { return (size_t)m_entries[spectrumIndex].headerSize + m_entries[spectrumIndex].dataSize; }
+
+        /** @return the header of the spectrum with the given index, taken from the in-memory copy of the file.
+            The fields which are not part of the header of this spectrum are zero. Only available after Load(). */
+        SpectrumIO::MKZYhdr Header(size_t spectrumIndex) const;
+
+        /** Decompresses the spectrum with the given index from the in-memory copy of the file,
+            and compares it to the checksum in its header. Only available after Load().
+            @return false if the spectrum could not be decompressed or does not match its checksum. */
+        bool Decompress(size_t spectrumIndex, std::vector<long>& values) const;
+
+        /** @return the checksum of the given decompressed spectrum, as stored in the spectrum headers */
+        static unsigned short Checksum(const std::vector<long>& values);
+
+        /** @return the index in the scan of the spectrum with the given index in the file.
+            The spectrum is read from the file if its header is too old to hold the scan index.
+            @return -1 if the index could not be found */
+        int ScanIndex(size_t spectrumIndex) const;
+
+        /** Reads the spectrum with the given index in the file by seeking directly to it.
+            @param headerBuffer - if not null then this is filled with the binary spectrum header.
+            @param headerBufferSize - the size of 'headerBuffer'.
+            @param headerSize - if not null then this is filled with the size of the spectrum header.
+            @param lastError - if not null then this is filled with CSpectrumIO::m_lastError after the spectrum was read.
+            @return true if the spectrum could be read. */
+        bool ReadSpectrum(size_t spectrumIndex, CSpectrum& spec, char* headerBuffer = nullptr, int headerBufferSize = 0, int* headerSize = nullptr, int* lastError = nullptr) const;
+
+        /** @return the index of the first spectrum, at or after 'startIndex', which is the first spectrum of a scan.
+            @return SpectrumNum() if there is no such spectrum in the file. */
+        size_t FindNextScanStart(size_t startIndex = 0) const;
+
+        /** @return the name of the cache-file of the given .pak-file in the given directory.
+            The name includes a hash of the full path of the .pak-file, such that .pak-files with 
+            the same name in different directories get different cache-files. */
+        static std::string CacheFileName(const std::string& pakFileName, const std::string& cacheDirectory);
+
+    private:
+        /** The name of the indexed .pak-file */
+        std::string m_fileName;
+
+        /** The size [bytes] and the modification time of the file, when the index was built */
+        long long m_fileSize;
+        long long m_modificationTime;
+
+        /** The spectra in the file, in the order they appear in the file */
+        std::vector<CPakFileIndexEntry> m_entries;
+
+        /** The contents of the file, if it was read with Load() */
+        std::vector<char> m_contents;
+
+        /** Reads the headers of all spectra in the file */
+        bool ReadHeaders();
+
+        /** Reads the index from the given cache-file.
+            @return false if there is no cache-file, if it is damaged or if it is out of date */
+        bool ReadCache(const std::string& cacheFileName);
+
+        /** Writes the index to the given cache-file */
+        bool WriteCache(const std::string& cacheFileName) const;
+    };
+}
@@ -0,0 +1,111 @@
+#include "StdAfx.h"
+#include "ScanFileWriter.h"
+#include "PakFileIndex.h"
+#include "../mk_pack.h"
+#include <SpectralEvaluation/File/SpectrumIO.h>
+#include <cstddef>
+
+using namespace FileHandler;
+
+void CScanFileWriter::SetFileName(const CString& fileName)
+{
+    m_fileName = fileName;
+    m_pending.clear();
+    m_hasChannelHeader = false;
+    m_triedChannelHeader = false;
+}
+
+void CScanFileWriter::AddRecord(const char* record, size_t size)
+{
+    m_pending.insert(m_pending.end(), record, record + size);
+}
+
+/** Writes 'value' into the header at the position of the given field, if the header is large enough to hold it */
+template<class T>
+static void SetHeaderField(std::vector<char>& header, size_t offset, T value)
+{
+    if (offset + sizeof(T) <= header.size())
+    {
+        memcpy(header.data() + offset, &value, sizeof(T));
+    }
+}
+
+std::vector<long> CScanFileWriter::StoredValues(const CSpectrum& spec)
+{
+    std::vector<long> values((size_t)spec.m_length);
+    for (size_t k = 0; k < values.size(); ++k)
+    {
+        values[k] = (long)spec.m_data[k];
+    }
+    return values;
+}
+
+bool CScanFileWriter::AddSpectrum(const CSpectrum& spec, const char* sourceHeader, int sourceHeaderSize)
+{
+    std::vector<long> values = StoredValues(spec);
+
+    if (!m_hasChannelHeader || sourceHeader == nullptr || sourceHeaderSize < (int)(offsetof(SpectrumIO::MKZYhdr, channel) + sizeof(SpectrumIO::MKZYhdr::channel)) || values.empty())
+    {
+        // Let CSpectrumIO write the spectrum, and read back which header it wrote
+        if (!Flush())
+        {
+            return false;
+        }
+        SpectrumIO::CSpectrumIO writer;
+        writer.AddSpectrumToFile(std::string((LPCSTR)m_fileName), spec);
+
+        CPakFileIndex written;
+        std::vector<long> writtenValues;
+        if (!m_triedChannelHeader && written.Load(std::string((LPCSTR)m_fileName)) && written.SpectrumNum() > 0)
+        {
+            const size_t last = written.SpectrumNum() - 1;
+            const SpectrumIO::MKZYhdr header = written.Header(last);
+            m_hasChannelHeader = written.Decompress(last, writtenValues) && writtenValues == values;
+            m_channel = header.channel;
+            m_startChannel = header.startc;
+        }
+        m_triedChannelHeader = true;
+        return true;
+    }
+
+    // Compress the differences between the values, as CSpectrumIO does
+    const unsigned short checksum = CPakFileIndex::Checksum(values);
+    for (size_t k = values.size() - 1; k > 0; --k)
+    {
+        values[k] -= values[k - 1];
+    }
+    std::vector<unsigned char> compressed(values.size() * 6 + 16, 0); // <-- at most 12 bits of group header and 32 bits per value
+    const unsigned short compressedSize = mk_compress(values.data(), compressed.data(), (unsigned short)values.size());
+
+    std::vector<char> header(sourceHeader, sourceHeader + sourceHeaderSize);
+    SetHeaderField(header, offsetof(SpectrumIO::MKZYhdr, size), (decltype(SpectrumIO::MKZYhdr::size))compressedSize);
+    SetHeaderField(header, offsetof(SpectrumIO::MKZYhdr, checksum), (decltype(SpectrumIO::MKZYhdr::checksum))checksum);
+    SetHeaderField(header, offsetof(SpectrumIO::MKZYhdr, startc), m_startChannel);
+    SetHeaderField(header, offsetof(SpectrumIO::MKZYhdr, pixels), (decltype(SpectrumIO::MKZYhdr::pixels))values.size());
+    SetHeaderField(header, offsetof(SpectrumIO::MKZYhdr, channel), m_channel);
+
+    m_pending.insert(m_pending.end(), header.begin(), header.end());
+    m_pending.insert(m_pending.end(), compressed.begin(), compressed.begin() + compressedSize);
+    return true;
+}
+
+bool CScanFileWriter::Flush()
+{
+    if (m_pending.empty())
+    {
+        return true;
+    }
+
+    FILE* f = fopen(m_fileName, "ab");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    const size_t bytesWritten = fwrite(m_pending.data(), 1, m_pending.size(), f);
+    fclose(f);
+
+    const bool success = (bytesWritten == m_pending.size());
+    m_pending.clear();
+    return success;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <SpectralEvaluation/Spectra/Spectrum.h>
+#include <SpectralEvaluation/File/SpectrumIO.h>
+
+namespace FileHandler
+{
+    /** The <b>CScanFileWriter</b> collects the spectra of one scan in memory while a downloaded
+        .pak-file is being split up, and writes them to the scan-file in one go when the scan is complete.
+        The spectra are normally added as the binary records (header followed by the compressed data)
+        exactly as they were read from the downloaded file, such that they do not have to be compressed again.
+        The scan-file is only opened when the collected spectra are written, once per scan. */
+    class CScanFileWriter
+    {
+    public:
+        /** Sets the scan-file to write to. Any spectra not yet written are discarded. */
+        void SetFileName(const CString& fileName);
+
+        /** @return the scan-file which is written to */
+        const CString& FileName() const { return m_fileName; }
+
+        /** Adds one spectrum, as a complete binary record (header followed by the compressed data). */
+        void AddRecord(const char* record, size_t size);
+
+        /** Adds one channel of a multichannel spectrum, which needs to be compressed again.
+            The first such spectrum is written with CSpectrumIO, and the channel fields of the header
+            it writes are remembered. The following spectra are compressed into memory with the header
+            of the multichannel spectrum, 'sourceHeader', where only the channel fields, the size and
+            the checksum are changed.
+            @return false if the spectrum could not be written. */
+        bool AddSpectrum(const CSpectrum& spec, const char* sourceHeader, int sourceHeaderSize);
+
+        /** Writes all collected spectra to the end of the scan-file.
+            Nothing is done if there are no collected spectra.
+            @return true if successful. */
+        bool Flush();
+
+        /** @return true if there are spectra which are not yet written to the file */
+        bool HasPendingSpectra() const { return !m_pending.empty(); }
+
+    private:
+        /** The scan-file to write to */
+        CString m_fileName;
+
+        /** The binary records of the spectra which are not yet written to the file */
+        std::vector<char> m_pending;
+
+        /** True if the first spectrum added with AddSpectrum has been written with CSpectrumIO,
+            and the checksum and values in the record it wrote are the ones AddSpectrum calculates */
+        bool m_hasChannelHeader = false;
+
+        /** True if the header written by CSpectrumIO has been read back, successfully or not */
+        bool m_triedChannelHeader = false;
+
+        /** The channel and start-channel in the headers which CSpectrumIO writes for the spectra
+            added with AddSpectrum */
+        decltype(SpectrumIO::MKZYhdr::channel) m_channel = 0;
+        decltype(SpectrumIO::MKZYhdr::startc) m_startChannel = 0;
+
+        /** @return the values of the spectrum, as they are stored in the .pak-files */
+        static std::vector<long> StoredValues(const CSpectrum& spec);
+    };
+}
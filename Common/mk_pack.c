@@ -1,4 +1,6 @@
 
+#include "mk_pack.h"
+
 struct MKZYhdr
 {
   char ident[4];
@@ -27,6 +29,11 @@ struct MKZYhdr MKZY;
 
 #define headsiz 12
 
+/* The compressed data is a sequence of groups. Each group starts with a header of
+   'headsiz' bits, 7 bits with the number of values in the group followed by 5 bits
+   with the number of bits of each value, and is followed by the values of the group.
+   All bits are stored with the most significant bit first. */
+
 void SetBit(unsigned char *pek,long bit)
 {
   unsigned short ut=0x80;
@@ -39,61 +46,91 @@ void ClearBit(unsigned char *pek,long bit)
   pek[bit>>3]&=~(ut>>(bit&7));
 }
 
-void WriteBits(short a,short curr,long *inpek,unsigned char *utpek,long bitnr)
+/* Writes bit groups into a byte buffer. The bits are collected in a 64-bit word and
+   or:ed into the buffer a byte at a time, in the same way as SetBit does. */
+typedef struct
 {
-  short jj,j;
-  long utwrd;
-  long kk;
-  unsigned short utlng=0x80;
-  
-  utwrd=(unsigned long)( (a<<5) | (curr & 0x1f) );  
-  kk=1L<<(headsiz-1);
-  for(j=0;j<headsiz;j++)
+  unsigned char *pek;       /* the next byte to write to */
+  unsigned long long wrd;   /* the bits not yet written, in the lowest 'nbits' bits */
+  int nbits;
+} BitWriter;
+
+static void StartWriting(BitWriter *w,unsigned char *utpek,long bitnr)
+{
+  w->pek=utpek+(bitnr>>3);
+  w->wrd=0;                 /* or:ing the first bits of the byte with zeros leaves them */
+  w->nbits=(int)(bitnr&7);
+}
+
+static void PutBits(BitWriter *w,unsigned long val,int n)
+{
+  if(n<=0) return;
+  w->wrd=(w->wrd<<n) | (val & ((1ULL<<n)-1));
+  w->nbits+=n;
+  while(w->nbits>=8)
     {
-      if( utwrd & kk ) utpek[(bitnr>>3)]|=(utlng>>(bitnr&7));
-      bitnr++;
-      kk=kk>>1;
+      w->nbits-=8;
+      *w->pek++|=(unsigned char)(w->wrd>>w->nbits);
     }
-    
+}
+
+static void StopWriting(BitWriter *w)
+{
+  if(w->nbits>0) *w->pek|=(unsigned char)(w->wrd<<(8-w->nbits));
+}
+
+void WriteBits(short a,short curr,long *inpek,unsigned char *utpek,long bitnr)
+{
+  BitWriter w;
+  short jj;
+
+  StartWriting(&w,utpek,bitnr);
+  PutBits(&w,(unsigned long)( (a<<5) | (curr & 0x1f) ),headsiz);
   for(jj=0;jj<a;jj++)             /* spara undan alla */
-    {
-      kk=(1L<<(curr-1));
-      utwrd=*inpek++;
-      for(j=0;j<curr;j++)
-	{
-	  if( utwrd & kk ) utpek[(bitnr>>3)]|=(utlng>>(bitnr&7));
-	  bitnr++;
-	  kk=kk>>1;
-	}
-    }
+    PutBits(&w,(unsigned long)*inpek++,curr);
+  StopWriting(&w);
 }
 
+/* The number of bits in each byte value, 0 for 0 */
+static const unsigned char bitlen[256] =
+{
+  0,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4,
+  5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,
+  6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+  8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+  8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+  8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+  8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8
+};
+
+/* The number of bits needed to store i as a signed number,
+   0 for 0 and 1 for -1 */
 short BitsPrec(long i)
 {
-short j=1;
-if(!i) return(0);
-if(i<0)
-        {
-        if(i == -1) return(1);
-        while(i != -1 )
-                {
-                j++;
-                i=(i>>1);
-                }
-        }
-else
-while( i )
-        {
-        j++;
-        i=(i>>1);
-        }
-return(j);
+  unsigned long u;
+  short j=1;
+
+  if(!i) return(0);
+  if(i == -1) return(1);
+  u=(i<0) ? (unsigned long)~i : (unsigned long)i;
+  while(u>=256)
+    {
+      u>>=8;
+      j+=8;
+    }
+  return(j+bitlen[u]);
 }
 
-long bitnr;
-long *strt;
+/* The position in the compressed data and in the values, while compressing */
+typedef struct
+{
+  long bitnr;   /* the next bit to write */
+  long *strt;   /* the next value to compress */
+} PackState;
 
-void PackSeg(unsigned char *utpek, long *kvar )
+static void PackSeg(PackState *st,unsigned char *utpek, long *kvar )
 {
   short len[33];
   long j;
@@ -101,25 +138,25 @@ void PackSeg(unsigned char *utpek, long *kvar )
   short curr,i,a;
   
   for(j=0;j<33;j++) len[j]=0;
-  incpy=strt;
+  incpy=st->strt;
 
   i=BitsPrec(*incpy++);
   curr=i; 
   a=0;
   do {
     a++;
-    for(j=0;j<curr;j++)
+    /* the values which fit in j bits, for j<curr, make the run len[j] longer */
+    for(j=0;j<curr && j<i;j++) len[j]=0;
+    for(;j<curr;j++)
       {
-        if(i>j) len[j]=0;
-        else {
-          len[j]++;
-          if( len[j]*(curr-j)>headsiz*2)
-            {
-              a-=len[j];
-              goto Fixat;
-            }
-        }
-      } 
+        len[j]++;
+        if( len[j]*(curr-j)>headsiz*2)
+          {
+            a-=len[j];
+            goto Fixat;
+          }
+      }
+    if( a>=*kvar ) break;     /* all values are in the group, don't look beyond the end of the data */
     i=BitsPrec(*incpy++);    
     if(i>curr)
       {
@@ -139,75 +176,83 @@ void PackSeg(unsigned char *utpek, long *kvar )
   } while( a<*kvar && a<127 );
  Fixat:
     
-  WriteBits(a,curr,strt,utpek,bitnr);  
+  WriteBits(a,curr,st->strt,utpek,st->bitnr);  
   *kvar -=a;
-  strt += a;                  /* ka strt */
-  bitnr += a*curr+headsiz;
+  st->strt += a;              /* ka strt */
+  st->bitnr += a*curr+headsiz;
 }
 
 unsigned short mk_compress(long *in,unsigned char *ut,unsigned short size)
 {
+  PackState st;
   long kvar;
   unsigned short outsize;
 
-  strt=in;
+  st.strt=in;
   kvar=size;
-  bitnr=0;
+  st.bitnr=0;
   do {
-    PackSeg(ut,&kvar);
+    PackSeg(&st,ut,&kvar);
   } while( kvar>0);
 
-  outsize=(bitnr+7)>>3;
+  outsize=(st.bitnr+7)>>3;
   return(outsize);
 }
 
+/* Reads bit groups from a byte buffer, a byte at a time into a 64-bit word.
+   No byte is read unless some of its bits are used. */
+typedef struct
+{
+  const unsigned char *pek;   /* the next byte to read */
+  unsigned long long wrd;     /* the bits not yet used, in the lowest 'nbits' bits */
+  int nbits;
+} BitReader;
+
+static unsigned long GetBits(BitReader *r,int n)
+{
+  if(n<=0) return(0);
+  while(r->nbits<n)
+    {
+      r->wrd=(r->wrd<<8) | *r->pek++;
+      r->nbits+=8;
+    }
+  r->nbits-=n;
+  return((unsigned long)(r->wrd>>r->nbits) & (unsigned long)((1ULL<<n)-1));
+}
+
+/* Returns the 'n' lowest bits of 'v' as a signed value, the highest of them is the sign.
+   This is done in unsigned arithmetic, such that it does not overflow a 32-bit long for n=31. */
+static long SignExtend(unsigned long v,int n)
+{
+  const unsigned long m=1UL<<(n-1);
+  return((long)((v ^ m) - m));
+}
+
 long UnPack(unsigned char *inpek,long kvar,long *ut )
 {
+  BitReader r;
   long *utpek;
   short len,curr;
-  short j,jj;
+  short jj;
   long a;
   unsigned short lentofile=0;
-  long bit=0;
-  FILE *f;
   
-  /*  memcpy(ut,inpek,kvar*2);
-  return(kvar);
-  */
-  f=fopen("chunks.txt","w");
+  r.pek=inpek;
+  r.wrd=0;
+  r.nbits=0;
 
   utpek=ut;
   lentofile=0;  
   while(kvar>0)
     {
-      len=0;
-      for(j=0;j<7;j++)
-        {
-          len+=len;
-          len|=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
-          bit++;
-        }      
-      curr=0;
-      for(j=0;j<5;j++)
-        {
-          curr+=curr;
-          curr|=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
-          bit++;
-        }
-      fprintf(f,"%d %d\n",len,curr);    
+      len=(short)GetBits(&r,7);
+      curr=(short)GetBits(&r,5);
       if(curr)
         {
           for(jj=0;jj<len;jj++)
             {
-              a=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
-              if(a) a=-1;
-              bit++;
-              for(j=1;j<curr;j++)
-                {
-                  a+=a;
-                  a|=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
-                  bit++;
-                }
+              /* the values are stored with 'curr' bits, the first bit is the sign */
+              a=SignExtend(GetBits(&r,curr),curr);
               *utpek++=a;
             }
         }
@@ -219,6 +264,49 @@ long UnPack(unsigned char *inpek,long kvar,long *ut )
     {
       ut[jj]+=ut[jj-1];
     }
-  fclose(f);
+  return(lentofile);
+}
+
+/* As UnPack, but never reads more than 'insize' bytes from 'inpek' nor writes more than
+   'utsize' values to 'ut', such that damaged data can be decompressed safely.
+   Returns the number of values decompressed, or -1 if the data is damaged. */
+long UnPackChecked(const unsigned char *inpek,long insize,long kvar,long *ut,long utsize)
+{
+  BitReader r;
+  const unsigned char *endpek=inpek+insize;
+  long *utpek;
+  short len,curr;
+  short jj;
+  long a;
+  long lentofile=0;
+
+  r.pek=inpek;
+  r.wrd=0;
+  r.nbits=0;
+
+  utpek=ut;
+  while(kvar>0)
+    {
+      if( (endpek-r.pek)*8+r.nbits < headsiz ) return(-1);
+      len=(short)GetBits(&r,7);
+      curr=(short)GetBits(&r,5);
+      if( lentofile+len > utsize ) return(-1);
+      if( (endpek-r.pek)*8+r.nbits < (long)len*curr ) return(-1);
+      if(curr)
+        {
+          for(jj=0;jj<len;jj++)
+            {
+              a=SignExtend(GetBits(&r,curr),curr);
+              *utpek++=a;
+            }
+        }
+      else for(jj=0;jj<len;jj++) *utpek++=0;
+      kvar-=len;
+      lentofile+=len;
+    }
+  for(a=1;a<lentofile;a++)
+    {
+      ut[a]+=ut[a-1];
+    }
   return(lentofile);
 }
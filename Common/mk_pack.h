@@ -0,0 +1,26 @@
+#pragma once
+
+/** The compression of the spectra in the MKZY-format of the .pak-files, implemented in mk_pack.c.
+    The spectra are differentiated before they are compressed and integrated again when decompressed,
+    the values are stored in groups of values with the same number of bits. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /** Compresses the 'size' values in 'in' into 'ut', which must be zero-filled and large enough.
+        This can be called from several threads at the same time.
+        @return the number of bytes written to 'ut'. */
+    unsigned short mk_compress(long *in, unsigned char *ut, unsigned short size);
+
+    /** Decompresses 'kvar' values from 'inpek' into 'ut'.
+        @return the number of values decompressed, which may be larger than 'kvar' if the last group is. */
+    long UnPack(unsigned char *inpek, long kvar, long *ut);
+
+    /** As UnPack, but reads at most 'insize' bytes from 'inpek' and writes at most 'utsize' values to 'ut'.
+        @return the number of values decompressed, or -1 if the data is damaged. */
+    long UnPackChecked(const unsigned char *inpek, long insize, long kvar, long *ut, long utsize);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,18 +1,25 @@
 #include "StdAfx.h"
 #include "communicationdatastorage.h"
 #include "Common/Common.h"
+#include "Common/SnapshotFile.h"
 
-// ----------------- CLinkInfo - class ------------------------
-CCommunicationDataStorage::CLinkInfo::CLinkInfo() {
-	m_downloadSpeed = 0.0;
+// ----------------- CLinkHistory - class ------------------------
+CCommunicationDataStorage::CLinkHistory::CLinkHistory()
+	: m_time(MAX_HISTORY), m_downloadSpeed(MAX_HISTORY) {
 }
-CCommunicationDataStorage::CLinkInfo::~CLinkInfo() {
+CCommunicationDataStorage::CLinkHistory::~CLinkHistory() {
 }
-CCommunicationDataStorage::CLinkInfo &CCommunicationDataStorage::CLinkInfo::operator=(const CCommunicationDataStorage::CLinkInfo &info) {
-	this->m_downloadSpeed = info.m_downloadSpeed;
-	this->m_time = info.m_time;
-
-	return *this;
+void CCommunicationDataStorage::CLinkHistory::Append(double time, double downloadSpeed) {
+	m_time.PushBack(time);
+	m_downloadSpeed.PushBack(downloadSpeed);
+}
+void CCommunicationDataStorage::CLinkHistory::RemoveOlderThan(double time) {
+	size_t nOld = 0;
+	while (nOld < m_time.Size() && m_time[nOld] < time) {
+		++nOld;
+	}
+	m_time.PopFront(nOld);
+	m_downloadSpeed.PopFront(nOld);
 }
 
 // --------- CCommunicationDataStorage - class ----------------
@@ -22,9 +29,7 @@ CCommunicationDataStorage::CCommunicationDataStorage(void)
 	for (int i = 0; i < MAX_NUMBER_OF_SCANNING_INSTRUMENTS; ++i)
 		this->m_serials[i].Format("");
 	memset(m_communicationStatus, -1, sizeof(int)*MAX_NUMBER_OF_SCANNING_INSTRUMENTS);
-	memset(m_dataLinkIndex, 0, sizeof(int)*MAX_NUMBER_OF_SCANNING_INSTRUMENTS);
 
-	m_nFTPServerLinkInformation = 0;
 	m_serialNum = 0;
 }
 
@@ -105,29 +110,18 @@ int  CCommunicationDataStorage::GetScannerIndex(const CString &serial) {
 void	CCommunicationDataStorage::AddDownloadData(const CString &serial, double linkSpeed, const CDateTime *timeOfDownload) {
 	RemoveOldLinkInformation(); // First of all, clear out all old data
 
-	if (Equals(serial, "FTP")) {
-		// The data comes from the FTP-uploading link
-
-		// First check if the data-buffer is full
-		if (m_nFTPServerLinkInformation == MAX_HISTORY) {
-			// shift all data-bits down one step
-			for (int i = 0; i < MAX_HISTORY - 1; ++i) {
-				m_ftpServerLinkInformation[i] = m_ftpServerLinkInformation[i + 1];
-			}
-			--m_nFTPServerLinkInformation;
-		}
-
-		// replace the information
-		CLinkInfo &thisInfo = m_ftpServerLinkInformation[m_nFTPServerLinkInformation];
-		thisInfo.m_downloadSpeed = linkSpeed;
-		if (timeOfDownload == NULL) {
-			thisInfo.m_time.SetToNowUTC();
-		}
-		else {
-			thisInfo.m_time = *timeOfDownload;
-		}
+	Common common;
+	CDateTime time;
+	if (timeOfDownload == NULL) {
+		time.SetToNowUTC();
+	}
+	else {
+		time = *timeOfDownload;
+	}
 
-		++m_nFTPServerLinkInformation;
+	if (Equals(serial, "FTP")) {
+		// The data comes from the FTP-uploading link, if the buffer is full then the oldest data is dropped
+		m_ftpServerLinkInformation.Append(common.Epoch(time), linkSpeed);
 	}
 	else {
 		// The data comes from one of the scanners
@@ -137,26 +131,8 @@ void	CCommunicationDataStorage::AddDownloadData(const CString &serial, double li
 			return;
 		}
 
-		// First check if the data-buffer is full
-		if (m_dataLinkIndex[scannerIndex] == MAX_HISTORY) {
-			// shift all data-bits down one step
-			for (int i = 0; i < MAX_HISTORY; ++i) {
-				m_dataLinkInformation[scannerIndex][i] = m_dataLinkInformation[scannerIndex][i + 1];
-			}
-			--m_dataLinkIndex[scannerIndex];
-		}
-
-		// replace the information
-		CLinkInfo &thisInfo = m_dataLinkInformation[scannerIndex][m_dataLinkIndex[scannerIndex]];
-		thisInfo.m_downloadSpeed = linkSpeed;
-		if (timeOfDownload == NULL) {
-			thisInfo.m_time.SetToNowUTC();
-		}
-		else {
-			thisInfo.m_time = *timeOfDownload;
-		}
-
-		++m_dataLinkIndex[scannerIndex];
+		// if the buffer is full then the oldest data is dropped
+		m_dataLinkInformation[scannerIndex].Append(common.Epoch(time), linkSpeed);
 	}
 }
 
@@ -168,17 +144,11 @@ void	CCommunicationDataStorage::AddDownloadData(const CString &serial, double li
 	@return the number of data points copied into the dataBuffer*/
 long CCommunicationDataStorage::GetLinkSpeedData(const CString &serial, double *timeBuffer, double *dataBuffer, long bufferSize) {
 	int nCopy;
-	Common common;
 
 	if (Equals(serial, "FTP")) {
 		// Copy the link-speed data
-		nCopy = min(bufferSize, m_nFTPServerLinkInformation);
-		for (int i = 0; i < nCopy; ++i) {
-			CLinkInfo &info = m_ftpServerLinkInformation[i];
-			dataBuffer[i] = info.m_downloadSpeed;
-			timeBuffer[i] = common.Epoch(info.m_time);
-			//timeBuffer[i]			= info.m_time.hour * 3600.0 + info.m_time.minute * 60.0 + info.m_time.second;
-		}
+		nCopy = (int)m_ftpServerLinkInformation.m_downloadSpeed.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
+		m_ftpServerLinkInformation.m_time.CopyTo(timeBuffer, nCopy);
 	}
 	else {
 		// get the scanner index
@@ -188,35 +158,73 @@ long CCommunicationDataStorage::GetLinkSpeedData(const CString &serial, double *
 			return 0;
 
 		// Copy the link-speed data
-		nCopy = min(bufferSize, m_dataLinkIndex[scannerIndex]);
-		for (int i = 0; i < nCopy; ++i) {
-			CLinkInfo &info = m_dataLinkInformation[scannerIndex][i];
-			dataBuffer[i] = info.m_downloadSpeed;
-			timeBuffer[i] = common.Epoch(info.m_time);
-			//timeBuffer[i]			= info.m_time.hour * 3600.0 + info.m_time.minute * 60.0 + info.m_time.second;
-		}
+		nCopy = (int)m_dataLinkInformation[scannerIndex].m_downloadSpeed.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
+		m_dataLinkInformation[scannerIndex].m_time.CopyTo(timeBuffer, nCopy);
 	}
 
 	return nCopy;
 }
 
+/** Returns the time of the last download from the given instrument */
+double CCommunicationDataStorage::GetLastDownloadTime(const CString &serial) {
+	const CLinkHistory *link = &m_ftpServerLinkInformation;
+	if (!Equals(serial, "FTP")) {
+		int scannerIndex = GetScannerIndex(serial);
+		if (scannerIndex < 0)
+			return 0.0;
+		link = &m_dataLinkInformation[scannerIndex];
+	}
+
+	return link->m_time.Empty() ? 0.0 : link->m_time.Back();
+}
+
+void CCommunicationDataStorage::SaveSnapshot(FileHandler::CSnapshotWriter &snapshot) const {
+	snapshot.WriteRingBuffer(m_ftpServerLinkInformation.m_time);
+	snapshot.WriteRingBuffer(m_ftpServerLinkInformation.m_downloadSpeed);
+
+	snapshot.Write((uint32_t)m_serialNum);
+	for (unsigned int scannerIndex = 0; scannerIndex < m_serialNum; ++scannerIndex) {
+		snapshot.WriteString(m_serials[scannerIndex]);
+		snapshot.WriteRingBuffer(m_dataLinkInformation[scannerIndex].m_time);
+		snapshot.WriteRingBuffer(m_dataLinkInformation[scannerIndex].m_downloadSpeed);
+	}
+}
+
+bool CCommunicationDataStorage::LoadSnapshot(FileHandler::CSnapshotReader &snapshot) {
+	snapshot.ReadRingBuffer(m_ftpServerLinkInformation.m_time);
+	snapshot.ReadRingBuffer(m_ftpServerLinkInformation.m_downloadSpeed);
+
+	uint32_t serialNum = 0;
+	snapshot.Read(serialNum);
+	for (uint32_t it = 0; it < serialNum && snapshot.Ok(); ++it) {
+		CString serial;
+		CLinkHistory link;
+		snapshot.ReadString(serial);
+		snapshot.ReadRingBuffer(link.m_time);
+		snapshot.ReadRingBuffer(link.m_downloadSpeed);
+
+		// the link information is kept only if the spectrometer is known
+		int scannerIndex = GetScannerIndex(serial);
+		if (snapshot.Ok() && scannerIndex >= 0) {
+			m_dataLinkInformation[scannerIndex] = link;
+		}
+	}
+
+	if (!snapshot.Ok())
+		return false;
+
+	// the snapshot may have been taken some time ago
+	RemoveOldLinkInformation();
+
+	return true;
+}
+
 /** Clear out old data from the 'm_dataLinkInformation' buffers */
 void CCommunicationDataStorage::RemoveOldLinkInformation() {
 	Common common;
+	const double oldestTime = (double)common.Epoch() - 86400;
 	for (unsigned int scannerIndex = 0; scannerIndex < m_serialNum; ++scannerIndex) {
-		int k = 0;
-		// count how many records to remove
-		while (k < m_dataLinkIndex[scannerIndex]) {
-			if (common.Epoch() - common.Epoch(m_dataLinkInformation[scannerIndex][k].m_time) <= 86400) {
-				++k;
-			}
-			else {
-				// if this measurement is not from today, then remove it
-				for (int j = k; j < m_dataLinkIndex[scannerIndex] - 1; ++j) {
-					m_dataLinkInformation[scannerIndex][j] = m_dataLinkInformation[scannerIndex][j + 1];
-				}
-				--m_dataLinkIndex[scannerIndex];
-			}
-		}
+		// the downloads are stored in the order they were made, just advance past the old ones
+		m_dataLinkInformation[scannerIndex].RemoveOlderThan(oldestTime);
 	}
 }
@@ -1,21 +1,38 @@
 #pragma once
 
 #include "Common/Common.h"
+#include "Common/RingBuffer.h"
+
+namespace FileHandler
+{
+	class CSnapshotWriter;
+	class CSnapshotReader;
+}
+
 //GREEN - running, YELLOW - sleeping , RED - not connected
 const enum COMMUNICATION_STATUS {COMM_STATUS_GREEN, COMM_STATUS_YELLOW, COMM_STATUS_RED};
 
 class CCommunicationDataStorage
 {
 
-	// ------------------- class CLinkInfo -----------------------
+	// ------------------- class CLinkHistory -----------------------
 	// --- takes care of 'remembering' the status of each link ---
-	class CLinkInfo{
+	// --- each property is kept in its own ring-buffer, such that it can be copied out in one go ---
+	class CLinkHistory{
 	public:
-		CLinkInfo();
-		~CLinkInfo();
-		CDateTime		m_time;
-		double			m_downloadSpeed;
-		CLinkInfo &operator=(const CLinkInfo &);
+		CLinkHistory();
+		~CLinkHistory();
+		CRingBuffer<double> m_time;           // the time (epoch) of the download
+		CRingBuffer<double> m_downloadSpeed;  // the speed of the download
+
+		/** @return the number of downloads stored */
+		size_t Size() const { return m_time.Size(); }
+
+		/** Appends one download, if the history is full then the oldest download is removed */
+		void Append(double time, double downloadSpeed);
+
+		/** Removes the downloads which were made before the given time (epoch) */
+		void RemoveOlderThan(double time);
 	};
 
 public:
@@ -57,6 +74,20 @@ public:
 
 	/**Add one serial number into the m_serials[]array*/
 	int AddData(const CString &serial);
+
+	/** Returns the time (epoch) of the last download from the instrument with the
+		given serial-ID, or of the last upload if the serial equals "FTP".
+		Returns 0 if there is none */
+	double GetLastDownloadTime(const CString &serial);
+
+	/** Writes the link information of the last day to the given snapshot */
+	void SaveSnapshot(FileHandler::CSnapshotWriter &snapshot) const;
+
+	/** Restores the link information written by SaveSnapshot.
+		Only the spectrometers already added with AddData are restored, the others are skipped.
+		Information older than one day is removed.
+		@return false if the snapshot could not be read */
+	bool LoadSnapshot(FileHandler::CSnapshotReader &snapshot);
 private:
 
 	// ----------------------------------------------------------------------
@@ -72,12 +103,10 @@ private:
 	CString m_serials[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
 
 	/** Holds a list of the information we have on the data-links */
-	CLinkInfo	m_dataLinkInformation[MAX_NUMBER_OF_SCANNING_INSTRUMENTS][MAX_HISTORY];
-	int				m_dataLinkIndex[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
+	CLinkHistory m_dataLinkInformation[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
 
 	/** Holds the information about the FTP-uploading data link */
-	CLinkInfo m_ftpServerLinkInformation[MAX_HISTORY];
-	int				m_nFTPServerLinkInformation;
+	CLinkHistory m_ftpServerLinkInformation;
 
 	// ----------------------------------------------------------------------
 	// -------------------- PRIVATE METHODS ---------------------------------
@@ -23,6 +23,7 @@ CConfigurationSetting::CommunicationSetting::CommunicationSetting()
     this->baudrate = 115200;
     this->connectionType = FTP_CONNECTION;
     this->flowControl = 1;
+    this->pipelinedDownload = 0;
     this->port = 1;
     medium = MEDIUM_CABLE;
 
@@ -54,6 +55,7 @@ void CConfigurationSetting::CommunicationSetting::Clear()
     this->baudrate = 57600;
     this->connectionType = FTP_CONNECTION;
     this->flowControl = 1;
+    this->pipelinedDownload = 0;
     this->port = 1;
     medium = MEDIUM_CABLE;
 
@@ -133,6 +135,7 @@ void CConfigurationSetting::SpectrometerChannelSetting::Clear()
     fitWindow.nRef = 0;
     fitWindow.polyOrder = 5;
     fitWindow.specLength = 2048;
+    additionalFitWindowFile = "";
 
     m_darkSettings.Clear();
 }
@@ -141,6 +144,7 @@ void CConfigurationSetting::SpectrometerChannelSetting::Clear()
 CConfigurationSetting::SpectrometerChannelSetting &CConfigurationSetting::SpectrometerChannelSetting::operator =(const CConfigurationSetting::SpectrometerChannelSetting &spec2)
 {
     fitWindow = spec2.fitWindow;
+    additionalFitWindowFile = spec2.additionalFitWindowFile;
 
     m_darkSettings = spec2.m_darkSettings;
     return *this;
@@ -203,6 +207,7 @@ CConfigurationSetting::CommunicationSetting &CConfigurationSetting::Communicatio
     this->baudrate = comm2.baudrate;
     this->connectionType = comm2.connectionType;
     this->flowControl = comm2.flowControl;
+    this->pipelinedDownload = comm2.pipelinedDownload;
     this->port = comm2.port;
     this->medium = comm2.medium;
 
@@ -224,7 +229,7 @@ CConfigurationSetting::CommunicationSetting &CConfigurationSetting::Communicatio
 }
 /** ------------- Constructor for the ftp-settings ----------------- */
 CConfigurationSetting::CFTPSetting::CFTPSetting()
-    : ftpStatus(0), ftpAddress(""), userName(""), password(""), protocol("SFTP"), ftpStartTime(0), ftpStopTime(86400)
+    : ftpStatus(0), ftpAddress(""), userName(""), password(""), protocol("SFTP"), ftpStartTime(0), ftpStopTime(86400), parallelUploads(4)
 {
 }
 
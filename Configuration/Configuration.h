@@ -38,6 +38,11 @@ public:
         /** The timeout for communication */
         long timeout;
 
+        /** Non-zero if the files should be downloaded with several requests for data in flight
+            at the same time, only useful if connection type is serial. Older instruments only
+            handle one request at a time, this is therefore off unless turned on in the configuration. */
+        int pipelinedDownload;
+
         /** The medium through which the communciation occurs.
                 MEDIUM_CABLE corresponds to a cable,
                 MEDIUM_FREEWAVE_SERIAL_MODEM corresponds to a Freewave radio modem. */
@@ -86,6 +91,10 @@ public:
         /** The fit settings that are defined for this spectrometer */
         Evaluation::CFitWindow fitWindow;
 
+        /** The name and path of a .nfw file with more fit windows to evaluate the scans in.
+            The results are written to evaluation logs of their own, named after each window. Empty if not used. */
+        std::string additionalFitWindowFile;
+
         /** The settings for how to get the dark-spectrum */
         Configuration::CDarkSettings m_darkSettings;
 
@@ -284,6 +293,7 @@ public:
         int     ftpStatus;      // not used?
         int     ftpStartTime;   // the time of day when to start uploading (seconds since midnight)
         int     ftpStopTime;    // the time of day when to stop uploading (seconds since midnight)
+        int     parallelUploads; // the number of files to upload at the same time (SFTP only)
     };
 
     /** Settings for publishing the results on a web - page */
@@ -312,6 +322,23 @@ public:
         int enabled; // 1 if enabled; 0 if not
     };
 
+    /** Settings for how the evaluation of the scans is distributed over the processor cores */
+    class CEvaluationThreadSettings
+    {
+    public:
+        int threadsPerScan = 1; // the number of threads used to fit the spectra of one scan, 1 evaluates the spectra sequentially
+        int concurrentScans = 1; // the number of scans, from different spectrometers, which may be evaluated at the same time
+    };
+
+    /** Settings for how the text written to the log files is kept in memory before it is written to disk */
+    class CLogFileSettings
+    {
+    public:
+        int flushPolicy = LOGFLUSH_PER_SCAN; // when the buffered text is written to disk, one of the LOGFLUSH_ constants below
+        int flushInterval = 60; // the longest time, in seconds, the text is kept in memory when the policy is LOGFLUSH_TIMED
+        int bufferSize = 64; // the size of the buffer of each open log file, in kB
+    };
+
     CConfigurationSetting() = default;
 
     /** Resets all values to default */
@@ -326,6 +353,10 @@ public:
     static const int CHANGEMODE_SAFE = 0;
     static const int CHANGEMODE_FAST = 1;
 
+    static const int LOGFLUSH_PER_SCAN = 0;    // the log files are written to disk after each evaluated scan
+    static const int LOGFLUSH_TIMED = 1;       // the log files are written to disk at regular intervals
+    static const int LOGFLUSH_ON_SHUTDOWN = 2; // the log files are written to disk when the buffers are full, at midnight and when the program stops
+
     // ----------------------------------------------------------------
     // ----------------------- PUBLIC DATA ----------------------------
     // ----------------------------------------------------------------
@@ -353,6 +384,16 @@ public:
 
     /** The settings for retrieving the wind-field from external sources */
     CWindFieldDataSettings windSourceSettings;
+
+    /** The settings for the number of threads to use in the evaluation */
+    CEvaluationThreadSettings evaluationThreads;
+
+    /** The settings for how the log files are written to disk */
+    CLogFileSettings logFiles;
+
+    /** Set to 1 to write a binary evaluation log next to each text evaluation log,
+        this can be read much faster than the text file. */
+    int binaryEvaluationLog = 0;
 };
 
 // --------------------------------------------------------------------------------------------------------- 
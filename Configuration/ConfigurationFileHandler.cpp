@@ -208,6 +208,8 @@ int CConfigurationFileHandler::WriteConfigurationFile(CConfigurationSetting &con
     fprintf(f, str);
     str.Format("\t<ftpStopTime>%d</ftpStopTime>\n", conf->ftpSetting.ftpStopTime);
     fprintf(f, str);
+    str.Format("\t<ftpParallelUploads>%d</ftpParallelUploads>\n", conf->ftpSetting.parallelUploads);
+    fprintf(f, str);
 
 
     // 4f. Write if we should publish results
@@ -241,6 +243,36 @@ int CConfigurationFileHandler::WriteConfigurationFile(CConfigurationSetting &con
         fprintf(f, str);
     }
 
+    // 4i. The number of threads to use in the evaluation, if other than the default
+    if (conf->evaluationThreads.threadsPerScan > 1 || conf->evaluationThreads.concurrentScans > 1) {
+        str.Format("\t<evaluationThreads>\n");
+        str.AppendFormat("\t\t<perScan>%d</perScan>\n", conf->evaluationThreads.threadsPerScan);
+        str.AppendFormat("\t\t<concurrentScans>%d</concurrentScans>\n", conf->evaluationThreads.concurrentScans);
+        str.AppendFormat("\t</evaluationThreads>\n");
+        fprintf(f, str);
+    }
+
+    // 4j. How the log files are written to disk, if other than the default
+    const CConfigurationSetting::CLogFileSettings defaultLogFiles;
+    if (conf->logFiles.flushPolicy != defaultLogFiles.flushPolicy || conf->logFiles.flushInterval != defaultLogFiles.flushInterval || conf->logFiles.bufferSize != defaultLogFiles.bufferSize) {
+        str.Format("\t<logFiles>\n");
+        switch (conf->logFiles.flushPolicy) {
+        case CConfigurationSetting::LOGFLUSH_TIMED: str.AppendFormat("\t\t<flush>timed</flush>\n"); break;
+        case CConfigurationSetting::LOGFLUSH_ON_SHUTDOWN: str.AppendFormat("\t\t<flush>shutdown</flush>\n"); break;
+        default: str.AppendFormat("\t\t<flush>scan</flush>\n"); break;
+        }
+        str.AppendFormat("\t\t<flushInterval>%d</flushInterval>\n", conf->logFiles.flushInterval);
+        str.AppendFormat("\t\t<bufferSize>%d</bufferSize>\n", conf->logFiles.bufferSize);
+        str.AppendFormat("\t</logFiles>\n");
+        fprintf(f, str);
+    }
+
+    // 4k. If the binary evaluation logs should be written
+    if (conf->binaryEvaluationLog) {
+        str.Format("\t<binaryEvaluationLog>%d</binaryEvaluationLog>\n", conf->binaryEvaluationLog);
+        fprintf(f, str);
+    }
+
     // 5. Begin the device list
     fprintf(f, TEXT("\t<deviceList>\n"));
 
@@ -381,6 +413,12 @@ int CConfigurationFileHandler::WriteConfigurationFile(CConfigurationSetting &con
                 str.Format("\t%s<fitHigh>%ld</fitHigh>\n", (LPCSTR)indent, spec.channel[l].fitWindow.fitHigh);
                 fprintf(f, str);
 
+                // the file with the additional fit windows
+                if (spec.channel[l].additionalFitWindowFile.size() > 0) {
+                    str.Format("\t%s<additionalFitWindows>%s</additionalFitWindows>\n", (LPCSTR)indent, spec.channel[l].additionalFitWindowFile.c_str());
+                    fprintf(f, str);
+                }
+
                 // The options for the dark-current
                 if (spec.channel[l].m_darkSettings.m_darkSpecOption != Configuration::DARK_SPEC_OPTION::MEASURED_IN_SCAN)
                 {
@@ -440,6 +478,10 @@ int CConfigurationFileHandler::WriteConfigurationFile(CConfigurationSetting &con
                 str.Format("%s<flowControl>%d</flowControl>\n", (LPCSTR)indent, comm.flowControl);
                 fprintf(f, str);
 
+                // several requests in flight when downloading
+                str.Format("%s<pipelinedDownload>%d</pipelinedDownload>\n", (LPCSTR)indent, comm.pipelinedDownload);
+                fprintf(f, str);
+
                 // The communication medium
                 str.Format("%s<medium>", (LPCSTR)indent);
                 switch (comm.medium) {
@@ -592,6 +634,11 @@ int CConfigurationFileHandler::Parse() {
             conf->ftpSetting.ftpStopTime = abs(conf->ftpSetting.ftpStopTime);
             continue;
         }
+        if (Equals(szToken, "ftpParallelUploads")) {
+            Parse_IntItem(TEXT("/ftpParallelUploads"), conf->ftpSetting.parallelUploads);
+            conf->ftpSetting.parallelUploads = max(min(conf->ftpSetting.parallelUploads, 16), 1);
+            continue;
+        }
 
         if (Equals(szToken, "publishFormat")) {
             Parse_StringItem(TEXT("/publishFormat"), conf->webSettings.imageFormat);
@@ -620,6 +667,19 @@ int CConfigurationFileHandler::Parse() {
             this->Parse_WindImport();
         }
 
+        if (Equals(szToken, "evaluationThreads")) {
+            this->Parse_EvaluationThreads();
+        }
+
+        if (Equals(szToken, "logFiles")) {
+            this->Parse_LogFiles();
+        }
+
+        if (Equals(szToken, "binaryEvaluationLog")) {
+            Parse_IntItem(TEXT("/binaryEvaluationLog"), conf->binaryEvaluationLog);
+            continue;
+        }
+
         // -----------------------------------------------------
         // ------------- Scanning Instrument Settings ----------
         // -----------------------------------------------------
@@ -842,6 +902,11 @@ int CConfigurationFileHandler::Parse_Communication() {
             continue;
         }
 
+        if (Equals(szToken, "pipelinedDownload")) {
+            Parse_IntItem(TEXT("/pipelinedDownload"), curComm->pipelinedDownload);
+            continue;
+        }
+
 
 
         if (Equals(szToken, "timeout")) {
@@ -1094,6 +1159,12 @@ int CConfigurationFileHandler::Parse_Channel()
             continue;
         }
 
+        if (Equals(szToken, "additionalFitWindows")) {
+            if (curSpec != NULL)
+                this->Parse_StringItem(TEXT("/additionalFitWindows"), curChannel->additionalFitWindowFile);
+            continue;
+        }
+
         if (Equals(szToken, "dark")) {
             if (curSpec != NULL)
                 Parse_IntItem(TEXT("/dark"), tmpInt);
@@ -1544,6 +1615,93 @@ int CConfigurationFileHandler::Parse_WindImport() {
     return 0;
 }
 
+int CConfigurationFileHandler::Parse_EvaluationThreads() {
+    // the actual reading loop
+    while (szToken = NextToken()) {
+
+        // no use to parse empty lines
+        if (strlen(szToken) < 3)
+            continue;
+
+        // ignore comments
+        if (Equals(szToken, "!--", 3)) {
+            continue;
+        }
+
+        // the end of the evaluationThreads section
+        if (Equals(szToken, "/evaluationThreads")) {
+            return 0;
+        }
+
+        // found the number of threads to use for each scan
+        if (Equals(szToken, "perScan")) {
+            Parse_IntItem("/perScan", conf->evaluationThreads.threadsPerScan);
+            if (conf->evaluationThreads.threadsPerScan < 1)
+                conf->evaluationThreads.threadsPerScan = 1;
+            continue;
+        }
+
+        // found the number of scans which may be evaluated at the same time
+        if (Equals(szToken, "concurrentScans")) {
+            Parse_IntItem("/concurrentScans", conf->evaluationThreads.concurrentScans);
+            if (conf->evaluationThreads.concurrentScans < 1)
+                conf->evaluationThreads.concurrentScans = 1;
+            continue;
+        }
+    }
+    return 0;
+}
+
+int CConfigurationFileHandler::Parse_LogFiles() {
+    // the actual reading loop
+    while (szToken = NextToken()) {
+
+        // no use to parse empty lines
+        if (strlen(szToken) < 3)
+            continue;
+
+        // ignore comments
+        if (Equals(szToken, "!--", 3)) {
+            continue;
+        }
+
+        // the end of the logFiles section
+        if (Equals(szToken, "/logFiles")) {
+            return 0;
+        }
+
+        // found when the log files should be written to disk
+        if (Equals(szToken, "flush")) {
+            CString policy;
+            Parse_StringItem("/flush", policy);
+            if (Equals(policy, "timed"))
+                conf->logFiles.flushPolicy = CConfigurationSetting::LOGFLUSH_TIMED;
+            else if (Equals(policy, "shutdown"))
+                conf->logFiles.flushPolicy = CConfigurationSetting::LOGFLUSH_ON_SHUTDOWN;
+            else
+                conf->logFiles.flushPolicy = CConfigurationSetting::LOGFLUSH_PER_SCAN;
+            continue;
+        }
+
+        // found the interval between writing the log files to disk
+        if (Equals(szToken, "flushInterval")) {
+            Parse_IntItem("/flushInterval", conf->logFiles.flushInterval);
+            if (conf->logFiles.flushInterval < 1)
+                conf->logFiles.flushInterval = 1;
+            continue;
+        }
+
+        // found the size of the buffer of each log file
+        if (Equals(szToken, "bufferSize")) {
+            Parse_IntItem("/bufferSize", conf->logFiles.bufferSize);
+            if (conf->logFiles.bufferSize < 1)
+                conf->logFiles.bufferSize = 1;
+            continue;
+        }
+    }
+    return 0;
+}
+
 int CConfigurationFileHandler::CheckSettings() {
 
     // -------- FTP - SETTINGS -------------------
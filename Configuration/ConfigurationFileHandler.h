@@ -98,6 +98,12 @@ namespace FileHandler
     
     /** Parses the 'windImport' - section */
     int Parse_WindImport();
+
+    /** Parses the 'evaluationThreads' - section */
+    int Parse_EvaluationThreads();
+
+    /** Parses the 'logFiles' - section */
+    int Parse_LogFiles();
     
     /** Parses the 'motor' - section */
     int Parse_Motor();
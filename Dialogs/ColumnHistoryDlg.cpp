@@ -7,12 +7,10 @@
 #include "afxdialogex.h"
 #include <afxwin.h>
 #include <ctime>
-#include <fstream>
 #include "../Configuration/Configuration.h"
 #include "../Configuration/ConfigurationFileHandler.h"
 #include "../UserSettings.h"
-#include "../Common/EvaluationLogFileHandler.h"
-#include <SpectralEvaluation/StringUtils.h>
+#include "../Common/DailyRollup.h"
 
 extern CConfigurationSetting	g_settings;
 extern CUserSettings			g_userSettings;
@@ -230,7 +228,6 @@ void ColumnHistoryDlg::ReadEvalLogs() {
 	CWaitCursor wait;
 	for (int day = 0; day < 30; day++) {
 		m_index[day] = 0;
-		FileHandler::CEvaluationLogFileHandler evalLogReader;
 
 		// get date
 		utc->tm_sec -= (SECONDS_IN_DAY);
@@ -248,48 +245,19 @@ void ColumnHistoryDlg::ReadEvalLogs() {
 			(LPCTSTR)m_serialNumber,
 			(LPCTSTR)dateStr);
 
-		// check if file exists
-		std::ifstream ifile(path);
-		if (!ifile) {
+		// Read the columns of the day from the rollup of the eval-log, it is built the first time it is needed
+		FileHandler::CDailyRollup rollup;
+		if (!rollup.ReadColumns(path)) {
 			continue;
 		}
 
-		// Try to read the eval-log
-		evalLogReader.m_evaluationLog.Format(path);
-		if (FAIL == evalLogReader.ReadEvaluationLog())
-			continue;
-
-		// check if there are scan in log
-		if (evalLogReader.m_scanNum <= 0) {
-			continue;
-		}
-
-		// Plot the read in data
-		int scanNum = evalLogReader.m_scanNum;
-		for (int j = 0; j < scanNum; ++j) {
-			Evaluation::CScanResult &sr = evalLogReader.m_scan[j];
-			for (unsigned long k = 0; k < sr.GetEvaluatedNum(); ++k) {
-				// Check if this is a dark measurement, if so then don't include it...
-				// 1. Clean the spectrum name from special characters...
-				std::string spectrumName = CleanString(sr.GetSpectrumInfo(k).m_name);
-				Trim(spectrumName, " \t");
-				if (fabs(sr.GetScanAngle(k)) - 180.0 < 1e-3 && (EqualsIgnoringCase(spectrumName, "offset") || EqualsIgnoringCase(spectrumName, "dark_cur") || EqualsIgnoringCase(spectrumName, "dark"))) {
-					continue;
-				}
-
-				CDateTime st;
-				sr.GetStartTime(k, st);
-				int startsec = st.hour * 3600 + st.minute * 60 + st.second;
-				double epoch = (double)(epochDay + startsec - offset); // unsure why offset substraction is needed but it is
-				double col = sr.GetColumn(k, 0); //Assumes SO2 ref is at index 0
-				bool isBadFit = sr.IsBad(k);
-				if (!isBadFit && m_index[day] < 10000) {
-					m_time[day][m_index[day]] = epoch;
-					m_column[day][m_index[day]] = col*unitConversionFactor;
-					m_index[day]++;
-				}
+		for (const FileHandler::CRollupPoint &point : rollup.m_good) {
+			if (m_index[day] >= 10000) {
+				break;
 			}
-
+			m_time[day][m_index[day]] = (double)(epochDay - offset) + point.secondOfDay; // unsure why offset substraction is needed but it is
+			m_column[day][m_index[day]] = point.value * unitConversionFactor;
+			m_index[day]++;
 		}
 	}
 	wait.Restore();
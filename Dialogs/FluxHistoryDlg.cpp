@@ -7,12 +7,10 @@
 #include "afxdialogex.h"
 #include <afxwin.h>
 #include <ctime>
-#include <fstream>
 #include "../Configuration/Configuration.h"
 #include "../Configuration/ConfigurationFileHandler.h"
 #include "../UserSettings.h"
-#include "../Common/FluxLogFileHandler.h"
-#include <SpectralEvaluation/StringUtils.h>
+#include "../Common/DailyRollup.h"
 
 extern CConfigurationSetting	g_settings;
 extern CUserSettings			g_userSettings;
@@ -262,7 +260,8 @@ void FluxHistoryDlg::ReadFluxLogs() {
 	CString path, dateStr;
 	CWaitCursor wait;
 	for (int day = 0; day < 30; day++) {
-		FileHandler::CFluxLogFileHandler fluxLogReader;
+		m_goodFluxNum[day] = 0;
+		m_badFluxNum[day] = 0;
 
 		// get date
 		utc->tm_sec -= (SECONDS_IN_DAY);
@@ -280,41 +279,27 @@ void FluxHistoryDlg::ReadFluxLogs() {
 			(LPCTSTR)m_serialNumber,
 			(LPCTSTR)dateStr);
 
-		// check if file exists
-		std::ifstream ifile(path);
-		if (!ifile) {
+		// Read the fluxes of the day from the rollup of the flux-log, it is built the first time it is needed
+		FileHandler::CDailyRollup rollup;
+		if (!rollup.ReadFluxes(path)) {
 			continue;
 		}
 
-		// Try to read the flux-log
-		fluxLogReader.m_fluxLog.Format(path);
-		if (FAIL == fluxLogReader.ReadFluxLog())
-			return;
-
-		// check if there are fluxes in log
-		int fluxNum = fluxLogReader.m_fluxesNum;
-		if (fluxNum <= 0) {
-			continue;
-		}
-
-		// Plot the read in data
-		m_goodFluxNum[day] = 0;
-		m_badFluxNum[day] = 0;
-		for (int j = 0; j < fluxNum; ++j) {
-			Evaluation::CFluxResult &fr = fluxLogReader.m_fluxes[j];
-			CDateTime st = fr.m_startTime;
-			int startsec = st.hour * 3600 + st.minute * 60 + st.second;
-			double epoch = (double)(epochDay + startsec - offset); // unsure why offset substraction is needed but it is
-			if (fr.m_fluxOk && m_goodFluxNum[day] < 500) {
-				m_goodTime[day][m_goodFluxNum[day]] = epoch;
-				m_goodFlux[day][m_goodFluxNum[day]] = fr.m_flux * unitConversionFactor;
-				m_goodFluxNum[day]++;
+		for (const FileHandler::CRollupPoint &point : rollup.m_good) {
+			if (m_goodFluxNum[day] >= 500) {
+				break;
 			}
-			if (!fr.m_fluxOk && m_badFluxNum[day] < 500) {
-				m_badTime[day][m_badFluxNum[day]] = epoch;
-				m_badFlux[day][m_badFluxNum[day]] = fr.m_flux * unitConversionFactor;
-				m_badFluxNum[day]++;
+			m_goodTime[day][m_goodFluxNum[day]] = (double)(epochDay - offset) + point.secondOfDay; // unsure why offset substraction is needed but it is
+			m_goodFlux[day][m_goodFluxNum[day]] = point.value * unitConversionFactor;
+			m_goodFluxNum[day]++;
+		}
+		for (const FileHandler::CRollupPoint &point : rollup.m_bad) {
+			if (m_badFluxNum[day] >= 500) {
+				break;
 			}
+			m_badTime[day][m_badFluxNum[day]] = (double)(epochDay - offset) + point.secondOfDay;
+			m_badFlux[day][m_badFluxNum[day]] = point.value * unitConversionFactor;
+			m_badFluxNum[day]++;
 		}
 	}
 	wait.Restore();
@@ -7,6 +7,9 @@
 #include "../Common/Common.h"
 #include <SpectralEvaluation/File/SpectrumIO.h>
 #include <SpectralEvaluation/Spectra/SpectrometerModel.h>
+#include "../Configuration/Configuration.h"
+
+extern CConfigurationSetting g_settings;	// <-- The settings
 
 // CPakFileInspector dialog
 using namespace Dialogs;
@@ -198,7 +201,6 @@ void CPakFileInspector::OnOpenPakFile()
 }
 
 void CPakFileInspector::CheckPakFile(){
-	SpectrumIO::CSpectrumIO reader;
 	CSpectrum spec;
 	CFile *pFile = NULL;
 	ULONGLONG fileSize = 0;
@@ -222,15 +224,22 @@ void CPakFileInspector::CheckPakFile(){
 		delete pFile;
 	}
 
-	// Count the spectra
+	// Index the file, this also counts the spectra
+	//  The index is cached in the temporary directory, never next to the file which is inspected
     const std::string fName((LPCSTR)m_fileName);
-	m_spectrumNum = reader.CountSpectra(fName);
+	CString cacheDirectory;
+	cacheDirectory.Format("%sTemp\\PakFileIndex\\", (LPCSTR)g_settings.outputDirectory);
+	if (0 == CreateDirectoryStructure(cacheDirectory))
+		m_pakFileIndex.Build(fName, std::string((LPCSTR)cacheDirectory));
+	else
+		m_pakFileIndex.Build(fName);
+	m_spectrumNum = (int)m_pakFileIndex.SpectrumNum();
 
 	// Get the start-time of the first spectrum
-    reader.ReadSpectrum(fName, 0, firstSpectrum);
+	m_pakFileIndex.ReadSpectrum(0, firstSpectrum);
 
 	// Get the stop-time of the last spectrum
-    reader.ReadSpectrum(fName, m_spectrumNum - 1, lastSpectrum);
+	m_pakFileIndex.ReadSpectrum(m_spectrumNum - 1, lastSpectrum);
 
 	// ---- Show the information to the user... ----
 	int index = 0;
@@ -407,14 +416,14 @@ void CPakFileInspector::UpdateFileInfo(){
 }
 
 int CPakFileInspector::TryReadSpectrum(){
-	SpectrumIO::CSpectrumIO reader;
 	CString message;
 	char headerBuffer[16384];
 	int headerSize=0;
 
-	// Read the spectrum
-    const std::string fName((LPCSTR)m_fileName);
-    const bool ret = reader.ReadSpectrum(fName, m_curSpectrum, m_spectrum, headerBuffer, 16384, &headerSize);
+	// Read the spectrum, seeking directly to it in the file
+	if(m_curSpectrum < 0)
+		return 1;
+    const bool ret = m_pakFileIndex.ReadSpectrum(m_curSpectrum, m_spectrum, headerBuffer, 16384, &headerSize);
 
 	if(!ret){
 //    switch(reader.m_lastError){
@@ -3,6 +3,7 @@
 #include "../Graphs/SpectrumGraph.h"
 #include <SpectralEvaluation/Spectra/Spectrum.h>
 #include <SpectralEvaluation/File/MKPack.h>
+#include "../Common/Spectra/PakFileIndex.h"
 
 // CPakFileInspector dialog
 
@@ -33,6 +34,9 @@ namespace Dialogs{
 		/** The number of spectra in the .pak-file */
 		int		m_spectrumNum;
 
+		/** The positions of the spectra in the .pak-file, lets us read any spectrum directly */
+		FileHandler::CPakFileIndex m_pakFileIndex;
+
 		/** The contents of the spectrum 'm_curspectrum' */
 		CSpectrum	m_spectrum;
 
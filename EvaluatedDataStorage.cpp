@@ -3,37 +3,48 @@
 #include "Configuration/Configuration.h"
 #include "VolcanoInfo.h"
 #include "UserSettings.h"
+#include "Common/SnapshotFile.h"
 #include <SpectralEvaluation/StringUtils.h>
 #include <SpectralEvaluation/Spectra/SpectrometerModel.h>
+#include <vector>
 
 extern CConfigurationSetting g_settings;   // <-- The settings
 extern CVolcanoInfo g_volcanoes;           // <-- The global database of volcanoes
 extern CUserSettings g_userSettings;       // <-- The users preferences
 
-// ------------------------ CSCANDATA ------------------------------
-CEvaluatedDataStorage::CScanData::CScanData(){
-	m_flux		= 0.0;
-	m_fluxOk	= true;
-	m_time		= 0.0;
-	m_date		= 0;
-	m_battery	= 0.0;
-	m_temp		= 0.0;
-	m_expTime	= 0;
+// ------------------------ CSCANHISTORY ------------------------------
+CEvaluatedDataStorage::CScanHistory::CScanHistory()
+	: m_time(MAX_HISTORY), m_flux(MAX_HISTORY), m_fluxOk(MAX_HISTORY),
+	m_battery(MAX_HISTORY), m_temp(MAX_HISTORY), m_expTime(MAX_HISTORY)
+{
 }
 
-CEvaluatedDataStorage::CScanData::~CScanData(){
+CEvaluatedDataStorage::CScanHistory::~CScanHistory(){
 }
 
-CEvaluatedDataStorage::CScanData &CEvaluatedDataStorage::CScanData::operator=(const CEvaluatedDataStorage::CScanData &sd){
-	this->m_flux    = sd.m_flux;
-	this->m_fluxOk  = sd.m_fluxOk;
-	this->m_time    = sd.m_time;
-	this->m_date    = sd.m_date;
-	this->m_battery = sd.m_battery;
-	this->m_temp    = sd.m_temp;
-	this->m_expTime = sd.m_expTime;
+void CEvaluatedDataStorage::CScanHistory::Append(double time, double flux, bool fluxOk, double battery, double temp, long expTime){
+	m_time.PushBack(time);
+	m_flux.PushBack(flux);
+	m_fluxOk.PushBack(fluxOk ? 1 : 0);
+	m_battery.PushBack(battery);
+	m_temp.PushBack(temp);
+	m_expTime.PushBack((double)expTime);
+}
 
-	return *this;
+void CEvaluatedDataStorage::CScanHistory::RemoveOlderThan(double time){
+	size_t nOld = 0;
+	while(nOld < m_time.Size() && m_time[nOld] < time){
+		++nOld;
+	}
+	if(nOld == 0)
+		return;
+
+	m_time.PopFront(nOld);
+	m_flux.PopFront(nOld);
+	m_fluxOk.PopFront(nOld);
+	m_battery.PopFront(nOld);
+	m_temp.PopFront(nOld);
+	m_expTime.PopFront(nOld);
 }
 
 // ------------------------ CSPECTRUMDATA ------------------------------
@@ -63,7 +74,45 @@ CEvaluatedDataStorage::CSpectrumData &CEvaluatedDataStorage::CSpectrumData::oper
 	return *this;
 }
 
-// ------------------------ CSCANDATA ------------------------------
+// ------------------------ CSPECTRUMHISTORY ------------------------------
+
+CEvaluatedDataStorage::CSpectrumHistory::CSpectrumHistory()
+	: m_time(MAX_SPEC_HISTORY), m_column(MAX_SPEC_HISTORY), m_columnError(MAX_SPEC_HISTORY),
+	m_peakSaturation(MAX_SPEC_HISTORY), m_fitSaturation(MAX_SPEC_HISTORY), m_angle(MAX_SPEC_HISTORY), m_isBadFit(MAX_SPEC_HISTORY)
+{
+}
+
+CEvaluatedDataStorage::CSpectrumHistory::~CSpectrumHistory(){
+}
+
+void CEvaluatedDataStorage::CSpectrumHistory::Append(double time, double column, double columnError, double peakSaturation, double fitSaturation, double angle, bool isBadFit){
+	m_time.PushBack(time);
+	m_column.PushBack(column);
+	m_columnError.PushBack(columnError);
+	m_peakSaturation.PushBack(peakSaturation);
+	m_fitSaturation.PushBack(fitSaturation);
+	m_angle.PushBack(angle);
+	m_isBadFit.PushBack(isBadFit ? 1 : 0);
+}
+
+void CEvaluatedDataStorage::CSpectrumHistory::RemoveOlderThan(double time){
+	size_t nOld = 0;
+	while(nOld < m_time.Size() && m_time[nOld] < time){
+		++nOld;
+	}
+	if(nOld == 0)
+		return;
+
+	m_time.PopFront(nOld);
+	m_column.PopFront(nOld);
+	m_columnError.PopFront(nOld);
+	m_peakSaturation.PopFront(nOld);
+	m_fitSaturation.PopFront(nOld);
+	m_angle.PopFront(nOld);
+	m_isBadFit.PopFront(nOld);
+}
+
+// ------------------------ CWINDMEASDATA ------------------------------
 CEvaluatedDataStorage::CWindMeasData::CWindMeasData(){
 	m_scannerIndex = 0;
 	m_time         = 0;
@@ -98,9 +147,6 @@ CEvaluatedDataStorage::CEvaluatedDataStorage(void)
 	memset(m_temperatureRange[0], 999, MAX_NUMBER_OF_SCANNING_INSTRUMENTS * sizeof(double));
 	memset(m_temperatureRange[1], -999, MAX_NUMBER_OF_SCANNING_INSTRUMENTS * sizeof(double));
 
-	memset(m_fluxIndex, 0, MAX_NUMBER_OF_SCANNING_INSTRUMENTS * sizeof(int));
-	memset(m_specIndex, 0, MAX_NUMBER_OF_SCANNING_INSTRUMENTS * sizeof(int));
-
 	for(int i = 0; i < MAX_NUMBER_OF_SCANNING_INSTRUMENTS; ++i)
 		this->m_serials[i].Format("");
 
@@ -240,13 +286,8 @@ int CEvaluatedDataStorage::AddData(const CString &serial, Evaluation::CScanResul
 	// add the offset
 	m_offset[scannerIndex] = result->GetOffset();
 
-	// add the temperature
+	// the temperature and exposure-time of flux-scans are stored in AppendFluxResult
 	double curTemp = result->GetTemperature();
-	m_data[scannerIndex][m_fluxIndex[scannerIndex]].m_temp = curTemp;
-
-	// add the exposure-time
-	long curExpTime	= result->GetExposureTime(0);
-	m_data[scannerIndex][m_fluxIndex[scannerIndex]].m_expTime = curExpTime;
 
 	// if this is the highest or the lowest temperature today, then remember it
 	if(fabs(curTemp) < 100.0){
@@ -347,12 +388,17 @@ void CEvaluatedDataStorage::GetFluxRange(const CString &serial, double &minFlux,
 		unitConversionFactor = 3.6 * 24.0;
 
 	// find the maximum flux
-	maxFlux = m_data[scannerIndex][0].m_flux;
-	minFlux = m_data[scannerIndex][0].m_flux;
+	const CRingBuffer<double> &flux = m_data[scannerIndex].m_flux;
+	if(flux.Empty()){
+		minFlux = maxFlux = 0;
+		return;
+	}
+	maxFlux = flux[0];
+	minFlux = flux[0];
 
-	for(int i = 0; i < m_fluxIndex[scannerIndex]; ++i){
-		maxFlux = max(maxFlux, m_data[scannerIndex][i].m_flux);
-		minFlux = min(minFlux, m_data[scannerIndex][i].m_flux);
+	for(size_t i = 0; i < flux.Size(); ++i){
+		maxFlux = max(maxFlux, flux[i]);
+		minFlux = min(minFlux, flux[i]);
 	}
 
 	// convert to the correct unit
@@ -373,10 +419,11 @@ void CEvaluatedDataStorage::GetColumnRange(const CString &serial, double &minCol
 	minColumn = 1e9;
 
 	if (fullDay) {
-		for (int i = 0; i < m_specIndex[scannerIndex]; ++i) {
-			if (!m_specDataDay[scannerIndex][i].m_isBadFit) {
-				maxColumn = max(maxColumn, m_specDataDay[scannerIndex][i].m_column);
-				minColumn = min(minColumn, m_specDataDay[scannerIndex][i].m_column);
+		const CSpectrumHistory &history = m_specDataDay[scannerIndex];
+		for (size_t i = 0; i < history.Size(); ++i) {
+			if (!history.m_isBadFit[i]) {
+				maxColumn = max(maxColumn, history.m_column[i]);
+				minColumn = min(minColumn, history.m_column[i]);
 			}
 		}
 	}
@@ -422,83 +469,37 @@ void CEvaluatedDataStorage::GetAngleRange(const CString &serial, double &minAngl
 void CEvaluatedDataStorage::AppendSpecDataHistory(int scannerIndex, int time, double column, double columnError, 
 	double peakSaturation, double fitSaturation, double angle, bool isBadFit) {
 	// If there are any old values in the array then remove them before appending more data.
-	RemoveOldSpec(scannerIndex);
-
-	// m_specIndex[scannerIndex] is the number of data-points there are in
-	//	the array of col-values
-	if (m_specIndex[scannerIndex] < MAX_SPEC_PER_SCAN * 300) {
-		// insert the datapoint into the array
-		int index = m_specIndex[scannerIndex];
-		m_specDataDay[scannerIndex][index].m_time = time;
-		m_specDataDay[scannerIndex][index].m_column = column;
-		m_specDataDay[scannerIndex][index].m_columnError = columnError;
-		m_specDataDay[scannerIndex][index].m_peakSaturation = peakSaturation;
-		m_specDataDay[scannerIndex][index].m_fitSaturation = fitSaturation;
-		m_specDataDay[scannerIndex][index].m_angle = angle;
-		m_specDataDay[scannerIndex][index].m_isBadFit = isBadFit;
-		++m_specIndex[scannerIndex];
-	}
+	RemoveOldSpec();
+
+	// insert the datapoint into the history, if the history is full then the oldest datapoint is dropped
+	m_specDataDay[scannerIndex].Append(time, column, columnError, peakSaturation, fitSaturation, angle, isBadFit);
 }
 /** Removes old spec data */
-void  CEvaluatedDataStorage::RemoveOldSpec(int scannerIndex) {
+void  CEvaluatedDataStorage::RemoveOldSpec() {
 	Common common;
+	const double oldestTime = (double)common.Epoch() - 86400;
 	for (unsigned int scannerIndex = 0; scannerIndex < m_serialNum; ++scannerIndex) {
-		int k = 0;
-		// count how many records to remove
-		while (k < m_specIndex[scannerIndex]) {
-			if (common.Epoch() - m_specDataDay[scannerIndex][k].m_time <= 86400) {
-				++k;
-			}
-			else {
-				// if this measurement is not from today, then remove it
-				for (int j = k; j < m_specIndex[scannerIndex] - 1; ++j) {
-					m_specDataDay[scannerIndex][j] = m_specDataDay[scannerIndex][j + 1];
-				}
-				--m_specIndex[scannerIndex];
-			}
-		}
+		// the data-points are stored in the order they were made, just advance past the old ones
+		m_specDataDay[scannerIndex].RemoveOlderThan(oldestTime);
 	}
 }
 
 void CEvaluatedDataStorage::AppendFluxResult(int scannerIndex, const CDateTime &time, double fluxValue, bool fluxOk, double batteryVoltage, double temp, long expTime){
 	// If there are any old values in the array then remove them before appending more data.
 	RemoveOldFluxResults();
-	// m_fluxIndex[scannerIndex] is the number of data-points there are in
-	//	the array of flux-values
 
+	// insert the datapoint into the history, if the history is full then the oldest datapoint is dropped
 	Common common;
-	if(m_fluxIndex[scannerIndex] < MAX_HISTORY){
-		// insert the datapoint into the array
-		int index = m_fluxIndex[scannerIndex];
-		m_data[scannerIndex][index].m_flux      = fluxValue;
-		m_data[scannerIndex][index].m_fluxOk    = fluxOk;
-		m_data[scannerIndex][index].m_time = common.Epoch(time);
-		m_data[scannerIndex][index].m_date      = time.day;
-		m_data[scannerIndex][index].m_battery   = batteryVoltage;
-		m_data[scannerIndex][index].m_temp      = temp;
-		m_data[scannerIndex][index].m_expTime   = expTime;
-		++m_fluxIndex[scannerIndex];
-	}
+	m_data[scannerIndex].Append(common.Epoch(time), fluxValue, fluxOk, batteryVoltage, temp, expTime);
 }
 
 /** Removes old flux results */
 void  CEvaluatedDataStorage::RemoveOldFluxResults(){
 	Common common;
+	const double oldestTime = (double)common.Epoch() - 86400;
 	for (unsigned int scannerIndex = 0; scannerIndex < m_serialNum; ++scannerIndex) {
-		int k = 0;
-		// count how many records to remove
-		while (k < m_fluxIndex[scannerIndex]) {
-			if (common.Epoch() - m_data[scannerIndex][k].m_time <= 86400) {
-				++k;
-			}
-			else {
-				// if this measurement is not from today, then remove it
-				for (int j = k; j < m_fluxIndex[scannerIndex] - 1; ++j) {
-					m_data[scannerIndex][j] = m_data[scannerIndex][j + 1];
-				}
-				--m_fluxIndex[scannerIndex];
-			}
-		}
+		// the results are stored in the order they were made, just advance past the old ones
+		m_data[scannerIndex].RemoveOlderThan(oldestTime);
 	}
 
 	// other clean up below (for new UTC day)
@@ -558,10 +559,11 @@ long CEvaluatedDataStorage::GetColumnData(const CString &serial, double *dataBuf
 	int nCopy;
 	if (fullDay) {
 		// full day
-		nCopy = min(bufferSize, m_specIndex[scannerIndex]);
+		nCopy = (int)m_specDataDay[scannerIndex].m_column.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
+		m_specDataDay[scannerIndex].m_columnError.CopyTo(dataErrorBuffer, nCopy);
 		for (int i = 0; i < nCopy; ++i) {
-			dataBuffer[i] = m_specDataDay[scannerIndex][i].m_column * unitConversionFactor;
-			dataErrorBuffer[i] = m_specDataDay[scannerIndex][i].m_columnError * unitConversionFactor;
+			dataBuffer[i] *= unitConversionFactor;
+			dataErrorBuffer[i] *= unitConversionFactor;
 		}
 	}
 	else {
@@ -592,10 +594,7 @@ long CEvaluatedDataStorage::GetTimeData(const CString &serial, double *dataBuffe
 
 	int nCopy;
 	if (fullDay) {
-		nCopy = min(bufferSize, m_specIndex[scannerIndex]);
-		for (int i = 0; i < nCopy; ++i) {
-			dataBuffer[i] = (double)m_specDataDay[scannerIndex][i].m_time;
-		}
+		nCopy = (int)m_specDataDay[scannerIndex].m_time.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
 	}
 	else {
 		nCopy = min(bufferSize, m_positionsNum[scannerIndex]);
@@ -629,10 +628,11 @@ long CEvaluatedDataStorage::GetBadColumnData(const CString &serial, double *data
 
 	int nCopy;
 	if (fullDay) {
-		nCopy = min(bufferSize, m_specIndex[scannerIndex]);
+		const CSpectrumHistory &history = m_specDataDay[scannerIndex];
+		nCopy = (int)history.m_column.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
 		for (int k = 0; k < nCopy; ++k) {
-			if (m_specDataDay[scannerIndex][k].m_isBadFit)
-				dataBuffer[k] = m_specDataDay[scannerIndex][k].m_column * unitConversionFactor;
+			if (history.m_isBadFit[k])
+				dataBuffer[k] *= unitConversionFactor;
 			else
 				dataBuffer[k] = 0;
 		}
@@ -672,10 +672,11 @@ long CEvaluatedDataStorage::GetGoodColumnData(const CString &serial, double *dat
 
 	int nCopy;
 	if (fullDay) {
-		nCopy = min(bufferSize, m_specIndex[scannerIndex]);
+		const CSpectrumHistory &history = m_specDataDay[scannerIndex];
+		nCopy = (int)history.m_column.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
 		for (int k = 0; k < nCopy; ++k) {
-			if (!m_specDataDay[scannerIndex][k].m_isBadFit)
-				dataBuffer[k] = m_specDataDay[scannerIndex][k].m_column * unitConversionFactor;
+			if (!history.m_isBadFit[k])
+				dataBuffer[k] *= unitConversionFactor;
 			else
 				dataBuffer[k] = 0;
 		}
@@ -709,11 +710,8 @@ long CEvaluatedDataStorage::GetIntensityData(const CString &serial, double *peak
 
 	int nCopy;
 	if (fullDay) {
-		nCopy = min(bufferSize, m_specIndex[scannerIndex]);
-		for (int i = 0; i < nCopy; ++i) {
-			peakSat[i] = m_specDataDay[scannerIndex][i].m_peakSaturation;
-			fitSat[i] = m_specDataDay[scannerIndex][i].m_fitSaturation;
-		}
+		nCopy = (int)m_specDataDay[scannerIndex].m_peakSaturation.CopyTo(peakSat, (size_t)max(bufferSize, 0L));
+		m_specDataDay[scannerIndex].m_fitSaturation.CopyTo(fitSat, nCopy);
 	}
 	else {
 		nCopy = min(bufferSize, m_positionsNum[scannerIndex]);
@@ -773,11 +771,12 @@ long CEvaluatedDataStorage::GetFluxData(const CString &serial, double *timeBuffe
 	}
 
 	// Copy the flux data
-	int nCopy = min(bufferSize, m_fluxIndex[scannerIndex]);
+	const CScanHistory &history = m_data[scannerIndex];
+	int nCopy = (int)history.m_flux.CopyTo(dataBuffer, (size_t)max(bufferSize, 0L));
+	history.m_fluxOk.CopyTo(qualityBuffer, nCopy);
+	history.m_time.CopyTo(timeBuffer, nCopy);
 	for(int i = 0; i < nCopy; ++i){
-		dataBuffer[i]     = m_data[scannerIndex][i].m_flux * unitConversionFactor;
-		qualityBuffer[i]  = (m_data[scannerIndex][i].m_fluxOk) ? 1 : 0;
-		timeBuffer[i]     = m_data[scannerIndex][i].m_time;
+		dataBuffer[i] *= unitConversionFactor;
 	}
 
 	return nCopy;
@@ -937,10 +936,10 @@ double CEvaluatedDataStorage::GetTemperature(const CString &serial){
 	if(scannerIndex < 0)
 		return -1;
 
-	if(m_fluxIndex[scannerIndex] == 0)
+	if(m_data[scannerIndex].m_temp.Empty())
 		return 0.0;
 	else
-		return m_data[scannerIndex][m_fluxIndex[scannerIndex]-1].m_temp;
+		return m_data[scannerIndex].m_temp.Back();
 }
 
 /** Gets the temperature of saved scans.
@@ -954,11 +953,8 @@ long CEvaluatedDataStorage::GetTemperatureData(const CString &serial, double *ti
 	if(scannerIndex < 0)
 		return -1;
 
-	long nCopy = min(m_fluxIndex[scannerIndex], bufferSize);
-	for(int i = 0; i < nCopy; ++i){
-		timeBuffer[i]	= m_data[scannerIndex][i].m_time;
-		dataBuffer[i]	=	m_data[scannerIndex][i].m_temp;
-	}
+	long nCopy = (long)m_data[scannerIndex].m_time.CopyTo(timeBuffer, (size_t)max(bufferSize, 0L));
+	m_data[scannerIndex].m_temp.CopyTo(dataBuffer, nCopy);
 
 	return nCopy;
 }
@@ -969,10 +965,10 @@ double CEvaluatedDataStorage::GetBatteryVoltage(const CString &serial){
 	if(scannerIndex < 0)
 		return -1;
 
-	if(m_fluxIndex[scannerIndex] <= 0)
+	if(m_data[scannerIndex].m_battery.Empty())
 		return 0.0;
 	else
-		return m_data[scannerIndex][m_fluxIndex[scannerIndex]-1].m_battery;
+		return m_data[scannerIndex].m_battery.Back();
 }
 
 /** Gets the battery-voltage of saved scans.
@@ -986,11 +982,8 @@ long CEvaluatedDataStorage::GetBatteryVoltageData(const CString &serial, double
 	if(scannerIndex < 0)
 		return -1;
 
-	long nCopy = min(m_fluxIndex[scannerIndex], bufferSize);
-	for(int i = 0; i < nCopy; ++i){
-		timeBuffer[i] = m_data[scannerIndex][i].m_time;
-		dataBuffer[i] = m_data[scannerIndex][i].m_battery;
-	}
+	long nCopy = (long)m_data[scannerIndex].m_time.CopyTo(timeBuffer, (size_t)max(bufferSize, 0L));
+	m_data[scannerIndex].m_battery.CopyTo(dataBuffer, nCopy);
 
 	return nCopy;
 }
@@ -1006,11 +999,8 @@ long CEvaluatedDataStorage::GetExposureTimeData(const CString &serial, double *t
 	if(scannerIndex < 0)
 		return -1;
 
-	long nCopy = min(m_fluxIndex[scannerIndex], bufferSize);
-	for(int i = 0; i < nCopy; ++i){
-		timeBuffer[i] = m_data[scannerIndex][i].m_time;
-		dataBuffer[i] = m_data[scannerIndex][i].m_expTime;
-	}
+	long nCopy = (long)m_data[scannerIndex].m_time.CopyTo(timeBuffer, (size_t)max(bufferSize, 0L));
+	m_data[scannerIndex].m_expTime.CopyTo(dataBuffer, nCopy);
 
 	return nCopy;
 }
@@ -1041,10 +1031,11 @@ double	CEvaluatedDataStorage::GetMinBatteryVoltage(const CString &serial){
 	if(scannerIndex < 0)
 		return -1;
 
+	const CRingBuffer<double> &battery = m_data[scannerIndex].m_battery;
 	double minVoltage = 999;
-	for(int i = 0; i < m_fluxIndex[scannerIndex]; ++i){
-		if(m_data[scannerIndex][i].m_battery > -990)
-			minVoltage = min(minVoltage, m_data[scannerIndex][i].m_battery);
+	for(size_t i = 0; i < battery.Size(); ++i){
+		if(battery[i] > -990)
+			minVoltage = min(minVoltage, battery[i]);
 	}
 	return minVoltage;
 }
@@ -1055,14 +1046,189 @@ double	CEvaluatedDataStorage::GetMaxBatteryVoltage(const CString &serial){
 	if(scannerIndex < 0)
 		return -1;
 
+	const CRingBuffer<double> &battery = m_data[scannerIndex].m_battery;
 	double maxVoltage = -999;
-	for(int i = 0; i < m_fluxIndex[scannerIndex]; ++i){
-		if(m_data[scannerIndex][i].m_battery < 1000)
-			maxVoltage = max(maxVoltage, m_data[scannerIndex][i].m_battery);
+	for(size_t i = 0; i < battery.Size(); ++i){
+		if(battery[i] < 1000)
+			maxVoltage = max(maxVoltage, battery[i]);
 	}
 	return maxVoltage;
 }
 
+/** Gets the time of the last flux result stored for the given spectrometer */
+double CEvaluatedDataStorage::GetLastFluxTime(const CString &serial){
+	int scannerIndex = GetScannerIndex(serial);
+	if(scannerIndex < 0 || m_data[scannerIndex].m_time.Empty())
+		return 0.0;
+
+	return m_data[scannerIndex].m_time.Back();
+}
+
+/** Gets the time of the last spectrum stored for the given spectrometer */
+double CEvaluatedDataStorage::GetLastSpectrumTime(const CString &serial){
+	int scannerIndex = GetScannerIndex(serial);
+	if(scannerIndex < 0 || m_specDataDay[scannerIndex].m_time.Empty())
+		return 0.0;
+
+	return m_specDataDay[scannerIndex].m_time.Back();
+}
+
+void CEvaluatedDataStorage::SaveSnapshot(FileHandler::CSnapshotWriter &snapshot) const{
+	snapshot.Write((uint32_t)m_serialNum);
+
+	for(unsigned int scannerIndex = 0; scannerIndex < m_serialNum; ++scannerIndex){
+		snapshot.WriteString(m_serials[scannerIndex]);
+
+		// the scans of the last day
+		const CScanHistory &scans = m_data[scannerIndex];
+		snapshot.WriteRingBuffer(scans.m_time);
+		snapshot.WriteRingBuffer(scans.m_flux);
+		snapshot.WriteRingBuffer(scans.m_fluxOk);
+		snapshot.WriteRingBuffer(scans.m_battery);
+		snapshot.WriteRingBuffer(scans.m_temp);
+		snapshot.WriteRingBuffer(scans.m_expTime);
+
+		// the spectra of the last day
+		const CSpectrumHistory &spectra = m_specDataDay[scannerIndex];
+		snapshot.WriteRingBuffer(spectra.m_time);
+		snapshot.WriteRingBuffer(spectra.m_column);
+		snapshot.WriteRingBuffer(spectra.m_columnError);
+		snapshot.WriteRingBuffer(spectra.m_peakSaturation);
+		snapshot.WriteRingBuffer(spectra.m_fitSaturation);
+		snapshot.WriteRingBuffer(spectra.m_angle);
+		snapshot.WriteRingBuffer(spectra.m_isBadFit);
+
+		// the last scan
+		snapshot.Write((int32_t)m_positionsNum[scannerIndex]);
+		for(int k = 0; k < m_positionsNum[scannerIndex]; ++k){
+			const CSpectrumData &sd = m_specData[scannerIndex][k];
+			snapshot.Write((int32_t)sd.m_time);
+			snapshot.Write(sd.m_column);
+			snapshot.Write(sd.m_columnError);
+			snapshot.Write(sd.m_peakSaturation);
+			snapshot.Write(sd.m_fitSaturation);
+			snapshot.Write(sd.m_angle);
+			snapshot.Write((uint8_t)(sd.m_isBadFit ? 1 : 0));
+		}
+		snapshot.Write(m_offset[scannerIndex]);
+		snapshot.Write(m_plumeCentre[scannerIndex]);
+
+		// the wind-speed measurements made today
+		uint32_t windMeasurementNum = 0;
+		POSITION pos = m_windData.GetHeadPosition();
+		while(pos != NULL){
+			if(m_windData.GetNext(pos).m_scannerIndex == (int)scannerIndex)
+				++windMeasurementNum;
+		}
+		snapshot.Write(windMeasurementNum);
+		pos = m_windData.GetHeadPosition();
+		while(pos != NULL){
+			const CWindMeasData &wd = m_windData.GetNext(pos);
+			if(wd.m_scannerIndex != (int)scannerIndex)
+				continue;
+			snapshot.Write((int32_t)wd.m_time);
+			snapshot.Write((int32_t)wd.m_date);
+			snapshot.Write((int32_t)wd.m_duration);
+			snapshot.Write(wd.m_correlation);
+			snapshot.Write(wd.m_windSpeed);
+			snapshot.Write(wd.m_windSpeedErr);
+		}
+	}
+}
+
+bool CEvaluatedDataStorage::LoadSnapshot(FileHandler::CSnapshotReader &snapshot){
+	uint32_t serialNum = 0;
+	if(!snapshot.Read(serialNum))
+		return false;
+
+	for(uint32_t it = 0; it < serialNum && snapshot.Ok(); ++it){
+		CString serial;
+		snapshot.ReadString(serial);
+
+		// The data is read into temporary objects, and kept only if the spectrometer is known
+		CScanHistory scans;
+		snapshot.ReadRingBuffer(scans.m_time);
+		snapshot.ReadRingBuffer(scans.m_flux);
+		snapshot.ReadRingBuffer(scans.m_fluxOk);
+		snapshot.ReadRingBuffer(scans.m_battery);
+		snapshot.ReadRingBuffer(scans.m_temp);
+		snapshot.ReadRingBuffer(scans.m_expTime);
+
+		CSpectrumHistory spectra;
+		snapshot.ReadRingBuffer(spectra.m_time);
+		snapshot.ReadRingBuffer(spectra.m_column);
+		snapshot.ReadRingBuffer(spectra.m_columnError);
+		snapshot.ReadRingBuffer(spectra.m_peakSaturation);
+		snapshot.ReadRingBuffer(spectra.m_fitSaturation);
+		snapshot.ReadRingBuffer(spectra.m_angle);
+		snapshot.ReadRingBuffer(spectra.m_isBadFit);
+
+		int32_t positionsNum = 0;
+		snapshot.Read(positionsNum);
+		if(positionsNum < 0 || positionsNum > MAX_SPEC_PER_SCAN)
+			return false;
+		CSpectrumData lastScan[MAX_SPEC_PER_SCAN];
+		for(int k = 0; k < positionsNum; ++k){
+			int32_t time = 0;
+			uint8_t isBadFit = 0;
+			snapshot.Read(time);
+			snapshot.Read(lastScan[k].m_column);
+			snapshot.Read(lastScan[k].m_columnError);
+			snapshot.Read(lastScan[k].m_peakSaturation);
+			snapshot.Read(lastScan[k].m_fitSaturation);
+			snapshot.Read(lastScan[k].m_angle);
+			snapshot.Read(isBadFit);
+			lastScan[k].m_time     = time;
+			lastScan[k].m_isBadFit = (isBadFit != 0);
+		}
+		double offset = 0.0, plumeCentre = 0.0;
+		snapshot.Read(offset);
+		snapshot.Read(plumeCentre);
+
+		uint32_t windMeasurementNum = 0;
+		snapshot.Read(windMeasurementNum);
+		std::vector<CWindMeasData> windData;
+		for(uint32_t k = 0; k < windMeasurementNum && snapshot.Ok(); ++k){
+			int32_t time = 0, date = 0, duration = 0;
+			CWindMeasData wd;
+			snapshot.Read(time);
+			snapshot.Read(date);
+			snapshot.Read(duration);
+			snapshot.Read(wd.m_correlation);
+			snapshot.Read(wd.m_windSpeed);
+			snapshot.Read(wd.m_windSpeedErr);
+			wd.m_time     = time;
+			wd.m_date     = date;
+			wd.m_duration = duration;
+			windData.push_back(wd);
+		}
+
+		int scannerIndex = GetScannerIndex(serial);
+		if(!snapshot.Ok() || scannerIndex < 0)
+			continue;
+
+		m_data[scannerIndex]        = scans;
+		m_specDataDay[scannerIndex] = spectra;
+		for(int k = 0; k < positionsNum; ++k)
+			m_specData[scannerIndex][k] = lastScan[k];
+		m_positionsNum[scannerIndex] = positionsNum;
+		m_offset[scannerIndex]       = offset;
+		m_plumeCentre[scannerIndex]  = plumeCentre;
+		for(CWindMeasData &wd : windData){
+			wd.m_scannerIndex = scannerIndex;
+			m_windData.AddTail(wd);
+		}
+	}
+
+	if(!snapshot.Ok())
+		return false;
+
+	// the snapshot may have been taken some time ago
+	RemoveOldFluxResults();
+	RemoveOldSpec();
+
+	return true;
+}
 
 /** Returns the spectrometer index given a serial number */
 int CEvaluatedDataStorage::GetScannerIndex(const CString &serial){
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "Common/Common.h"
+#include "Common/RingBuffer.h"
 #include "Evaluation/ScanResult.h"
 #include "WindMeasurement/WindSpeedResult.h"
 
+namespace FileHandler
+{
+	class CSnapshotWriter;
+	class CSnapshotReader;
+}
+
 /** <b>CEvaluatedDataStorage</b> is a class for holding evaluated data for 
     later plotting. */
 
@@ -11,20 +18,28 @@ const enum SPECTROMETER_STATUS {STATUS_GREEN, STATUS_YELLOW, STATUS_RED};
 
 class CEvaluatedDataStorage
 {
-	// ------------------- class CScanData ----------------------
-	// --- takes care of 'remembering' data from entire scans ---
-	class CScanData{
+	// ------------------- class CScanHistory ----------------------
+	// --- takes care of 'remembering' data from the entire scans of the last day ---
+	// --- each property is kept in its own ring-buffer, such that it can be copied out in one go ---
+	class CScanHistory{
 	public:
-		CScanData();
-		~CScanData();
-		double	m_flux;				// the calculated flux [kg/s]
-		bool		m_fluxOk;		// true if the flux-value is a good measurement
-		double	m_time;				// the time-of-day (seconds since midnight) when the scan was started
-		int			m_date;			// the date (day of month) when the scan was made
-		double	m_battery;			// the battery voltage [V] when the scan was started
-		double	m_temp;				// the temperature of the instrument [deg C] when the scan was started
-		long		m_expTime;		// the exposure-time of the measurement
-		CScanData &operator=(const CScanData &);
+		CScanHistory();
+		~CScanHistory();
+		CRingBuffer<double> m_time;     // the time (epoch) when the scan was made
+		CRingBuffer<double> m_flux;     // the calculated flux [kg/s]
+		CRingBuffer<int>    m_fluxOk;   // 1 if the flux-value is a good measurement, otherwise 0
+		CRingBuffer<double> m_battery;  // the battery voltage [V] when the scan was started
+		CRingBuffer<double> m_temp;     // the temperature of the instrument [deg C] when the scan was started
+		CRingBuffer<double> m_expTime;  // the exposure-time of the measurement
+
+		/** @return the number of scans stored */
+		size_t Size() const { return m_time.Size(); }
+
+		/** Appends one scan, if the history is full then the oldest scan is removed */
+		void Append(double time, double flux, bool fluxOk, double battery, double temp, long expTime);
+
+		/** Removes the scans which were made before the given time (epoch) */
+		void RemoveOlderThan(double time);
 	};
 
 	// ------------------- class CSpectrumData --------------------
@@ -43,6 +58,31 @@ class CEvaluatedDataStorage
 		CSpectrumData &operator=(const CSpectrumData &);
 	};
 
+	// ------------------- class CSpectrumHistory --------------------
+	// --- takes care of 'remembering' the spectra of the last day -----
+	// --- each property is kept in its own ring-buffer, such that it can be copied out in one go ---
+	class CSpectrumHistory{
+	public:
+		CSpectrumHistory();
+		~CSpectrumHistory();
+		CRingBuffer<double> m_time;           // the time (epoch) of each spectrum
+		CRingBuffer<double> m_column;         // the evaluated columns
+		CRingBuffer<double> m_columnError;    // the error in the evaluated columns
+		CRingBuffer<double> m_peakSaturation; // the peak saturation-ratios of the spectrum
+		CRingBuffer<double> m_fitSaturation;  // the maximum saturation-ratio in the fit region of the spectrum
+		CRingBuffer<double> m_angle;          // the scan angle used
+		CRingBuffer<int>    m_isBadFit;       // 1 if the evaluated spectrum is a bad fit, otherwise 0
+
+		/** @return the number of spectra stored */
+		size_t Size() const { return m_time.Size(); }
+
+		/** Appends one spectrum, if the history is full then the oldest spectrum is removed */
+		void Append(double time, double column, double columnError, double peakSaturation, double fitSaturation, double angle, bool isBadFit);
+
+		/** Removes the spectra which were collected before the given time (epoch) */
+		void RemoveOlderThan(double time);
+	};
+
 	// ------------------- class CWindMeasData -----------------------
 	// --- takes care of 'remembering' data wind-measurements made ---
 	class CWindMeasData{
@@ -70,6 +110,9 @@ public:
 
 	static const int MAX_HISTORY = 1000;
 
+	/** The maximum number of spectra remembered from the last day, for each spectrometer */
+	static const int MAX_SPEC_HISTORY = MAX_SPEC_PER_SCAN * 30;
+
 	// ----------------------------------------------------------------------
 	// ---------------------- PUBLIC METHODS --------------------------------
 	// ----------------------------------------------------------------------
@@ -235,6 +278,23 @@ public:
 
 	/** Gets the highest recorded battery voltage for the given spectrometer */
 	double GetMaxBatteryVoltage(const CString &serial);
+
+	/** Gets the time (epoch) of the last flux result stored for the given spectrometer.
+		Returns 0 if there is none */
+	double GetLastFluxTime(const CString &serial);
+
+	/** Gets the time (epoch) of the last spectrum stored in the history of the day
+		for the given spectrometer. Returns 0 if there is none */
+	double GetLastSpectrumTime(const CString &serial);
+
+	/** Writes the data of the last day, for all spectrometers, to the given snapshot */
+	void SaveSnapshot(FileHandler::CSnapshotWriter &snapshot) const;
+
+	/** Restores the data written by SaveSnapshot. Only the data of spectrometers which
+		already have been inserted (with AddData) is restored, the data of other spectrometers
+		is skipped. Data older than one day is removed.
+		@return false if the snapshot could not be read */
+	bool LoadSnapshot(FileHandler::CSnapshotReader &snapshot);
 	
 private:
 	// ----------------------------------------------------------------------
@@ -251,10 +311,7 @@ private:
 	int m_positionsNum[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
 
 	/** The information about the spectra for the day */
-	CSpectrumData m_specDataDay[MAX_NUMBER_OF_SCANNING_INSTRUMENTS][MAX_SPEC_PER_SCAN*30];
-
-	/** The number of positions in each m_specDataDay */
-	int m_specIndex[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
+	CSpectrumHistory m_specDataDay[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
 
 	/** The offset in the measurement */
 	double m_offset[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
@@ -266,8 +323,7 @@ private:
 	double m_temperatureRange[2][MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
 
 	/** The 'scan-memory' */
-	CScanData m_data[MAX_NUMBER_OF_SCANNING_INSTRUMENTS][MAX_HISTORY];
-	int m_fluxIndex[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
+	CScanHistory m_data[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
 
 	/** The list of wind-speed measurements made.
 	    This is impplemented as a list for simplicity, the number of wind-speed
@@ -296,8 +352,8 @@ private:
 	/** Removes old flux results */
 	void RemoveOldFluxResults();
 
-	/** Reset spec index */
-	void  RemoveOldSpec(int scannerIndex);
+	/** Removes the spectra older than one day */
+	void  RemoveOldSpec();
 
 	/** Returns the spectrometer index given a serial number */
 	int GetScannerIndex(const CString &serial);
@@ -1,6 +1,7 @@
 #include "StdAfx.h"
 #include "evaluationcontroller.h"
 #include "ScanEvaluation.h"
+#include "FitWindowFileHandler.h"
 
 #ifdef _MSC_VER
 #pragma warning (push, 4)
@@ -20,6 +21,11 @@
 
 // ... support for handling the evaluation-log files...
 #include "../Common/EvaluationLogFileHandler.h"
+#include "../Common/BinaryEvaluationLog.h"
+#include "../Common/BufferedLogWriter.h"
+#include "../Common/SnapshotFile.h"
+#include "../Common/DailyRollup.h"
+#include "../Common/LogTail.h"
 
 // For the moment we also need the geometry calculator and the list of volcanoes...
 //	THIS IS ONLY USED FOR THE HEIDELBEG GEOMETRY CALCULATIONS AND SHOULD BE MOVED LATER ...
@@ -38,10 +44,35 @@ extern CFormView				*pView;			// <-- The screen
 extern CWinThread				*g_windMeas;	// <-- The thread that evaluates the wind-measurements.
 extern CWinThread				*g_geometry;	// <-- The thread that performes geometrical calculations from the scans
 extern CWinThread				*g_comm;		// <-- the communication controller
+extern CCriticalSection			g_evalLogCritSect; // <-- synchronization access to evaluation-log files
+extern CBufferedLogWriter		g_logFiles;		// <-- the open log files
+extern CLogTail					g_logTails;		// <-- the logs read so far
 
 UINT primaryLanguage;
 UINT subLanguage;
 
+/** The identifier of the snapshot files of the spectrometer histories */
+static const char HISTORY_SNAPSHOT_IDENTIFIER[8] = { 'N', 'O', 'V', 'H', 'I', 'S', '0', '1' };
+
+/** @return the suffix added to the names of the log files of the given fit window,
+    the characters which are not allowed in file names are replaced with '_' */
+static CString FitWindowFileSuffix(const Evaluation::CFitWindow &window, size_t fitWindowIndex) {
+    CString name(window.name.c_str());
+    for (int k = 0; k < name.GetLength(); ++k) {
+        if ((unsigned char)name[k] < 32 || nullptr != strchr("\\/:*?\"<>|", name[k])) {
+            name.SetAt(k, '_');
+        }
+    }
+    name.Trim(" .");
+
+    CString suffix;
+    if (name.IsEmpty())
+        suffix.Format("_window%d", (int)fitWindowIndex);
+    else
+        suffix.Format("_%s", (LPCSTR)name);
+    return suffix;
+}
+
 IMPLEMENT_DYNCREATE(CEvaluationController, CWinThread)
 
 BEGIN_MESSAGE_MAP(CEvaluationController, CWinThread)
@@ -51,7 +82,6 @@ END_MESSAGE_MAP()
 
 CEvaluationController::CEvaluationController(void)
 {
-    m_fluxSpecie = "SO2";
     m_realTime = false;
     m_date[0] = m_date[1] = m_date[2] = 0;
     m_lastResult = nullptr;
@@ -59,6 +89,14 @@ CEvaluationController::CEvaluationController(void)
 
 CEvaluationController::~CEvaluationController(void)
 {
+    if (m_scheduler != nullptr) {
+        m_scheduler->Stop();
+    }
+
+    if (m_rollupThread.joinable()) {
+        m_rollupThread.join();
+    }
+
     for (int i = 0; i < m_spectrometer.GetSize(); ++i) {
         if (m_spectrometer[i] != NULL) {
             delete m_spectrometer[i];
@@ -69,12 +107,21 @@ CEvaluationController::~CEvaluationController(void)
 
 /** Quits the thread */
 void CEvaluationController::OnQuit(WPARAM wp, LPARAM lp) {
+    // wait for the scans being evaluated before removing the spectrometers
+    if (m_scheduler != nullptr) {
+        m_scheduler->Stop();
+    }
+
+    // write everything which is still kept in memory to the log files
+    g_logFiles.CloseAll();
+
     for (int i = 0; i < m_spectrometer.GetSize(); ++i) {
         if (m_spectrometer[i] != NULL) {
             delete m_spectrometer[i];
             m_spectrometer[i] = NULL;
         }
     }
+    std::lock_guard<std::mutex> lock{ m_lastResultMutex };
     this->m_lastResult.reset();
 }
 
@@ -87,8 +134,8 @@ void CEvaluationController::OnTestEvaluation(WPARAM wp, LPARAM lp) {
 
     // 1. Check if the file exists
     if (!IsExistingFile(*fileName)) {
-        errorMessage.Format("EvaluationController recieved filename with erroneous filePath: %s ", (LPCSTR)fileName);
-        this->m_logFileWriter.WriteErrorMessage(errorMessage);
+        errorMessage.Format("EvaluationController recieved filename with erroneous filePath: %s ", (LPCSTR)*fileName);
+        WriteErrorMessage(errorMessage);
         fileName->Format("");   // signals that we are done with this file
         return;
     }
@@ -103,11 +150,45 @@ void CEvaluationController::OnTestEvaluation(WPARAM wp, LPARAM lp) {
 }
 
 /** This function takes care of newly arrived scan files,
-        evaluates the spectra and stores the scan-file in the archives. */
+        and queues them for evaluation in the lane of the spectrometer which generated them. */
 void CEvaluationController::OnArrivedSpectra(WPARAM wp, LPARAM /*lp*/)
 {
     // The filename of the newly arrived file is the first parameter 
     const CString *fileName = (CString *)wp;
+    CString errorMessage;
+    SpectrumIO::CSpectrumIO reader;
+    CSpectrum spec;
+
+    // 1. Check if the file exists
+    if (!IsExistingFile(*fileName)) {
+        errorMessage.Format("EvaluationController recieved filename with erroneous filePath: %s ", (LPCSTR)*fileName);
+        WriteErrorMessage(errorMessage);
+        ShowMessage(errorMessage);
+        delete fileName;
+        return;
+    }
+
+    // 2. Find the serial number of the spectrometer, this identifies the lane of the scan.
+    //  All channels of one spectrometer share the same lane since they share the same history.
+    const std::string fileNameStr((LPCSTR)*fileName);
+    reader.ReadSpectrum(fileNameStr, 0, spec);
+
+    m_scheduler->Enqueue(spec.m_info.m_device, *fileName);
+
+    delete fileName;   // the scheduler keeps its own copy of the file name
+}
+
+std::vector<CEvaluationLaneStatus> CEvaluationController::GetQueueStatus() const
+{
+    if (m_scheduler == nullptr) {
+        return std::vector<CEvaluationLaneStatus>();
+    }
+    return m_scheduler->GetLaneStatus();
+}
+
+/** This function evaluates a newly arrived scan file and stores it in the archives. */
+void CEvaluationController::ProcessArrivedScan(const CString &fileName)
+{
     CString errorMessage, message;
     CString storeFileName_pak, storeFileName_txt;
     CString str;
@@ -117,16 +198,15 @@ void CEvaluationController::OnArrivedSpectra(WPARAM wp, LPARAM /*lp*/)
     int nSpectra = 0;
 
     // 1. Check if the file exists
-    if (!IsExistingFile(*fileName)) {
+    if (!IsExistingFile(fileName)) {
         errorMessage.Format("EvaluationController recieved filename with erroneous filePath: %s ", (LPCSTR)fileName);
-        m_logFileWriter.WriteErrorMessage(errorMessage);
+        WriteErrorMessage(errorMessage);
         ShowMessage(errorMessage);
-        delete fileName;
         return;
     }
 
     // 2. Find the serial number of the spectrometer and the channel that was used
-    const std::string fileNameStr((LPCSTR)*fileName);
+    const std::string fileNameStr((LPCSTR)fileName);
     reader.ReadSpectrum(fileNameStr, 0, spec); // TODO: check for errors!!
     const CString serialNumber(spec.m_info.m_device.c_str());
     const int specPerScan = spec.SpectraPerScan();
@@ -135,7 +215,7 @@ void CEvaluationController::OnArrivedSpectra(WPARAM wp, LPARAM /*lp*/)
     const int volcanoIndex = Common::GetMonitoredVolcano(serialNumber);
 
     // 4. Check so that this file contains one full scan
-    const MEASUREMENT_MODE measurementMode = CPakFileHandler::GetMeasurementMode(*fileName);
+    const MEASUREMENT_MODE measurementMode = CPakFileHandler::GetMeasurementMode(fileName);
 
     if (measurementMode == MODE_FLUX) {
         nSpectra = reader.CountSpectra(fileNameStr);
@@ -143,11 +223,12 @@ void CEvaluationController::OnArrivedSpectra(WPARAM wp, LPARAM /*lp*/)
     }
 
     // 5. Evaluate the scan
-    EvaluateScan(*fileName, volcanoIndex); // TODO: Check for errors
+    EvaluateScan(fileName, volcanoIndex); // TODO: Check for errors
+    g_logFiles.ScanCompleted();
 
     // 6. Move the file to the archive
-    GetArchivingfileName(storeFileName_pak, storeFileName_txt, *fileName);
-    if (0 == MoveFileEx(*fileName, storeFileName_pak, MOVEFILE_REPLACE_EXISTING)) {// after evaluation, move the file to the archive
+    GetArchivingfileName(storeFileName_pak, storeFileName_txt, fileName);
+    if (0 == MoveFileEx(fileName, storeFileName_pak, MOVEFILE_REPLACE_EXISTING)) {// after evaluation, move the file to the archive
         DWORD errorCode = GetLastError();
         message.Format("Could not move file");
         if (Common::FormatErrorCode(errorCode, str))
@@ -156,7 +237,7 @@ void CEvaluationController::OnArrivedSpectra(WPARAM wp, LPARAM /*lp*/)
             message.AppendFormat("Reason - unknown");
         ShowMessage(message);
         // Try to copy the file instead...
-        CopyFile(*fileName, storeFileName_pak, TRUE);
+        CopyFile(fileName, storeFileName_pak, TRUE);
     }
 
     // 7. Upload the file(s) to the data-server
@@ -218,8 +299,13 @@ void CEvaluationController::OnArrivedSpectra(WPARAM wp, LPARAM /*lp*/)
     }
 
     // 11. Clean Up
-    DeleteFile(*fileName);   // If the file still exists, try to delete it.
-    delete fileName;   // signals that we are done with this file
+    DeleteFile(fileName);   // If the file still exists, try to delete it.
+}
+
+void CEvaluationController::WriteErrorMessage(const CString &message)
+{
+    std::lock_guard<std::mutex> lock{ m_logFileWriterMutex };
+    m_logFileWriter.WriteErrorMessage(message);
 }
 
 /** This function takes a scan-file and evaluates one of the spectra inside it */
@@ -234,6 +320,10 @@ RETURN_CODE CEvaluationController::EvaluateScan(const CString &fileName, int vol
     CString message;
     CWindField windField;
     CDateTime startTime;
+    Common common;
+
+    // The result of the evaluation
+    std::unique_ptr<CScanResult> lastResult;
 
     // The CScanFileHandler is a structure for reading the 
     //		spectral information from the scan-file
@@ -243,7 +333,10 @@ RETURN_CODE CEvaluationController::EvaluateScan(const CString &fileName, int vol
     bool sucess = true;
 
     // Check if the output directories needs to be updated
-    UpdateOutputDirectories();
+    {
+        std::lock_guard<std::mutex> lock{ m_spectrometerMutex };
+        UpdateOutputDirectories();
+    }
 
     // clock the time it takes to treat one scan
     cStart = clock();
@@ -252,19 +345,23 @@ RETURN_CODE CEvaluationController::EvaluateScan(const CString &fileName, int vol
 
     // 1. Assert that the scan-file exists
     if (!IsExistingFile(fileName)) {
-        m_logFileWriter.WriteErrorMessage(TEXT("Recieved scan with illegal path. Could not evaluate."));
+        WriteErrorMessage(TEXT("Recieved scan with illegal path. Could not evaluate."));
         return FAIL;
     }
 
     // 2. Read the scan file
     const std::string fileNameStr((LPCSTR)fileName);
     if (!scan->CheckScanFile(fileNameStr)) {
-        m_logFileWriter.WriteErrorMessage(TEXT("Could not read recieved scan"));
+        WriteErrorMessage(TEXT("Could not read recieved scan"));
         return FAIL;
     }
 
     // 3. Identify which spectrometer has generated this scan
-    CSpectrometer *spectrometer = IdentifySpectrometer(*scan);
+    CSpectrometer *spectrometer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{ m_spectrometerMutex };
+        spectrometer = IdentifySpectrometer(*scan);
+    }
     if (nullptr == spectrometer)
     {
         Output_SpectrometerNotIdentified();
@@ -278,17 +375,18 @@ RETURN_CODE CEvaluationController::EvaluateScan(const CString &fileName, int vol
     // 5. Evaluate the scan
     std::unique_ptr<CScanEvaluation> ev = std::make_unique<CScanEvaluation>();
     ev->m_pause = NULL;
+    ev->SetOption_Threads(g_settings.evaluationThreads.threadsPerScan);
     Configuration::CDarkSettings *darkSettings = &spectrometer->m_settings.channel[0].m_darkSettings;
-    long spectrumNum = ev->EvaluateScan(fileName, spectrometer->m_fitWindows[0], NULL, darkSettings);
+    long spectrumNum = ev->EvaluateScan(fileName, spectrometer->m_fitWindows, NULL, darkSettings);
 
     // 6. Get the result from the evaluation
     if (ev != nullptr && ev->HasResult()) {
-        m_lastResult = ev->GetResult();
+        lastResult = ev->GetResult();
     }
 
     // 7. Get the mode of the evaluation
-    if (m_lastResult) {
-        m_lastResult->CheckMeasurementMode();
+    if (lastResult) {
+        lastResult->CheckMeasurementMode();
     }
 
     // 8. Check the reasonability of the evaluation
@@ -297,36 +395,49 @@ RETURN_CODE CEvaluationController::EvaluateScan(const CString &fileName, int vol
         return FAIL;
     }
 
-    m_lastResult->GetStartTime(0, startTime);
+    lastResult->GetStartTime(0, startTime);
 
     // 9. Get the local wind field when the scan was taken
     if (SUCCESS != GetWind(windField, *spectrometer, startTime)) {
-        spectrometer->m_logFileHandler.WriteErrorMessage(m_common.GetString(ERROR_WIND_NOT_FOUND));
+        spectrometer->m_logFileHandler.WriteErrorMessage(common.GetString(ERROR_WIND_NOT_FOUND));
     }
     // 10. Calculate the flux. The spectrometer is needed to identify the geometry.
-    if (!m_lastResult->IsWindMeasurement()
-        && !m_lastResult->IsStratosphereMeasurement()
-        && !m_lastResult->IsDirectSunMeasurement()
-        && !m_lastResult->IsLunarMeasurement()
-        && !m_lastResult->IsCompositionMeasurement()) {
+    if (!lastResult->IsWindMeasurement()
+        && !lastResult->IsStratosphereMeasurement()
+        && !lastResult->IsDirectSunMeasurement()
+        && !lastResult->IsLunarMeasurement()
+        && !lastResult->IsCompositionMeasurement()) {
 
         // 10a. Calculate the centre of the plume
-        bool inplume = m_lastResult->CalculatePlumeCentre("SO2");
+        bool inplume = lastResult->CalculatePlumeCentre("SO2");
 
         // 10c. Calculate the flux...
-        if (SUCCESS != CalculateFlux(m_lastResult.get(), spectrometer, volcanoIndex, windField)) {
-            Output_FluxFailure(m_lastResult.get(), spectrometer);
+        if (SUCCESS != CalculateFlux(lastResult.get(), spectrometer, volcanoIndex, windField)) {
+            Output_FluxFailure(lastResult.get(), spectrometer);
             sucess = false;
         }
     }
 
     // 11. Append the result to the log file of the corresponding scanningInstrument
-    if (SUCCESS != WriteEvaluationResult(m_lastResult.get(), *scan, *spectrometer, windField)) {
+    if (SUCCESS != WriteEvaluationResult(lastResult.get(), *scan, *spectrometer, windField, 0)) {
         spectrometer->m_logFileHandler.WriteErrorMessage(TEXT("Could not write result to file"));
     }
 
-    // 12. Remember the result from the last scan
-    spectrometer->RememberResult(*m_lastResult);
+    // 11b. Append the results from the other fit windows to their own log files
+    for (size_t windowIndex = 1; windowIndex < spectrometer->m_fitWindows.size(); ++windowIndex) {
+        std::unique_ptr<CScanResult> windowResult = ev->GetResult(windowIndex);
+        if (windowResult == nullptr) {
+            continue;
+        }
+        windowResult->CheckMeasurementMode();
+        if (SUCCESS != WriteEvaluationResult(windowResult.get(), *scan, *spectrometer, windField, windowIndex)) {
+            spectrometer->m_logFileHandler.WriteErrorMessage(TEXT("Could not write result to file"));
+        }
+    }
+
+    // 12. Remember the result from the last scan, also over a restart of the program
+    spectrometer->RememberResult(*lastResult);
+    SaveHistorySnapshot(*spectrometer);
 
     // 13. Check if we should do a wind-measurement or a composition mode measurement now
     InitiateSpecialModeMeasurement(spectrometer);
@@ -336,14 +447,19 @@ RETURN_CODE CEvaluationController::EvaluateScan(const CString &fileName, int vol
     Output_TimingOfScanEvaluation(spectrumNum, spectrometer->SerialNumber(), ((double)(cFinish - cStart) / (double)CLOCKS_PER_SEC));
 
     // TODO: Check that this is ok.
-    m_lastResult->m_path = std::string((LPCSTR)fileName);
+    lastResult->m_path = std::string((LPCSTR)fileName);
 
     // 16. Share the results with the rest of the program
     if (sucess) {
-        CScanResult *newResult = new CScanResult(*m_lastResult);
+        CScanResult *newResult = new CScanResult(*lastResult);
         pView->PostMessage(WM_EVAL_SUCCESS, (WPARAM)&(spectrometer->SerialNumber()), (LPARAM)newResult);
     }
 
+    {
+        std::lock_guard<std::mutex> lock{ m_lastResultMutex };
+        m_lastResult = std::move(lastResult);
+    }
+
     return SUCCESS;
 }
 
@@ -374,22 +490,25 @@ CSpectrometer *CEvaluationController::IdentifySpectrometer(const FileHandler::CS
 RETURN_CODE CEvaluationController::CalculateFlux(CScanResult *result, const CSpectrometer *spectrometer, int volcanoIndex, CWindField &windField) {
     CString errorMessage;
 
+    // The specie for which the flux should be calculated. E.g. "SO2"
+    std::string fluxSpecie;
+
     // 0. If there's only one specie evaluated for, use it as flux specie. 
     //		No matter what previously said
     if (result->GetSpecieNum(0) == 1) {
-        m_fluxSpecie = result->GetSpecieName(0, 0);
+        fluxSpecie = result->GetSpecieName(0, 0);
     }
     else {
-        m_fluxSpecie = "SO2";
+        fluxSpecie = "SO2";
     }
 
     // 1. Get the offset level of the scan
-    if (result->CalculateOffset(m_fluxSpecie)) {
-        if (!result->IsEvaluatedSpecie(m_fluxSpecie)) {
-            spectrometer->m_logFileHandler.WriteErrorMessage(TEXT("Could not calculate scan offset. There is no reference file for: " + CString(m_fluxSpecie.c_str()) + " for this spectrometer!"));
+    if (result->CalculateOffset(fluxSpecie)) {
+        if (!result->IsEvaluatedSpecie(fluxSpecie)) {
+            spectrometer->m_logFileHandler.WriteErrorMessage(TEXT("Could not calculate scan offset. There is no reference file for: " + CString(fluxSpecie.c_str()) + " for this spectrometer!"));
         }
         else {
-            spectrometer->m_logFileHandler.WriteErrorMessage(TEXT("Could not calculate scan offset. Is there a reference file for: " + CString(m_fluxSpecie.c_str()) + " for this spectrometer ?"));
+            spectrometer->m_logFileHandler.WriteErrorMessage(TEXT("Could not calculate scan offset. Is there a reference file for: " + CString(fluxSpecie.c_str()) + " for this spectrometer ?"));
         }
     }
 
@@ -401,7 +520,7 @@ RETURN_CODE CEvaluationController::CalculateFlux(CScanResult *result, const CSpe
 #endif
 
     // 2. Calculate the flux
-    if (result->CalculateFlux(m_fluxSpecie, windField, fmod(spectrometer->m_scanner.compass, 360.0), spectrometer->m_scanner.coneAngle, spectrometer->m_scanner.tilt)) {
+    if (result->CalculateFlux(fluxSpecie, windField, fmod(spectrometer->m_scanner.compass, 360.0), spectrometer->m_scanner.coneAngle, spectrometer->m_scanner.tilt)) {
         spectrometer->m_logFileHandler.WriteErrorMessage("Could not calculate flux for scan");
     }
 
@@ -421,6 +540,7 @@ RETURN_CODE CEvaluationController::WriteFluxResult(const CScanResult *result, co
     CString errorMessage;
     CDateTime dateTime;
     double edge1, edge2;
+    Common common;
 
     // 0. Get the sources for the wind-field
     windField.GetWindSpeedSource(wsSrc);
@@ -505,7 +625,6 @@ RETURN_CODE CEvaluationController::WriteFluxResult(const CScanResult *result, co
     serialNumber.Format("%s", (LPCSTR)spectrometer.SerialNumber());
     directory.Format("%sOutput\\%s\\%s\\", (LPCSTR)g_settings.outputDirectory, (LPCSTR)dateStr2, (LPCSTR)serialNumber);
     if (CreateDirectoryStructure(directory)) {
-        Common common;
         common.GetExePath();
         directory.Format("%sOutput\\%s", (LPCSTR)common.m_exePath, (LPCSTR)dateStr2);
         if (CreateDirectoryStructure(directory)) {
@@ -519,60 +638,63 @@ RETURN_CODE CEvaluationController::WriteFluxResult(const CScanResult *result, co
     // 21b. Get the file-name
     fluxLogFile.Format("%sFluxLog_%s_%s.txt", (LPCSTR)directory, (LPCSTR)serialNumber, (LPCSTR)dateStr2);
 
-    // 21c. Check if the file exists
+    // 21c. Check if the file exists, the file is created when it is first appended to
+    CString text;
     if (!IsExistingFile(fluxLogFile)) {
         // write the header
-        FILE *f = fopen(fluxLogFile, "w");
-        if (f != NULL) {
-            fprintf(f, "serial=%s\n", (LPCSTR)serialNumber);
-            fprintf(f, "volcano=%s\n", (LPCSTR)m_common.SimplifyString(spectrometer.m_scanner.volcano));
-            fprintf(f, "site=%s\n", (LPCSTR)m_common.SimplifyString(spectrometer.m_scanner.site));
-            fprintf(f, "#scandate\tscanstarttime\tscanstoptime\t");
-            fprintf(f, "flux_[kg/s]\t");
-            fprintf(f, "windspeed_[m/s]\twinddirection_[deg]\twindspeedsource\twinddirectionsource\t");
-            fprintf(f, "plumeheight_[m]\tplumeheightsource\t");
-            fprintf(f, "compassdirection_[deg]\tcompasssource\t");
-            fprintf(f, "plumecentre_[deg]\tplumeedge1_[deg]\tplumeedge2_[deg]\tplumecompleteness_[%%]\t");
-            fprintf(f, "coneangle\ttilt\tokflux\ttemperature\tbatteryvoltage\texposuretime\n");
-            fclose(f);
-        }
+        text.Format("serial=%s\n", (LPCSTR)serialNumber);
+        text.AppendFormat("volcano=%s\n", (LPCSTR)common.SimplifyString(spectrometer.m_scanner.volcano));
+        text.AppendFormat("site=%s\n", (LPCSTR)common.SimplifyString(spectrometer.m_scanner.site));
+        text.AppendFormat("#scandate\tscanstarttime\tscanstoptime\t");
+        text.AppendFormat("flux_[kg/s]\t");
+        text.AppendFormat("windspeed_[m/s]\twinddirection_[deg]\twindspeedsource\twinddirectionsource\t");
+        text.AppendFormat("plumeheight_[m]\tplumeheightsource\t");
+        text.AppendFormat("compassdirection_[deg]\tcompasssource\t");
+        text.AppendFormat("plumecentre_[deg]\tplumeedge1_[deg]\tplumeedge2_[deg]\tplumecompleteness_[%%]\t");
+        text.AppendFormat("coneangle\ttilt\tokflux\ttemperature\tbatteryvoltage\texposuretime\n");
     }
 
     // 21d. Write the flux-result to the file
-    FILE *f = fopen(fluxLogFile, "a+");
-    if (f != NULL) {
-        fprintf(f, string);
-        fprintf(f, "\n");
-        fclose(f);
-    }
+    text.AppendFormat("%s\n", (LPCSTR)string);
+    g_logFiles.Append(fluxLogFile, text, &g_evalLogCritSect);
 
-    // 22. Upload the flux-log file to the FTP-Server
+    // 22. Upload the flux-log file to the FTP-Server, with everything written so far
+    g_logFiles.Flush(fluxLogFile);
     UploadToNOVACServer(fluxLogFile, volcanoIndex);
 
     return SUCCESS;
 }
 
-RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *result, const FileHandler::CScanFileHandler& scan, const CSpectrometer &spectrometer, CWindField &windField) {
+RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *result, const FileHandler::CScanFileHandler& scan, const CSpectrometer &spectrometer, CWindField &windField, size_t fitWindowIndex) {
     CString string, string1, string2, string3, string4;
     const CConfigurationSetting::SpectrometerSetting &settings = spectrometer.m_settings;
     CString pakFile, txtFile, evalLogFile;
     CString wsSrc, wdSrc, phSrc;
     CDateTime dateTime;
+    Common common;
 
     const CString fName(scan.GetFileName().c_str());
     GetArchivingfileName(pakFile, txtFile, fName);
 
+    // The fit window used. The results from all but the first fit window are written to separate files
+    const Evaluation::CFitWindow &window = spectrometer.m_fitWindows[fitWindowIndex];
+    CString windowSuffix;
+    if (fitWindowIndex > 0) {
+        windowSuffix = FitWindowFileSuffix(window, fitWindowIndex);
+        txtFile = txtFile.Left(txtFile.GetLength() - 4) + windowSuffix + ".txt";
+    }
+
     // 1. Get the name of the evaluation-log file to write to...
     //		The path is the top-directory of the text-file
     evalLogFile.Format(txtFile);
-    m_common.GetDirectory(evalLogFile); // the directory where the pak/txt-files are
+    Common::GetDirectory(evalLogFile); // the directory where the pak/txt-files are
     evalLogFile = evalLogFile.Left((int)strlen(evalLogFile) - 1);	// remove the last backslash
-    m_common.GetDirectory(evalLogFile); // the parent-directory to the pak/txt-files
+    Common::GetDirectory(evalLogFile); // the parent-directory to the pak/txt-files
 
     // The date of the measurement & the serial-number of the spectrometer
     result->GetSkyStartTime(dateTime);
 
-    evalLogFile.AppendFormat("EvaluationLog_%s_%04d.%02d.%02d.txt", (LPCSTR)spectrometer.SerialNumber(), dateTime.year, dateTime.month, dateTime.day);
+    evalLogFile.AppendFormat("EvaluationLog_%s_%04d.%02d.%02d%s.txt", (LPCSTR)spectrometer.SerialNumber(), dateTime.year, dateTime.month, dateTime.day, (LPCSTR)windowSuffix);
 
     // 0. Create the additional scan-information
     string.Format("<scaninformation>\n");
@@ -584,9 +706,9 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
     string.AppendFormat("\tlong=%.6lf\n", spectrometer.m_scanner.gps.m_longitude);
     string.AppendFormat("\talt=%.3lf\n", spectrometer.m_scanner.gps.m_altitude);
 
-    string.AppendFormat("\tvolcano=%s\n", (LPCSTR)m_common.SimplifyString(spectrometer.m_scanner.volcano));
-    string.AppendFormat("\tsite=%s\n", (LPCSTR)m_common.SimplifyString(spectrometer.m_scanner.site));
-    string.AppendFormat("\tobservatory=%s\n", (LPCSTR)m_common.SimplifyString(spectrometer.m_scanner.observatory));
+    string.AppendFormat("\tvolcano=%s\n", (LPCSTR)common.SimplifyString(spectrometer.m_scanner.volcano));
+    string.AppendFormat("\tsite=%s\n", (LPCSTR)common.SimplifyString(spectrometer.m_scanner.site));
+    string.AppendFormat("\tobservatory=%s\n", (LPCSTR)common.SimplifyString(spectrometer.m_scanner.observatory));
 
     string.AppendFormat("\tserial=%s\n", (LPCSTR)settings.serialNumber);
     string.AppendFormat("\tspectrometer=%s\n", spectrometer.m_settings.modelName.c_str());
@@ -656,7 +778,7 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
     string.AppendFormat("\t<model>%s</model>\n", spectrometer.m_settings.modelName.c_str());
     for (int i = 0; i < settings.channelNum; i++) {
         string.AppendFormat("\t<channel number='%d'>\n", i);
-        const Evaluation::CFitWindow &fitWindow = settings.channel[i].fitWindow;
+        const Evaluation::CFitWindow &fitWindow = (i == spectrometer.m_channel) ? window : settings.channel[i].fitWindow;
         for (int k = 0; k < fitWindow.nRef; k++) {
             const CReferenceFile &ref = fitWindow.ref[k];
             string.AppendFormat("\t\t<Reference>\n");
@@ -696,10 +818,9 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
     string.AppendFormat("</spectrometer>\n");
 
     // 1. write the header
-    const Evaluation::CFitWindow &window = settings.channel[0].fitWindow;
     string.AppendFormat("#scanangle\tstarttime\tstoptime\tname\tspecsaturation\tfitsaturation\tcounts_ms\tdelta\tchisquare\texposuretime\tnumspec\t");
 
-    for (int itSpecie = 0; itSpecie < spectrometer.m_fitWindows[0].nRef; ++itSpecie) {
+    for (int itSpecie = 0; itSpecie < window.nRef; ++itSpecie) {
         string.AppendFormat("column(%s)\tcolumnerror(%s)\t", window.ref[itSpecie].m_specieName.c_str(), window.ref[itSpecie].m_specieName.c_str());
         string.AppendFormat("shift(%s)\tshifterror(%s)\t", window.ref[itSpecie].m_specieName.c_str(), window.ref[itSpecie].m_specieName.c_str());
         string.AppendFormat("squeeze(%s)\tsqueezeerror(%s)\t", window.ref[itSpecie].m_specieName.c_str(), window.ref[itSpecie].m_specieName.c_str());
@@ -719,7 +840,7 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
         sky.m_info.m_fitIntensity = (float)(sky.MaxValue(window.fitLow, window.fitHigh));
         if (sky.NumSpectra() > 0)
             sky.Div(sky.NumSpectra());
-        CEvaluationLogFileHandler::FormatEvaluationResult(&sky.m_info, NULL, maxIntensity*sky.NumSpectra(), spectrometer.m_fitWindows[0].nRef, string1);
+        CEvaluationLogFileHandler::FormatEvaluationResult(&sky.m_info, NULL, maxIntensity*sky.NumSpectra(), window.nRef, string1);
     }
     scan.GetDark(dark);
     if (dark.m_info.m_interlaceStep > 1)
@@ -728,7 +849,7 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
         dark.m_info.m_fitIntensity = (float)(dark.MaxValue(window.fitLow, window.fitHigh));
         if (dark.NumSpectra() > 0)
             dark.Div(dark.NumSpectra());
-        CEvaluationLogFileHandler::FormatEvaluationResult(&dark.m_info, NULL, maxIntensity*dark.NumSpectra(), spectrometer.m_fitWindows[0].nRef, string2);
+        CEvaluationLogFileHandler::FormatEvaluationResult(&dark.m_info, NULL, maxIntensity*dark.NumSpectra(), window.nRef, string2);
     }
     scan.GetOffset(offset);
     if (offset.m_info.m_interlaceStep > 1)
@@ -736,7 +857,7 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
     if (offset.m_length > 0) {
         offset.m_info.m_fitIntensity = (float)(offset.MaxValue(window.fitLow, window.fitHigh));
         offset.Div(offset.NumSpectra());
-        CEvaluationLogFileHandler::FormatEvaluationResult(&offset.m_info, NULL, maxIntensity * offset.NumSpectra(), spectrometer.m_fitWindows[0].nRef, string3);
+        CEvaluationLogFileHandler::FormatEvaluationResult(&offset.m_info, NULL, maxIntensity * offset.NumSpectra(), window.nRef, string3);
     }
     scan.GetDarkCurrent(darkCurrent);
     if (darkCurrent.m_info.m_interlaceStep > 1)
@@ -744,7 +865,7 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
     if (darkCurrent.m_length > 0) {
         darkCurrent.m_info.m_fitIntensity = (float)(darkCurrent.MaxValue(window.fitLow, window.fitHigh));
         darkCurrent.Div(darkCurrent.NumSpectra());
-        CEvaluationLogFileHandler::FormatEvaluationResult(&darkCurrent.m_info, NULL, maxIntensity*darkCurrent.NumSpectra(), spectrometer.m_fitWindows[0].nRef, string4);
+        CEvaluationLogFileHandler::FormatEvaluationResult(&darkCurrent.m_info, NULL, maxIntensity*darkCurrent.NumSpectra(), window.nRef, string4);
     }
 
     string.AppendFormat("%s", (LPCSTR)string1);
@@ -762,19 +883,15 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
         Evaluation::CEvaluationResult evResult;
         result->GetResult(itSpectrum, evResult);
 
-        CEvaluationLogFileHandler::FormatEvaluationResult(&result->GetSpectrumInfo(itSpectrum), &evResult, maxIntensity * nSpectra, spectrometer.m_fitWindows[0].nRef, string1);
+        CEvaluationLogFileHandler::FormatEvaluationResult(&result->GetSpectrumInfo(itSpectrum), &evResult, maxIntensity * nSpectra, window.nRef, string1);
 
         string.AppendFormat("%s", (LPCSTR)string1);
     }
     string.AppendFormat("</spectraldata>\n");
 
-    // 3b. Write it all to the main evaluation log file
-    FILE *eF = fopen(evalLogFile, "a");
-    if (eF != NULL) {
-        fprintf(eF, "\n");
-        fprintf(eF, string);
-        fclose(eF);
-    }
+    // 3b. Write it all to the main evaluation log file. The whole scan is written
+    //      to disk at once, such that the readers of the log never see part of a scan.
+    g_logFiles.Append(evalLogFile, "\n" + string, &g_evalLogCritSect);
 
     // 3c. Write it all to the additional evaluation log file
     FILE *f = fopen(txtFile, "w");
@@ -783,6 +900,11 @@ RETURN_CODE CEvaluationController::WriteEvaluationResult(const CScanResult *resu
         fclose(f);
     }
 
+    // 3d. Append the scan to the binary evaluation log, if wanted
+    if (g_settings.binaryEvaluationLog) {
+        FileHandler::CBinaryEvaluationLog::AppendScan(FileHandler::CBinaryEvaluationLog::FileNameFor(evalLogFile), *result, spectrometer, windField);
+    }
+
     return SUCCESS;
 }
 
@@ -805,7 +927,7 @@ CSpectrometer *CEvaluationController::HandleUnIdentifiedSpectrometer(const CStri
 
     // 3. Configure the log file handlers
     CString dateStr, path, filePath;
-    m_common.GetDateText(dateStr);
+    Common::GetDateText(dateStr);
     path.Format("%sOutput\\%s", (LPCSTR)g_settings.outputDirectory, (LPCSTR)dateStr);
     filePath.Format("%s\\%s", (LPCSTR)path, (LPCSTR)serialNumber);
 
@@ -826,7 +948,7 @@ CSpectrometer *CEvaluationController::HandleUnIdentifiedSpectrometer(const CStri
     // 6. Tell the user what just happened...
     message.Format("RECEIVED SCAN FROM A NOT CONFIGURED SPECTROMETER: %s. SPECTRA WILL NOT BE CORRECTLY EVALUATED. PLEASE CHECK SETTINGS AND RESTART!", (LPCSTR)serialNumber);
     ShowMessage(message);
-    m_logFileWriter.WriteErrorMessage(message);
+    WriteErrorMessage(message);
 
     // 7. finally return a pointer to the new spectrometer
     return m_spectrometer[spectrometerNum];
@@ -847,8 +969,14 @@ BOOL Evaluation::CEvaluationController::InitInstance()
     }
 
     // 3. Initialize the output files
+    g_logFiles.SetFlushPolicy(g_settings.logFiles.flushPolicy, g_settings.logFiles.flushInterval, (size_t)g_settings.logFiles.bufferSize * 1024);
     InitializeOutput();
 
+    // 4. Start the workers which evaluates the arriving scans
+    m_scheduler = std::make_unique<CEvaluationScheduler>(
+        g_settings.evaluationThreads.concurrentScans,
+        [this](const CString &fileName) { ProcessArrivedScan(fileName); });
+
     return 1;
 }
 
@@ -866,6 +994,12 @@ RETURN_CODE CEvaluationController::InitializeSpectrometers() {
 
             CSpectrometerHistory *history = new CSpectrometerHistory();
 
+            // continue from where we were when the program was last stopped
+            CSnapshotReader snapshot;
+            if (snapshot.Open(HistorySnapshotFileName(g_settings.scanner[i].spec[j].serialNumber), HISTORY_SNAPSHOT_IDENTIFIER)) {
+                history->LoadSnapshot(snapshot);
+            }
+
             for (k = 0; k < g_settings.scanner[i].spec[j].channelNum; ++k) {
 
                 CConfigurationSetting::ScanningInstrumentSetting &scanner = g_settings.scanner[i];
@@ -895,6 +1029,25 @@ RETURN_CODE CEvaluationController::InitializeSpectrometers() {
                 // set the fit window
                 curSpec->m_fitWindows.push_back(window);
 
+                // the additional fit windows, their results are written to evaluation logs of their own
+                if (channel.additionalFitWindowFile.size() > 0) {
+                    const CString fitWindowFile(channel.additionalFitWindowFile.c_str());
+                    FileHandler::CFitWindowFileHandler fitWindowReader;
+                    std::vector<Evaluation::CFitWindow> additionalWindows = fitWindowReader.ReadFitWindowFile(fitWindowFile);
+                    if (additionalWindows.empty()) {
+                        message.Format("Could not read any fit window from %s, spectrometer %s is evaluated in one fit window", (LPCSTR)fitWindowFile, (LPCSTR)spec.serialNumber);
+                        ShowMessage(message);
+                    }
+                    for (Evaluation::CFitWindow &additionalWindow : additionalWindows) {
+                        if (!ReadReferences(additionalWindow)) {
+                            message.Format("Cannot read all references of fit window %s for spectrometer %s, the window is not evaluated", additionalWindow.name.c_str(), (LPCSTR)spec.serialNumber);
+                            ShowMessage(message);
+                            continue;
+                        }
+                        curSpec->m_fitWindows.push_back(additionalWindow);
+                    }
+                }
+
                 // Insert the new spectrometer
                 m_spectrometer.SetAtGrow(spectrometerNum, curSpec);
 
@@ -907,6 +1060,25 @@ RETURN_CODE CEvaluationController::InitializeSpectrometers() {
     return SUCCESS;
 }
 
+CString CEvaluationController::HistorySnapshotFileName(const CString &serialNumber) {
+    CString fileName;
+    fileName.Format("%sTemp\\SpectrometerHistory_%s.bin", (LPCSTR)g_settings.outputDirectory, (LPCSTR)serialNumber);
+    return fileName;
+}
+
+void CEvaluationController::SaveHistorySnapshot(const CSpectrometer &spectrometer) {
+    if (spectrometer.m_history == nullptr) {
+        return;
+    }
+
+    // The history is small, it is saved after every scan
+    CSnapshotWriter snapshot;
+    if (snapshot.Open(HistorySnapshotFileName(spectrometer.SerialNumber()), HISTORY_SNAPSHOT_IDENTIFIER)) {
+        spectrometer.m_history->SaveSnapshot(snapshot);
+        snapshot.Commit();
+    }
+}
+
 /** Called all messages have been handled */
 BOOL Evaluation::CEvaluationController::OnIdle(LONG lCount)
 {
@@ -964,9 +1136,9 @@ RETURN_CODE CEvaluationController::InitializeOutput()
     }
 
     // store the date when the directories were last created
-    m_date[0] = (unsigned short)m_common.GetYear();
-    m_date[1] = (unsigned short)m_common.GetMonth();
-    m_date[2] = (unsigned short)m_common.GetDay();
+    m_date[0] = (unsigned short)Common::GetYear();
+    m_date[1] = (unsigned short)Common::GetMonth();
+    m_date[2] = (unsigned short)Common::GetDay();
 
     return SUCCESS;
 }
@@ -974,14 +1146,15 @@ RETURN_CODE CEvaluationController::InitializeOutput()
 
 /** Handles the output when a new scan has arrived but we could not identify the spectrometer */
 void CEvaluationController::Output_SpectrometerNotIdentified() {
-    m_logFileWriter.WriteErrorMessage(TEXT("Could not identify spectrometer, scan not evaluated."));
+    WriteErrorMessage(TEXT("Could not identify spectrometer, scan not evaluated."));
     ShowMessage("Unrecognized spectrometer, scan not evaluated");
 }
 
 /** Handles the output when a new scan has arrived and we have identified the spectrometer */
 void CEvaluationController::Output_ArrivedScan(const CSpectrometer *spec) {
     CString message;
-    message.Format("%s %s", (LPCSTR)m_common.GetString(RECIEVED_NEW_SCAN_FROM), (LPCSTR)spec->m_settings.serialNumber);
+    Common common;
+    message.Format("%s %s", (LPCSTR)common.GetString(RECIEVED_NEW_SCAN_FROM), (LPCSTR)spec->m_settings.serialNumber);
     ShowMessage(message);
 }
 
@@ -989,7 +1162,7 @@ void CEvaluationController::Output_ArrivedScan(const CSpectrometer *spec) {
 void CEvaluationController::Output_FitFailure(const CSpectrum &spec) {
     CString message;
     message.Format("Failed to evaluate spectrum from spectrometer: %s", spec.m_info.m_device.c_str());
-    m_logFileWriter.WriteErrorMessage(message);
+    WriteErrorMessage(message);
     pView->PostMessage(WM_EVAL_FAILURE, (WPARAM)&(spec.m_info.m_device));
     ShowMessage(message);
 }
@@ -998,10 +1171,6 @@ void CEvaluationController::Output_FitFailure(const CSpectrum &spec) {
 void CEvaluationController::Output_FluxFailure(const CScanResult *result, const CSpectrometer *spec) {
     spec->m_logFileHandler.WriteErrorMessage(TEXT("Could not calculate the flux"));
 
-    if (result != m_lastResult.get()) {
-        *m_lastResult = *result;
-    }
-
     CScanResult* copiedResult = (nullptr != result) ? new CScanResult(*result) : nullptr;
 
     pView->PostMessage(WM_EVAL_FAILURE, (WPARAM)&(spec->m_settings.serialNumber), (LPARAM)copiedResult);
@@ -1011,6 +1180,16 @@ void CEvaluationController::Output_FluxFailure(const CScanResult *result, const
 void CEvaluationController::Output_TimingOfScanEvaluation(int spectrumNum, const CString &serial, double timeElapsed) {
     CString timingMessage;
     timingMessage.Format("Evaluated one scan of %d spectra from %s in %lf seconds (%lf seconds/spectrum)", spectrumNum, (LPCSTR)serial, timeElapsed, timeElapsed / (double)spectrumNum);
+
+    // Tell the user if there is a backlog of scans building up from this spectrometer
+    if (m_scheduler != nullptr) {
+        const CEvaluationLaneStatus status = m_scheduler->GetLaneStatus(std::string((LPCSTR)serial));
+        timingMessage.AppendFormat(". Scan waited %.1lf seconds in queue, %d more scans waiting", status.lastWaitTime, (int)status.queueDepth);
+        if (status.queueDepth > 0) {
+            timingMessage.AppendFormat(" (oldest has waited %.1lf seconds)", status.oldestWaitTime);
+        }
+    }
+
     ShowMessage(timingMessage);
 }
 
@@ -1087,11 +1266,48 @@ void CEvaluationController::UpdateOutputDirectories() {
     // Check the current date. If the current date is different from the 
     //	date when the output directories were last initialized, then
     //	initialize them again.
-    if ((m_date[0] != m_common.GetYear()) || (m_date[1] != m_common.GetMonth()) || (m_date[2] != m_common.GetDay())) {
+    if ((m_date[0] != Common::GetYear()) || (m_date[1] != Common::GetMonth()) || (m_date[2] != Common::GetDay())) {
+        // close the log files of the previous day
+        g_logFiles.CloseAll();
+        if (m_date[0] != 0) {
+            BuildDailyRollups();
+        }
+        g_logTails.Clear();
         InitializeOutput();
     }
 }
 
+void CEvaluationController::BuildDailyRollups() {
+    // The logs of the day which has just closed are summarized once, such that the history plots need not read them again
+    CString dateStr, logFile;
+    dateStr.Format("%04d.%02d.%02d", m_date[0], m_date[1], m_date[2]);
+
+    std::vector<CString> evaluationLogs, fluxLogs;
+    for (int i = 0; i < m_spectrometer.GetSize(); ++i) {
+        const CString serialNumber = m_spectrometer[i]->SerialNumber();
+
+        logFile.Format("%sOutput\\%s\\%s\\EvaluationLog_%s_%s.txt", (LPCSTR)g_settings.outputDirectory, (LPCSTR)dateStr, (LPCSTR)serialNumber, (LPCSTR)serialNumber, (LPCSTR)dateStr);
+        evaluationLogs.push_back(logFile);
+
+        logFile.Format("%sOutput\\%s\\%s\\FluxLog_%s_%s.txt", (LPCSTR)g_settings.outputDirectory, (LPCSTR)dateStr, (LPCSTR)serialNumber, (LPCSTR)serialNumber, (LPCSTR)dateStr);
+        fluxLogs.push_back(logFile);
+    }
+
+    // The rollups of the previous day are long done by now
+    if (m_rollupThread.joinable()) {
+        m_rollupThread.join();
+    }
+
+    // Reading the logs takes a while, this is done without holding up the evaluation
+    m_rollupThread = std::thread([evaluationLogs, fluxLogs]() {
+        for (size_t i = 0; i < evaluationLogs.size(); ++i) {
+            FileHandler::CDailyRollup rollup;
+            rollup.ReadColumns(evaluationLogs[i]);
+            rollup.ReadFluxes(fluxLogs[i]);
+        }
+    });
+}
+
 void CEvaluationController::GetSpectrumInformation(CSpectrometer *spectrometer, const CString &fileName)
 {
     CSpectrum skySpec, darkSpec;
@@ -1244,19 +1460,29 @@ RETURN_CODE CEvaluationController::MakeGeometryCalculations_Heidelberg(CSpectrom
     CString debugFile, dateStr;
     Common common;
 
+    // take a copy of the last result, it may be replaced by any of the workers
+    std::unique_ptr<CScanResult> lastResult;
+    {
+        std::lock_guard<std::mutex> lock{ m_lastResultMutex };
+        if (m_lastResult == nullptr) {
+            return FAIL;
+        }
+        lastResult = std::make_unique<CScanResult>(*m_lastResult);
+    }
+
     common.GetDateText(dateStr);
     debugFile.Format("%sOutput\\%s\\Debug_UHEI_Geometry.txt", (LPCSTR)g_settings.outputDirectory, (LPCSTR)dateStr);
 
     // if we don't see any plume at all in the last measurement, then there's no
     //	point in trying to calculate anything
-    alpha_center_of_mass = m_lastResult->GetCalculatedPlumeCentre(0);
-    phi_center_of_mass = m_lastResult->GetCalculatedPlumeCentre(1);
+    alpha_center_of_mass = lastResult->GetCalculatedPlumeCentre(0);
+    phi_center_of_mass = lastResult->GetCalculatedPlumeCentre(1);
     if (alpha_center_of_mass < -900) {
         return FAIL;
     }
 
     // Get the user supplied wind field at the time of the last measurement
-    m_lastResult->GetStartTime(0, startTime);
+    lastResult->GetStartTime(0, startTime);
     GetWind(wind, *spectrometer, startTime);
 
     // Get the position of the scanner
@@ -1311,8 +1537,12 @@ void CEvaluationController::InitiateSpecialModeMeasurement(const CSpectrometer*
 {
     static time_t cTimeOfLastWindMeasurement = 0;
     static time_t cTimeOfLastCompMeasurement = 0;
+    static std::mutex specialModeMutex;
     time_t now;
 
+    // The times of the last measurements are shared by all spectrometers
+    std::lock_guard<std::mutex> lock{ specialModeMutex };
+
     // Get the current time
     time(&now);
 
@@ -2,9 +2,12 @@
 
 #include "../resource.h"
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "Spectrometer.h"
 #include "ScanResult.h"
+#include "EvaluationScheduler.h"
 
 #include "../Common/Common.h"
 #include <SpectralEvaluation/File/ScanFileHandler.h>
@@ -21,6 +24,9 @@ namespace Evaluation
 		of the spectra. The class is run as a separate thread and
 		recives messages on incoming spectra that should be evaluated
 		and dispatches the spectra to the correct evaluator. 
+		The arriving scans are queued in one lane per spectrometer in a 
+		CEvaluationScheduler, which evaluates scans from different spectrometers
+		concurrently while keeping the scans from each spectrometer in order.
 		*/
 
 	class CEvaluationController : CWinThread
@@ -49,18 +55,24 @@ namespace Evaluation
 		// ----------------------------------------------------------------------
 
 		/** A scan-result, for sharing evaluated data with the rest of the
-			program. This is updated after every evaluation of a full scan. */
+			program. This is updated after every evaluation of a full scan. 
+			Protected by m_lastResultMutex. */
 		std::unique_ptr<CScanResult> m_lastResult;
 
 		// ----------------------------------------------------------------------
 		// --------------------- PUBLIC METHODS ---------------------------------
 		// ----------------------------------------------------------------------
 
-		/** Handling the appearance of a new pak-file one scan which should be evaluated
+		/** Handling the appearance of a new pak-file one scan which should be evaluated.
+			The file is queued in the lane of the spectrometer which generated it and
+			is evaluated by one of the workers in m_scheduler.
 			@param wp is a pointer to a CString object telling the filename of the pak-file. 
 			@param lp - unused. */
 		afx_msg void OnArrivedSpectra(WPARAM wp, LPARAM lp);
 
+		/** @return the state of the queue of scans waiting to be evaluated, one item for every spectrometer */
+		std::vector<CEvaluationLaneStatus> GetQueueStatus() const;
+
 		/** Used to test the evaluation. 
 			@param wp is a pointer to a CString object telling the filename of the pak-file. 
 			@param lp - unused. */
@@ -102,6 +114,19 @@ namespace Evaluation
 			from each spectrometer. */
 		CArray<CSpectrometer *, CSpectrometer *>m_spectrometer;
 
+		/** Protects the list of spectrometers, and the settings of their log files, 
+			from being modified by two workers simultaneously */
+		std::mutex m_spectrometerMutex;
+
+		/** Protects m_lastResult */
+		std::mutex m_lastResultMutex;
+
+		/** Schedules the evaluation of the arriving scans over the worker threads */
+		std::unique_ptr<CEvaluationScheduler> m_scheduler;
+
+		/** Builds the daily rollups of the day which has just closed, see BuildDailyRollups */
+		std::thread m_rollupThread;
+
 		/** A log-file writer to handle the output of the program. 
 			This is not used for any output which can be connected to a single 
 			spectrometer, that is handled by the logFileHandler in each 
@@ -109,8 +134,8 @@ namespace Evaluation
 			state of the program. */
 		FileHandler::CLogFileWriter m_logFileWriter;
 
-		/** The specie for which the flux should be calculated. E.g. "SO2" */
-		std::string m_fluxSpecie;
+		/** Protects m_logFileWriter, which is written to from the worker threads. See WriteErrorMessage */
+		std::mutex m_logFileWriterMutex;
 
 		/** Defining which of the result logs is the evaluation log */
 		const static int EVALUATION_LOG = 0;
@@ -118,9 +143,6 @@ namespace Evaluation
 		/** Defining which of the result logs is the flux log */
 		const static int FLUX_LOG = 1;
 
-		/** A common-object, for doing common tasks. */
-		Common m_common;
-
 		/** Determines if the evaluation should be done in real-time or if we should
 			wait until a full scan has arrived. if m_realTime is true then the spectra will
 			be evaluated as they arrive, if m_realTime is false then they will not be evaluated
@@ -138,6 +160,13 @@ namespace Evaluation
 		// --------------------- PRIVATE METHODS --------------------------------
 		// ----------------------------------------------------------------------
 
+		/** Evaluates and archives one newly arrived scan-file.
+			This is called on one of the worker threads of m_scheduler. */
+		void ProcessArrivedScan(const CString &fileName);
+
+		/** Appends the given message to the error log of m_logFileWriter, while holding m_logFileWriterMutex */
+		void WriteErrorMessage(const CString &message);
+
 		/** Indentifies the scanning instrument from which this scan was generated. 
 			@param scan a reference to a scan that should be identified. 
 			@return a pointer to the spectrometer. @return NULL if no spectrometer found */
@@ -162,8 +191,10 @@ namespace Evaluation
 			@param result - a CScanResult holding information about the result
 			@param scan - the scan itself, also containing information about the evaluation and the flux.
 			@param scanningInstrument - information about the scanning instrument that generated the scan. 
+			@param fitWindowIndex - the index of the fit window in which the result was evaluated. 
+				The results from all but the first fit window are written to files named after the fit window.
 			@return SUCCESS if operation completed sucessfully. */
-		RETURN_CODE WriteEvaluationResult(const CScanResult *result, const FileHandler::CScanFileHandler& scan, const CSpectrometer &spectrometer, CWindField &windField);
+		RETURN_CODE WriteEvaluationResult(const CScanResult *result, const FileHandler::CScanFileHandler& scan, const CSpectrometer &spectrometer, CWindField &windField, size_t fitWindowIndex);
 
 		/** Handles the connection of a un-identified spectrometer to the network.
 			@param serialNumber - the serial number of the newly connected spectrometer. 
@@ -181,6 +212,13 @@ namespace Evaluation
 			@return SUCCESS if everything works. */
 		RETURN_CODE InitializeSpectrometers();
 
+		/** @return the name of the file in which the history of the spectrometer with the 
+			given serial number is saved, such that it survives a restart of the program */
+		static CString HistorySnapshotFileName(const CString &serialNumber);
+
+		/** Saves the history of the given spectrometer to its snapshot file */
+		static void SaveHistorySnapshot(const CSpectrometer &spectrometer);
+
 		/** Tries to retrieve the local wind field when the scan was collected. 
 			@param wind - a wind field structure that will be filled with the wind field data.
 			@param scan - the scan for which we want to know the wind field.
@@ -214,6 +252,12 @@ namespace Evaluation
 		/** Checks today's date and if necessary updates the output directories */
 		void UpdateOutputDirectories();
 
+		/** Builds the daily rollups of the evaluation-logs and the flux-logs of the day
+			in 'm_date', which has just closed. These are read by the history plots.
+			The rollups are built in the background, in 'm_rollupThread', such that the
+			evaluation of the arriving scans is not held up. */
+		void BuildDailyRollups();
+
 		/** Shows information that we have recieved a new scan */
 		void Output_ArrivedScan(const CSpectrometer *spec);
 
@@ -226,7 +270,8 @@ namespace Evaluation
 		/** Shows the information about a failure in the flux calculation */
 		void Output_FluxFailure(const CScanResult *result, const CSpectrometer *spec);
 
-		/** Shows the timing information from evaluating a scan */
+		/** Shows the timing information from evaluating a scan, together with the
+			number of scans from the same spectrometer which are waiting to be evaluated */
 		void Output_TimingOfScanEvaluation(int spectrumNum, const CString &serial, double timeElapsed);
 
 		/** Shows information about an arrival of a scan without any spectra in it */
@@ -15,5 +15,8 @@ namespace Evaluation
         CSpectrum measuredSpectrum;
         CSpectrum residual;
         CSpectrum polynomial;
+
+        // The index of the fit window which was used in the fit
+        int fitWindowIndex = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "StdAfx.h"
+#include "EvaluationScheduler.h"
+#include <algorithm>
+
+using namespace Evaluation;
+
+CEvaluationScheduler::CEvaluationScheduler(int numberOfWorkers, ScanProcessor processor)
+    : m_processor(processor)
+{
+    if (numberOfWorkers < 1)
+    {
+        numberOfWorkers = 1;
+    }
+
+    for (int k = 0; k < numberOfWorkers; ++k)
+    {
+        m_workers.push_back(std::thread(&CEvaluationScheduler::RunWorker, this));
+    }
+}
+
+CEvaluationScheduler::~CEvaluationScheduler()
+{
+    Stop();
+}
+
+void CEvaluationScheduler::Enqueue(const std::string& lane, const CString& fileName)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    Lane& curLane = m_lanes[lane];
+    curLane.pending.push_back(PendingScan{ fileName, Clock::now() });
+
+    // A lane is ready when it has waiting scans and is not busy. If it already
+    //  had waiting scans then it is either already ready, or busy.
+    if (!curLane.busy && curLane.pending.size() == 1)
+    {
+        m_readyLanes.push_back(lane);
+        m_workAvailable.notify_one();
+    }
+}
+
+void CEvaluationScheduler::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+    m_workers.clear();
+}
+
+void CEvaluationScheduler::RunWorker()
+{
+    while (1)
+    {
+        std::string laneName;
+        PendingScan scan;
+
+        // 1. Wait for a lane with a scan to process
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_workAvailable.wait(lock, [&] { return m_stopping || !m_readyLanes.empty(); });
+
+            if (m_stopping)
+            {
+                return;
+            }
+
+            laneName = m_readyLanes.front();
+            m_readyLanes.pop_front();
+
+            Lane& lane = m_lanes[laneName];
+            scan = lane.pending.front();
+            lane.pending.pop_front();
+            lane.busy = true;
+
+            lane.lastWaitTime = std::chrono::duration<double>(Clock::now() - scan.arrivalTime).count();
+            lane.maxWaitTime = std::max(lane.maxWaitTime, lane.lastWaitTime);
+        }
+
+        // 2. Process the scan, without holding the lock
+        m_processor(scan.fileName);
+
+        // 3. Release the lane, if it has more scans waiting then it goes to the back of the line
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            Lane& lane = m_lanes[laneName];
+            lane.busy = false;
+            ++lane.processedScans;
+
+            if (!lane.pending.empty())
+            {
+                m_readyLanes.push_back(laneName);
+                m_workAvailable.notify_one();
+            }
+        }
+    }
+}
+
+std::vector<CEvaluationLaneStatus> CEvaluationScheduler::GetLaneStatus() const
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    const Clock::time_point now = Clock::now();
+
+    std::vector<CEvaluationLaneStatus> status;
+    for (const auto& lane : m_lanes)
+    {
+        status.push_back(MakeStatus(lane.first, lane.second, now));
+    }
+    return status;
+}
+
+CEvaluationLaneStatus CEvaluationScheduler::GetLaneStatus(const std::string& lane) const
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    auto it = m_lanes.find(lane);
+    if (it == m_lanes.end())
+    {
+        CEvaluationLaneStatus status;
+        status.name = lane;
+        return status;
+    }
+    return MakeStatus(it->first, it->second, Clock::now());
+}
+
+CEvaluationLaneStatus CEvaluationScheduler::MakeStatus(const std::string& name, const Lane& lane, Clock::time_point now)
+{
+    CEvaluationLaneStatus status;
+    status.name = name;
+    status.queueDepth = lane.pending.size();
+    status.busy = lane.busy;
+    status.lastWaitTime = lane.lastWaitTime;
+    status.maxWaitTime = lane.maxWaitTime;
+    status.processedScans = lane.processedScans;
+    if (!lane.pending.empty())
+    {
+        status.oldestWaitTime = std::chrono::duration<double>(now - lane.pending.front().arrivalTime).count();
+    }
+    return status;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Evaluation
+{
+    /** The state of one lane in the CEvaluationScheduler.
+        Used to monitor if a backlog of scans is building up for an instrument. */
+    struct CEvaluationLaneStatus
+    {
+        /** The name of the lane, this is the serial-number of the spectrometer */
+        std::string name;
+
+        /** The number of scans waiting to be evaluated, not counting the scan being evaluated */
+        size_t queueDepth = 0;
+
+        /** True if a scan from this lane is being evaluated right now */
+        bool busy = false;
+
+        /** The time the oldest scan in the queue has been waiting [s] */
+        double oldestWaitTime = 0.0;
+
+        /** The time the last started scan had to wait before its evaluation started [s] */
+        double lastWaitTime = 0.0;
+
+        /** The longest time any scan in this lane has had to wait [s] */
+        double maxWaitTime = 0.0;
+
+        /** The number of scans from this lane which have been evaluated */
+        long long processedScans = 0;
+    };
+
+    /** The <b>CEvaluationScheduler</b> distributes the arriving scan-files over a bounded
+        pool of worker threads. Every spectrometer has its own lane (a first-in-first-out queue)
+        of scans. Scans from different lanes are evaluated concurrently, but at most one scan
+        from each lane is evaluated at any time such that the results from one instrument
+        are always produced in the order the scans arrived.
+        Lanes with waiting scans are served round-robin, such that a backlog from one instrument
+        does not hold up the scans from the other instruments. */
+    class CEvaluationScheduler
+    {
+    public:
+        /** The function which is called, on one of the worker threads, to process one scan-file */
+        typedef std::function<void(const CString& fileName)> ScanProcessor;
+
+        /** Creates the scheduler and starts the worker threads.
+            @param numberOfWorkers - the maximum number of scans to process concurrently.
+            @param processor - the function which processes one scan. */
+        CEvaluationScheduler(int numberOfWorkers, ScanProcessor processor);
+
+        /** Stops the worker threads */
+        ~CEvaluationScheduler();
+
+        /** Adds the scan-file to the end of the given lane. */
+        void Enqueue(const std::string& lane, const CString& fileName);
+
+        /** Stops the worker threads. Scans still waiting in the lanes are not processed.
+            This blocks until the scans which are being processed are done. */
+        void Stop();
+
+        /** @return the current state of all lanes */
+        std::vector<CEvaluationLaneStatus> GetLaneStatus() const;
+
+        /** @return the current state of one lane */
+        CEvaluationLaneStatus GetLaneStatus(const std::string& lane) const;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct PendingScan
+        {
+            CString fileName;
+            Clock::time_point arrivalTime;
+        };
+
+        struct Lane
+        {
+            std::deque<PendingScan> pending;
+            bool busy = false;
+            double lastWaitTime = 0.0;
+            double maxWaitTime = 0.0;
+            long long processedScans = 0;
+        };
+
+        /** The function which processes the scans */
+        ScanProcessor m_processor;
+
+        /** All lanes we know of, by name. */
+        std::map<std::string, Lane> m_lanes;
+
+        /** The names of the lanes which have scans waiting and which are not busy,
+            in the order in which they should be served. */
+        std::deque<std::string> m_readyLanes;
+
+        /** Protects m_lanes, m_readyLanes and m_stopping */
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        bool m_stopping = false;
+
+        std::vector<std::thread> m_workers;
+
+        /** The loop run by each worker thread */
+        void RunWorker();
+
+        static CEvaluationLaneStatus MakeStatus(const std::string& name, const Lane& lane, Clock::time_point now);
+    };
+}
@@ -6,12 +6,15 @@
 #include <SpectralEvaluation/File/STDFile.h>
 #include <SpectralEvaluation/StringUtils.h>
 #include <SpectralEvaluation/Spectra/SpectrometerModel.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 using namespace Evaluation;
 
 CScanEvaluation::CScanEvaluation()
 {
-    m_result = nullptr;
     m_skySettings.skyOption = Configuration::SKY_OPTION::MEASURED_IN_SCAN;
     m_skySettings.indexInScan = 0;
 
@@ -32,9 +35,9 @@ int CScanEvaluation::NumberOfSpectraInLastResult()
 {
     std::lock_guard<std::mutex> lock{ m_resultMutex };
 
-    if (nullptr != m_result)
+    if (!m_results.empty() && nullptr != m_results[0])
     {
-        return m_result->GetEvaluatedNum();
+        return m_results[0]->GetEvaluatedNum();
     }
     else
     {
@@ -43,39 +46,60 @@ int CScanEvaluation::NumberOfSpectraInLastResult()
 }
 
 std::unique_ptr<CScanResult> CScanEvaluation::GetResult()
+{
+    return GetResult(0);
+}
+
+std::unique_ptr<CScanResult> CScanEvaluation::GetResult(size_t windowIndex)
 {
     std::lock_guard<std::mutex> lock{ m_resultMutex };
     std::unique_ptr<CScanResult> copiedResult;
 
-    if (nullptr != m_result.get())
+    if (windowIndex < m_results.size() && nullptr != m_results[windowIndex].get())
     {
-        copiedResult.reset(new CScanResult(*m_result.get()));
+        copiedResult.reset(new CScanResult(*m_results[windowIndex].get()));
     }
 
     return copiedResult;
 }
 
 bool CScanEvaluation::HasResult()
+{
+    return HasResult(0);
+}
+
+bool CScanEvaluation::HasResult(size_t windowIndex)
 {
     std::lock_guard<std::mutex> lock{ m_resultMutex };
 
-    return (nullptr != m_result.get());
+    return (windowIndex < m_results.size() && nullptr != m_results[windowIndex].get());
 }
 
 /** Called to evaluate one scan */
-long CScanEvaluation::EvaluateScan(const CString &scanfile, const CFitWindow& window, bool *fRun, const Configuration::CDarkSettings *darkSettings)
+long CScanEvaluation::EvaluateScan(const CString &scanfile, const CFitWindow& window, const std::atomic<bool> *fRun, const Configuration::CDarkSettings *darkSettings)
+{
+    const std::vector<CFitWindow> windows{ window };
+
+    return EvaluateScan(scanfile, windows, fRun, darkSettings);
+}
+
+/** Called to evaluate one scan in several fit windows */
+long CScanEvaluation::EvaluateScan(const CString &scanfile, const std::vector<CFitWindow>& windows, const std::atomic<bool> *fRun, const Configuration::CDarkSettings *darkSettings)
 {
-    CString message;	// used for ShowMessage messages
-    int	index = 0;		// keeping track of the index of the current spectrum into the .pak-file
-    double highestColumn = 0.0;	// the highest column-value in the evaluation
-    bool success = true;
+    // variables for storing the sky and dark spectra
+    CSpectrum sky, dark;
 
-    // variables for storing the sky, dark and the measured spectra
-    CSpectrum sky, dark, current;
+    // Forget the result of the previous scan
+    {
+        std::lock_guard<std::mutex> lock{ m_resultMutex };
+        m_results.clear();
+        m_results.resize(windows.size());
+    }
 
-    // Remember the fit-range
-    m_fitLow = window.fitLow;
-    m_fitHigh = window.fitHigh;
+    if (windows.empty())
+    {
+        return 0;
+    }
 
     // Check so that the file exists
     if (!IsExistingFile(scanfile))
@@ -95,8 +119,150 @@ long CScanEvaluation::EvaluateScan(const CString &scanfile, const CFitWindow& wi
         return 0;
     }
 
-    // make a backup of the fit window (this function may make some changes to the
-    //  fit window, and we should be able to restore the old values on return).
+    // Prepare the evaluation in each of the fit windows
+    std::vector<CWindowEvaluation> evaluations(windows.size());
+    for (size_t windowIndex = 0; windowIndex < windows.size(); ++windowIndex)
+    {
+        CWindowEvaluation& evaluation = evaluations[windowIndex];
+
+        PrepareWindowEvaluation(scan, windows[windowIndex], darkSettings, evaluation);
+
+        // Get the sky and dark spectra and divide them by the number of 
+        //     co-added spectra in it. The sky spectrum only depends on the fit window 
+        //     if it is the average of the good spectra in the scan, otherwise it is shared.
+        if (windowIndex == 0 || m_skySettings.skyOption == Configuration::SKY_OPTION::AVERAGE_OF_GOOD_SPECTRA_IN_SCAN)
+        {
+            m_fitLow = evaluation.fitLow;
+            m_fitHigh = evaluation.fitHigh;
+
+            if (SUCCESS != GetSky(&scan, sky))
+            {
+                return 0;
+            }
+
+            if (sky.NumSpectra() > 0 && !m_averagedSpectra)
+            {
+                sky.Div(sky.NumSpectra());
+            }
+            evaluation.skyWithoutDarkCorrection = sky;
+
+            if (m_skySettings.skyOption != Configuration::SKY_OPTION::USER_SUPPLIED)
+            {
+                if (SUCCESS != GetDark(&scan, sky, dark, darkSettings))
+                {
+                    return 0;
+                }
+                dark.Div(dark.NumSpectra());
+                sky.Sub(dark);
+            }
+        }
+        else
+        {
+            evaluation.skyWithoutDarkCorrection = evaluations[0].skyWithoutDarkCorrection;
+        }
+        evaluation.sky = sky;
+
+        // tell the evaluator which sky-spectrum to use
+        evaluation.eval->SetSkySpectrum(sky);
+    }
+
+    // The parallel evaluation cannot show each spectrum, or pause, as it is evaluated
+    const bool runInParallel = (m_maxThreads > 1) && (pView == nullptr) && (m_pause == nullptr);
+
+    // Evaluate the scan (one or two times, depending on the settings). 
+    //  The first pass evaluates all the fit windows, the second pass only the fit windows 
+    //  for which we are to find an optimal shift and squeeze
+    for (int iteration = 0; iteration < 2; ++iteration)
+    {
+        bool anyActiveWindow = false;
+        for (CWindowEvaluation& evaluation : evaluations)
+        {
+            if (!evaluation.active)
+            {
+                continue;
+            }
+            anyActiveWindow = true;
+
+            evaluation.result = std::make_shared<CScanResult>();
+            evaluation.result->SetSkySpecInfo(evaluation.skyWithoutDarkCorrection.m_info);
+            evaluation.result->SetDarkSpecInfo(dark.m_info);
+            evaluation.highestColumn = 0.0;
+            evaluation.indexOfMostAbsorbingSpectrum = -1;	// as far as we know, there's no absorption in any spectrum...
+        }
+
+        if (!anyActiveWindow)
+        {
+            break;
+        }
+
+        // Make sure that we'll start with the first spectrum in the scan
+        scan.ResetCounter();
+
+        if (runInParallel)
+        {
+            if (!EvaluateSpectraInParallel(scan, evaluations, dark, darkSettings, fRun))
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            if (!EvaluateSpectra(scan, evaluations, dark, darkSettings, fRun))
+            {
+                return 0;
+            }
+        }
+
+        // end of scan...
+        for (CWindowEvaluation& evaluation : evaluations)
+        {
+            if (!evaluation.active || iteration > 0 || evaluation.window.findOptimalShift == FALSE)
+            {
+                evaluation.active = false;
+                continue;
+            }
+
+            if (evaluation.indexOfMostAbsorbingSpectrum < 0)
+            {
+                ShowMessage("Could not determine optimal shift & squeeze. No good spectra in scan.");
+                evaluation.active = false;
+                continue;
+            }
+
+            m_indexOfMostAbsorbingSpectrum = evaluation.indexOfMostAbsorbingSpectrum;
+            CEvaluationResult result = FindOptimumShiftAndSqueeze(evaluation.eval.get(), &scan, evaluation.result.get());
+
+            // Get a new fit-window to use for the second iteration...
+            CFitWindow newWindow = evaluation.window; // create a new copy
+
+            // 5. Set the shift for all references to this value
+            for (int k = 0; k < newWindow.nRef; ++k)
+            {
+                if (newWindow.ref[k].m_specieName.compare("FraunhoferRef") == 0)
+                {
+                    continue;
+                }
+
+                newWindow.ref[k].m_shiftOption = SHIFT_FIX;
+                newWindow.ref[k].m_squeezeOption = SHIFT_FIX;
+                newWindow.ref[k].m_shiftValue = result.m_referenceResult[0].m_shift;
+                newWindow.ref[k].m_squeezeValue = result.m_referenceResult[0].m_squeeze;
+            }
+
+            evaluation.eval.reset(new CEvaluationBase{ newWindow });
+
+            // tell the new evaluator which sky-spectrum to use
+            evaluation.eval->SetSkySpectrum(evaluation.sky);
+        }
+    }
+
+    return NumberOfSpectraInLastResult();
+}
+
+void CScanEvaluation::PrepareWindowEvaluation(FileHandler::CScanFileHandler& scan, const CFitWindow& window, const Configuration::CDarkSettings* darkSettings, CWindowEvaluation& evaluation)
+{
+    // make a copy of the fit window (this function may make some changes to the
+    //  fit window, and we should not change the settings of the caller).
     CFitWindow copyOfWindow = window;
 
     // If the user wants to find optimum shift, then the scan shall be evaluated
@@ -119,11 +285,8 @@ long CScanEvaluation::EvaluateScan(const CString &scanfile, const CFitWindow& wi
     copyOfWindow.startChannel = scan.GetStartChannel();
 
     // Adjust the fit-low and fit-high parameters according to the spectra
-    m_fitLow = copyOfWindow.fitLow - copyOfWindow.startChannel;
-    m_fitHigh = copyOfWindow.fitHigh - copyOfWindow.startChannel;
-
-    // Create our evaluator
-    std::unique_ptr<CEvaluationBase> eval;
+    evaluation.fitLow = copyOfWindow.fitLow - copyOfWindow.startChannel;
+    evaluation.fitHigh = copyOfWindow.fitHigh - copyOfWindow.startChannel;
 
     // If we have a solar-spectrum that we can use to determine the shift
     //	& squeeze then fit that first so that we know the wavelength calibration
@@ -143,259 +306,458 @@ long CScanEvaluation::EvaluateScan(const CString &scanfile, const CFitWindow& wi
         if (nullptr != newEval)
         {
             copyOfWindow = newEval->FitWindow();
-            eval.reset(newEval);
+            evaluation.eval.reset(newEval);
         }
         else
         {
             ShowMessage(m_lastErrorMessage.c_str());
+            evaluation.eval = std::make_unique<CEvaluationBase>(copyOfWindow);
         }
     }
     else
     {
-        eval = std::make_unique<CEvaluationBase>(copyOfWindow);
+        evaluation.eval = std::make_unique<CEvaluationBase>(copyOfWindow);
     }
 
-    // Get the sky and dark spectra and divide them by the number of 
-    //     co-added spectra in it
-    if (SUCCESS != GetSky(&scan, sky))
-    {
-        return 0;
-    }
+    evaluation.window = copyOfWindow;
+    evaluation.active = true;
+}
 
-    if (sky.NumSpectra() > 0 && !m_averagedSpectra)
-    {
-        sky.Div(sky.NumSpectra());
-    }
-    CSpectrum skySpectrumWithoutDarkCorrection = sky;
+void CScanEvaluation::UpdateResult(size_t windowIndex, std::shared_ptr<CScanResult> newResult)
+{
+    std::lock_guard<std::mutex> lock{ m_resultMutex };
+    m_results[windowIndex] = newResult;
+}
 
-    if (m_skySettings.skyOption != Configuration::SKY_OPTION::USER_SUPPLIED)
+bool CScanEvaluation::EvaluateSpectra(FileHandler::CScanFileHandler& scan, std::vector<CWindowEvaluation>& evaluations, CSpectrum& dark, const Configuration::CDarkSettings* darkSettings, const std::atomic<bool>* fRun)
+{
+    const CSpectrum& sky = evaluations[0].sky;
+    CPreparedSpectrum item;
+    CSpectrum current;
+    int index = -1; // we're at spectrum number 0 in the .pak-file
+
+    // Evaluate all the spectra in the scan.
+    while (1)
     {
-        if (SUCCESS != GetDark(&scan, sky, dark, darkSettings))
+        // If the user wants to exit this thread then do so.
+        if (fRun != nullptr && *fRun == false)
         {
-            return 0;
+            ShowMessage("Scan Evaluation cancelled by user");
+            return false;
         }
-        dark.Div(dark.NumSpectra());
-        sky.Sub(dark);
-    }
 
-    // tell the evaluator which sky-spectrum to use
-    eval->SetSkySpectrum(sky);
+        // a. - d. Read the next spectrum from the file and prepare it for the evaluation
+        const SpectrumReadOutcome outcome = ReadNextSpectrum(scan, evaluations, sky, dark, darkSettings, current, index, item);
 
-    // the data structure to keep track of the evaluation results
-    std::shared_ptr<CScanResult> newResult = std::make_shared<CScanResult>();
+        if (outcome == SpectrumReadOutcome::EndOfScan)
+        {
+            // at the end of the file, quit the 'while' loop
+            break;
+        }
+        else if (outcome == SpectrumReadOutcome::Corrupted)
+        {
+            // remember that this spectrum is corrupted
+            for (CWindowEvaluation& evaluation : evaluations)
+            {
+                if (evaluation.active)
+                {
+                    evaluation.result->MarkAsCorrupted(item.corruptedScanIndex);
+                }
+            }
+            continue;
+        }
+        else if (outcome == SpectrumReadOutcome::Failed)
+        {
+            return false;
+        }
+        else if (outcome == SpectrumReadOutcome::Skip)
+        {
+            continue;
+        }
 
-    // Check weather we are to find an optimal shift and squeeze
-    const int nIt = (copyOfWindow.findOptimalShift == FALSE) ? 1 : 2;
+        // e. - h. Evaluate the spectrum in each of the fit windows
+        for (size_t windowIndex = 0; windowIndex < evaluations.size(); ++windowIndex)
+        {
+            CWindowEvaluation& evaluation = evaluations[windowIndex];
+            if (!item.fits[windowIndex].evaluate)
+            {
+                continue;
+            }
+            bool success = true; // assume that we will succeed in evaluating this spectrum
 
-    // Evaluate the scan (one or two times, depending on the settings)
-    for (int iteration = 0; iteration < nIt; ++iteration)
-    {
-        index = -1; // we're at spectrum number 0 in the .pak-file
-        m_indexOfMostAbsorbingSpectrum = -1;	// as far as we know, there's no absorption in any spectrum...
+            current.m_info.m_fitIntensity = item.fits[windowIndex].fitIntensity;
 
-        newResult->SetSkySpecInfo(skySpectrumWithoutDarkCorrection.m_info);
-        newResult->SetDarkSpecInfo(dark.m_info);
+            // e. Evaluate the spectrum
+            if (evaluation.eval->Evaluate(current))
+            {
+                CString str;
+                str.Format("Failed to evaluate spectrum from spectrometer %s. Failure at spectrum %d in scan containing %d spectra. Message: '%s'",
+                    current.m_info.m_device.c_str(), current.ScanIndex(), current.SpectraPerScan(), evaluation.eval->m_lastError.c_str());
+                ShowMessage(str);
+                success = false;
+            }
 
-        // Make sure that we'll start with the first spectrum in the scan
-        scan.ResetCounter();
+            // e. Save the evaluation result
+            CScanResult& newResult = *evaluation.result;
+            newResult.AppendResult(evaluation.eval->GetEvaluationResult(), current.m_info);
 
-        // Evaluate all the spectra in the scan.
-        while (1)
-        {
-            success = true; // assume that we will succeed in evaluating this spectrum
+            // f. Check if this was an ok data point (CScanResult)
+            newResult.CheckGoodnessOfFit(current.m_info);
 
-            // If the user wants to exit this thread then do so.
-            if (fRun != nullptr && *fRun == false)
+            // g. If it is ok, then check if the value is higher than any of the previous ones
+            const unsigned long lastIndex = newResult.GetEvaluatedNum() - 1;
+            if (newResult.IsOk(lastIndex) && fabs(newResult.GetColumn(lastIndex, 0)) > evaluation.highestColumn)
             {
-                ShowMessage("Scan Evaluation cancelled by user");
-                return 0;
+                evaluation.highestColumn = fabs(newResult.GetColumn(lastIndex, 0));
+                evaluation.indexOfMostAbsorbingSpectrum = index;
             }
 
-            // remember which spectrum we're at
-            int	spectrumIndex = current.ScanIndex();
-
-            // a. Read the next spectrum from the file
-            int ret = scan.GetNextSpectrum(current);
-
-            if (ret == 0)
+            // h. Update the screen (if any)
+            if (success)
             {
-                // if something went wrong when reading the spectrum
-                if (scan.m_lastError == SpectrumIO::CSpectrumIO::ERROR_SPECTRUM_NOT_FOUND || scan.m_lastError == SpectrumIO::CSpectrumIO::ERROR_EOF)
-                {
-                    // at the end of the file, quit the 'while' loop
-                    break;
-                }
-                else
+                UpdateResult(windowIndex, evaluation.result);
+
+                if (pView != nullptr)
                 {
-                    CString errMsg;
-                    errMsg.Format("Faulty spectrum found in %s", (LPCSTR)scanfile);
-                    switch (scan.m_lastError) {
-                    case SpectrumIO::CSpectrumIO::ERROR_CHECKSUM_MISMATCH:
-                        errMsg.AppendFormat(", Checksum mismatch. Spectrum ignored"); break;
-                    case SpectrumIO::CSpectrumIO::ERROR_DECOMPRESS:
-                        errMsg.AppendFormat(", Decompression error. Spectrum ignored"); break;
-                    default:
-                        ShowMessage(", Unknown error. Spectrum ignored");
-                    }
-                    ShowMessage(errMsg);
-                    // remember that this spectrum is corrupted
-                    newResult->MarkAsCorrupted(spectrumIndex);
-                    continue;
+                    ShowResult(current, evaluation.eval.get(), windowIndex, index, scan.GetSpectrumNumInFile());
                 }
             }
+        }
 
-            ++index; // we'have just read the next spectrum in the .pak-file
-
-            // If the read spectrum is the sky or the dark spectrum, 
-            //   then don't evaluate it...
-            if (current.ScanIndex() == sky.ScanIndex() || current.ScanIndex() == dark.ScanIndex())
+        // i. If the user wants us to sleep between each evaluation. Do so...
+        if (m_pause != nullptr && *m_pause == 1 && m_sleeping != nullptr)
+        {
+            CWinThread *thread = AfxGetThread();
+            *m_sleeping = true;
+            if (pView != 0)
             {
-                continue;
+                pView->PostMessage(WM_GOTO_SLEEP);
             }
+            thread->SuspendThread();
+            *m_sleeping = false;
+        }
+        else
+        {
+            Sleep(20);
+        }
+    } // end while(1)
 
-            // If the spectrum is read out in an interlaced way then interpolate it back to it's original state
-            if (current.m_info.m_interlaceStep > 1)
-            {
-                current.InterpolateSpectrum();
+    return true;
+}
+
+CScanEvaluation::SpectrumReadOutcome CScanEvaluation::ReadNextSpectrum(FileHandler::CScanFileHandler& scan, const std::vector<CWindowEvaluation>& evaluations, const CSpectrum& sky, CSpectrum& dark, const Configuration::CDarkSettings* darkSettings, CSpectrum& current, int& index, CPreparedSpectrum& item)
+{
+    // remember which spectrum we're at
+    item.corruptedScanIndex = current.ScanIndex();
+
+    // a. Read the next spectrum from the file
+    int ret = scan.GetNextSpectrum(current);
+
+    if (ret == 0)
+    {
+        // if something went wrong when reading the spectrum
+        if (scan.m_lastError == SpectrumIO::CSpectrumIO::ERROR_SPECTRUM_NOT_FOUND || scan.m_lastError == SpectrumIO::CSpectrumIO::ERROR_EOF)
+        {
+            // at the end of the file
+            return SpectrumReadOutcome::EndOfScan;
+        }
+        else
+        {
+            CString errMsg;
+            errMsg.Format("Faulty spectrum found in %s", scan.GetFileName().c_str());
+            switch (scan.m_lastError) {
+            case SpectrumIO::CSpectrumIO::ERROR_CHECKSUM_MISMATCH:
+                errMsg.AppendFormat(", Checksum mismatch. Spectrum ignored"); break;
+            case SpectrumIO::CSpectrumIO::ERROR_DECOMPRESS:
+                errMsg.AppendFormat(", Decompression error. Spectrum ignored"); break;
+            default:
+                ShowMessage(", Unknown error. Spectrum ignored");
             }
+            ShowMessage(errMsg);
+            return SpectrumReadOutcome::Corrupted;
+        }
+    }
+
+    ++index; // we'have just read the next spectrum in the .pak-file
+
+    // If the read spectrum is the sky or the dark spectrum, 
+    //   then don't evaluate it...
+    if (current.ScanIndex() == sky.ScanIndex() || current.ScanIndex() == dark.ScanIndex())
+    {
+        return SpectrumReadOutcome::Skip;
+    }
+
+    // If the spectrum is read out in an interlaced way then interpolate it back to it's original state
+    if (current.m_info.m_interlaceStep > 1)
+    {
+        current.InterpolateSpectrum();
+    }
+
+    // b. Get the dark spectrum for this measured spectrum
+    if (SUCCESS != GetDark(&scan, current, dark, darkSettings))
+    {
+        return SpectrumReadOutcome::Failed;
+    }
+
+    // b. Calculate the intensities, before we divide by the number of spectra
+    //      and before we subtract the dark
+    current.m_info.m_peakIntensity = (float)current.MaxValue(0, current.m_length - 2);
+
+    item.fits.resize(evaluations.size());
+    for (size_t windowIndex = 0; windowIndex < evaluations.size(); ++windowIndex)
+    {
+        item.fits[windowIndex] = CWindowFit();
+        item.fits[windowIndex].fitIntensity = (float)current.MaxValue(evaluations[windowIndex].fitLow, evaluations[windowIndex].fitHigh);
+    }
+
+    // c. Divide the measured spectrum with the number of co-added spectra
+    //     The sky and dark spectra should already be divided before this loop.
+    if (current.NumSpectra() > 0 && !m_averagedSpectra)
+    {
+        current.Div(current.NumSpectra());
+    }
+
+    // d. Check if this spectrum is worth evaluating, in each of the fit windows
+    bool evaluateInAnyWindow = false;
+    for (size_t windowIndex = 0; windowIndex < evaluations.size(); ++windowIndex)
+    {
+        const CWindowEvaluation& evaluation = evaluations[windowIndex];
+        if (!evaluation.active)
+        {
+            continue;
+        }
 
-            // b. Get the dark spectrum for this measured spectrum
-            if (SUCCESS != GetDark(&scan, current, dark, darkSettings))
+        if (Ignore(current, evaluation.window))
+        {
+            CString message;
+            if (evaluations.size() > 1)
             {
-                return 0;
+                message.Format("Ignoring spectrum %d in scan %s in fit window %s.", current.ScanIndex(), scan.GetFileName().c_str(), evaluation.window.name.c_str());
             }
+            else
+            {
+                message.Format("Ignoring spectrum %d in scan %s.", current.ScanIndex(), scan.GetFileName().c_str());
+            }
+            ShowMessage(message);
+        }
+        else
+        {
+            item.fits[windowIndex].evaluate = true;
+            evaluateInAnyWindow = true;
+        }
+    }
 
-            // b. Calculate the intensities, before we divide by the number of spectra
-            //      and before we subtract the dark
-            current.m_info.m_peakIntensity = (float)current.MaxValue(0, current.m_length - 2);
-            current.m_info.m_fitIntensity = (float)current.MaxValue(m_fitLow, m_fitHigh);
+    if (!evaluateInAnyWindow)
+    {
+        return SpectrumReadOutcome::Skip;
+    }
 
-            // c. Divide the measured spectrum with the number of co-added spectra
-            //     The sky and dark spectra should already be divided before this loop.
-            if (current.NumSpectra() > 0 && !m_averagedSpectra)
+    // d2. Now subtract the dark (if we did this earlier, then the 'Ignore' - function would
+    //      not function properly)
+    if (dark.NumSpectra() > 0 && !m_averagedSpectra)
+    {
+        dark.Div(dark.NumSpectra());
+    }
+
+    current.Sub(dark);
+
+    return SpectrumReadOutcome::Evaluate;
+}
+
+bool CScanEvaluation::EvaluateSpectraInParallel(FileHandler::CScanFileHandler& scan, std::vector<CWindowEvaluation>& evaluations, CSpectrum& dark, const Configuration::CDarkSettings* darkSettings, const std::atomic<bool>* fRun)
+{
+    // All spectra read from the file, in the order they appear in the file.
+    std::vector<std::unique_ptr<CPreparedSpectrum>> spectra;
+
+    // The fits (spectrum and fit window) which have been prepared but not yet picked up by any of the workers
+    std::deque<std::pair<CPreparedSpectrum*, size_t>> pendingFits;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool allSpectraRead = false;
+
+    // The workers. Each of them fits the spectra using its own copy of the evaluators,
+    //  since the CEvaluationBase keeps the state of the last fit. The copies are cloned from the
+    //  configured evaluators, which are not changed while the workers run.
+    auto fitSpectra = [&]()
+    {
+        std::vector<std::unique_ptr<CEvaluationBase>> workerEval(evaluations.size());
+
+        while (1)
+        {
+            std::pair<CPreparedSpectrum*, size_t> work;
             {
-                current.Div(current.NumSpectra());
+                std::unique_lock<std::mutex> lock{ queueMutex };
+                queueCondition.wait(lock, [&] { return !pendingFits.empty() || allSpectraRead; });
+
+                if (pendingFits.empty())
+                {
+                    return; // all spectra are read and fitted
+                }
+                work = pendingFits.front();
+                pendingFits.pop_front();
             }
 
-            // d. Check if this spectrum is worth evaluating
-            if (Ignore(current, copyOfWindow))
+            if (fRun != nullptr && *fRun == false)
             {
-                message.Format("Ignoring spectrum %d in scan %s.", current.ScanIndex(), scan.GetFileName().c_str());
-                ShowMessage(message);
-                continue;
+                continue; // cancelled, empty the queue without fitting
             }
 
-            // d2. Now subtract the dark (if we did this earlier, then the 'Ignore' - function would
-            //      not function properly)
-            if (dark.NumSpectra() > 0 && !m_averagedSpectra)
+            const size_t windowIndex = work.second;
+            if (workerEval[windowIndex] == nullptr)
             {
-                dark.Div(dark.NumSpectra());
+                workerEval[windowIndex] = std::make_unique<CEvaluationBase>(*evaluations[windowIndex].eval);
             }
 
-            current.Sub(dark);
-
-            // e. Evaluate the spectrum
-            if (eval->Evaluate(current))
+            CWindowFit& fit = work.first->fits[windowIndex];
+            if (workerEval[windowIndex]->Evaluate(work.first->spectrum))
             {
-                CString str;
-                str.Format("Failed to evaluate spectrum from spectrometer %s. Failure at spectrum %d in scan containing %d spectra. Message: '%s'",
-                    current.m_info.m_device.c_str(), current.ScanIndex(), current.SpectraPerScan(), eval->m_lastError.c_str());
-                ShowMessage(str);
-                success = false;
+                fit.fitFailed = true;
+                fit.errorMessage = workerEval[windowIndex]->m_lastError;
             }
+            fit.result = workerEval[windowIndex]->GetEvaluationResult();
+        }
+    };
 
-            // e. Save the evaluation result
-            newResult->AppendResult(eval->GetEvaluationResult(), current.m_info);
+    std::vector<std::thread> workers;
+    for (int k = 0; k < m_maxThreads; ++k)
+    {
+        workers.push_back(std::thread(fitSpectra));
+    }
 
-            // f. Check if this was an ok data point (CScanResult)
-            newResult->CheckGoodnessOfFit(current.m_info);
+    // Read and prepare all the spectra in the scan on this thread, the workers picks them up as they arrive.
+    //  Each spectrum is only read and dark-corrected once, and is then fitted in every fit window.
+    const CSpectrum& sky = evaluations[0].sky;
+    bool cancelled = false;
+    bool failed = false;
+    CSpectrum current;
+    int index = -1; // we're at spectrum number 0 in the .pak-file
+    while (1)
+    {
+        if (fRun != nullptr && *fRun == false)
+        {
+            cancelled = true;
+            break;
+        }
 
-            // g. If it is ok, then check if the value is higher than any of the previous ones
-            if (newResult->IsOk(newResult->GetEvaluatedNum() - 1) && fabs(newResult->GetColumn(newResult->GetEvaluatedNum() - 1, 0)) > highestColumn)
-            {
-                highestColumn = fabs(newResult->GetColumn(newResult->GetEvaluatedNum() - 1, 0));
-                m_indexOfMostAbsorbingSpectrum = index;
-            }
+        std::unique_ptr<CPreparedSpectrum> item = std::make_unique<CPreparedSpectrum>();
+        item->outcome = ReadNextSpectrum(scan, evaluations, sky, dark, darkSettings, current, index, *item);
 
-            // h. Update the screen (if any)
-            if (success)
-            {
-                UpdateResult(newResult);
+        if (item->outcome == SpectrumReadOutcome::EndOfScan)
+        {
+            break;
+        }
+        else if (item->outcome == SpectrumReadOutcome::Failed)
+        {
+            failed = true;
+            break;
+        }
+        else if (item->outcome == SpectrumReadOutcome::Skip)
+        {
+            continue;
+        }
 
-                if (pView != nullptr)
+        item->index = index;
+        if (item->outcome == SpectrumReadOutcome::Evaluate)
+        {
+            item->spectrum = current;
+
+            std::lock_guard<std::mutex> lock{ queueMutex };
+            for (size_t windowIndex = 0; windowIndex < item->fits.size(); ++windowIndex)
+            {
+                if (item->fits[windowIndex].evaluate)
                 {
-                    ShowResult(current, eval.get(), index, scan.GetSpectrumNumInFile());
+                    pendingFits.push_back(std::make_pair(item.get(), windowIndex));
                 }
             }
+            queueCondition.notify_all();
+        }
+        spectra.push_back(std::move(item));
+    }
+
+    // Wait for the workers to finish the remaining spectra
+    {
+        std::lock_guard<std::mutex> lock{ queueMutex };
+        allSpectraRead = true;
+    }
+    queueCondition.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    if (cancelled || (fRun != nullptr && *fRun == false))
+    {
+        ShowMessage("Scan Evaluation cancelled by user");
+        return false;
+    }
+    if (failed)
+    {
+        return false;
+    }
+
+    // Merge the results into the scan-results, in the order of the spectra in the scan
+    for (size_t windowIndex = 0; windowIndex < evaluations.size(); ++windowIndex)
+    {
+        CWindowEvaluation& evaluation = evaluations[windowIndex];
+        if (!evaluation.active)
+        {
+            continue;
+        }
+        CScanResult& newResult = *evaluation.result;
 
-            // i. If the user wants us to sleep between each evaluation. Do so...
-            if (m_pause != nullptr && *m_pause == 1 && m_sleeping != nullptr)
+        bool anySuccessfulFit = false;
+        for (const std::unique_ptr<CPreparedSpectrum>& item : spectra)
+        {
+            if (item->outcome == SpectrumReadOutcome::Corrupted)
             {
-                CWinThread *thread = AfxGetThread();
-                *m_sleeping = true;
-                if (pView != 0)
-                {
-                    pView->PostMessage(WM_GOTO_SLEEP);
-                }
-                thread->SuspendThread();
-                *m_sleeping = false;
+                // remember that this spectrum is corrupted
+                newResult.MarkAsCorrupted(item->corruptedScanIndex);
+                continue;
             }
-            else
+
+            const CWindowFit& fit = item->fits[windowIndex];
+            if (!fit.evaluate)
             {
-                Sleep(20);
+                continue;
             }
-        } // end while(1)
 
-        // end of scan...
-        if ((iteration == 0) && (copyOfWindow.findOptimalShift == TRUE))
-        {
-            if (m_indexOfMostAbsorbingSpectrum < 0)
+            CSpectrumInfo info = item->spectrum.m_info;
+            info.m_fitIntensity = fit.fitIntensity;
+
+            if (fit.fitFailed)
             {
-                ShowMessage("Could not determine optimal shift & squeeze. No good spectra in scan.");
-                break;
+                CString str;
+                str.Format("Failed to evaluate spectrum from spectrometer %s. Failure at spectrum %d in scan containing %d spectra. Message: '%s'",
+                    info.m_device.c_str(), item->spectrum.ScanIndex(), item->spectrum.SpectraPerScan(), fit.errorMessage.c_str());
+                ShowMessage(str);
             }
             else
             {
-                CEvaluationResult result = FindOptimumShiftAndSqueeze(eval.get(), &scan, newResult.get());
-
-                // Get a new fit-window to use for the second iteration...
-                CFitWindow newWindow = copyOfWindow; // create a new copy
-
-                // 5. Set the shift for all references to this value
-                for (int k = 0; k < newWindow.nRef; ++k)
-                {
-                    if (newWindow.ref[k].m_specieName.compare("FraunhoferRef") == 0)
-                    {
-                        continue;
-                    }
-
-                    newWindow.ref[k].m_shiftOption = SHIFT_FIX;
-                    newWindow.ref[k].m_squeezeOption = SHIFT_FIX;
-                    newWindow.ref[k].m_shiftValue = result.m_referenceResult[0].m_shift;
-                    newWindow.ref[k].m_squeezeValue = result.m_referenceResult[0].m_squeeze;
-                }
-
-                eval.reset(new CEvaluationBase{ newWindow });
+                anySuccessfulFit = true;
+            }
 
-                // tell the new evaluator which sky-spectrum to use
-                eval->SetSkySpectrum(sky);
+            newResult.AppendResult(fit.result, info);
+            newResult.CheckGoodnessOfFit(info);
 
-                // drop the old result and start anew
-                newResult = std::make_shared<CScanResult>();
+            const unsigned long lastIndex = newResult.GetEvaluatedNum() - 1;
+            if (newResult.IsOk(lastIndex) && fabs(newResult.GetColumn(lastIndex, 0)) > evaluation.highestColumn)
+            {
+                evaluation.highestColumn = fabs(newResult.GetColumn(lastIndex, 0));
+                evaluation.indexOfMostAbsorbingSpectrum = item->index;
             }
         }
-    }
 
-    return NumberOfSpectraInLastResult();
-}
+        // The sequential evaluation only publishes the result after a successful fit
+        if (anySuccessfulFit)
+        {
+            UpdateResult(windowIndex, evaluation.result);
+        }
+    }
 
-void CScanEvaluation::UpdateResult(std::shared_ptr<CScanResult> newResult)
-{
-    std::lock_guard<std::mutex> lock{ m_resultMutex };
-    m_result = newResult;
+    return true;
 }
 
-void CScanEvaluation::ShowResult(const CSpectrum &spec, const CEvaluationBase *eval, long curSpecIndex, long specNum)
+void CScanEvaluation::ShowResult(const CSpectrum &spec, const CEvaluationBase *eval, size_t windowIndex, long curSpecIndex, long specNum)
 {
     if (pView == nullptr)
     {
@@ -417,6 +779,7 @@ void CScanEvaluation::ShowResult(const CSpectrum &spec, const CEvaluationBase *e
     resultView->scaledReference.resize(eval->NumberOfReferencesFitted());
 
     resultView->measuredSpectrum = spec;
+    resultView->fitWindowIndex = (int)windowIndex;
 
     // copy the residual and the polynomial
     for (int i = fitLow; i < fitHigh; ++i)
@@ -436,7 +799,7 @@ void CScanEvaluation::ShowResult(const CSpectrum &spec, const CEvaluationBase *e
 
     {
         std::lock_guard<std::mutex> lock{ m_resultMutex };
-        CScanResult* copiedResult = new CScanResult(*m_result.get());
+        CScanResult* copiedResult = new CScanResult(*m_results[windowIndex].get());
 
         // post the message to the view to update. This will also transfer the ownership of the two pointers to the view
         pView->PostMessage(WM_EVAL_SUCCESS, (WPARAM)resultView, (LPARAM)copiedResult);
@@ -562,6 +925,11 @@ void	CScanEvaluation::SetOption_AveragedSpectra(bool averaged) {
     this->m_averagedSpectra = averaged;
 }
 
+void CScanEvaluation::SetOption_Threads(int numberOfThreads)
+{
+    this->m_maxThreads = std::max(1, numberOfThreads);
+}
+
 /** Returns true if the spectrum should be ignored */
 bool CScanEvaluation::Ignore(const CSpectrum &spec, const CFitWindow window) {
     bool ret = false;
@@ -1,16 +1,18 @@
 #pragma once
 
 #include "ScanResult.h"
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <SpectralEvaluation/Evaluation/ScanEvaluationBase.h>
 #include <SpectralEvaluation/Evaluation/FitParameter.h>
 #include <SpectralEvaluation/Configuration/SkySettings.h>
+#include <SpectralEvaluation/Spectra/Spectrum.h>
 #include "../Common/Common.h"
 #include "../Configuration/Configuration.h"
 
-class CSpectrum;
 namespace FileHandler
 {
     class CScanFileHandler;
@@ -38,15 +40,23 @@ namespace Evaluation
 
         /** The state of the evaluation. If m_sleeping is true then the
             thread is sleeping and needs to be woken up. */
-        bool* m_sleeping = nullptr;
+        std::atomic<bool>* m_sleeping = nullptr;
 
         /** if pView != NULL then after the evaluation of a spectrum, a 'WM_EVAL_SUCCESS'
             message will be sent to pView. */
         CWnd* pView = nullptr;
 
         /** Called to evaluate one scan.
+                @param fRun - if not null, the evaluation stops as soon as this becomes false.
+                    This is read from the worker threads of the parallel evaluation.
                 @return the number of spectra evaluated. */
-        long EvaluateScan(const CString &scanfile, const CFitWindow& window, bool *fRun = NULL, const Configuration::CDarkSettings *darkSettings = NULL);
+        long EvaluateScan(const CString &scanfile, const CFitWindow& window, const std::atomic<bool> *fRun = NULL, const Configuration::CDarkSettings *darkSettings = NULL);
+
+        /** Called to evaluate one scan in several fit windows. Each spectrum is only read
+            from the file, interpolated and dark-corrected once and is then evaluated in every
+            one of the fit windows. The result of each fit window is retrieved with GetResult(windowIndex).
+                @return the number of spectra evaluated in the first fit window. */
+        long EvaluateScan(const CString &scanfile, const std::vector<CFitWindow>& windows, const std::atomic<bool> *fRun = NULL, const Configuration::CDarkSettings *darkSettings = NULL);
 
         /** Setting the option for how to get the sky spectrum. */
         void SetOption_Sky(const Configuration::CSkySettings& settings);
@@ -57,25 +67,136 @@ namespace Evaluation
         /** Setting the option for wheather the spectra are averaged or not. */
         void SetOption_AveragedSpectra(bool averaged);
 
-        /** @return a copy of the scan result */
+        /** Setting the number of threads to use when fitting the spectra of one scan.
+            With more than one thread are the spectra read and dark-corrected on the calling
+            thread while the fits are distributed over a pool of worker threads, each with
+            its own copy of the evaluator. The result is identical to the sequential evaluation.
+            The parallel evaluation is not used when the result of each spectrum is to be
+            shown in 'pView' or when the evaluation may be paused between the spectra. */
+        void SetOption_Threads(int numberOfThreads);
+
+        /** @return a copy of the scan result (in the first fit window) */
         std::unique_ptr<CScanResult> GetResult();
 
-        /** @return true if a result has been produced here */
+        /** @return a copy of the scan result in the fit window with the given index.
+            @return nullptr if no result was produced in this fit window. */
+        std::unique_ptr<CScanResult> GetResult(size_t windowIndex);
+
+        /** @return true if a result has been produced here (in the first fit window) */
         bool HasResult();
 
-        /** @return the number of spectra in the last scan evaluated */
+        /** @return true if a result has been produced in the fit window with the given index */
+        bool HasResult(size_t windowIndex);
+
+        /** @return the number of spectra in the last scan evaluated (in the first fit window) */
         int NumberOfSpectraInLastResult();
 
     private:
 
-        /** The evaluation results from the last scan evaluated */
-        std::shared_ptr<CScanResult> m_result;
+        /** The evaluation results from the last scan evaluated, one for each fit window */
+        std::vector<std::shared_ptr<CScanResult>> m_results;
 
-        /** A mutex to protect the scan result from bein updated/deleted/altered from two threads simultaneously */
+        /** A mutex to protect the scan results from bein updated/deleted/altered from two threads simultaneously */
         std::mutex m_resultMutex;
 
+        /** The outcome of reading the next spectrum from the scan-file */
+        enum class SpectrumReadOutcome
+        {
+            Evaluate,       // the spectrum is read, dark-corrected and should be evaluated
+            Skip,           // the spectrum is the sky or dark spectrum, or should be ignored
+            Corrupted,      // the spectrum could not be read from the file
+            EndOfScan,      // there are no more spectra in the file
+            Failed          // the dark spectrum could not be retrieved, the evaluation must be aborted
+        };
+
+        /** The state of the evaluation of the scan in one of the fit windows */
+        struct CWindowEvaluation
+        {
+            /** The fit window, adapted to the spectra in the scan */
+            CFitWindow window;
+
+            /** The evaluator of this fit window */
+            std::unique_ptr<CEvaluationBase> eval;
+
+            /** The fit region, adjusted for the start channel of the spectra */
+            long fitLow = 0;
+            long fitHigh = 0;
+
+            /** The dark-corrected sky spectrum, and the sky spectrum before the dark correction */
+            CSpectrum sky;
+            CSpectrum skyWithoutDarkCorrection;
+
+            /** The result of the evaluation */
+            std::shared_ptr<CScanResult> result;
+
+            /** The highest column found and the index of the spectrum in which it was found */
+            double highestColumn = 0.0;
+            int indexOfMostAbsorbingSpectrum = -1;
+
+            /** True if the fit window should be evaluated in the current pass through the scan */
+            bool active = true;
+        };
+
+        /** The fit of one spectrum in one fit window */
+        struct CWindowFit
+        {
+            /** True if the spectrum should be evaluated in this fit window */
+            bool evaluate = false;
+
+            /** The maximum intensity of the spectrum in the fit region */
+            float fitIntensity = 0.0f;
+
+            /** The result of the fit, filled in by the worker thread in the parallel evaluation */
+            CEvaluationResult result;
+
+            /** True if the fit failed, in which case 'errorMessage' tells why */
+            bool fitFailed = false;
+            std::string errorMessage;
+        };
+
+        /** One spectrum which has been read from the scan-file, together with the outcome of fitting it
+            in each of the fit windows. */
+        struct CPreparedSpectrum
+        {
+            SpectrumReadOutcome outcome = SpectrumReadOutcome::Evaluate;
+
+            /** The index of the spectrum in the .pak-file */
+            int index = 0;
+
+            /** The scan-index which should be marked as corrupted, if outcome is 'Corrupted' */
+            int corruptedScanIndex = 0;
+
+            /** The read and dark-corrected spectrum (only filled in by the parallel evaluation) */
+            CSpectrum spectrum;
+
+            /** The fits of this spectrum, one for each fit window */
+            std::vector<CWindowFit> fits;
+        };
+
         // ----------------------- PRIVATE METHODS ---------------------------
 
+        /** Adapts the fit window to the spectra in the scan and creates the evaluator for it */
+        void PrepareWindowEvaluation(FileHandler::CScanFileHandler& scan, const CFitWindow& window, const Configuration::CDarkSettings* darkSettings, CWindowEvaluation& evaluation);
+
+        /** Reads the next spectrum from the scan file and prepares it for the evaluation,
+            i.e. interpolates it, divides it by the number of co-adds and subtracts the dark.
+            The fit intensity and the ignore-check is made for each of the active fit windows.
+            @param index - the index of the spectrum in the .pak-file, incremented for every spectrum read.
+            @param item - will on return be filled with the fit windows in which the spectrum should be evaluated,
+                and the scan-index to mark as corrupted if the spectrum could not be read.
+            @param dark - will on return be filled with the dark spectrum of the read spectrum. */
+        SpectrumReadOutcome ReadNextSpectrum(FileHandler::CScanFileHandler& scan, const std::vector<CWindowEvaluation>& evaluations, const CSpectrum& sky, CSpectrum& dark, const Configuration::CDarkSettings* darkSettings, CSpectrum& current, int& index, CPreparedSpectrum& item);
+
+        /** Reads all spectra of the scan and fits them in all active fit windows, on the calling thread.
+            @return false if the evaluation was cancelled or failed. */
+        bool EvaluateSpectra(FileHandler::CScanFileHandler& scan, std::vector<CWindowEvaluation>& evaluations, CSpectrum& dark, const Configuration::CDarkSettings* darkSettings, const std::atomic<bool>* fRun);
+
+        /** Reads all spectra of the scan on the calling thread and fits them in all active fit windows 
+            using 'm_maxThreads' worker threads, each with its own copy of the configured evaluators. The results are
+            added to the result of each fit window in the order of the spectra in the scan.
+            @return false if the evaluation was cancelled or failed. */
+        bool EvaluateSpectraInParallel(FileHandler::CScanFileHandler& scan, std::vector<CWindowEvaluation>& evaluations, CSpectrum& dark, const Configuration::CDarkSettings* darkSettings, const std::atomic<bool>* fRun);
+
         /** This returns the sky spectrum that is to be used in the fitting. */
         RETURN_CODE GetSky(FileHandler::CScanFileHandler *scan, CSpectrum &sky);
 
@@ -91,10 +212,10 @@ namespace Evaluation
 
         /** This function updates the 'm_residual' and 'm_fitResult' spectra
             and sends the 'WM_EVAL_SUCCESS' message to the pView-window. */
-        void ShowResult(const CSpectrum &spec, const CEvaluationBase *eval, long curSpecIndex, long specNum);
+        void ShowResult(const CSpectrum &spec, const CEvaluationBase *eval, size_t windowIndex, long curSpecIndex, long specNum);
 
-        /** Updates the m_result in a thread safe manner (locking the m_resultMutex) */
-        void UpdateResult(std::shared_ptr<CScanResult> newResult);
+        /** Updates the result of one fit window in a thread safe manner (locking the m_resultMutex) */
+        void UpdateResult(size_t windowIndex, std::shared_ptr<CScanResult> newResult);
 
         /** Finds the optimum shift and squeeze for an evaluated scan
                     by looking at the spectrum with the highest absorption of the evaluated specie
@@ -128,6 +249,9 @@ namespace Evaluation
         /** True if the spectra are averaged, not summed */
         bool m_averagedSpectra;
 
+        /** The number of threads to use for fitting the spectra of one scan */
+        int m_maxThreads = 1;
+
         /** Remember the index of the spectrum with the highest absorption, to be able to
             adjust the shift and squeeze with it later */
         int m_indexOfMostAbsorbingSpectrum;
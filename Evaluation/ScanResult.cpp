@@ -70,6 +70,39 @@ CScanResult::CScanResult(const CScanResult& other)
     this->m_measurementMode = other.m_measurementMode;
 }
 
+CScanResult::CScanResult(CScanResult&& other)
+{
+    // The calculated flux and offset
+    this->m_flux = std::move(other.m_flux);
+    this->m_offset = other.m_offset;
+
+    // The errors
+    m_geomError = other.m_geomError;
+    m_scatteringError = other.m_scatteringError;
+    m_spectroscopyError = other.m_spectroscopyError;
+
+    // The calculated wind-direction and plume-centre
+    this->m_windDirection = other.m_windDirection;
+    this->m_plumeCentre[0] = other.m_plumeCentre[0];
+    this->m_plumeCentre[1] = other.m_plumeCentre[1];
+    this->m_plumeEdge[0] = other.m_plumeEdge[0];
+    this->m_plumeEdge[1] = other.m_plumeEdge[1];
+    this->m_plumeCompleteness = other.m_plumeCompleteness;
+
+    this->m_spec = std::move(other.m_spec);
+    this->m_specInfo = std::move(other.m_specInfo);
+    this->m_corruptedSpectra = std::move(other.m_corruptedSpectra);
+    this->m_specNum = other.m_specNum;
+    other.m_specNum = 0; // <-- the spectra are no longer in 'other'
+
+    this->m_skySpecInfo = std::move(other.m_skySpecInfo);
+    this->m_darkSpecInfo = std::move(other.m_darkSpecInfo);
+    this->m_offsetSpecInfo = std::move(other.m_offsetSpecInfo);
+    this->m_darkCurSpecInfo = std::move(other.m_darkCurSpecInfo);
+
+    this->m_measurementMode = other.m_measurementMode;
+}
+
 CScanResult::~CScanResult(void)
 {
     m_spec.clear();
@@ -597,6 +630,45 @@ CScanResult &CScanResult::operator=(const CScanResult &s2) {
     return *this;
 }
 
+/** Move assignment operator */
+CScanResult &CScanResult::operator=(CScanResult &&s2) {
+    if (this == &s2) {
+        return *this;
+    }
+
+    // The calculated flux and offset
+    this->m_flux = std::move(s2.m_flux);
+    this->m_offset = s2.m_offset;
+
+    // The errors
+    m_geomError = s2.m_geomError;
+    m_scatteringError = s2.m_scatteringError;
+    m_spectroscopyError = s2.m_spectroscopyError;
+
+    // The calculated wind-direction and plume-centre
+    this->m_windDirection = s2.m_windDirection;
+    this->m_plumeCentre[0] = s2.m_plumeCentre[0];
+    this->m_plumeCentre[1] = s2.m_plumeCentre[1];
+    this->m_plumeEdge[0] = s2.m_plumeEdge[0];
+    this->m_plumeEdge[1] = s2.m_plumeEdge[1];
+    this->m_plumeCompleteness = s2.m_plumeCompleteness;
+
+    this->m_spec = std::move(s2.m_spec);
+    this->m_specInfo = std::move(s2.m_specInfo);
+    this->m_corruptedSpectra = std::move(s2.m_corruptedSpectra);
+    this->m_specNum = s2.m_specNum;
+    s2.m_specNum = 0; // <-- the spectra are no longer in 's2'
+
+    this->m_skySpecInfo = std::move(s2.m_skySpecInfo);
+    this->m_darkSpecInfo = std::move(s2.m_darkSpecInfo);
+    this->m_offsetSpecInfo = std::move(s2.m_offsetSpecInfo);
+    this->m_darkCurSpecInfo = std::move(s2.m_darkCurSpecInfo);
+
+    this->m_measurementMode = s2.m_measurementMode;
+
+    return *this;
+}
+
 bool CScanResult::MarkAs(unsigned long index, int MARK_FLAG) {
     if (!IsValidSpectrumIndex(index))
         return false;
@@ -946,6 +1018,18 @@ bool CScanResult::IsCompositionMeasurement() const {
     return false;
 }
 
+bool CScanResult::IsDarkSpectrum(unsigned long index) const {
+    if (!IsValidSpectrumIndex(index))
+        return false;
+
+    if (fabs(m_specInfo[index].m_scanAngle) - 180.0 >= 1e-3)
+        return false;
+
+    std::string name = CleanString(m_specInfo[index].m_name);
+    Trim(name, " \t");
+    return EqualsIgnoringCase(name, "offset") || EqualsIgnoringCase(name, "dark_cur") || EqualsIgnoringCase(name, "dark");
+}
+
 bool CScanResult::GetStartTime(unsigned long index, CDateTime &t) const {
     if (!IsValidSpectrumIndex(index))
         return false;
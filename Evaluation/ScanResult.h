@@ -22,6 +22,7 @@ namespace Evaluation
 	public:
 		CScanResult();
 		CScanResult(const CScanResult& other);
+		CScanResult(CScanResult&& other);
 
 		~CScanResult();
 
@@ -138,6 +139,10 @@ namespace Evaluation
 		/** Returns true if this is a composition mode measurement */
 		bool IsCompositionMeasurement() const;
 
+		/** Returns true if the spectrum with the given index is a dark or offset
+		    measurement, i.e. it was collected at 180 degrees and is named 'dark', 'dark_cur' or 'offset' */
+		bool IsDarkSpectrum(unsigned long index) const;
+
 		/** Calculates the maximum good column value in the scan, 
 		    corrected for the offset.
 		    NB!! The function 'CalculateOffset' must have been called
@@ -374,6 +379,10 @@ namespace Evaluation
 		/** Assignment operator */
 		CScanResult &operator=(const CScanResult &s2);
 
+		/** Move assignment operator, takes over the evaluated spectra of 's2' instead of copying them.
+				's2' is left without any evaluated spectra. */
+		CScanResult &operator=(CScanResult &&s2);
+
 		/** Getting the estimated geometrical error */
 		double	GetGeometricalError() const;
 
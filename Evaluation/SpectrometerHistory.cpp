@@ -1,5 +1,6 @@
 #include "StdAfx.h"
 #include "spectrometerhistory.h"
+#include "../Common/SnapshotFile.h"
 
 using namespace Evaluation;
 
@@ -588,3 +589,82 @@ void	CSpectrometerHistory::GetAlphaRange(double &alpha_min, double &alpha_max){
 
 	return;
 }
+
+
+void CSpectrometerHistory::SaveSnapshot(FileHandler::CSnapshotWriter &snapshot) const{
+	// the lists are written in their order, i.e. the newest first
+	snapshot.Write((uint32_t)m_scanInfo.GetCount());
+	POSITION pos = m_scanInfo.GetHeadPosition();
+	while(pos != NULL){
+		const CScanInfo &info = m_scanInfo.GetNext(pos);
+		snapshot.WriteTime(info.startTime);
+		snapshot.WriteTime(info.arrived);
+		snapshot.Write(info.plumeCentre);
+		snapshot.Write(info.plumeEdge);
+		snapshot.Write(info.plumeCompleteness);
+		snapshot.Write((int32_t)info.exposureTime);
+		snapshot.Write(info.maxColumn);
+		snapshot.Write(info.alpha);
+	}
+
+	SaveMeasurementTimes(snapshot, m_windMeasurementTimes);
+	SaveMeasurementTimes(snapshot, m_compMeasurementTimes);
+}
+
+bool CSpectrometerHistory::LoadSnapshot(FileHandler::CSnapshotReader &snapshot){
+	uint32_t scanNum = 0;
+	if(!snapshot.Read(scanNum) || scanNum > MAX_SPECTROMETER_HISTORY)
+		return false;
+
+	CList <CScanInfo, CScanInfo &> scanInfo;
+	for(uint32_t k = 0; k < scanNum && snapshot.Ok(); ++k){
+		CScanInfo info;
+		int32_t exposureTime = 0;
+		snapshot.ReadTime(info.startTime);
+		snapshot.ReadTime(info.arrived);
+		snapshot.Read(info.plumeCentre);
+		snapshot.Read(info.plumeEdge);
+		snapshot.Read(info.plumeCompleteness);
+		snapshot.Read(exposureTime);
+		snapshot.Read(info.maxColumn);
+		snapshot.Read(info.alpha);
+		info.exposureTime = exposureTime;
+		scanInfo.AddTail(info);
+	}
+
+	CList <CWMInfo, CWMInfo &> windMeasurementTimes, compMeasurementTimes;
+	LoadMeasurementTimes(snapshot, windMeasurementTimes);
+	LoadMeasurementTimes(snapshot, compMeasurementTimes);
+	if(!snapshot.Ok())
+		return false;
+
+	m_scanInfo.RemoveAll();
+	m_scanInfo.AddTail(&scanInfo);
+	m_windMeasurementTimes.RemoveAll();
+	m_windMeasurementTimes.AddTail(&windMeasurementTimes);
+	m_compMeasurementTimes.RemoveAll();
+	m_compMeasurementTimes.AddTail(&compMeasurementTimes);
+
+	return true;
+}
+
+void CSpectrometerHistory::SaveMeasurementTimes(FileHandler::CSnapshotWriter &snapshot, const CList <CWMInfo, CWMInfo &> &list){
+	snapshot.Write((uint32_t)list.GetCount());
+	POSITION pos = list.GetHeadPosition();
+	while(pos != NULL){
+		const CWMInfo &info = list.GetNext(pos);
+		snapshot.WriteTime(info.startTime);
+		snapshot.WriteTime(info.arrived);
+	}
+}
+
+void CSpectrometerHistory::LoadMeasurementTimes(FileHandler::CSnapshotReader &snapshot, CList <CWMInfo, CWMInfo &> &list){
+	uint32_t number = 0;
+	snapshot.Read(number);
+	for(uint32_t k = 0; k < number && snapshot.Ok(); ++k){
+		CWMInfo info;
+		snapshot.ReadTime(info.startTime);
+		snapshot.ReadTime(info.arrived);
+		list.AddTail(info);
+	}
+}
\ No newline at end of file
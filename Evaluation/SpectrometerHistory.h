@@ -7,6 +7,11 @@
 
 #include "ScanResult.h"
 
+namespace FileHandler{
+	class CSnapshotWriter;
+	class CSnapshotReader;
+}
+
 namespace Evaluation{
 
 	/** <b>CSpectrometerHistory</b> is a data structure, used by the
@@ -127,6 +132,13 @@ namespace Evaluation{
 				than 'scansToAverage' scans collected today */
 		double	GetColumnMax(int scansToAverage);
 
+		/** Writes the whole history to the given snapshot */
+		void SaveSnapshot(FileHandler::CSnapshotWriter &snapshot) const;
+
+		/** Replaces the history with the one written by SaveSnapshot.
+				@return false if the snapshot could not be read, the history is then left unchanged */
+		bool LoadSnapshot(FileHandler::CSnapshotReader &snapshot);
+
 		// ----------------------------------------------------------------------
 		// ----------------------- PUBLIC DATA ----------------------------------
 		// ----------------------------------------------------------------------
@@ -139,6 +151,11 @@ namespace Evaluation{
 		// --------------------- PRIVATE METHODS --------------------------------
 		// ----------------------------------------------------------------------
 
+		/** Writes the given list of measurement times to the snapshot */
+		static void SaveMeasurementTimes(FileHandler::CSnapshotWriter &snapshot, const CList <CWMInfo, CWMInfo &> &list);
+
+		/** Reads a list of measurement times written by SaveMeasurementTimes */
+		static void LoadMeasurementTimes(FileHandler::CSnapshotReader &snapshot, CList <CWMInfo, CWMInfo &> &list);
 
 		// ----------------------------------------------------------------------
 		// ---------------------- PRIVATE DATA ----------------------------------
@@ -0,0 +1,386 @@
+#include "StdAfx.h"
+#include "NetCdfWindFileReader.h"
+#include "../Meteorology/WindFieldInterpolation.h"
+#include "../External/NetCdf_4_7_2/include/netcdf.h"
+#include <SpectralEvaluation/StringUtils.h>
+#include <cmath>
+#include <stdexcept>
+
+using namespace FileHandler;
+
+namespace
+{
+    /** @return the number of days since 1970-01-01 of the given date in the Gregorian calendar */
+    long long DaysFromCivil(int year, int month, int day)
+    {
+        year -= (month <= 2) ? 1 : 0;
+        const long long era = (year >= 0 ? year : year - 399) / 400;
+        const long long yearOfEra = year - era * 400;
+        const long long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    /** Calculates the date in the Gregorian calendar from the number of days since 1970-01-01 */
+    void CivilFromDays(long long days, int& year, int& month, int& day)
+    {
+        days += 719468;
+        const long long era = (days >= 0 ? days : days - 146096) / 146097;
+        const long long dayOfEra = days - era * 146097;
+        const long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const long long mp = (5 * dayOfYear + 2) / 153;
+        day = (int)(dayOfYear - (153 * mp + 2) / 5 + 1);
+        month = (int)(mp < 10 ? mp + 3 : mp - 9);
+        year = (int)(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+    }
+
+    /** Reads a text attribute of the given variable */
+    std::string ReadTextAttribute(int ncid, int varId, const char* name)
+    {
+        size_t length = 0;
+        if (NC_NOERR != nc_inq_attlen(ncid, varId, name, &length) || length == 0)
+        {
+            return std::string();
+        }
+        std::vector<char> buffer(length + 1, 0);
+        if (NC_NOERR != nc_get_att_text(ncid, varId, name, buffer.data()))
+        {
+            return std::string();
+        }
+        return std::string(buffer.data());
+    }
+
+    /** Reads a numerical attribute of the given variable, returns 'defaultValue' if there is no such attribute */
+    double ReadNumericAttribute(int ncid, int varId, const char* name, double defaultValue)
+    {
+        double value = defaultValue;
+        if (NC_NOERR != nc_get_att_double(ncid, varId, name, &value))
+        {
+            return defaultValue;
+        }
+        return value;
+    }
+}
+
+RETURN_CODE CNetCdfWindFileReader::ReadWindFile(const std::vector<CNamedLocation>& locations, std::vector<CWindFieldDatabase>& result)
+{
+    result.clear();
+    result.resize(locations.size());
+
+    int ncid = 0;
+    if (NC_NOERR != nc_open((LPCSTR)m_windFile, NC_NOWRITE, &ncid))
+    {
+        return FAIL;
+    }
+
+    // 1. Find the wind variables and their dimensions
+    int uVarId = 0, vVarId = 0;
+    int nDims = 0;
+    int dimensionIds[NC_MAX_VAR_DIMS];
+    if (NC_NOERR != nc_inq_varid(ncid, "u", &uVarId) || NC_NOERR != nc_inq_varid(ncid, "v", &vVarId) ||
+        NC_NOERR != nc_inq_varndims(ncid, uVarId, &nDims) || nDims != 4 ||
+        NC_NOERR != nc_inq_vardimid(ncid, uVarId, dimensionIds))
+    {
+        nc_close(ncid);
+        return FAIL;
+    }
+
+    // 2. Read the coordinate axes. These are small compared to the wind-field itself.
+    std::vector<CDateTime> times;
+    CoordinateAxis levels, latitudes, longitudes;
+    if (!ReadTimeAxis(ncid, dimensionIds[0], times) ||
+        !ReadCoordinateAxis(ncid, dimensionIds[1], levels) ||
+        !ReadCoordinateAxis(ncid, dimensionIds[2], latitudes) ||
+        !ReadCoordinateAxis(ncid, dimensionIds[3], longitudes))
+    {
+        nc_close(ncid);
+        return FAIL;
+    }
+
+    // 3. Extract the wind at each of the locations
+    std::vector<float> u, v;
+    std::vector<char> uValid, vValid;
+    std::vector<double> speed(times.size()), speedError(times.size()), direction(times.size()), directionError(times.size());
+    for (size_t locationIdx = 0; locationIdx < locations.size(); ++locationIdx)
+    {
+        const CNamedLocation& location = locations[locationIdx];
+
+        // 3a. Find the grid cell surrounding the location. The longitudes can be given either in the range
+        //      [-180, 180] or in the range [0, 360].
+        GridCell cell;
+        cell.count[0] = times.size();
+        double longitude = location.m_longitude;
+        if (longitudes.values.size() > 0 && longitude < longitudes.values.front() && longitude < longitudes.values.back())
+        {
+            longitude += 360.0;
+        }
+        if (!LocateOnAxis(levels.values, PressureAtAltitude(location.m_altitude), true, cell.start[1], cell.count[1], cell.fraction[0]) ||
+            !LocateOnAxis(latitudes.values, location.m_latitude, false, cell.start[2], cell.count[2], cell.fraction[1]) ||
+            !LocateOnAxis(longitudes.values, longitude, false, cell.start[3], cell.count[3], cell.fraction[2]))
+        {
+            continue; // the location is outside of the model grid
+        }
+
+        // 3b. Read the wind in the grid cell
+        if (!ReadGridCell(ncid, uVarId, cell, u, uValid) || !ReadGridCell(ncid, vVarId, cell, v, vValid))
+        {
+            nc_close(ncid);
+            return FAIL;
+        }
+
+        // 3c. Interpolate the wind speed and direction at the location
+        InterpolatedWindBuffers buffers;
+        buffers.speed = speed.data();
+        buffers.speedError = speedError.data();
+        buffers.direction = direction.data();
+        buffers.directionError = directionError.data();
+        try
+        {
+            const std::vector<size_t> sizes = { times.size(), 2, 2, 2 };
+            const std::vector<double> spatialIndices = { cell.fraction[0], cell.fraction[1], cell.fraction[2] };
+            InterpolateWind(u, v, sizes, spatialIndices, &buffers);
+        }
+        catch (std::invalid_argument* e)
+        {
+            delete e;
+            continue;
+        }
+
+        // 3d. Insert the wind-fields into the database of this location
+        std::vector<CWindField> records;
+        records.reserve(times.size());
+        for (size_t timeIdx = 0; timeIdx < times.size(); ++timeIdx)
+        {
+            if (!uValid[timeIdx] || !vValid[timeIdx])
+            {
+                continue;
+            }
+
+            double windDirection = direction[timeIdx];
+            if (windDirection < 0.0)
+            {
+                windDirection += 360.0;
+            }
+
+            CWindField windField;
+            windField.SetTimeAndDate(times[timeIdx]);
+            windField.SetWindSpeed(speed[timeIdx], MET_ECMWF_ANALYSIS, speedError[timeIdx]);
+            windField.SetWindDirection(windDirection, MET_ECMWF_ANALYSIS, directionError[timeIdx]);
+            records.push_back(windField);
+        }
+
+        result[locationIdx].InsertWindFields(std::move(records));
+        result[locationIdx].m_containsWindSpeed = true;
+        result[locationIdx].m_containsWindDirection = true;
+        result[locationIdx].m_containsPlumeHeight = false;
+    }
+
+    nc_close(ncid);
+
+    return SUCCESS;
+}
+
+bool CNetCdfWindFileReader::ReadCoordinateAxis(int ncid, int dimensionId, CoordinateAxis& axis)
+{
+    char name[NC_MAX_NAME + 1];
+    size_t length = 0;
+    if (NC_NOERR != nc_inq_dim(ncid, dimensionId, name, &length))
+    {
+        return false;
+    }
+    axis.name = name;
+    axis.values.resize(length);
+
+    // The values along the axis are stored in the variable with the same name as the dimension
+    int varId = 0;
+    if (NC_NOERR != nc_inq_varid(ncid, name, &varId))
+    {
+        // no coordinate variable, this is only acceptable if there is just one value along the axis
+        axis.values.assign(length, 0.0);
+        return (length == 1);
+    }
+    if (NC_NOERR != nc_get_var_double(ncid, varId, axis.values.data()))
+    {
+        return false;
+    }
+
+    // Apply the packing of the values, if any
+    const double scale = ReadNumericAttribute(ncid, varId, "scale_factor", 1.0);
+    const double offset = ReadNumericAttribute(ncid, varId, "add_offset", 0.0);
+    for (double& value : axis.values)
+    {
+        value = value * scale + offset;
+    }
+
+    return true;
+}
+
+bool CNetCdfWindFileReader::ReadTimeAxis(int ncid, int dimensionId, std::vector<CDateTime>& times)
+{
+    CoordinateAxis axis;
+    if (!ReadCoordinateAxis(ncid, dimensionId, axis))
+    {
+        return false;
+    }
+
+    // The units are given as e.g. 'hours since 1900-01-01 00:00:00.0'
+    int varId = 0;
+    if (NC_NOERR != nc_inq_varid(ncid, axis.name.c_str(), &varId))
+    {
+        return false;
+    }
+    const std::string units = ReadTextAttribute(ncid, varId, "units");
+    char unit[32];
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    double second = 0.0;
+    if (sscanf(units.c_str(), "%31s since %d-%d-%d %d:%d:%lf", unit, &year, &month, &day, &hour, &minute, &second) < 4)
+    {
+        return false;
+    }
+
+    double secondsPerUnit = 0.0;
+    if (EqualsIgnoringCase(unit, "seconds"))
+    {
+        secondsPerUnit = 1.0;
+    }
+    else if (EqualsIgnoringCase(unit, "minutes"))
+    {
+        secondsPerUnit = 60.0;
+    }
+    else if (EqualsIgnoringCase(unit, "hours"))
+    {
+        secondsPerUnit = 3600.0;
+    }
+    else if (EqualsIgnoringCase(unit, "days"))
+    {
+        secondsPerUnit = 86400.0;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Convert the times to seconds since 1970-01-01 and from that to date and time
+    const double referenceTime = DaysFromCivil(year, month, day) * 86400.0 + hour * 3600.0 + minute * 60.0 + second;
+    times.resize(axis.values.size());
+    for (size_t k = 0; k < axis.values.size(); ++k)
+    {
+        const long long secondsSince1970 = (long long)std::floor(referenceTime + axis.values[k] * secondsPerUnit + 0.5);
+        long long days = secondsSince1970 / 86400;
+        long long secondOfDay = secondsSince1970 % 86400;
+        if (secondOfDay < 0)
+        {
+            secondOfDay += 86400;
+            --days;
+        }
+
+        int y = 0, m = 0, d = 0;
+        CivilFromDays(days, y, m, d);
+        times[k] = CDateTime(y, m, d, (int)(secondOfDay / 3600), (int)((secondOfDay / 60) % 60), (int)(secondOfDay % 60));
+    }
+
+    return true;
+}
+
+bool CNetCdfWindFileReader::LocateOnAxis(const std::vector<double>& axis, double value, bool clamp, size_t& start, size_t& count, double& fraction)
+{
+    if (axis.size() == 0)
+    {
+        return false;
+    }
+    if (axis.size() == 1)
+    {
+        start = 0;
+        count = 1;
+        fraction = 0.0;
+        return true;
+    }
+
+    // The axis can be either increasing (e.g. longitudes) or decreasing (e.g. latitudes in ECMWF files)
+    const bool increasing = axis.back() > axis.front();
+    const double lowest = increasing ? axis.front() : axis.back();
+    const double highest = increasing ? axis.back() : axis.front();
+    if (value < lowest || value > highest)
+    {
+        if (!clamp)
+        {
+            return false;
+        }
+        value = (value < lowest) ? lowest : highest;
+    }
+
+    count = 2;
+    for (size_t k = 0; k + 1 < axis.size(); ++k)
+    {
+        const double first = axis[k];
+        const double second = axis[k + 1];
+        if ((value >= first && value <= second) || (value <= first && value >= second))
+        {
+            start = k;
+            fraction = (second == first) ? 0.0 : (value - first) / (second - first);
+
+            // The interpolation requires the location to be strictly inside of the cell,
+            //  a location exactly on the last grid point is moved a tiny bit inwards.
+            if (fraction >= 1.0)
+            {
+                fraction = 1.0 - 1e-9;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CNetCdfWindFileReader::ReadGridCell(int ncid, int varId, const GridCell& cell, std::vector<float>& values, std::vector<char>& valid)
+{
+    const size_t timeNum = cell.count[0];
+    const size_t cellSize = cell.count[1] * cell.count[2] * cell.count[3];
+
+    // Read the hyperslab, this is only the values in the grid cell
+    std::vector<float> raw(timeNum * cellSize);
+    if (NC_NOERR != nc_get_vara_float(ncid, varId, cell.start, cell.count, raw.data()))
+    {
+        return false;
+    }
+
+    // The values are often packed as short integers, with a scale factor and offset
+    const double scale = ReadNumericAttribute(ncid, varId, "scale_factor", 1.0);
+    const double offset = ReadNumericAttribute(ncid, varId, "add_offset", 0.0);
+    const double fillValue = ReadNumericAttribute(ncid, varId, "_FillValue", ReadNumericAttribute(ncid, varId, "missing_value", NC_FILL_FLOAT));
+
+    // Unpack the values into a 2x2x2 cube for each point in time.
+    //  Along a dimension with only one value in the file, the same value is used on both sides of the cube.
+    values.resize(timeNum * 8);
+    valid.assign(timeNum, 1);
+    for (size_t timeIdx = 0; timeIdx < timeNum; ++timeIdx)
+    {
+        const float* timeValues = raw.data() + timeIdx * cellSize;
+        for (size_t lvl = 0; lvl < 2; ++lvl)
+        {
+            for (size_t lat = 0; lat < 2; ++lat)
+            {
+                for (size_t lon = 0; lon < 2; ++lon)
+                {
+                    const size_t lvlIdx = (lvl < cell.count[1]) ? lvl : 0;
+                    const size_t latIdx = (lat < cell.count[2]) ? lat : 0;
+                    const size_t lonIdx = (lon < cell.count[3]) ? lon : 0;
+                    const float rawValue = timeValues[(lvlIdx * cell.count[2] + latIdx) * cell.count[3] + lonIdx];
+                    if (rawValue == (float)fillValue)
+                    {
+                        valid[timeIdx] = 0;
+                    }
+                    values[timeIdx * 8 + (lvl * 2 + lat) * 2 + lon] = (float)(rawValue * scale + offset);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+double CNetCdfWindFileReader::PressureAtAltitude(double altitude)
+{
+    return 1013.25 * std::pow(1.0 - 2.25577e-5 * altitude, 5.25588);
+}
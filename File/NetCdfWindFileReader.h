@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../Meteorology/WindFieldDatabase.h"
+
+namespace FileHandler
+{
+
+/** This class reads the wind field from a NetCDF file with the eastward (u) and northward (v)
+    components of the wind from a meteorological model, such as the ECMWF reanalysis.
+    The variables 'u' and 'v' must have the dimensions [time, level, latitude, longitude].
+    Only the grid cells surrounding each location of interest are read from the file, for all
+    points in time, such that also very large files can be read quickly and using little memory. */
+class CNetCdfWindFileReader
+{
+public:
+    CNetCdfWindFileReader() = default;
+
+    /** The name and path of the NetCDF file */
+    CString m_windFile;
+
+    // ------------------- PUBLIC METHODS -------------------------
+
+    /** Reads the wind at the given locations from the file. The wind is extracted at the
+        pressure level corresponding to the altitude of each location.
+        @param locations The locations where the wind should be extracted.
+        @param result Will on successful return be filled with one database for each location,
+            in the same order as 'locations'. The database of a location outside of the model grid is left empty.
+        @return SUCCESS if the file could be read. */
+    RETURN_CODE ReadWindFile(const std::vector<CNamedLocation>& locations, std::vector<CWindFieldDatabase>& result);
+
+private:
+
+    /** The values of the coordinate variable along one dimension of the wind-field */
+    struct CoordinateAxis
+    {
+        std::string name;
+        std::vector<double> values;
+    };
+
+    /** The part of the wind-field grid surrounding one location */
+    struct GridCell
+    {
+        size_t start[4] = { 0, 0, 0, 0 };  // the index of the first value to read in each dimension
+        size_t count[4] = { 0, 1, 1, 1 };  // the number of values to read in each dimension (one or two)
+        double fraction[3] = { 0, 0, 0 };  // the position of the location in the cell, in the range [0, 1) in each spatial dimension
+    };
+
+    // ------------------- PRIVATE METHODS -------------------------
+
+    /** Reads the coordinate variable of the given dimension in the open file */
+    static bool ReadCoordinateAxis(int ncid, int dimensionId, CoordinateAxis& axis);
+
+    /** Reads the time axis of the open file and converts it to date and time (UTC) */
+    static bool ReadTimeAxis(int ncid, int dimensionId, std::vector<CDateTime>& times);
+
+    /** Finds the position of the given value along the given axis.
+        @param clamp If true then a value outside of the axis is moved to the closest end of the axis,
+            otherwise false is returned for values outside of the axis. */
+    static bool LocateOnAxis(const std::vector<double>& axis, double value, bool clamp, size_t& start, size_t& count, double& fraction);
+
+    /** Reads the values of the given variable in the given grid cell, for all points in time, and unpacks
+        them into cubes of 2x2x2 values for each point in time as expected by InterpolateWind.
+        @param valid Will be set to false for the points in time where any of the values is missing. */
+    static bool ReadGridCell(int ncid, int varId, const GridCell& cell, std::vector<float>& values, std::vector<char>& valid);
+
+    /** @return the approximate atmospheric pressure (hPa) at the given altitude (meters above sea level),
+        using the international standard atmosphere. */
+    static double PressureAtAltitude(double altitude);
+};
+
+}
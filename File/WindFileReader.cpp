@@ -6,6 +6,7 @@ using namespace FileHandler;
 RETURN_CODE CWindFileReader::ReadWindFile(CWindFieldDatabase& result)
 {
     CWindField windfield; // <-- the next wind-field to insert
+    std::vector<CWindField> windfields; // <-- all the wind-fields read, these are inserted together in the end
     char dateStr[] = _T("date"); // this string only exists in the header line.
     char sourceStr[] = _T("source");
     char szLine[8192];
@@ -150,12 +151,15 @@ RETURN_CODE CWindFileReader::ReadWindFile(CWindFieldDatabase& result)
         }//end while(szToken = strtok(szToken, " \t"))
 
         // insert the recently read wind-field into the list
-        result.InsertWindField(windfield);
+        windfields.push_back(windfield);
     }
 
     // close the file
     fclose(f);
 
+    // insert the wind-fields into the database, they are then sorted once
+    result.InsertWindFields(std::move(windfields));
+
     // all is ok..
     return SUCCESS;
 }
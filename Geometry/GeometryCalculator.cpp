@@ -6,12 +6,16 @@
 #include "../VolcanoInfo.h"
 
 #include "../Common/EvaluationLogFileHandler.h"
+#include "../Common/LogTail.h"
 
 using namespace Geometry;
 
 // The global list of volcanoes in the NOVAC network
 extern CVolcanoInfo g_volcanoes;
 
+// The evaluation-logs read so far
+extern FileHandler::CLogTail g_logTails;
+
 CGeometryCalculator::CGeometryCalculator(void)
 {
 }
@@ -384,26 +388,26 @@ void CGeometryCalculator::GetDirection(double direction[3], double scanAngle, do
 /** Calculate the plume-height using the two scans found in the 
 		given evaluation-files. */
 bool CGeometryCalculator::CalculateGeometry(const CString &evalLog1, int scanIndex1, const CString &evalLog2, int scanIndex2, double &plumeHeight, double &plumeHeightError, double &windDirection, double &windDirectionError, CGeometryCalculationInfo *info){
-	FileHandler::CEvaluationLogFileHandler reader[2];
+	std::shared_ptr<const FileHandler::CEvaluationLogView> logView[2];
 	CGPSData gps[2], source;
 	double plumeCentre[2], plumeCompleteness, tmp, plumeEdge_low, plumeEdge_high;
 	Common common;
 	int k;
 
-	// 1. Read the evaluation-logs
-	reader[0].m_evaluationLog.Format("%s", (LPCSTR)evalLog1);
-	reader[1].m_evaluationLog.Format("%s", (LPCSTR)evalLog2);
-	if(SUCCESS != reader[0].ReadEvaluationLog())
+	// 1. Read the evaluation-logs, only what has been appended since they were last read
+	logView[0] = g_logTails.FollowEvaluationLog(evalLog1);
+	logView[1] = g_logTails.FollowEvaluationLog(evalLog2);
+	if(logView[0] == nullptr || logView[1] == nullptr)
 		return false;
-	if(SUCCESS != reader[1].ReadEvaluationLog())
+	if(scanIndex1 < 0 || scanIndex1 >= (int)logView[0]->m_scans.size() || scanIndex2 < 0 || scanIndex2 >= (int)logView[1]->m_scans.size())
 		return false;
 
 	// 2. Get the gps-data from the eval-logs, if they don't contain any
 	//      GPS-information or if the instruments are too close then return.
 	for(k = 0; k < 2; ++k){
-		gps[k].m_latitude  = reader[k].m_specInfo.m_gps.m_latitude;
-		gps[k].m_longitude = reader[k].m_specInfo.m_gps.m_longitude;
-		gps[k].m_altitude  = reader[k].m_specInfo.m_gps.m_altitude;
+		gps[k].m_latitude  = logView[k]->m_specInfo.m_gps.m_latitude;
+		gps[k].m_longitude = logView[k]->m_specInfo.m_gps.m_longitude;
+		gps[k].m_altitude  = logView[k]->m_specInfo.m_gps.m_altitude;
 	}
 	if(fabs(gps[0].m_latitude) < 1e-2 && fabs(gps[0].m_longitude) < 1e-2)
 		return false;
@@ -429,16 +433,17 @@ bool CGeometryCalculator::CalculateGeometry(const CString &evalLog1, int scanInd
 	// 4. Get the scan-angles around which the plumes are centred
 	int index[2] = {scanIndex1, scanIndex2};
 	for(k = 0; k < 2; ++k){
-		if(false == reader[k].m_scan[index[k]].CalculatePlumeCentre("SO2", plumeCentre[k], tmp, plumeCompleteness, plumeEdge_low, plumeEdge_high))
+		Evaluation::CScanResult scan = logView[k]->m_scans[index[k]]->scan; // <-- a copy, the scans in the view are shared
+		if(false == scan.CalculatePlumeCentre("SO2", plumeCentre[k], tmp, plumeCompleteness, plumeEdge_low, plumeEdge_high))
 			return false; // <-- cannot see the plume
 	}
 
 	// 5. Get the compass-directions, the tilt of the two systems and the coneAngles
 	double compass[2], coneAngle[2], tilt[2];
 	for(k = 0; k < 2; ++k){
-		compass[k]    = reader[k].m_specInfo.m_compass;
-		coneAngle[k]  = reader[k].m_specInfo.m_coneAngle;
-		tilt[k]       = reader[k].m_specInfo.m_pitch;
+		compass[k]    = logView[k]->m_specInfo.m_compass;
+		coneAngle[k]  = logView[k]->m_specInfo.m_coneAngle;
+		tilt[k]       = logView[k]->m_specInfo.m_pitch;
 	}
 
 	// 6. Calculate the plume-height
@@ -19,6 +19,8 @@
 #include "Communication/FTPServerContacter.h"
 #include "WindFileController.h"
 #include "Common/ReportWriter.h"
+#include "Common/BufferedLogWriter.h"
+#include "Common/LogTail.h"
 
 using namespace Evaluation;
 using namespace Communication;
@@ -56,6 +58,14 @@ CWinThread *g_report;
       evaluation-log - files */
 CCriticalSection g_evalLogCritSect;
 
+/** The log files which are written to by the program. These are kept
+      open and written to disk according to the configured flush policy */
+CBufferedLogWriter g_logFiles;
+
+/** The evaluation logs and flux logs which are followed while they are being written.
+      The scans already read from each log are shared by all the readers of the log */
+CLogTail g_logTails;
+
 /** This function looks through the output directories and sees if there's any
     old spectra there that should be evaluted. This function is only called at
     startup to make sure that there's no left-overs from previous runs of the
@@ -1,12 +1,15 @@
 #include "StdAfx.h"
 #include "MeteorologicalData.h"
 #include "../File/WindFileReader.h"
+#include "../File/NetCdfWindFileReader.h"
 
 /** The global instance of meterological data */
 CMeteorologicalData g_metData;
 
 int CMeteorologicalData::SetWindField(const CString& serialNumber, const CWindField& windField)
 {
+    std::lock_guard<std::mutex> lock(m_windFieldMutex);
+
     for (int i = 0; i < m_scannerNum; ++i)
     {
         if (Equals(serialNumber, m_scanner[i]))
@@ -33,48 +36,79 @@ int CMeteorologicalData::SetWindField(const CString& serialNumber, const CWindFi
 
 void CMeteorologicalData::SetVolcanoes(const std::vector<CNamedLocation>& volcanoes)
 {
+    std::lock_guard<std::mutex> lock(m_wfDatabaseMutex);
+
     this->m_volcanoes = volcanoes;
 }
 
+void CMeteorologicalData::SetInstrumentLocations(const std::vector<CNamedLocation>& instruments, const std::vector<std::string>& volcanoNames)
+{
+    std::lock_guard<std::mutex> lock(m_wfDatabaseMutex);
+
+    this->m_instruments = instruments;
+    this->m_volcanoOfInstrument.clear();
+    for (size_t ii = 0; ii < instruments.size() && ii < volcanoNames.size(); ++ii)
+    {
+        if (!volcanoNames[ii].empty())
+        {
+            this->m_volcanoOfInstrument[instruments[ii].m_name] = volcanoNames[ii];
+        }
+    }
+}
+
 int CMeteorologicalData::GetWindField(const CString& serialNumber, const CDateTime& dt, CWindField& windField)
 {
     int scannerIndex = -1;
 
     // Find the index of the scanner
-    for (scannerIndex = 0; scannerIndex < m_scannerNum; ++scannerIndex)
     {
-        if (Equals(serialNumber, m_scanner[scannerIndex]))
+        std::lock_guard<std::mutex> lock(m_windFieldMutex);
+        for (scannerIndex = 0; scannerIndex < m_scannerNum; ++scannerIndex)
+        {
+            if (Equals(serialNumber, m_scanner[scannerIndex]))
+            {
+                break;
+            }
+        }
+        if (scannerIndex == m_scannerNum)
         {
-            break;
+            scannerIndex = -1; // not found
         }
     }
 
     // 1. Try to read the wind from the wind-field file reader
-    if (m_wfDatabaseFromFile != nullptr)
     {
         std::lock_guard<std::mutex> lock(m_wfDatabaseMutex);
-        if (SUCCESS == m_wfDatabaseFromFile->InterpolateWindField(dt, windField))
+        if (m_wfDatabaseFromFile != nullptr && GetWindFieldFromDatabase(*m_wfDatabaseFromFile, scannerIndex, dt, windField))
         {
-            // Check if the file contains the wind-speed, the wind-direction and/or the plume height
-            if (!m_wfDatabaseFromFile->m_containsWindDirection && scannerIndex >= 0)
-            {
-                windField.SetWindDirection(m_windFieldAtScanner[scannerIndex].GetWindDirection(), MET_USER);
-            }
+            return 0; // wind-field found...
+        }
 
-            if (!m_wfDatabaseFromFile->m_containsWindSpeed)
+        // 1b. The wind extracted from a net-cdf file, preferably at the volcano monitored by the instrument
+        //  and otherwise at the location of the instrument itself.
+        if (m_wfDatabasePerLocation.size() > 0)
+        {
+            const std::string serial((LPCSTR)serialNumber);
+            auto volcano = m_volcanoOfInstrument.find(serial);
+            if (volcano != m_volcanoOfInstrument.end())
             {
-                windField.SetWindSpeed(m_windFieldAtScanner[scannerIndex].GetWindSpeed(), MET_USER);
+                auto database = m_wfDatabasePerLocation.find(volcano->second);
+                if (database != m_wfDatabasePerLocation.end() && GetWindFieldFromDatabase(database->second, scannerIndex, dt, windField))
+                {
+                    return 0; // wind-field found...
+                }
             }
 
-            if (!m_wfDatabaseFromFile->m_containsPlumeHeight)
+            auto database = m_wfDatabasePerLocation.find(serial);
+            if (database != m_wfDatabasePerLocation.end() && GetWindFieldFromDatabase(database->second, scannerIndex, dt, windField))
             {
-                windField.SetPlumeHeight(m_windFieldAtScanner[scannerIndex].GetPlumeHeight(), MET_USER);
+                return 0; // wind-field found...
             }
-            return 0; // wind-field found...
         }
     }
 
     // 2. No wind field found in the reader, use the user-supplied or default...
+    std::lock_guard<std::mutex> lock(m_windFieldMutex);
     if (scannerIndex >= 0)
     {
         windField = m_windFieldAtScanner[scannerIndex];
@@ -87,37 +121,110 @@ int CMeteorologicalData::GetWindField(const CString& serialNumber, const CDateTi
 
 int CMeteorologicalData::ReadWindFieldFromFile(const CString& fileName)
 {
-    std::lock_guard<std::mutex> lock(m_wfDatabaseMutex);
-
-    // Completely reset the data in the existing file-reader
-    m_wfDatabaseFromFile.reset(new CWindFieldDatabase());
+    // The file is read without holding the lock, such that the wind field can be used
+    //  while the (large) file is read. The new data replaces the old once the whole file is read.
+    std::unique_ptr<CWindFieldDatabase> databaseFromFile;
+    std::map<std::string, CWindFieldDatabase> databasePerLocation;
 
-    // Start reading the file
     bool fileReadSuccessfully = false;
     if (Equals(fileName.Right(4), ".txt"))
     {
-        fileReadSuccessfully = ReadWindFieldFromTextFile(fileName);
+        databaseFromFile.reset(new CWindFieldDatabase());
+        fileReadSuccessfully = ReadWindFieldFromTextFile(fileName, *databaseFromFile);
+    }
+    else if (Equals(fileName.Right(3), ".nc"))
+    {
+        // There is no single wind-field for all locations
+        fileReadSuccessfully = ReadWindFieldFromNetCdfFile(fileName, databasePerLocation);
     }
 
+    std::lock_guard<std::mutex> lock(m_wfDatabaseMutex);
     if (fileReadSuccessfully)
     {
+        m_wfDatabaseFromFile = std::move(databaseFromFile);
+        m_wfDatabasePerLocation = std::move(databasePerLocation);
         return 0;
     }
     else
     {
-        m_wfDatabaseFromFile.release();
+        m_wfDatabaseFromFile.reset();
+        m_wfDatabasePerLocation.clear();
         return 1;
     }
 }
 
-bool CMeteorologicalData::ReadWindFieldFromTextFile(const CString& fileName)
+bool CMeteorologicalData::ReadWindFieldFromTextFile(const CString& fileName, CWindFieldDatabase& database)
 {
     FileHandler::CWindFileReader fileReader;
 
     fileReader.m_windFile = fileName;
 
-    auto returnCode = fileReader.ReadWindFile(*m_wfDatabaseFromFile);
+    auto returnCode = fileReader.ReadWindFile(database);
 
     return returnCode == SUCCESS;
 }
 
+bool CMeteorologicalData::ReadWindFieldFromNetCdfFile(const CString& fileName, std::map<std::string, CWindFieldDatabase>& databasePerLocation)
+{
+    FileHandler::CNetCdfWindFileReader fileReader;
+
+    fileReader.m_windFile = fileName;
+
+    // Extract the wind at each of the volcanoes and each of the instruments, only the grid cells
+    //  surrounding these locations are read from the file.
+    std::vector<CNamedLocation> locations;
+    {
+        std::lock_guard<std::mutex> lock(m_wfDatabaseMutex);
+        locations = m_volcanoes;
+        locations.insert(locations.end(), m_instruments.begin(), m_instruments.end());
+    }
+
+    std::vector<CWindFieldDatabase> databases;
+    if (SUCCESS != fileReader.ReadWindFile(locations, databases))
+    {
+        return false;
+    }
+
+    for (size_t ii = 0; ii < locations.size(); ++ii)
+    {
+        if (databases[ii].GetRecordNum() > 0)
+        {
+            databasePerLocation[locations[ii].m_name] = std::move(databases[ii]);
+        }
+    }
+
+    return databasePerLocation.size() > 0;
+}
+
+bool CMeteorologicalData::GetWindFieldFromDatabase(const CWindFieldDatabase& database, int scannerIndex, const CDateTime& dt, CWindField& windField) const
+{
+    if (SUCCESS != database.InterpolateWindField(dt, windField))
+    {
+        return false;
+    }
+
+    // Check if the file contains the wind-speed, the wind-direction and/or the plume height.
+    //  The missing parameters are taken from the user given wind-field, if there is one for the scanner
+    std::lock_guard<std::mutex> lock(m_windFieldMutex);
+    if (scannerIndex < 0 || scannerIndex >= m_scannerNum)
+    {
+        return true;
+    }
+    const CWindField& userWindField = m_windFieldAtScanner[scannerIndex];
+
+    if (!database.m_containsWindDirection)
+    {
+        windField.SetWindDirection(userWindField.GetWindDirection(), MET_USER);
+    }
+
+    if (!database.m_containsWindSpeed)
+    {
+        windField.SetWindSpeed(userWindField.GetWindSpeed(), MET_USER);
+    }
+
+    if (!database.m_containsPlumeHeight)
+    {
+        windField.SetPlumeHeight(userWindField.GetPlumeHeight(), MET_USER);
+    }
+    return true;
+}
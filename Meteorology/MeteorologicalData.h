@@ -3,14 +3,17 @@
 #include "WindField.h"
 #include "WindFieldDatabase.h"
 #include "../Common/Common.h"
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 
 #ifndef METEROLOGY_H
 #define METEROLOGY_H
 
 /** <b>CMeteorologicalData</b> is the class which holds all the meterological data
-    which is needed in the program. */
+    which is needed in the program. The wind fields are set and read from several threads,
+    e.g. the workers evaluating the scans, the members are protected by the mutexes below. */
 class CMeteorologicalData
 {
 public:
@@ -24,6 +27,13 @@ public:
         to know to which locations the wind data should be monitored */
     void SetVolcanoes(const std::vector<CNamedLocation>& volcanoes);
 
+    /** Sets up the list of scanning instruments, with their positions and the volcano each one monitors.
+        Used together with the list of volcanoes by the net-cdf reading routine.
+        @param instruments The location of each instrument, named by the serial number of the instrument.
+        @param volcanoNames The name of the volcano monitored by each instrument, as in the list given to SetVolcanoes.
+            Empty if the volcano is not known, the wind is then taken at the location of the instrument. */
+    void SetInstrumentLocations(const std::vector<CNamedLocation>& instruments, const std::vector<std::string>& volcanoNames);
+
     /** Tries to read in a wind-field from a file. If this is successful
         then all wind-data returned will be first searched for in the wind-field
         file and secondly from the user given or default values.
@@ -51,10 +61,18 @@ private:
         then the data can be found here. */
     std::unique_ptr<CWindFieldDatabase> m_wfDatabaseFromFile = nullptr;
 
-    /** This is to protect the m_wfDatabaseFromFile from being accessed from two
-        threads simultaneously */
+    /** The wind-fields read from a net-cdf file, extracted at each of the monitored volcanoes
+        and at each of the scanning instruments. Indexed by the name of the location. */
+    std::map<std::string, CWindFieldDatabase> m_wfDatabasePerLocation;
+
+    /** This is to protect the m_wfDatabaseFromFile and m_wfDatabasePerLocation from being
+        accessed from two threads simultaneously */
     std::mutex m_wfDatabaseMutex;
 
+    /** This is to protect m_windFieldAtScanner, m_scanner and m_scannerNum from being accessed from
+        two threads simultaneously. Lock order: this is taken while holding m_wfDatabaseMutex, never the other way around */
+    mutable std::mutex m_windFieldMutex;
+
     /** The windfield at each of the scanningInstruments
         the windfield at scanning Instrument 'm_scanner[i]' is given
         by 'm_windFieldAtScanner[i]' */
@@ -69,10 +87,27 @@ private:
         Used by the net-cdf reading routine to figure out where to extract the data. */
     std::vector<CNamedLocation> m_volcanoes;
 
+    /** This is the list of scanning instruments, including their positions.
+        Used by the net-cdf reading routine to figure out where to extract the data. */
+    std::vector<CNamedLocation> m_instruments;
+
+    /** The name of the volcano monitored by each of the scanning instruments, indexed by serial number. */
+    std::map<std::string, std::string> m_volcanoOfInstrument;
+
     /** How many scanners that we have defined the wind field for */
     long m_scannerNum = 0;
 
-    bool ReadWindFieldFromTextFile(const CString& fileName);
+    /** Reads the wind-field text file into the given database, without holding any lock */
+    bool ReadWindFieldFromTextFile(const CString& fileName, CWindFieldDatabase& database);
+
+    /** Reads the wind-field at each monitored volcano and scanning instrument from the given net-cdf file
+        into 'databasePerLocation', indexed by the name of the location. Only holds the lock while copying the locations. */
+    bool ReadWindFieldFromNetCdfFile(const CString& fileName, std::map<std::string, CWindFieldDatabase>& databasePerLocation);
+
+    /** Interpolates the wind-field in the given database. The parameters not contained
+        in the database are taken from the user given wind-field of the scanner, if 'scannerIndex' is a known scanner.
+        @return true if the database contains the wind-field at the given time. */
+    bool GetWindFieldFromDatabase(const CWindFieldDatabase& database, int scannerIndex, const CDateTime& dt, CWindField& windField) const;
 };
 
 #endif
\ No newline at end of file
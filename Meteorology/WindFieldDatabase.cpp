@@ -1,9 +1,36 @@
 #include "StdAfx.h"
 #include "WindFieldDatabase.h"
+#include <algorithm>
+
+namespace
+{
+    bool IsEarlier(const CWindField& first, const CWindField& second)
+    {
+        return first.GetTimeAndDate() < second.GetTimeAndDate();
+    }
+}
 
 void CWindFieldDatabase::InsertWindField(const CWindField& wind)
 {
-    m_windField.push_back(wind);
+    // Insert the record after all records which are not later than it.
+    //  This is at the end of the list if the records are inserted in order.
+    auto position = std::upper_bound(begin(m_windField), end(m_windField), wind, IsEarlier);
+    m_windField.insert(position, wind);
+}
+
+void CWindFieldDatabase::InsertWindFields(std::vector<CWindField>&& winds)
+{
+    if (winds.size() == 0)
+    {
+        return;
+    }
+
+    // Sort the new records, then merge them with the ones we already have
+    const size_t oldSize = m_windField.size();
+    std::stable_sort(begin(winds), end(winds), IsEarlier);
+    m_windField.insert(end(m_windField), std::make_move_iterator(begin(winds)), std::make_move_iterator(end(winds)));
+    std::inplace_merge(begin(m_windField), begin(m_windField) + oldSize, end(m_windField), IsEarlier);
+    winds.clear();
 }
 
 long CWindFieldDatabase::GetRecordNum() const
@@ -19,6 +46,13 @@ void CWindFieldDatabase::Clear()
     m_containsPlumeHeight = false;
 }
 
+size_t CWindFieldDatabase::LowerBound(const CDateTime& time) const
+{
+    auto position = std::lower_bound(begin(m_windField), end(m_windField), time,
+        [](const CWindField& record, const CDateTime& t) { return record.GetTimeAndDate() < t; });
+    return (size_t)(position - begin(m_windField));
+}
+
 RETURN_CODE CWindFieldDatabase::InterpolateWindField(const CDateTime& desiredTime, CWindField &desiredWindField) const
 {
     // First check if there's any records at all in the database
@@ -27,72 +61,76 @@ RETURN_CODE CWindFieldDatabase::InterpolateWindField(const CDateTime& desiredTim
         return FAIL;
     }
 
-    // Loop through all wind-fields in the database and see if we can find an exact match
-    //  otherwise extract the wind-fields which are the closest records before and after
-    //  the desired one.
-    CWindField closestBefore, closestAfter;
-    bool foundClosestBefore = false; // <-- if no wind-field was found before the desired one then return false
-    bool foundClosestAfter = false; // <-- if no wind-field was found after the desired one then return false
-    for (size_t i = 0; i < m_windField.size(); ++i)
+    return InterpolateWindField(LowerBound(desiredTime), desiredTime, desiredWindField);
+}
+
+long CWindFieldDatabase::InterpolateWindFields(const std::vector<CDateTime>& desiredTimes, std::vector<CWindField>& desiredWindFields, std::vector<RETURN_CODE>& status) const
+{
+    desiredWindFields.resize(desiredTimes.size());
+    status.assign(desiredTimes.size(), FAIL);
+
+    if (m_windField.size() == 0)
     {
-        const CWindField &currentRecord = m_windField[i];
+        return 0;
+    }
 
-        // First check if we've found an exact match, if so
-        //  then return the current wind-field
-        if (currentRecord.GetTimeAndDate() == desiredTime)
-        {
-            desiredWindField = currentRecord;
-            return SUCCESS; // we're done!
-        }
+    // Visit the desired times in order of time, such that both the desired times and
+    //  the records can be traversed in one pass.
+    std::vector<size_t> order(desiredTimes.size());
+    for (size_t k = 0; k < order.size(); ++k)
+    {
+        order[k] = k;
+    }
+    std::stable_sort(begin(order), end(order), [&](size_t first, size_t second) { return desiredTimes[first] < desiredTimes[second]; });
 
-        // Then check if this is earlier than the desired one
-        if (currentRecord.GetTimeAndDate() < desiredTime)
+    long successNum = 0;
+    size_t position = 0;
+    for (size_t index : order)
+    {
+        const CDateTime& desiredTime = desiredTimes[index];
+
+        // Advance to the first record which is not earlier than the desired time
+        while (position < m_windField.size() && m_windField[position].GetTimeAndDate() < desiredTime)
         {
-            // currentRecord is valid before the desired time
-            if (foundClosestBefore)
-            {
-                // We have already found another record which is valid before the desired time
-                //  compare if the currentRecord is collected after the previously found
-                //  record, if it is then use the currentRecord as the closest one before
-                if (closestBefore.GetTimeAndDate() < currentRecord.GetTimeAndDate())
-                {
-                    closestBefore = currentRecord;
-                }
-                continue;
-            }
-            else
-            {
-                // We have found the first record in the database which is collected
-                //  before the desired time, remember this and then continue the search
-                foundClosestBefore = true;
-                closestBefore = currentRecord;
-                continue;
-            }
+            ++position;
         }
-        else
+
+        status[index] = InterpolateWindField(position, desiredTime, desiredWindFields[index]);
+        if (SUCCESS == status[index])
         {
-            // currentRecord is valid after the desired time
-            if (foundClosestAfter)
-            {
-                // We have already found another record which is valid after the desired time
-                //  compare if the currentRecord is collected before the previously found
-                //  record, if it is then use the currentRecord as the closest one after
-                if (currentRecord.GetTimeAndDate() < closestAfter.GetTimeAndDate())
-                {
-                    closestAfter = currentRecord;
-                }
-                continue;
-            }
-            else
-            {
-                // We have found the first record in the database which is collected
-                //  before the desired time, remember this and then continue the search
-                foundClosestAfter = true;
-                closestAfter = currentRecord;
-                continue;
-            }
+            ++successNum;
         }
-    } // end for...
+    }
+
+    return successNum;
+}
+
+RETURN_CODE CWindFieldDatabase::InterpolateWindField(size_t position, const CDateTime& desiredTime, CWindField &desiredWindField) const
+{
+    if (m_windField.size() == 0)
+    {
+        return FAIL;
+    }
+
+    // First check if we've found an exact match, if so
+    //  then return this wind-field
+    if (position < m_windField.size() && m_windField[position].GetTimeAndDate() == desiredTime)
+    {
+        desiredWindField = m_windField[position];
+        return SUCCESS; // we're done!
+    }
+
+    // The closest record after the desired time is the one at 'position'. The closest record before
+    //  is the one just before that, if there are several records with that time then the first one is used.
+    const bool foundClosestAfter = (position < m_windField.size());
+    const bool foundClosestBefore = (position > 0);
+    size_t positionBefore = 0;
+    if (foundClosestBefore)
+    {
+        positionBefore = LowerBound(m_windField[position - 1].GetTimeAndDate());
+    }
+    const CWindField& closestBefore = m_windField[positionBefore];
+    const CWindField& closestAfter = m_windField[foundClosestAfter ? position : m_windField.size() - 1];
 
     // If the desired time is not in between any two wind-fields in the database,
     //  then we can not interpolate. If the time difference between the desried time
@@ -10,7 +10,8 @@
 
 /** The CWindFieldDatabase class contains a series of known CWindField records
     for a specific location (typically the latitude and longitude of the volcano). 
-    Each record is valid for a given period of time. */
+    Each record is valid for a given period of time. 
+    The records are kept sorted by time, such that a record can be found with a binary search. */
 class CWindFieldDatabase
 {
 public:
@@ -26,9 +27,14 @@ public:
 
     // ------------------- PUBLIC METHODS -------------------------
 
-    /** Inserts a given wind-field into the record */
+    /** Inserts a given wind-field into the record.
+        Records are typically inserted in order of time, this is then a constant time operation. */
     void InsertWindField(const CWindField& wind);
 
+    /** Inserts all the given wind-fields into the record, the records are sorted once
+        after they have all been inserted. This is the preferred way of inserting many records. */
+    void InsertWindFields(std::vector<CWindField>&& winds);
+
     /** Searches through the read-in data and looks for the wind-field at the
         given time.
         If the given time lies between to times in the 'database',
@@ -46,6 +52,17 @@ public:
                 or the distance between the two data-points to interpolate is larger than 24 hours. */
     RETURN_CODE InterpolateWindField(const CDateTime& desiredTime, CWindField &desiredWindField) const;
 
+    /** Interpolates the wind-field at each of the given times, in the same way as 
+        InterpolateWindField. The times and the records are traversed together in one pass, 
+        which is faster than searching for each time separately when there are many times. 
+        @param desiredTimes - the times and dates at which the wind-field is to be extracted, 
+            preferably (but not necessarily) in increasing order.
+        @param desiredWindFields - will on return be filled with the wind-field at each of the given times. 
+        @param status - will on return be filled with the outcome for each of the given times, 
+            SUCCESS if the wind could be interpolated, otherwise FAIL.
+        @return the number of times where the wind could be interpolated. */
+    long InterpolateWindFields(const std::vector<CDateTime>& desiredTimes, std::vector<CWindField>& desiredWindFields, std::vector<RETURN_CODE>& status) const;
+
     /** Returns the number of points in the database */
     long GetRecordNum() const;
 
@@ -56,8 +73,17 @@ private:
 
     // ------------------- PRIVATE DATA -------------------------
 
-    /** Information about the wind */
+    /** Information about the wind, sorted in increasing order of time.
+        Records with the same time are kept in the order they were inserted. */
     std::vector<CWindField> m_windField;
+
+    /** Finds the position of the first record which is not earlier than the given time */
+    size_t LowerBound(const CDateTime& time) const;
+
+    /** Extracts the wind-field at the given time.
+        @param position - the position of the first record which is not earlier than 'desiredTime',
+            as returned by LowerBound. */
+    RETURN_CODE InterpolateWindField(size_t position, const CDateTime& desiredTime, CWindField &desiredWindField) const;
 };
 
 #endif
\ No newline at end of file
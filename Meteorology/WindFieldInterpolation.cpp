@@ -1,27 +1,86 @@
 #include "stdafx.h"
 #include "WindFieldInterpolation.h"
 #include <SpectralEvaluation/Interpolation.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
 
-void SelectCubeValues(const std::vector<float>& tensor, const std::vector<size_t>& tensorDimensions, const std::vector<size_t>& floorIdx, std::vector<double>& corners)
+namespace
 {
+    // defining the dimensions, the data is ordered as [time, level, latitude, longitude]
     const size_t timeDim = 0;
     const size_t lvlDim = 1;
     const size_t latDim = 2;
     const size_t lonDim = 3;
 
-    // ----------- Pick out the neighoring u- and v- values at this point in time -----------
-    // -----------      this is a small cube with 2x2x2 values     -----------
-    for (size_t lvlIdx = floorIdx[lvlDim]; lvlIdx <= floorIdx[lvlDim] + 1; ++lvlIdx)
+    // The number of points in time for which the values in the corners of the cube are calculated together.
+    const size_t timeBatchSize = 64;
+
+    /** The small cube with 2x2x2 values surrounding one spatial point */
+    struct UnitCube
+    {
+        /** The flat offsets, relative to the start of one point in time, of the eight corners of the cube.
+            Ordered with the level changing slowest and the longitude changing fastest. */
+        size_t cornerOffset[8];
+
+        /** The position of the point inside the cube, in the range [0, 1] in each spatial dimension */
+        std::vector<double> indices = std::vector<double>(3);
+    };
+
+    /** Checks that the data is a four-dimensional matrix of the given size
+        @return the number of values in one point in time */
+    size_t CheckDimensions(const std::vector<float>& values, const std::vector<size_t>& sizes, const std::vector<double>& spatialIndices, const char* functionName)
     {
-        for (size_t latIdx = floorIdx[latDim]; latIdx <= floorIdx[latDim] + 1; ++latIdx)
+        if (sizes.size() != 4) throw new std::invalid_argument(std::string("Invalid data to ") + functionName + ", the data must be four-dimensional.");
+        if (spatialIndices.size() == 0 || spatialIndices.size() % 3 != 0) throw new std::invalid_argument(std::string("Invalid data to ") + functionName + ", there must be three spatial dimensions.");
+
+        const size_t timeStride = sizes[lvlDim] * sizes[latDim] * sizes[lonDim];
+        if (values.size() < sizes[timeDim] * timeStride) throw new std::invalid_argument(std::string("Invalid data to ") + functionName + ", the data is smaller than the given size.");
+
+        return timeStride;
+    }
+
+    /** Locates the cube surrounding the given spatial point (level, latitude, longitude) */
+    void LocateCube(const std::vector<size_t>& sizes, const double* spatialIndex, const char* functionName, UnitCube& cube)
+    {
+        const size_t lvlFloor = (size_t)std::floor(spatialIndex[0]);
+        const size_t latFloor = (size_t)std::floor(spatialIndex[1]);
+        const size_t lonFloor = (size_t)std::floor(spatialIndex[2]);
+
+        if (spatialIndex[0] < 0.0 || spatialIndex[1] < 0.0 || spatialIndex[2] < 0.0 ||
+            lvlFloor + 1 >= sizes[lvlDim] || latFloor + 1 >= sizes[latDim] || lonFloor + 1 >= sizes[lonDim])
         {
-            for (size_t lonIdx = floorIdx[lonDim]; lonIdx <= floorIdx[lonDim] + 1; ++lonIdx)
+            throw new std::invalid_argument(std::string("Invalid data to ") + functionName + ", the spatial point is outside of the data.");
+        }
+
+        for (size_t lvl = 0; lvl < 2; ++lvl)
+        {
+            for (size_t lat = 0; lat < 2; ++lat)
             {
-                size_t index = ((floorIdx[timeDim] * tensorDimensions[lvlDim] + lvlIdx) * tensorDimensions[latDim] + latIdx) * tensorDimensions[lonDim] + lonIdx;
+                for (size_t lon = 0; lon < 2; ++lon)
+                {
+                    const size_t minorIndex = (lvl * 2 + lat) * 2 + lon;
+                    cube.cornerOffset[minorIndex] = ((lvlFloor + lvl) * sizes[latDim] + latFloor + lat) * sizes[lonDim] + lonFloor + lon;
+                }
+            }
+        }
 
-                size_t minorIndex = ((lvlIdx - floorIdx[lvlDim]) * 2 + (latIdx - floorIdx[latDim])) * 2 + (lonIdx - floorIdx[lonDim]);
+        cube.indices[0] = spatialIndex[0] - lvlFloor;
+        cube.indices[1] = spatialIndex[1] - latFloor;
+        cube.indices[2] = spatialIndex[2] - lonFloor;
+    }
 
-                corners[minorIndex] = tensor[index];
+    /** Copies the values in the corners of the cube for 'timeNum' points in time, starting at 'data',
+        into 'corners'. The values at each point in time are stored after each other. */
+    void GatherCorners(const float* data, size_t timeStride, size_t timeNum, const UnitCube& cube, double* corners)
+    {
+        for (size_t timeIdx = 0; timeIdx < timeNum; ++timeIdx)
+        {
+            const float* values = data + timeIdx * timeStride;
+            for (size_t ii = 0; ii < 8; ++ii)
+            {
+                corners[timeIdx * 8 + ii] = values[cube.cornerOffset[ii]];
             }
         }
     }
@@ -37,72 +96,95 @@ void InterpolateWind(
     if (sizes.size() != 4) throw new std::invalid_argument("Invalid data to InterpolateWind, the data must be four-dimensional.");
     if (spatialIndices.size() != 3) throw new std::invalid_argument("Invalid data to InterpolateWind, there must be three spatial dimensions.");
 
-    // defining the dimensions
-    const size_t timeDim = 0;
-    const size_t lvlDim = 1;
-    const size_t latDim = 2;
-    const size_t lonDim = 3;
+    result.speed.resize(sizes[timeDim]);
+    result.speedError.resize(sizes[timeDim]);
+    result.direction.resize(sizes[timeDim]);
+    result.directionError.resize(sizes[timeDim]);
+
+    InterpolatedWindBuffers buffers;
+    buffers.speed = result.speed.data();
+    buffers.speedError = result.speedError.data();
+    buffers.direction = result.direction.data();
+    buffers.directionError = result.directionError.data();
 
-    const size_t lvlFloor = (size_t)std::floor(spatialIndices[0]);
-    const size_t latFloor = (size_t)std::floor(spatialIndices[1]);
-    const size_t lonFloor = (size_t)std::floor(spatialIndices[2]);
+    InterpolateWind(u, v, sizes, spatialIndices, &buffers);
+}
 
-    std::vector<size_t> floorIdx = { 0, lvlFloor, latFloor, lonFloor };
+void InterpolateWind(
+    const std::vector<float>& u,
+    const std::vector<float>& v,
+    const std::vector<size_t>& sizes,
+    const std::vector<double>& spatialIndices,
+    InterpolatedWindBuffers* result)
+{
+    const size_t timeStride = CheckDimensions(u, sizes, spatialIndices, "InterpolateWind");
+    CheckDimensions(v, sizes, spatialIndices, "InterpolateWind");
 
-    std::vector<double> finalWindSpeeds(sizes[timeDim]);
-    std::vector<double> finalWindSpeedErrors(sizes[timeDim]);
-    std::vector<double> finalWindDirections(sizes[timeDim]);
-    std::vector<double> finalWindDirectionErrors(sizes[timeDim]);
+    const size_t pointNum = spatialIndices.size() / 3;
 
-    // temporary variables in the loop below.
-    std::vector<double> uValues(8);
-    std::vector<double> vValues(8);
-    std::vector<double> windSpeedTemp(8);
-    std::vector<double> windDirTemp(8);
-    std::vector<double> indices(3);
+    // temporary variables in the loop below, the values in the corners of the cubes for one batch of points in time.
+    std::vector<double> uValues(timeBatchSize * 8);
+    std::vector<double> vValues(timeBatchSize * 8);
+    std::vector<double> windSpeedTemp(timeBatchSize * 8);
+    std::vector<double> windDirTemp(timeBatchSize * 8);
+    std::vector<double> cubeValues(8);
+    UnitCube cube;
 
-    // Dimensions are [time, level, latitude, longitude]
-    for (size_t timeIdx = 0; timeIdx < sizes[timeDim]; ++timeIdx)
+    for (size_t pointIdx = 0; pointIdx < pointNum; ++pointIdx)
     {
-        floorIdx[timeDim] = timeIdx;
+        LocateCube(sizes, spatialIndices.data() + 3 * pointIdx, "InterpolateWind", cube);
+        InterpolatedWindBuffers& output = result[pointIdx];
 
-        // ----------- Pick out the neighoring u- and v- values at this point in time -----------
-        // -----------      this is a small cube with 2x2x2 values     -----------
-        SelectCubeValues(u, sizes, floorIdx, uValues);
-        SelectCubeValues(v, sizes, floorIdx, vValues);
-
-        // Calculate the wind-speed and wind-direction at each corner in the cube
-        for (size_t ii = 0; ii < 8; ++ii)
+        for (size_t batchStart = 0; batchStart < sizes[timeDim]; batchStart += timeBatchSize)
         {
-            windSpeedTemp[ii] = std::sqrt(uValues[ii] * uValues[ii] + vValues[ii] * vValues[ii]);
-            windDirTemp[ii] = 180.0 * std::atan2(-uValues[ii], -vValues[ii]) / 3.14159265358979323846;
-        }
+            const size_t batchLength = std::min(timeBatchSize, sizes[timeDim] - batchStart);
 
-        // Now perform a tri-linear interpolation inside this cube with wind-speed values to calculate
-        //  the inerpolated wind-speed
-        double interpolatedValue = 0;
-        double interpolatedVariation = 0;
-        indices[0] = spatialIndices[0] - lvlFloor;
-        indices[1] = spatialIndices[1] - latFloor;
-        indices[2] = spatialIndices[2] - lonFloor;
+            // ----------- Pick out the neighoring u- and v- values at these points in time -----------
+            GatherCorners(u.data() + batchStart * timeStride, timeStride, batchLength, cube, uValues.data());
+            GatherCorners(v.data() + batchStart * timeStride, timeStride, batchLength, cube, vValues.data());
 
-        if (TriLinearInterpolation(windSpeedTemp, indices, interpolatedValue, interpolatedVariation))
-        {
-            finalWindSpeeds[timeIdx] = interpolatedValue;
-            finalWindSpeedErrors[timeIdx] = interpolatedVariation;
-        }
+            // Calculate the wind-speed and wind-direction at each corner in the cubes, for all points in time in one go.
+            const size_t cornerNum = batchLength * 8;
+            for (size_t ii = 0; ii < cornerNum; ++ii)
+            {
+                windSpeedTemp[ii] = std::sqrt(uValues[ii] * uValues[ii] + vValues[ii] * vValues[ii]);
+                windDirTemp[ii] = 180.0 * std::atan2(-uValues[ii], -vValues[ii]) / 3.14159265358979323846;
+            }
 
-        if (TriLinearInterpolation(windDirTemp, indices, interpolatedValue, interpolatedVariation))
-        {
-            finalWindDirections[timeIdx] = interpolatedValue;
-            finalWindDirectionErrors[timeIdx] = interpolatedVariation;
+            // Now perform a tri-linear interpolation inside each cube with wind-speed values to calculate
+            //  the inerpolated wind-speed
+            for (size_t timeIdx = 0; timeIdx < batchLength; ++timeIdx)
+            {
+                const size_t outputIdx = batchStart + timeIdx;
+                double interpolatedValue = 0;
+                double interpolatedVariation = 0;
+
+                cubeValues.assign(windSpeedTemp.begin() + timeIdx * 8, windSpeedTemp.begin() + timeIdx * 8 + 8);
+                if (TriLinearInterpolation(cubeValues, cube.indices, interpolatedValue, interpolatedVariation))
+                {
+                    output.speed[outputIdx] = interpolatedValue;
+                    output.speedError[outputIdx] = interpolatedVariation;
+                }
+                else
+                {
+                    output.speed[outputIdx] = 0.0;
+                    output.speedError[outputIdx] = 0.0;
+                }
+
+                cubeValues.assign(windDirTemp.begin() + timeIdx * 8, windDirTemp.begin() + timeIdx * 8 + 8);
+                if (TriLinearInterpolation(cubeValues, cube.indices, interpolatedValue, interpolatedVariation))
+                {
+                    output.direction[outputIdx] = interpolatedValue;
+                    output.directionError[outputIdx] = interpolatedVariation;
+                }
+                else
+                {
+                    output.direction[outputIdx] = 0.0;
+                    output.directionError[outputIdx] = 0.0;
+                }
+            }
         }
     }
-
-    result.speed = finalWindSpeeds;
-    result.speedError = finalWindSpeedErrors;
-    result.direction = finalWindDirections;
-    result.directionError = finalWindDirectionErrors;
 }
 
 void InterpolateValue(
@@ -114,43 +196,54 @@ void InterpolateValue(
     if (sizes.size() != 4) throw new std::invalid_argument("Invalid data to InterpolateValue, the data must be four-dimensional.");
     if (spatialIndices.size() != 3) throw new std::invalid_argument("Invalid data to InterpolateValue, there must be three spatial dimensions.");
 
-    // defining the dimensions
-    const size_t timeDim = 0;
-    const size_t lvlDim = 1;
-    const size_t latDim = 2;
-    const size_t lonDim = 3;
+    result.resize(sizes[timeDim]);
 
-    const size_t lvlFloor = (size_t)std::floor(spatialIndices[0]);
-    const size_t latFloor = (size_t)std::floor(spatialIndices[1]);
-    const size_t lonFloor = (size_t)std::floor(spatialIndices[2]);
+    double* buffer = result.data();
+    InterpolateValue(values, sizes, spatialIndices, &buffer);
+}
 
-    std::vector<size_t> floorIdx = { 0, lvlFloor, latFloor, lonFloor };
+void InterpolateValue(
+    const std::vector<float>& values,
+    const std::vector<size_t>& sizes,
+    const std::vector<double>& spatialIndices,
+    double* const* result)
+{
+    const size_t timeStride = CheckDimensions(values, sizes, spatialIndices, "InterpolateValue");
 
-    result.resize(sizes[timeDim]);
+    const size_t pointNum = spatialIndices.size() / 3;
 
-    // temporary variable in the loop below.
+    // temporary variables in the loop below, the values in the corners of the cubes for one batch of points in time.
+    std::vector<double> cornerValues(timeBatchSize * 8);
     std::vector<double> unitCubeValues(8);
-    std::vector<double> indices(3);
+    UnitCube cube;
 
-    // Dimensions are [time, level, latitude, longitude]
-    for (size_t timeIdx = 0; timeIdx < sizes[timeDim]; ++timeIdx)
+    for (size_t pointIdx = 0; pointIdx < pointNum; ++pointIdx)
     {
-        floorIdx[timeDim] = timeIdx;
+        LocateCube(sizes, spatialIndices.data() + 3 * pointIdx, "InterpolateValue", cube);
+        double* output = result[pointIdx];
 
-        // ----------- Pick out the neighoring u- and v- values at this point in time -----------
-        // -----------      this is a small cube with 2x2x2 values     -----------
-        SelectCubeValues(values, sizes, floorIdx, unitCubeValues);
+        for (size_t batchStart = 0; batchStart < sizes[timeDim]; batchStart += timeBatchSize)
+        {
+            const size_t batchLength = std::min(timeBatchSize, sizes[timeDim] - batchStart);
 
-        // Now perform a tri-linear interpolation inside this cube to calculate the interpolated value
-        double interpolatedValue = 0;
-        indices[0] = spatialIndices[0] - lvlFloor;
-        indices[1] = spatialIndices[1] - latFloor;
-        indices[2] = spatialIndices[2] - lonFloor;
+            // ----------- Pick out the neighoring values at these points in time -----------
+            GatherCorners(values.data() + batchStart * timeStride, timeStride, batchLength, cube, cornerValues.data());
 
-        if (TriLinearInterpolation(unitCubeValues, indices, interpolatedValue))
-        {
-            result[timeIdx] = interpolatedValue;
+            // Now perform a tri-linear interpolation inside each cube to calculate the interpolated value
+            for (size_t timeIdx = 0; timeIdx < batchLength; ++timeIdx)
+            {
+                double interpolatedValue = 0;
+
+                unitCubeValues.assign(cornerValues.begin() + timeIdx * 8, cornerValues.begin() + timeIdx * 8 + 8);
+                if (TriLinearInterpolation(unitCubeValues, cube.indices, interpolatedValue))
+                {
+                    output[batchStart + timeIdx] = interpolatedValue;
+                }
+                else
+                {
+                    output[batchStart + timeIdx] = 0.0;
+                }
+            }
         }
     }
 }
-
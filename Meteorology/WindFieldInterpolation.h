@@ -12,6 +12,16 @@ struct InterpolatedWind
     std::vector<double> relativeHumidity; // [%]
 };
 
+/** Caller provided buffers for the interpolated wind at one spatial point.
+    Each buffer must have room for one value for each point in time, i.e. sizes[0] values. */
+struct InterpolatedWindBuffers
+{
+    double* speed = nullptr;
+    double* speedError = nullptr;
+    double* direction = nullptr; // [degrees]
+    double* directionError = nullptr; // [degrees]
+};
+
 /** Performs a linear interpolation to retrieve the
     wind speed, wind speed error, wind direction and wind direction error
     from the provided wind-field for all points in time.
@@ -31,6 +41,23 @@ void InterpolateWind(
     const std::vector<double>& spatialIndices,
     InterpolatedWind& result);
 
+/** Performs a linear interpolation to retrieve the wind speed, wind speed error,
+    wind direction and wind direction error at several spatial points for all points in time.
+    This gives the same result as calling the function above once for each point, but does
+    not allocate any memory for the result and is faster when there are many points in time.
+    @param spatialIndices The indices to interpolate for in the spatial dimensions,
+        three values (level, latitude, longitude) for each spatial point.
+    @param result One set of buffers for each spatial point, these will be filled with the result.
+    @throws invalid_argument if u and v are not four-dimensional matrices of the given size,
+        or if any of the spatial points is outside of the data.
+*/
+void InterpolateWind(
+    const std::vector<float>& u,
+    const std::vector<float>& v,
+    const std::vector<size_t>& sizes,
+    const std::vector<double>& spatialIndices,
+    InterpolatedWindBuffers* result);
+
 /** Performs a linear interpolation to retrieve values from the given four-dimensional
     vector at all points in time for the provided spatial indices.
     This differens from the function 'InterpolateWind' in that no values are calculated,
@@ -43,4 +70,17 @@ void InterpolateValue(
     const std::vector<double>& spatialIndices,
     std::vector<double>& result);
 
+/** Performs a linear interpolation to retrieve values from the given four-dimensional
+    vector at all points in time for several spatial points.
+    @param spatialIndices The indices to interpolate for in the spatial dimensions,
+        three values (level, latitude, longitude) for each spatial point.
+    @param result One buffer for each spatial point, each with room for sizes[0] values.
+    @throws invalid_argument if values is not a four-dimensional matrix of the given size,
+        or if any of the spatial points is outside of the data.
+*/
+void InterpolateValue(
+    const std::vector<float>& values,
+    const std::vector<size_t>& sizes,
+    const std::vector<double>& spatialIndices,
+    double* const* result);
 
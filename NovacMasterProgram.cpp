@@ -9,6 +9,9 @@
 #include "NovacMasterProgramView.h"
 
 #include "Evaluation/EvaluationController.h"
+#include "Evaluation/FitWindowFileHandler.h"
+#include "ReEvaluation/ReEvaluationJob.h"
+#include "ReEvaluation/ReEvalSettingsFileHandler.h"
 #include "UserSettings.h"
 
 #include <curl/curl.h>
@@ -19,6 +22,142 @@
 #endif
 
 extern CUserSettings g_userSettings;       // <-- The users preferences
+
+namespace
+{
+    /** The command line options of the program. An archive is reevaluated, without showing the
+        user interface, with the options:
+            /reevaluate /archive=<directory> /windows=<file.nfw> /output=<directory> [/settings=<file>] [/threads=<number>]
+        where 'settings' is a file with the reevaluation settings, as saved from the reevaluation dialog. */
+    class CNovacCommandLineInfo : public CCommandLineInfo
+    {
+    public:
+        bool m_reevaluate = false;
+        CString m_archiveDirectory;
+        CString m_fitWindowFile;
+        CString m_outputDirectory;
+        CString m_settingsFile;
+        int m_threadNum = 0;
+
+        virtual void ParseParam(const TCHAR* pszParam, BOOL bFlag, BOOL bLast) override
+        {
+            if (bFlag)
+            {
+                const CString param(pszParam);
+                if (Equals(param, "reevaluate"))
+                {
+                    m_reevaluate = true;
+                    return;
+                }
+                else if (Equals(param, "archive=", 8))
+                {
+                    m_archiveDirectory = param.Mid(8);
+                    return;
+                }
+                else if (Equals(param, "windows=", 8))
+                {
+                    m_fitWindowFile = param.Mid(8);
+                    return;
+                }
+                else if (Equals(param, "output=", 7))
+                {
+                    m_outputDirectory = param.Mid(7);
+                    return;
+                }
+                else if (Equals(param, "settings=", 9))
+                {
+                    m_settingsFile = param.Mid(9);
+                    return;
+                }
+                else if (Equals(param, "threads=", 8))
+                {
+                    m_threadNum = atoi(param.Mid(8));
+                    return;
+                }
+            }
+            CCommandLineInfo::ParseParam(pszParam, bFlag, bLast);
+        }
+    };
+
+    /** The reevaluator of the reevaluation job run from the command line, stopped by Ctrl+C */
+    ReEvaluation::CReEvaluator* s_commandLineReEvaluator = nullptr;
+
+    BOOL WINAPI StopCommandLineReEvaluation(DWORD /*ctrlType*/)
+    {
+        if (s_commandLineReEvaluator != nullptr)
+        {
+            s_commandLineReEvaluator->Stop();
+            return TRUE;
+        }
+        return FALSE;
+    }
+
+    /** Runs a reevaluation job from the command line, without showing the user interface.
+        @return the exit code of the program, zero if all the scan-files were evaluated. */
+    int RunReEvaluationJob(const CNovacCommandLineInfo& options)
+    {
+        // Write the messages to the console from which the program was started, if any
+        if (AttachConsole(ATTACH_PARENT_PROCESS))
+        {
+            freopen("CONOUT$", "w", stdout);
+        }
+
+        if (options.m_archiveDirectory.GetLength() == 0 || options.m_fitWindowFile.GetLength() == 0 || options.m_outputDirectory.GetLength() == 0)
+        {
+            printf("Usage: /reevaluate /archive=<directory> /windows=<file.nfw> /output=<directory> [/settings=<file>] [/threads=<number>]\n");
+            return 1;
+        }
+
+        ReEvaluation::CReEvaluator reeval;
+        if (options.m_settingsFile.GetLength() > 0)
+        {
+            FileHandler::CReEvalSettingsFileHandler settingsReader;
+            if (SUCCESS != settingsReader.ReadSettings(reeval, options.m_settingsFile))
+            {
+                printf("Could not read the reevaluation settings from %s\n", (LPCSTR)options.m_settingsFile);
+                return 1;
+            }
+        }
+        if (options.m_threadNum > 0)
+        {
+            reeval.m_threadNum = options.m_threadNum;
+        }
+
+        FileHandler::CFitWindowFileHandler fitWindowReader;
+        const std::vector<Evaluation::CFitWindow> windows = fitWindowReader.ReadFitWindowFile(options.m_fitWindowFile);
+        if (windows.size() == 0)
+        {
+            printf("Could not read any fit window from %s\n", (LPCSTR)options.m_fitWindowFile);
+            return 1;
+        }
+        reeval.m_windowNum = min((long)windows.size(), ReEvaluation::CReEvaluator::MAX_N_WINDOWS);
+        for (long k = 0; k < reeval.m_windowNum; ++k)
+        {
+            reeval.m_window[k] = windows[k];
+        }
+
+        ReEvaluation::CReEvaluationJob job(reeval);
+        job.m_archiveDirectory = options.m_archiveDirectory;
+        job.m_outputDirectory = options.m_outputDirectory;
+
+        printf("Reevaluating the scan-files in %s\n", (LPCSTR)options.m_archiveDirectory);
+
+        s_commandLineReEvaluator = &reeval;
+        SetConsoleCtrlHandler(StopCommandLineReEvaluation, TRUE);
+        const bool completed = job.Run();
+        SetConsoleCtrlHandler(StopCommandLineReEvaluation, FALSE);
+        s_commandLineReEvaluator = nullptr;
+
+        if (completed)
+        {
+            printf("Done, the result is saved in %s\n", (LPCSTR)options.m_outputDirectory);
+            return 0;
+        }
+        printf("The reevaluation was not completed. Run again with the same output directory to continue where it stopped.\n");
+        return 1;
+    }
+}
+
 // CNovacMasterProgramApp
 
 BEGIN_MESSAGE_MAP(CNovacMasterProgramApp, CWinApp)
@@ -52,6 +191,15 @@ BOOL CNovacMasterProgramApp::InitInstance()
 
     CWinApp::InitInstance();
 
+    // Reevaluations can be run from the command line, without the user interface
+    CNovacCommandLineInfo cmdInfo;
+    ParseCommandLine(cmdInfo);
+    if (cmdInfo.m_reevaluate)
+    {
+        m_commandLineExitCode = RunReEvaluationJob(cmdInfo);
+        return FALSE;
+    }
+
     /** ---------------- SET LANGUAGE ----------------------- */
     Common common;
     common.GetExePath();
@@ -122,9 +270,6 @@ BOOL CNovacMasterProgramApp::InitInstance()
         RUNTIME_CLASS(CMainFrame),       // main SDI frame window
         RUNTIME_CLASS(CNovacMasterProgramView));
     AddDocTemplate(pDocTemplate);
-    // Parse command line for standard shell commands, DDE, file open
-    CCommandLineInfo cmdInfo;
-    ParseCommandLine(cmdInfo);
     // Dispatch commands specified on the command line.  Will return FALSE if
     // app was launched with /RegServer, /Register, /Unregserver or /Unregister.
     if (!ProcessShellCommand(cmdInfo))
@@ -163,6 +308,11 @@ BOOL CNovacMasterProgramApp::ExitInstance()
 
     CWinApp::ExitInstance();
 
+    if (m_commandLineExitCode >= 0)
+    {
+        return m_commandLineExitCode;
+    }
+
     return TRUE;
 }
 
@@ -28,6 +28,10 @@ public:
     afx_msg void OnAppAbout();
     DECLARE_MESSAGE_MAP()
     virtual BOOL OnIdle(LONG lCount);
+
+private:
+    /** The exit code of a job run from the command line, negative when the user interface is used */
+    int m_commandLineExitCode = -1;
 };
 
 extern CNovacMasterProgramApp theApp;
\ No newline at end of file
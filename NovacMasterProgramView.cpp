@@ -15,6 +15,8 @@
 
 #include "Common/ReportWriter.h"
 #include "Common/FluxLogFileHandler.h"
+#include "Common/LogTail.h"
+#include "Common/SnapshotFile.h"
 #include "Communication/LinkStatistics.h"
 
 #include "Evaluation/ScanResult.h"
@@ -53,6 +55,10 @@
 #include "WindMeasurement/PostWindDlg.h"
 #include "WindMeasurement/WindSpeedResult.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <vector>
+
 #ifdef _DEBUG
 #define new DEBUG_NEW
 #endif
@@ -60,9 +66,14 @@
 extern CMeteorologicalData		g_metData;
 extern CConfigurationSetting	g_settings;
 extern CUserSettings			g_userSettings;
+extern CCriticalSection			g_evalLogCritSect;
+extern FileHandler::CLogTail	g_logTails;
 
 CFormView* pView;
 
+/** The identifier of the snapshot file of the data storages */
+static const char STATE_SNAPSHOT_IDENTIFIER[8] = { 'N', 'O', 'V', 'S', 'T', 'A', '0', '1' };
+
 // CNovacMasterProgramView
 
 IMPLEMENT_DYNCREATE(CNovacMasterProgramView, CFormView)
@@ -145,6 +156,8 @@ CNovacMasterProgramView::CNovacMasterProgramView()
     m_overView = NULL;
     m_windOverView = NULL;
     m_instrumentView = NULL;
+
+    m_lastSnapshotTime = 0;
 }
 
 CNovacMasterProgramView::~CNovacMasterProgramView()
@@ -236,32 +249,66 @@ void CNovacMasterProgramView::OnInitialUpdate()
     month = utc->tm_mon + 1;
     mday = utc->tm_mday;
     dateStr2.Format("%04d.%02d.%02d", year, month, mday); // yesterday
+
+    // Restore the data from the snapshot, if there is one. Then only the parts of
+    //  the logs which were written after the snapshot need to be read.
+    for (unsigned int it = 0; it < g_settings.scannerNum; ++it)
+    {
+        m_evalDataStorage->AddData(g_settings.scanner[it].spec[0].serialNumber, NULL);
+        m_commDataStorage->AddData(g_settings.scanner[it].spec[0].serialNumber);
+    }
+    std::map<CString, long long> logSizes;
+    MeasureLogSizes(logSizes);
+    if (LoadSnapshot())
+    {
+        ShowMessage("Restored the data of the last day from the snapshot");
+    }
+
     for (unsigned int it = 0; it < g_settings.scannerNum; ++it)
     {
         serialNumber.Format(g_settings.scanner[it].spec[0].serialNumber);
-        ReadFluxLog(it, dateStr, serialNumber);
+        // the oldest first, the results already stored are skipped
         ReadFluxLog(it, dateStr2, serialNumber);
+        ReadFluxLog(it, dateStr, serialNumber);
         // show both last 24 hour column plot on main screen and column history tab
         if (g_settings.scanner[it].plotColumn || g_settings.scanner[it].plotColumnHistory)
         {
-            ReadEvalLog(it, dateStr, serialNumber);
             ReadEvalLog(it, dateStr2, serialNumber);
+            ReadEvalLog(it, dateStr, serialNumber);
         }
     }
 
-    // Make the MeteorologicalData be aware of the volcanoes monitored
+    // Make the MeteorologicalData be aware of the volcanoes monitored. Volcanoes which are not known
+    //  are left out, there is no location to extract the wind at.
     auto volcanoNames = ListMonitoredVolcanoes(g_settings);
-    std::vector<CNamedLocation> allVolcanoes(volcanoNames.size());
+    std::vector<CNamedLocation> allVolcanoes;
     for (size_t ii = 0; ii < volcanoNames.size(); ++ii)
     {
         int volcanoIndex = IndexOfVolcano(volcanoNames[ii]);
         if (volcanoIndex >= 0)
         {
-            allVolcanoes[ii] = GetVolcano(volcanoIndex);
+            allVolcanoes.push_back(GetVolcano(volcanoIndex));
         }
     }
     g_metData.SetVolcanoes(allVolcanoes);
 
+    // ... and of the locations of the instruments. The volcano of each instrument is named as in the
+    //  list of volcanoes above, such that the wind extracted at the volcano is found for the instrument.
+    std::vector<CNamedLocation> allInstruments;
+    std::vector<std::string> volcanoOfInstrument;
+    for (unsigned int it = 0; it < g_settings.scannerNum; ++it)
+    {
+        const CGPSData& gps = g_settings.scanner[it].gps;
+        for (unsigned int jt = 0; jt < g_settings.scanner[it].specNum; ++jt)
+        {
+            const CString& serial = g_settings.scanner[it].spec[jt].serialNumber;
+            allInstruments.push_back(CNamedLocation(gps.m_latitude, gps.m_longitude, gps.m_altitude, std::string((LPCSTR)serial)));
+            const int volcanoIndex = IndexOfVolcano(std::string((LPCSTR)g_settings.scanner[it].volcano));
+            volcanoOfInstrument.push_back((volcanoIndex >= 0) ? GetVolcano(volcanoIndex).m_name : std::string());
+        }
+    }
+    g_metData.SetInstrumentLocations(allInstruments, volcanoOfInstrument);
+
     // Try to find and read in a wind-field file, if any can be found...
     CString windFieldFile;
     if (g_settings.windSourceSettings.enabled == 1 && g_settings.windSourceSettings.windFieldFile.GetLength() > 0 && IsExistingFile(g_settings.windSourceSettings.windFieldFile))
@@ -276,6 +323,10 @@ void CNovacMasterProgramView::OnInitialUpdate()
     // Check if there is any old status-log file from which we can learn anything...
     ScanStatusLogFile();
 
+    // Everything in the logs has now been read, the next snapshot covers it
+    m_snapshotLogSizes = logSizes;
+    m_lastSnapshotTime = time(NULL);
+
     // Initialize the controls of the screen
     InitializeControls();
 
@@ -320,49 +371,50 @@ void CNovacMasterProgramView::OnInitialUpdate()
 }
 
 void CNovacMasterProgramView::ReadFluxLog(int scannerIndex, CString dateStr, CString serialNumber) {
-    FileHandler::CFluxLogFileHandler fluxLogReader;
-    CString path;
-    path.Format("%sOutput\\%s\\%s\\FluxLog_%s_%s.txt",
-        (LPCTSTR)g_settings.outputDirectory,
-        (LPCTSTR)dateStr,
-        (LPCTSTR)serialNumber,
-        (LPCTSTR)serialNumber,
-        (LPCTSTR)dateStr);
+    Common common;
+    CString path = FluxLogFileName(dateStr, serialNumber);
 
     m_evalDataStorage->AddData(serialNumber, NULL);
 
+    // The flux log has one line per scan, it is small enough to always be read in full.
+    //  The scans which were restored from the snapshot are skipped.
+    const double lastFluxTime = m_evalDataStorage->GetLastFluxTime(serialNumber);
+
     if (IsExistingFile(path)) {
-        // Try to read the flux-log
-        fluxLogReader.m_fluxLog.Format(path);
-        if (FAIL == fluxLogReader.ReadFluxLog())
+        // Try to read the flux-log, the log is then followed by g_logTails while it is being written
+        std::shared_ptr<const FileHandler::CFluxLogView> fluxLog = g_logTails.FollowFluxLog(path);
+        if (fluxLog == nullptr)
             return;
 
-        if (fluxLogReader.m_fluxesNum > 0) {
+        if (!fluxLog->m_fluxes.empty()) {
             // Copy the read-in data to the m_evalDataStorage
-            int fluxesNum = fluxLogReader.m_fluxesNum;
+            int fluxesNum = (int)fluxLog->m_fluxes.size();
 
             for (int it2 = 0; it2 < fluxesNum; ++it2) {
-                Evaluation::CFluxResult &fl = fluxLogReader.m_fluxes[it2];
-                CSpectrumInfo &info = fluxLogReader.m_scanInfo[it2];
+                const Evaluation::CFluxResult &fl = fluxLog->m_fluxes[it2];
+                const CSpectrumInfo &info = fluxLog->m_scanInfo[it2];
+                if ((double)common.Epoch(fl.m_startTime) <= lastFluxTime) {
+                    continue;
+                }
                 m_evalDataStorage->AppendFluxResult(scannerIndex, fl.m_startTime, fl.m_flux, fl.m_fluxOk, info.m_batteryVoltage, info.m_temperature, info.m_exposureTime);
             }
 
             // Insert the last used wind-field for the current spectrometer
             CWindField windField;
-            if (fluxLogReader.m_fluxes[fluxesNum - 1].m_plumeHeight > 0 && fluxLogReader.m_fluxes[fluxesNum - 1].m_plumeHeight < 5000) {
-                windField.SetPlumeHeight(fluxLogReader.m_fluxes[fluxesNum - 1].m_plumeHeight, fluxLogReader.m_fluxes[fluxesNum - 1].m_plumeHeightSource);
+            if (fluxLog->m_fluxes[fluxesNum - 1].m_plumeHeight > 0 && fluxLog->m_fluxes[fluxesNum - 1].m_plumeHeight < 5000) {
+                windField.SetPlumeHeight(fluxLog->m_fluxes[fluxesNum - 1].m_plumeHeight, fluxLog->m_fluxes[fluxesNum - 1].m_plumeHeightSource);
             }
             else {
                 windField.SetPlumeHeight(1000, MET_DEFAULT);
             }
-            if (fluxLogReader.m_fluxes[fluxesNum - 1].m_windDirection > -180 && fluxLogReader.m_fluxes[fluxesNum - 1].m_windDirection <= 360) {
-                windField.SetWindDirection(fluxLogReader.m_fluxes[fluxesNum - 1].m_windDirection, fluxLogReader.m_fluxes[fluxesNum - 1].m_windDirectionSource);
+            if (fluxLog->m_fluxes[fluxesNum - 1].m_windDirection > -180 && fluxLog->m_fluxes[fluxesNum - 1].m_windDirection <= 360) {
+                windField.SetWindDirection(fluxLog->m_fluxes[fluxesNum - 1].m_windDirection, fluxLog->m_fluxes[fluxesNum - 1].m_windDirectionSource);
             }
             else {
                 windField.SetWindDirection(0, MET_DEFAULT);
             }
-            if (fluxLogReader.m_fluxes[fluxesNum - 1].m_windSpeed > -1 && fluxLogReader.m_fluxes[fluxesNum - 1].m_windSpeed <= 30) {
-                windField.SetWindSpeed(fluxLogReader.m_fluxes[fluxesNum - 1].m_windSpeed, fluxLogReader.m_fluxes[fluxesNum - 1].m_windSpeedSource);
+            if (fluxLog->m_fluxes[fluxesNum - 1].m_windSpeed > -1 && fluxLog->m_fluxes[fluxesNum - 1].m_windSpeed <= 30) {
+                windField.SetWindSpeed(fluxLog->m_fluxes[fluxesNum - 1].m_windSpeed, fluxLog->m_fluxes[fluxesNum - 1].m_windSpeedSource);
             }
             else {
                 windField.SetWindSpeed(10, MET_DEFAULT);
@@ -377,20 +429,23 @@ void CNovacMasterProgramView::ReadEvalLog(int scannerIndex, CString dateStr, CSt
     Common common;
     __int64 now = common.Epoch();
     FileHandler::CEvaluationLogFileHandler evalLogReader;
-    CString path;
-    path.Format("%sOutput\\%s\\%s\\EvaluationLog_%s_%s.txt",
-        (LPCTSTR)g_settings.outputDirectory,
-        (LPCTSTR)dateStr,
-        (LPCTSTR)serialNumber,
-        (LPCTSTR)serialNumber,
-        (LPCTSTR)dateStr);
+    CString path = EvalLogFileName(dateStr, serialNumber);
 
     m_evalDataStorage->AddData(serialNumber, NULL);
 
+    // Only the scans written after the snapshot are read, the spectra already restored are skipped
+    const double lastSpectrumTime = m_evalDataStorage->GetLastSpectrumTime(serialNumber);
+
     if (IsExistingFile(path)) {
+        // Nothing needs to be read if the log has not been written since the snapshot was taken
+        const long long startPosition = SnapshotLogPosition(path);
+        struct __stat64 fileStatus;
+        if (startPosition > 0 && 0 == _stat64(path, &fileStatus) && fileStatus.st_size == startPosition)
+            return;
+
         // Try to read the eval-log
         evalLogReader.m_evaluationLog.Format(path);
-        if (FAIL == evalLogReader.ReadEvaluationLog())
+        if (FAIL == evalLogReader.ReadEvaluationLog(startPosition))
             return;
 
         if (evalLogReader.m_scanNum > 0) {
@@ -409,7 +464,7 @@ void CNovacMasterProgramView::ReadEvalLog(int scannerIndex, CString dateStr, CSt
                     double fitIntensity = sr.GetFitIntensity(j);
                     double angle = sr.GetScanAngle(j);
                     bool isBadFit = sr.IsBad(j);
-                    if ((now - time) <= 86400) {
+                    if ((now - time) <= 86400 && time > lastSpectrumTime) {
                         m_evalDataStorage->AppendSpecDataHistory(scannerIndex, time, column, columnError,
                             peakIntensity, fitIntensity, angle, isBadFit);
                     }
@@ -641,6 +696,11 @@ LRESULT CNovacMasterProgramView::OnEvalSucess(WPARAM wParam, LPARAM lParam) {
 
     m_evalDataStorage->AddData(*serial, result);
 
+    // Save the data now and then, such that it can be restored quickly when the program restarts
+    if (difftime(time(NULL), m_lastSnapshotTime) >= SNAPSHOT_INTERVAL) {
+        SaveSnapshot();
+    }
+
     // forward the message to the correct scanner view
     if (m_overView->m_hWnd != NULL) {
         m_overView->PostMessage(WM_EVAL_SUCCESS, wParam, NULL);
@@ -836,6 +896,7 @@ void CNovacMasterProgramView::OnMenuViewInstrumentTab() {
 void CNovacMasterProgramView::OnDestroy()
 {
     this->m_controller.Stop();
+    SaveSnapshot();
     CFormView::OnDestroy();
 }
 
@@ -1382,14 +1443,12 @@ void CNovacMasterProgramView::ScanStatusLogFile() {
     CString serial;
     double linkSpeed;
     int dYear, dMonth, dDay, dHour, dMinute, dSecond;
-    CDateTime today, timeOfDownload;
+    CDateTime timeOfDownload;
     unsigned int nDownloadsFound = 0;
-
-    // Get todays date...
-    today.SetToNow();
+    Common common;
 
     // The file-name of today's status-log file, if any...
-    fileName.Format("%sOutput\\%04d.%02d.%02d\\StatusLog.txt", (LPCTSTR)g_settings.outputDirectory, today.year, today.month, today.day);
+    fileName = StatusLogFileName();
 
     // Try to open the status-log file
     FILE *f = fopen(fileName, "r");
@@ -1398,6 +1457,12 @@ void CNovacMasterProgramView::ScanStatusLogFile() {
         return; // could not open file, skip it...
     }
 
+    // Only the part written after the snapshot needs to be read
+    const long long startPosition = SnapshotLogPosition(fileName);
+    if (startPosition > 0) {
+        _fseeki64(f, startPosition, SEEK_SET);
+    }
+
     // Read the file, one line at a time
     while (fgets(szLine, BUFFER_SIZE, f)) {
 
@@ -1420,7 +1485,9 @@ void CNovacMasterProgramView::ScanStatusLogFile() {
                     timeOfDownload.hour = dHour;
                     timeOfDownload.minute = dMinute;
                     timeOfDownload.second = dSecond;
-                    m_commDataStorage->AddDownloadData(serial, linkSpeed, &timeOfDownload);
+                    if ((double)common.Epoch(timeOfDownload) > m_commDataStorage->GetLastDownloadTime(serial)) {
+                        m_commDataStorage->AddDownloadData(serial, linkSpeed, &timeOfDownload);
+                    }
 
                     ++nDownloadsFound;
                 }
@@ -1443,7 +1510,9 @@ void CNovacMasterProgramView::ScanStatusLogFile() {
                     timeOfDownload.hour = dHour;
                     timeOfDownload.minute = dMinute;
                     timeOfDownload.second = dSecond;
-                    m_commDataStorage->AddDownloadData("FTP", linkSpeed, &timeOfDownload);
+                    if ((double)common.Epoch(timeOfDownload) > m_commDataStorage->GetLastDownloadTime("FTP")) {
+                        m_commDataStorage->AddDownloadData("FTP", linkSpeed, &timeOfDownload);
+                    }
                 }
             }
         }
@@ -1456,6 +1525,165 @@ void CNovacMasterProgramView::ScanStatusLogFile() {
     delete[] szLine;
 }
 
+CString CNovacMasterProgramView::StatusLogFileName() const {
+    CDateTime today;
+    today.SetToNow();
+
+    CString fileName;
+    fileName.Format("%sOutput\\%04d.%02d.%02d\\StatusLog.txt", (LPCTSTR)g_settings.outputDirectory, today.year, today.month, today.day);
+    return fileName;
+}
+
+CString CNovacMasterProgramView::FluxLogFileName(const CString &dateStr, const CString &serialNumber) {
+    CString fileName;
+    fileName.Format("%sOutput\\%s\\%s\\FluxLog_%s_%s.txt",
+        (LPCTSTR)g_settings.outputDirectory,
+        (LPCTSTR)dateStr,
+        (LPCTSTR)serialNumber,
+        (LPCTSTR)serialNumber,
+        (LPCTSTR)dateStr);
+    return fileName;
+}
+
+CString CNovacMasterProgramView::EvalLogFileName(const CString &dateStr, const CString &serialNumber) {
+    CString fileName;
+    fileName.Format("%sOutput\\%s\\%s\\EvaluationLog_%s_%s.txt",
+        (LPCTSTR)g_settings.outputDirectory,
+        (LPCTSTR)dateStr,
+        (LPCTSTR)serialNumber,
+        (LPCTSTR)serialNumber,
+        (LPCTSTR)dateStr);
+    return fileName;
+}
+
+CString CNovacMasterProgramView::SnapshotFileName() {
+    CString fileName;
+    fileName.Format("%sTemp\\RealtimeState.bin", (LPCTSTR)g_settings.outputDirectory);
+    return fileName;
+}
+
+bool CNovacMasterProgramView::LoadSnapshot() {
+    m_snapshotLogSizes.clear();
+
+    FileHandler::CSnapshotReader snapshot;
+    if (!snapshot.Open(SnapshotFileName(), STATE_SNAPSHOT_IDENTIFIER)) {
+        return false;
+    }
+
+    // Only the data of the last day is shown, an older snapshot is of no use
+    if (difftime(time(NULL), snapshot.SavedTime()) > 86400) {
+        return false;
+    }
+
+    bool success = m_evalDataStorage->LoadSnapshot(snapshot) && m_commDataStorage->LoadSnapshot(snapshot);
+
+    uint32_t logNum = 0;
+    success = success && snapshot.Read(logNum);
+    for (uint32_t k = 0; k < logNum && success; ++k) {
+        CString fileName;
+        int64_t size = 0;
+        success = snapshot.ReadString(fileName) && snapshot.Read(size);
+        m_snapshotLogSizes[fileName] = size;
+    }
+
+    if (!success) {
+        // Start over with empty storages, everything is then read from the logs
+        m_snapshotLogSizes.clear();
+        delete m_evalDataStorage;
+        delete m_commDataStorage;
+        m_evalDataStorage = new CEvaluatedDataStorage();
+        m_commDataStorage = new CCommunicationDataStorage();
+        return false;
+    }
+
+    return true;
+}
+
+void CNovacMasterProgramView::SaveSnapshot() {
+    CString directory;
+    directory.Format("%sTemp\\", (LPCTSTR)g_settings.outputDirectory);
+    CreateDirectoryStructure(directory);
+
+    FileHandler::CSnapshotWriter snapshot;
+    if (!snapshot.Open(SnapshotFileName(), STATE_SNAPSHOT_IDENTIFIER)) {
+        return;
+    }
+
+    m_evalDataStorage->SaveSnapshot(snapshot);
+    m_commDataStorage->SaveSnapshot(snapshot);
+
+    // The log sizes from the previous snapshot are saved, not the current ones. The results of a scan
+    //  are written to the logs before they are sent to this view, those written since the previous 
+    //  snapshot may not have arrived here yet. They are instead read from the logs at the next start.
+    snapshot.Write((uint32_t)m_snapshotLogSizes.size());
+    for (const auto &log : m_snapshotLogSizes) {
+        snapshot.WriteString(log.first);
+        snapshot.Write((int64_t)log.second);
+    }
+    snapshot.Commit();
+
+    MeasureLogSizes(m_snapshotLogSizes);
+    m_lastSnapshotTime = time(NULL);
+}
+
+void CNovacMasterProgramView::MeasureLogSizes(std::map<CString, long long> &logSizes) const {
+    logSizes.clear();
+
+    // The flux- and evaluation-logs of today and yesterday (UTC)
+    CString dateStr[2];
+    time_t rawtime = time(NULL);
+    for (int day = 0; day < 2; ++day) {
+        struct tm *utc = gmtime(&rawtime);
+        dateStr[day].Format("%04d.%02d.%02d", utc->tm_year + 1900, utc->tm_mon + 1, utc->tm_mday);
+        rawtime -= 86400;
+    }
+
+    std::vector<CString> fileNames;
+    for (unsigned int it = 0; it < g_settings.scannerNum; ++it) {
+        const CString &serialNumber = g_settings.scanner[it].spec[0].serialNumber;
+        for (int day = 0; day < 2; ++day) {
+            fileNames.push_back(FluxLogFileName(dateStr[day], serialNumber));
+            fileNames.push_back(EvalLogFileName(dateStr[day], serialNumber));
+        }
+    }
+
+    // The logs are only appended to in whole scans while this lock is held
+    CSingleLock singleLock(&g_evalLogCritSect, TRUE);
+    for (CString &fileName : fileNames) {
+        struct __stat64 fileStatus;
+        if (0 == _stat64(fileName, &fileStatus)) {
+            fileName.MakeLower();
+            logSizes[fileName] = fileStatus.st_size;
+        }
+    }
+    singleLock.Unlock();
+
+    // The status-log is written by this view
+    CString statusLog = StatusLogFileName();
+    struct __stat64 fileStatus;
+    if (0 == _stat64(statusLog, &fileStatus)) {
+        statusLog.MakeLower();
+        logSizes[statusLog] = fileStatus.st_size;
+    }
+}
+
+long long CNovacMasterProgramView::SnapshotLogPosition(const CString &fileName) const {
+    CString key(fileName);
+    key.MakeLower();
+
+    auto it = m_snapshotLogSizes.find(key);
+    if (it == m_snapshotLogSizes.end()) {
+        return 0;
+    }
+
+    // A log which is smaller than when the snapshot was taken has been replaced, read all of it
+    struct __stat64 fileStatus;
+    if (0 != _stat64(fileName, &fileStatus) || fileStatus.st_size < it->second) {
+        return 0;
+    }
+    return it->second;
+}
+
 LRESULT CNovacMasterProgramView::OnRewriteConfigurationXml(WPARAM wParam, LPARAM lParam) {
     FileHandler::CConfigurationFileHandler writer;
     CString fileName, oldConfigurationFile, backupFile;
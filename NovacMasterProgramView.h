@@ -18,6 +18,8 @@
 #include "View_Scanner.h"
 
 #include "afxcmn.h"
+#include <ctime>
+#include <map>
 
 #pragma once
 
@@ -165,6 +167,19 @@ private:
 	/** This object holds the communication status */
 	CCommunicationDataStorage *m_commDataStorage;
 
+	// ------------- THE SNAPSHOT OF THE DATA, TO SPEED UP RESTARTING ---------------
+
+	/** The data storages are saved to a snapshot this often [s] */
+	static const int SNAPSHOT_INTERVAL = 600;
+
+	/** The time when the last snapshot was saved */
+	time_t m_lastSnapshotTime;
+
+	/** The sizes of the flux-, evaluation- and status-logs when the last snapshot was saved
+		(or when the logs were read at startup). The key is the lower-case file name.
+		The storages have received everything written to the logs up to these sizes. */
+	std::map<CString, long long> m_snapshotLogSizes;
+
 	// ---------------------- AUXILLIARY FUNCTIONS -----------------------
 
 	/** Called when the configuration file has been read */
@@ -185,6 +200,34 @@ private:
 	/** Scan the last status-log file for interesting data */
 	void	ScanStatusLogFile();
 
+	/** @return the name of today's status-log file */
+	CString StatusLogFileName() const;
+
+	/** @return the name of the flux log of the given spectrometer for the given date */
+	static CString FluxLogFileName(const CString &dateStr, const CString &serialNumber);
+
+	/** @return the name of the evaluation log of the given spectrometer for the given date */
+	static CString EvalLogFileName(const CString &dateStr, const CString &serialNumber);
+
+	/** @return the name of the snapshot file */
+	static CString SnapshotFileName();
+
+	/** Restores the data storages from the snapshot, if there is one from the last day.
+		The positions in the logs up to where the snapshot covers are read into 'm_snapshotLogSizes'.
+		@return true if the snapshot was restored */
+	bool	LoadSnapshot();
+
+	/** Saves the data storages, and the positions in the logs covered by them, to the snapshot */
+	void	SaveSnapshot();
+
+	/** Fills in the current sizes of today's and yesterday's flux- and evaluation-logs,
+		and of today's status-log. */
+	void	MeasureLogSizes(std::map<CString, long long> &logSizes) const;
+
+	/** @return the position in the given log from which it needs to be read,
+		this is zero for a log which is not covered by the snapshot. */
+	long long SnapshotLogPosition(const CString &fileName) const;
+
 
 public:
 	afx_msg void OnUpdateMenuViewInstrumenttab(CCmdUI *pCmdUI);
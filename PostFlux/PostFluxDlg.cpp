@@ -1009,45 +1009,56 @@ void	CPostFluxDlg::RetrieveWindField()
         // Find the time 
         CDateTime dt;
         m_calculator->m_scan[this->m_curScan].GetStartTime(0, dt);
-        if (SUCCESS != m_windFieldFromFile->InterpolateWindField(dt, m_calculator->m_wind))
-        {
-            MessageBox("Failed to interpolate the wind for the date and time for the current scan from the given wind file. Please supply another wind file and try again", "Error");
-            return;
-        }
+        CWindField windField;
+        const RETURN_CODE interpolationResult = m_windFieldFromFile->InterpolateWindField(dt, windField);
+        UseWindFieldFromFile(interpolationResult, windField);
+    }
+}
 
-        // Tell the user what wind field we've used
-        if (m_windFieldFromFile->m_containsWindSpeed)
-        {
-            ws.Format("%.2lf", m_calculator->m_wind.GetWindSpeed());
-            SetDlgItemText(IDC_PF_WINDSPEED, ws);
-        }
-        else
-        {
-            GetDlgItemText(IDC_PF_WINDSPEED, ws);
-            int ret = sscanf(ws, "%lf", &tmpDouble);	m_calculator->m_wind.SetWindSpeed(tmpDouble, MET_USER);
-        }
+void	CPostFluxDlg::UseWindFieldFromFile(RETURN_CODE interpolationResult, const CWindField &windField)
+{
+    CString ws, wd, ph;
+    double tmpDouble;
 
-        if (m_windFieldFromFile->m_containsWindDirection)
-        {
-            wd.Format("%.2lf", m_calculator->m_wind.GetWindDirection());
-            SetDlgItemText(IDC_PF_WINDDIRECTION, wd);
-        }
-        else
-        {
-            GetDlgItemText(IDC_PF_WINDDIRECTION, wd);
-            int ret = sscanf(wd, "%lf", &tmpDouble);	m_calculator->m_wind.SetWindDirection(tmpDouble, MET_USER);
-        }
+    if (SUCCESS != interpolationResult)
+    {
+        MessageBox("Failed to interpolate the wind for the date and time for the current scan from the given wind file. Please supply another wind file and try again", "Error");
+        return;
+    }
+    m_calculator->m_wind = windField;
 
-        if (m_windFieldFromFile->m_containsPlumeHeight)
-        {
-            ph.Format("%.1lf", m_calculator->m_wind.GetPlumeHeight());
-            SetDlgItemText(IDC_PF_PLUMEHEIGHT, ph);
-        }
-        else
-        {
-            GetDlgItemText(IDC_PF_PLUMEHEIGHT, ph);
-            int ret = sscanf(ph, "%lf", &tmpDouble);	m_calculator->m_wind.SetPlumeHeight(tmpDouble, MET_USER);
-        }
+    // Tell the user what wind field we've used
+    if (m_windFieldFromFile->m_containsWindSpeed)
+    {
+        ws.Format("%.2lf", m_calculator->m_wind.GetWindSpeed());
+        SetDlgItemText(IDC_PF_WINDSPEED, ws);
+    }
+    else
+    {
+        GetDlgItemText(IDC_PF_WINDSPEED, ws);
+        int ret = sscanf(ws, "%lf", &tmpDouble);	m_calculator->m_wind.SetWindSpeed(tmpDouble, MET_USER);
+    }
+
+    if (m_windFieldFromFile->m_containsWindDirection)
+    {
+        wd.Format("%.2lf", m_calculator->m_wind.GetWindDirection());
+        SetDlgItemText(IDC_PF_WINDDIRECTION, wd);
+    }
+    else
+    {
+        GetDlgItemText(IDC_PF_WINDDIRECTION, wd);
+        int ret = sscanf(wd, "%lf", &tmpDouble);	m_calculator->m_wind.SetWindDirection(tmpDouble, MET_USER);
+    }
+
+    if (m_windFieldFromFile->m_containsPlumeHeight)
+    {
+        ph.Format("%.1lf", m_calculator->m_wind.GetPlumeHeight());
+        SetDlgItemText(IDC_PF_PLUMEHEIGHT, ph);
+    }
+    else
+    {
+        GetDlgItemText(IDC_PF_PLUMEHEIGHT, ph);
+        int ret = sscanf(ph, "%lf", &tmpDouble);	m_calculator->m_wind.SetPlumeHeight(tmpDouble, MET_USER);
     }
 }
 
@@ -1392,6 +1403,19 @@ void CPostFluxDlg::OnCalculateFlux_AllScansInPlume()
     else
         m_calculator->m_coneAngle = m_coneAngles[m_coneangleCombo.GetCurSel()];
 
+    // Interpolate the wind-field from the wind file at the start of every scan, in one pass through the file
+    std::vector<CWindField> windFieldFromFile;
+    std::vector<RETURN_CODE> windFieldStatus;
+    if (m_windFieldFromFile != nullptr)
+    {
+        std::vector<CDateTime> scanStartTimes((size_t)m_calculator->m_scanNum);
+        for (int k = 0; k < m_calculator->m_scanNum; ++k)
+        {
+            m_calculator->m_scan[k].GetStartTime(0, scanStartTimes[k]);
+        }
+        m_windFieldFromFile->InterpolateWindFields(scanStartTimes, windFieldFromFile, windFieldStatus);
+    }
+
     for (m_curScan = 0; m_curScan < m_calculator->m_scanNum; ++m_curScan)
     {
 
@@ -1409,7 +1433,14 @@ void CPostFluxDlg::OnCalculateFlux_AllScansInPlume()
             continue;
 
         // get the wind-speed and direction
-        RetrieveWindField();
+        if (m_windFieldFromFile != nullptr)
+        {
+            UseWindFieldFromFile(windFieldStatus[m_curScan], windFieldFromFile[m_curScan]);
+        }
+        else
+        {
+            RetrieveWindField();
+        }
 
         // The offset, calculate or use the users value
         m_userOffset = m_calculator->CalculateOffset(m_curScan, m_calculator->m_specie[m_curSpecie]);
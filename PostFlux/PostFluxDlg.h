@@ -156,6 +156,12 @@ public:
 			into the correct place for calculating the flux */
 	void	RetrieveWindField();
 
+	/** Uses the wind-field interpolated from the wind file for the current scan, the parameters which
+			are not in the wind file are taken from the dialog.
+		@param interpolationResult - the outcome of the interpolation, the user is told if this is not SUCCESS.
+		@param windField - the interpolated wind-field. */
+	void	UseWindFieldFromFile(RETURN_CODE interpolationResult, const CWindField &windField);
+
 	/** Called when the user wants to calculate the wind-direction for the current
 			scan using the plume-centre information. */
 	afx_msg void OnCalculateWinddirection();
@@ -65,6 +65,7 @@ RETURN_CODE CReEvalSettingsFileHandler::WriteSettings(const ReEvaluation::CReEva
 
 	// 5. Misc...
 	fprintf(f, "\t<Average>%d</Average>\n",									(int)reeval.m_averagedSpectra);
+	fprintf(f, "\t<Threads>%d</Threads>\n",									reeval.m_threadNum);
 
 
 	fprintf(f, TEXT("</ReEvalSettings_Misc>\n"));
@@ -84,6 +85,7 @@ RETURN_CODE CReEvalSettingsFileHandler::ReadSettings(ReEvaluation::CReEvaluator
 	char  skySpecStr[]				= _T("SkySpectrum");
 	char  darkSpecStr[]				= _T("DarkSpectrum");
 	char  averageStr[]				= _T("Average");
+	char  threadsStr[]				= _T("Threads");
 
 	CFileException exceFile;
   CStdioFile file;
@@ -146,6 +148,13 @@ RETURN_CODE CReEvalSettingsFileHandler::ReadSettings(ReEvaluation::CReEvaluator
 			reeval.m_averagedSpectra = (tmpInt == 1)? true : false;
 			continue;
 		}
+
+		if(Equals(szToken, threadsStr, strlen(threadsStr))){
+			int tmpInt;
+			Parse_IntItem("/Threads", tmpInt);
+			reeval.m_threadNum = (tmpInt > 1)? tmpInt : 1;
+			continue;
+		}
 	}
 
 	// done
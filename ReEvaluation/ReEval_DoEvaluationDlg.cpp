@@ -10,8 +10,21 @@ UINT DoEvaluation(LPVOID pParam) {
     CReEvaluator *m_reeval = (CReEvaluator*)pParam;
 
     m_reeval->fRun = true;
-    m_reeval->DoEvaluation();
-    return 0;
+    if (m_reeval->DoEvaluation())
+    {
+        return 0;
+    }
+
+    // The evaluation could not be started, or failed. If it was stopped by the user then the dialog is already updated.
+    if (m_reeval->fRun)
+    {
+        m_reeval->fRun = false;
+        if (m_reeval->pView != nullptr)
+        {
+            m_reeval->pView->PostMessage(WM_DONE, FALSE);
+        }
+    }
+    return 1;
 }
 
 
@@ -258,16 +271,16 @@ LRESULT CReEval_DoEvaluationDlg::OnEvaluatedSpectrum(WPARAM wp, LPARAM lp) {
 
     m_result.reset((CScanResult *)lp);
 
-    // a handle to the fit window
-    CFitWindow &window = m_reeval->m_window[m_reeval->m_curWindow];
+    // a handle to the fit window, all fit windows are evaluated together so take the one used in this fit
+    CFitWindow &window = m_reeval->m_window[resultview->fitWindowIndex];
     int fitLow = window.fitLow - resultview->measuredSpectrum.m_info.m_startChannel;
     int fitHigh = window.fitHigh - resultview->measuredSpectrum.m_info.m_startChannel;
 
     // If the fit-window has changed, then change the list of references
-    if (m_reeval->m_curWindow != lastWindowUsed) {
+    if (resultview->fitWindowIndex != lastWindowUsed) {
         PopulateRefList();
     }
-    lastWindowUsed = m_reeval->m_curWindow;
+    lastWindowUsed = resultview->fitWindowIndex;
 
     // 1. Draw the resulting fit for one of the references
     {
@@ -473,7 +486,8 @@ LRESULT CReEval_DoEvaluationDlg::OnDone(WPARAM wp, LPARAM lp) {
     m_progressBar2.SetRange(0, 1000);
     m_progressBar2.SetPos(0);
 
-    SetDlgItemText(IDC_REEVAL_STATUSBAR, "Evaluation Done");
+    // 'wp' is TRUE if all the scan-files were evaluated
+    SetDlgItemText(IDC_REEVAL_STATUSBAR, wp ? "Evaluation Done" : "Evaluation failed");
     m_btnCancel.EnableWindow(FALSE);
     m_btnDoEval.EnableWindow(TRUE);
     m_btnDoEval.SetWindowText("&Do Evaluation");
@@ -0,0 +1,326 @@
+#include "StdAfx.h"
+#include "ReEvaluationJob.h"
+#include <algorithm>
+#include <io.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace ReEvaluation;
+using namespace Evaluation;
+
+CReEvaluationJob::CReEvaluationJob(CReEvaluator& reeval)
+    : m_reeval(reeval)
+{
+}
+
+CReEvaluationJob::~CReEvaluationJob()
+{
+    if (m_journal != nullptr)
+    {
+        fclose(m_journal);
+    }
+}
+
+bool CReEvaluationJob::Run()
+{
+    if (m_reeval.m_windowNum <= 0 || m_reeval.m_windowNum > CReEvaluator::MAX_N_WINDOWS)
+    {
+        ShowMessage("ReEvaluation job: no fit windows defined");
+        return false;
+    }
+
+    if (0 != CreateDirectoryStructure(m_outputDirectory))
+    {
+        return false;
+    }
+    m_reeval.m_outputDir = m_outputDirectory;
+    m_reeval.m_showDialogs = false;
+
+    // Find out what has already been done
+    ReadJournal();
+
+    // Read the references and create the evaluation logs. The logs from an earlier run of the job are appended to.
+    for (int windowIndex = 0; windowIndex < m_reeval.m_windowNum; ++windowIndex)
+    {
+        if (!ReadReferences(m_reeval.m_window[windowIndex]))
+        {
+            ShowMessage("ReEvaluation job: not all references could be read");
+            return false;
+        }
+
+        if (!ReconcileEvaluationLog(windowIndex))
+        {
+            return false;
+        }
+    }
+
+    // Open the journal to record what is done from now on
+    m_journal = fopen(JournalFileName(), "a");
+    if (m_journal == nullptr)
+    {
+        return false;
+    }
+
+    // Start walking through the archive
+    m_directories.clear();
+    m_directories.push_back(CDirectoryLevel());
+    ListDirectory(m_archiveDirectory, m_directories.back());
+
+    m_reeval.fRun = true;
+    const bool completed = m_reeval.EvaluateScanFiles(*this);
+
+    fclose(m_journal);
+    m_journal = nullptr;
+
+    return completed;
+}
+
+bool CReEvaluationJob::NextScanFile(CString& fileName)
+{
+    while (!m_directories.empty())
+    {
+        CDirectoryLevel& level = m_directories.back();
+
+        // First the scan-files in this directory
+        if (level.nextScanFile < level.scanFiles.size())
+        {
+            const CString& candidate = level.scanFiles[level.nextScanFile++];
+            for (int windowIndex = 0; windowIndex < m_reeval.m_windowNum; ++windowIndex)
+            {
+                if (!IsEvaluated(candidate, windowIndex))
+                {
+                    fileName = candidate;
+                    return true;
+                }
+            }
+            continue; // evaluated in all fit windows by an earlier run
+        }
+
+        // Then the sub-directories, one at a time
+        if (level.nextSubDirectory < level.subDirectories.size())
+        {
+            CDirectoryLevel subDirectory;
+            ListDirectory(level.subDirectories[level.nextSubDirectory++], subDirectory);
+            m_directories.push_back(std::move(subDirectory));
+            continue;
+        }
+
+        // All done in this directory
+        m_directories.pop_back();
+    }
+
+    return false;
+}
+
+double CReEvaluationJob::FractionRetrieved() const
+{
+    if (m_directories.empty())
+    {
+        return 1.0;
+    }
+
+    // Each directory counts as an equal part of its parent directory
+    double fraction = 0.0;
+    double scale = 1.0;
+    for (size_t k = 0; k < m_directories.size(); ++k)
+    {
+        const CDirectoryLevel& level = m_directories[k];
+        const size_t itemNum = level.scanFiles.size() + level.subDirectories.size();
+        if (itemNum == 0)
+        {
+            break;
+        }
+
+        size_t itemsDone = level.nextScanFile + level.nextSubDirectory;
+        if (k + 1 < m_directories.size())
+        {
+            --itemsDone; // the sub-directory we are currently in is not done
+        }
+        fraction += scale * itemsDone / (double)itemNum;
+        scale /= (double)itemNum;
+    }
+
+    return fraction;
+}
+
+bool CReEvaluationJob::IsEvaluated(const CString& fileName, int fitWindowIndex) const
+{
+    const unsigned long long key = EvaluatedKey(fileName, m_reeval.m_window[fitWindowIndex].name);
+    return m_evaluated.find(key) != m_evaluated.end();
+}
+
+void CReEvaluationJob::MarkEvaluated(const CString& fileName, int fitWindowIndex)
+{
+    const std::string& windowName = m_reeval.m_window[fitWindowIndex].name;
+    m_evaluated.insert(EvaluatedKey(fileName, windowName));
+
+    // Write the journal immediately, this is what makes it possible to resume the job if the program is stopped.
+    //  The size of the evaluation log tells where the log should end when the job is resumed.
+    if (m_journal != nullptr)
+    {
+        const long long logSize = FileSize(m_reeval.m_evalLog[fitWindowIndex]);
+        fprintf(m_journal, "%s\t%s\t%lld\n", windowName.c_str(), (LPCSTR)fileName, logSize);
+        fflush(m_journal);
+        m_journaledLogSize[windowName] = logSize;
+    }
+}
+
+CString CReEvaluationJob::JournalFileName() const
+{
+    return m_outputDirectory + "\\ReEvaluationJournal.txt";
+}
+
+void CReEvaluationJob::ReadJournal()
+{
+    m_evaluated.clear();
+    m_journaledLogSize.clear();
+
+    FILE* f = fopen(JournalFileName(), "r");
+    if (f == nullptr)
+    {
+        return; // this is a new job
+    }
+
+    // Each line consists of the name of the fit window, the name of the scan-file and the size
+    //  of the evaluation log after the scan was appended, separated by tabs
+    char buffer[4096];
+    while (nullptr != fgets(buffer, sizeof(buffer), f))
+    {
+        char* separator = strchr(buffer, '\t');
+        if (separator == nullptr)
+        {
+            continue;
+        }
+        *separator = 0;
+
+        char* fileName = separator + 1;
+        fileName[strcspn(fileName, "\r\n")] = 0;
+
+        char* sizeSeparator = strrchr(fileName, '\t');
+        if (sizeSeparator == nullptr)
+        {
+            continue; // the line was not completely written
+        }
+        *sizeSeparator = 0;
+
+        const std::string windowName(buffer);
+        m_evaluated.insert(EvaluatedKey(CString(fileName), windowName));
+        m_journaledLogSize[windowName] = _atoi64(sizeSeparator + 1);
+    }
+
+    fclose(f);
+}
+
+bool CReEvaluationJob::ReconcileEvaluationLog(int fitWindowIndex)
+{
+    const CString evaluationLog = m_reeval.EvaluationLogFileName(fitWindowIndex);
+    const long long logSize = FileSize(evaluationLog);
+
+    // A log without any scan recorded in the journal is started from the beginning
+    auto journaled = m_journaledLogSize.find(m_reeval.m_window[fitWindowIndex].name);
+    if (logSize < 0 || journaled == m_journaledLogSize.end())
+    {
+        return m_reeval.WriteEvaluationLogHeader(fitWindowIndex);
+    }
+
+    m_reeval.m_evalLog[fitWindowIndex] = evaluationLog;
+    if (logSize == journaled->second)
+    {
+        return true;
+    }
+    if (logSize < journaled->second)
+    {
+        CString message;
+        message.Format("ReEvaluation job: the evaluation log %s is shorter than recorded in the journal", (LPCSTR)evaluationLog);
+        ShowMessage(message);
+        return false;
+    }
+
+    // The last scan in the log was appended but the job was stopped before it was recorded in the journal.
+    //  Remove it, it will be evaluated again.
+    FILE* f = fopen(evaluationLog, "r+b");
+    if (f == nullptr)
+    {
+        return false;
+    }
+    const bool truncated = (0 == _chsize_s(_fileno(f), journaled->second));
+    fclose(f);
+
+    return truncated;
+}
+
+long long CReEvaluationJob::FileSize(const CString& fileName)
+{
+    struct __stat64 fileStatus;
+    if (0 != _stat64(fileName, &fileStatus))
+    {
+        return -1;
+    }
+    return (long long)fileStatus.st_size;
+}
+
+void CReEvaluationJob::ListDirectory(const CString& path, CDirectoryLevel& level)
+{
+    WIN32_FIND_DATA FindFileData;
+    CString fileToFind;
+    fileToFind.Format("%s\\*", (LPCSTR)path);
+
+    level.path = path;
+
+    HANDLE hFile = FindFirstFile(fileToFind, &FindFileData);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return; // empty, or not a directory
+    }
+
+    do
+    {
+        const CString fileName(FindFileData.cFileName);
+
+        // don't include the current and the parent directories
+        if (Equals(fileName, ".") || Equals(fileName, ".."))
+        {
+            continue;
+        }
+
+        const CString fullFileName = path + "\\" + fileName;
+        if (FindFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            level.subDirectories.push_back(fullFileName);
+        }
+        else if (Equals(fileName.Right(4), ".pak"))
+        {
+            level.scanFiles.push_back(fullFileName);
+        }
+    } while (0 != FindNextFile(hFile, &FindFileData));
+
+    FindClose(hFile);
+
+    // Evaluate the scan-files in the order of their names, which is the order they were collected in
+    auto byName = [](const CString& first, const CString& second) { return first.Compare(second) < 0; };
+    std::sort(level.scanFiles.begin(), level.scanFiles.end(), byName);
+    std::sort(level.subDirectories.begin(), level.subDirectories.end(), byName);
+}
+
+unsigned long long CReEvaluationJob::EvaluatedKey(const CString& fileName, const std::string& windowName)
+{
+    // 64-bit FNV-1a hash of the name of the fit window and the name of the file
+    unsigned long long hash = 14695981039346656037ULL;
+    auto addCharacter = [&hash](unsigned char c)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    };
+
+    for (char c : windowName)
+    {
+        addCharacter((unsigned char)c);
+    }
+    addCharacter(0);
+    for (int k = 0; k < fileName.GetLength(); ++k)
+    {
+        addCharacter((unsigned char)fileName[k]);
+    }
+
+    return hash;
+}
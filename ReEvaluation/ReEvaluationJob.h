@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ReEvaluator.h"
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace ReEvaluation
+{
+    /** A <b>CReEvaluationJob</b> reevaluates all the scan-files in an archive directory,
+        including all its sub-directories. The directory tree is walked one directory at a time
+        while the scan-files are evaluated, so the list of scan-files is never held in memory.
+
+        Every (scan-file, fit window) pair which has been written to the evaluation log is
+        recorded in a journal in the output directory, together with the size of the evaluation log
+        after the scan was appended. When a job which has been stopped is started again with the
+        same output directory, it resumes where it stopped and appends to the existing evaluation logs.
+        A scan which was appended to a log but not recorded in the journal, because the job was
+        stopped in between, is first cut away from the log. */
+    class CReEvaluationJob : public CScanFileSource
+    {
+    public:
+        /** @param reeval The reevaluator to use, with the fit windows and the evaluation settings set up. */
+        explicit CReEvaluationJob(CReEvaluator& reeval);
+        ~CReEvaluationJob();
+
+        /** The root directory of the archive to reevaluate */
+        CString m_archiveDirectory;
+
+        /** The directory where the evaluation logs and the journal are saved.
+            Running the job again with the same output directory resumes the job. */
+        CString m_outputDirectory;
+
+        /** Runs the job.
+            @return true if all the scan-files in the archive have been evaluated. */
+        bool Run();
+
+        // ------------------ CScanFileSource -------------------
+
+        virtual bool NextScanFile(CString& fileName) override;
+
+        virtual double FractionRetrieved() const override;
+
+        virtual bool IsEvaluated(const CString& fileName, int fitWindowIndex) const override;
+
+        virtual void MarkEvaluated(const CString& fileName, int fitWindowIndex) override;
+
+    private:
+        CReEvaluationJob(const CReEvaluationJob&) = delete;
+        CReEvaluationJob& operator=(const CReEvaluationJob&) = delete;
+
+        /** The contents of one directory in the archive, which is being walked through */
+        struct CDirectoryLevel
+        {
+            CString path;
+
+            /** The scan-files and the sub-directories in this directory, sorted by name */
+            std::vector<CString> scanFiles;
+            std::vector<CString> subDirectories;
+
+            /** The index of the next scan-file and the next sub-directory to visit */
+            size_t nextScanFile = 0;
+            size_t nextSubDirectory = 0;
+        };
+
+        /** The reevaluator */
+        CReEvaluator& m_reeval;
+
+        /** The directories being walked through, from the archive root down to the current directory */
+        std::vector<CDirectoryLevel> m_directories;
+
+        /** The (scan-file, fit window) pairs which have been evaluated, stored as the hash of
+            the file name and the name of the fit window to keep this small also for large archives. */
+        std::unordered_set<unsigned long long> m_evaluated;
+
+        /** The size of the evaluation log of each fit window, in bytes, as last recorded in the journal.
+            The key is the name of the fit window. */
+        std::map<std::string, long long> m_journaledLogSize;
+
+        /** The journal file, opened for appending */
+        FILE* m_journal = nullptr;
+
+        /** @return the name and path of the journal file */
+        CString JournalFileName() const;
+
+        /** Reads the journal of an earlier run of the job, if any */
+        void ReadJournal();
+
+        /** Makes sure that the evaluation log of the given fit window ends with the last scan recorded
+            in the journal, creating the log if it does not exist.
+            @return false if the log could not be created or corrected. */
+        bool ReconcileEvaluationLog(int fitWindowIndex);
+
+        /** @return the size of the given file, in bytes, or -1 if it does not exist */
+        static long long FileSize(const CString& fileName);
+
+        /** Lists the scan-files and the sub-directories in the given directory */
+        static void ListDirectory(const CString& path, CDirectoryLevel& level);
+
+        /** @return the key of the given (scan-file, fit window) pair in 'm_evaluated' */
+        static unsigned long long EvaluatedKey(const CString& fileName, const std::string& windowName);
+    };
+}
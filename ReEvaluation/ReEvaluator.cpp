@@ -6,10 +6,48 @@
 #include "../Evaluation/ScanEvaluation.h"
 #include "../Dialogs/QueryStringDialog.h"
 #include <SpectralEvaluation/StringUtils.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 using namespace ReEvaluation;
 using namespace Evaluation;
 
+namespace
+{
+    /** The scan-files selected by the user, evaluated in the order they are listed */
+    class CScanFileList : public CScanFileSource
+    {
+    public:
+        CScanFileList(const CArray<CString, CString&>& scanFiles, long scanFileNum)
+            : m_scanFiles(scanFiles), m_scanFileNum(scanFileNum)
+        {
+        }
+
+        virtual bool NextScanFile(CString& fileName) override
+        {
+            if (m_next >= m_scanFileNum)
+            {
+                return false;
+            }
+            fileName = m_scanFiles[m_next++];
+            return true;
+        }
+
+        virtual double FractionRetrieved() const override
+        {
+            return m_next / (double)m_scanFileNum;
+        }
+
+    private:
+        const CArray<CString, CString&>& m_scanFiles;
+        const long m_scanFileNum;
+        long m_next = 0;
+    };
+}
+
 CReEvaluator::CReEvaluator(void)
 {
     fRun = false;
@@ -50,6 +88,11 @@ CReEvaluator::CReEvaluator(void)
 
     // The default is that the spectra are summed, not averaged
     m_averagedSpectra = false;
+
+    // The default is to evaluate one scan-file at a time
+    m_threadNum = 1;
+
+    m_showDialogs = true;
 }
 
 /** Halts the current operation */
@@ -73,8 +116,133 @@ bool CReEvaluator::DoEvaluation()
     }
 
     /* evaluate the spectra */
+    CScanFileList scanFiles(m_scanFile, m_scanFileNum);
+    return EvaluateScanFiles(scanFiles);
+}
+
+bool CReEvaluator::EvaluateScanFiles(CScanFileSource& source)
+{
     m_progress = 0;
 
+    const bool evaluated = (m_threadNum > 1) ? EvaluateScansInParallel(source) : EvaluateScans(source);
+    if (!evaluated)
+    {
+        return false;
+    }
+
+    // Check if the user wants to stop
+    if (!fRun)
+    {
+        return false;
+    }
+
+    if (pView != nullptr)
+    {
+        pView->PostMessage(WM_DONE, TRUE);
+    }
+
+    fRun = false;
+
+    return true;
+}
+
+void CReEvaluator::SetupScanEvaluation(CScanEvaluation& ev) const
+{
+    ev.SetOption_Sky(m_skySettings);
+    ev.SetOption_Ignore(m_ignore_Lower, m_ignore_Upper);
+    ev.SetOption_AveragedSpectra(m_averagedSpectra);
+}
+
+CReEvaluator::ScanPreparation CReEvaluator::PrepareScan(const CString& scanFileName, int scanNumber, FileHandler::CScanFileHandler& scan, std::vector<CFitWindow>& windows)
+{
+    // Check the scan file
+    if (SUCCESS != scan.CheckScanFile(std::string((LPCSTR)scanFileName)))
+    {
+        CString errStr;
+        errStr.Format("Could not read scan-file %s", (LPCTSTR)scanFileName);
+        if (m_showDialogs)
+        {
+            MessageBox(NULL, errStr, "Error", MB_OK);
+        }
+        else
+        {
+            ShowMessage(errStr);
+        }
+        return ScanPreparation::Skip;
+    }
+
+    // update the status window
+    m_statusMsg.Format("Evaluating scan number %d", scanNumber);
+    ShowMessage(m_statusMsg);
+
+    // For each scanfile: adapt the fit windows to the spectra in the scan
+    CSpectrum skySpec;
+    scan.GetSky(skySpec);
+    const CSpectrum originalSkySpec = skySpec;
+
+    bool evaluateScan = true;
+    for (m_curWindow = 0; m_curWindow < m_windowNum; ++m_curWindow)
+    {
+        CFitWindow &thisWindow = m_window[m_curWindow];
+
+        // Check the interlace steps
+        skySpec = originalSkySpec;
+
+        if (skySpec.Channel() > MAX_CHANNEL_NUM)
+        {
+            // We should use an interlaced window instead
+            if (-1 == Common::GetInterlaceSteps(skySpec.Channel(), skySpec.m_info.m_interlaceStep))
+            {
+                m_curWindow = 0;
+                return ScanPreparation::Abort;
+            }
+
+            thisWindow.interlaceStep = skySpec.m_info.m_interlaceStep;
+            thisWindow.specLength = skySpec.m_length * skySpec.m_info.m_interlaceStep;
+        }
+
+        if (skySpec.m_info.m_startChannel > 0 || skySpec.m_length != thisWindow.specLength / thisWindow.interlaceStep)
+        {
+            // If the spectra are too short or the start channel is not zero
+            //	then they are read out as partial spectra. Lets adapt the evaluator to that
+            thisWindow.specLength = skySpec.m_length;
+            thisWindow.startChannel = skySpec.m_info.m_startChannel;
+        }
+
+        if (skySpec.m_info.m_interlaceStep > 1)
+        {
+            skySpec.InterpolateSpectrum();
+        }
+
+        // check the quality of the sky-spectrum
+        if (skySpec.AverageValue(thisWindow.fitLow, thisWindow.fitHigh) >= 4090 * skySpec.NumSpectra())
+        {
+            if (skySpec.NumSpectra() > 0 && m_showDialogs)
+            {
+                CString message;
+                message.Format("It seems like the sky-spectrum is saturated in the fit-region. Continue?");
+                if (IDNO == MessageBox(NULL, message, "Saturated sky spectrum?", MB_YESNO))
+                {
+                    evaluateScan = false; // continue with the next scan-file
+                    break;
+                }
+            }
+        }
+    }//end for m_curWindow...
+    m_curWindow = 0;
+
+    if (!evaluateScan)
+    {
+        return ScanPreparation::Skip;
+    }
+
+    windows.assign(m_window, m_window + m_windowNum);
+
+    return ScanPreparation::Evaluate;
+}
+
+bool CReEvaluator::EvaluateScans(CScanFileSource& source)
+{
     // The CScanEvaluation-object handles the evaluation of one single scan.
     CScanEvaluation ev;
     ev.pView = this->pView;
@@ -82,14 +250,19 @@ bool CReEvaluator::DoEvaluation()
     ev.m_sleeping = &m_sleeping;
 
     // Set the options for the CScanEvaluation object
-    ev.SetOption_Sky(m_skySettings);
-    ev.SetOption_Ignore(m_ignore_Lower, m_ignore_Upper);
-    ev.SetOption_AveragedSpectra(m_averagedSpectra);
+    SetupScanEvaluation(ev);
 
     // loop through all the scan files
-    for (int curScanFile = 0; curScanFile < m_scanFileNum; ++curScanFile)
+    CString scanFileName;
+    for (int scanNumber = 0; ; ++scanNumber)
     {
-        m_progress = curScanFile / (double)m_scanFileNum;
+        const double progress = source.FractionRetrieved();
+        if (!source.NextScanFile(scanFileName))
+        {
+            break;
+        }
+
+        m_progress = progress;
         if (pView != nullptr)
         {
             pView->PostMessage(WM_PROGRESS, (WPARAM)m_progress);
@@ -97,98 +270,227 @@ bool CReEvaluator::DoEvaluation()
 
         // The CScanFileHandler is a structure for reading the spectral information from the scan-file
         FileHandler::CScanFileHandler scan;
+        std::vector<CFitWindow> windows;
 
-        // Check the scan file
-        const std::string scanFileName((LPCSTR)m_scanFile[curScanFile]);
-        if (SUCCESS != scan.CheckScanFile(scanFileName))
+        const ScanPreparation preparation = PrepareScan(scanFileName, scanNumber, scan, windows);
+        if (preparation == ScanPreparation::Abort)
+        {
+            return false;
+        }
+        else if (preparation == ScanPreparation::Skip)
         {
-            CString errStr;
-            errStr.Format("Could not read scan-file %s", (LPCTSTR)m_scanFile[curScanFile]);
-            MessageBox(NULL, errStr, "Error", MB_OK);
             continue;
         }
 
-        // update the status window
-        m_statusMsg.Format("Evaluating scan number %d", curScanFile);
-        ShowMessage(m_statusMsg);
+        // Evaluate the scan-file in all the fit windows, this reads each spectrum in the file only once
+        ev.EvaluateScan(scanFileName, windows, &fRun, &m_darkSettings);
+
+        // Check if the user wants to stop
+        if (!fRun)
+        {
+            return true;
+        }
 
-        // For each scanfile: loop through the fit windows
-        for (m_curWindow = 0; m_curWindow < m_windowNum; ++m_curWindow)
+        // get the result of the evaluation and write them to file
+        for (int windowIndex = 0; windowIndex < m_windowNum; ++windowIndex)
         {
-            CFitWindow &thisWindow = m_window[m_curWindow];
+            std::unique_ptr<CScanResult> res = ev.GetResult(windowIndex);
+            WriteScanResult(source, scanFileName, scan, windowIndex, res.get());
+        }
+
+    } // end for(scanNumber...
+
+    return true;
+}
+
+bool CReEvaluator::EvaluateScansInParallel(CScanFileSource& source)
+{
+    /** One scan-file, handed to the workers for evaluation */
+    struct CScanJob
+    {
+        CString scanFileName;
+
+        /** The progress of the reevaluation when this scan-file has been written */
+        double progress = 0.0;
+
+        FileHandler::CScanFileHandler scan;
+        std::vector<CFitWindow> windows;
+
+        /** The result of the evaluation, one for each fit window */
+        std::vector<std::unique_ptr<CScanResult>> results;
+
+        /** True when the worker is done with this scan-file */
+        bool finished = false;
 
-            // Check the interlace steps
-            CSpectrum skySpec;
-            scan.GetSky(skySpec);
+        /** True if the evaluation ran to the end, i.e. was not stopped by the user */
+        bool completed = false;
+    };
 
-            if (skySpec.Channel() > MAX_CHANNEL_NUM)
+    // The reorder buffer. The scan-files which are being evaluated, in the order of the scan-files.
+    //  The results are written to the evaluation logs from the front of this buffer, such that
+    //  the logs are written in the same order as in the sequential evaluation.
+    std::deque<std::unique_ptr<CScanJob>> scansInFlight;
+
+    // The scan-files which are prepared but not yet picked up by any of the workers
+    std::deque<CScanJob*> pendingScans;
+    std::mutex queueMutex;
+    std::condition_variable scanAvailable;
+    std::condition_variable scanFinished;
+    bool allScansPrepared = false;
+
+    // The workers. Each of them evaluates scan-files using its own CScanEvaluation
+    auto evaluateScans = [&]()
+    {
+        CScanEvaluation ev;
+        SetupScanEvaluation(ev);
+
+        while (1)
+        {
+            CScanJob* job = nullptr;
             {
-                // We should use an interlaced window instead
-                if (-1 == Common::GetInterlaceSteps(skySpec.Channel(), skySpec.m_info.m_interlaceStep))
+                std::unique_lock<std::mutex> lock{ queueMutex };
+                scanAvailable.wait(lock, [&] { return !pendingScans.empty() || allScansPrepared; });
+
+                if (pendingScans.empty())
                 {
-                    return 0; // WRONG!!
+                    return; // all scan-files are evaluated
                 }
-
-                thisWindow.interlaceStep = skySpec.m_info.m_interlaceStep;
-                thisWindow.specLength = skySpec.m_length * skySpec.m_info.m_interlaceStep;
+                job = pendingScans.front();
+                pendingScans.pop_front();
             }
 
-            if (skySpec.m_info.m_startChannel > 0 || skySpec.m_length != thisWindow.specLength / thisWindow.interlaceStep)
+            bool completed = false;
+            if (fRun)
             {
-                // If the spectra are too short or the start channel is not zero
-                //	then they are read out as partial spectra. Lets adapt the evaluator to that
-                thisWindow.specLength = skySpec.m_length;
-                thisWindow.startChannel = skySpec.m_info.m_startChannel;
+                ev.EvaluateScan(job->scanFileName, job->windows, &fRun, &m_darkSettings);
+                for (size_t windowIndex = 0; windowIndex < job->windows.size(); ++windowIndex)
+                {
+                    job->results.push_back(ev.GetResult(windowIndex));
+                }
+                completed = fRun;
             }
 
-            if (skySpec.m_info.m_interlaceStep > 1)
             {
-                skySpec.InterpolateSpectrum();
+                std::lock_guard<std::mutex> lock{ queueMutex };
+                job->finished = true;
+                job->completed = completed;
             }
+            scanFinished.notify_all();
+        }
+    };
 
-            // check the quality of the sky-spectrum
-            if (skySpec.AverageValue(thisWindow.fitLow, thisWindow.fitHigh) >= 4090 * skySpec.NumSpectra())
+    // Writes the results of the finished scan-files at the front of the reorder buffer to the evaluation logs.
+    //  The lock is released while writing. Returns false if a scan-file whose evaluation was stopped is found.
+    auto writeFinishedScans = [&](std::unique_lock<std::mutex>& lock)
+    {
+        while (!scansInFlight.empty() && scansInFlight.front()->finished)
+        {
+            std::unique_ptr<CScanJob> job = std::move(scansInFlight.front());
+            scansInFlight.pop_front();
+            if (!job->completed)
             {
-                if (skySpec.NumSpectra() > 0)
-                {
-                    CString message;
-                    message.Format("It seems like the sky-spectrum is saturated in the fit-region. Continue?");
-                    if (IDNO == MessageBox(NULL, message, "Saturated sky spectrum?", MB_YESNO))
-                    {
-                        break; // continue with the next scan-file
-                    }
-                }
+                return false;
             }
 
-            // Evaluate the scan-file
-            int success = ev.EvaluateScan(m_scanFile[curScanFile], m_window[m_curWindow], &fRun, &m_darkSettings);
+            lock.unlock();
+            for (int windowIndex = 0; windowIndex < m_windowNum; ++windowIndex)
+            {
+                WriteScanResult(source, job->scanFileName, job->scan, windowIndex, job->results[windowIndex].get());
+            }
 
-            // Check if the user wants to stop
-            if (!fRun)
+            m_progress = job->progress;
+            if (pView != nullptr)
             {
-                return true;
+                pView->PostMessage(WM_PROGRESS, (WPARAM)m_progress);
             }
+            lock.lock();
+        }
+        return true;
+    };
+
+    std::vector<std::thread> workers;
+    for (int k = 0; k < m_threadNum; ++k)
+    {
+        workers.push_back(std::thread(evaluateScans));
+    }
+
+    // Prepare the scan-files in order on this thread, since the adaptation of the fit windows depends on
+    //  the previous scan-files and the user may be asked about each of them. At most two scan-files per
+    //  worker are kept in memory, the finished ones are written to the evaluation logs while waiting.
+    const size_t maxScansInFlight = 2 * (size_t)m_threadNum;
+    bool aborted = false;
+    bool stopped = false;
+    for (int scanNumber = 0; fRun && !stopped; ++scanNumber)
+    {
+        std::unique_ptr<CScanJob> job = std::make_unique<CScanJob>();
+        if (!source.NextScanFile(job->scanFileName))
+        {
+            break;
+        }
+        job->progress = source.FractionRetrieved();
+
+        const ScanPreparation preparation = PrepareScan(job->scanFileName, scanNumber, job->scan, job->windows);
+        if (preparation == ScanPreparation::Abort)
+        {
+            aborted = true;
+            break;
+        }
+        else if (preparation == ScanPreparation::Skip)
+        {
+            continue;
+        }
 
-            // get the result of the evaluation and write them to file
-            if (success)
+        std::unique_lock<std::mutex> lock{ queueMutex };
+        while (1)
+        {
+            if (!writeFinishedScans(lock))
+            {
+                stopped = true;
+                break;
+            }
+            if (scansInFlight.size() < maxScansInFlight)
             {
-                std::unique_ptr<CScanResult> res = ev.GetResult();
-                AppendResultToEvaluationLog(*res.get(), scan, m_curWindow);
+                break;
             }
+            scanFinished.wait(lock);
+        }
 
-        }//end for m_curWindow...
-        m_curWindow = 0;
+        if (!stopped)
+        {
+            pendingScans.push_back(job.get());
+            scansInFlight.push_back(std::move(job));
+            scanAvailable.notify_one();
+        }
+    }
 
-    } // end for(curScanFile...
+    {
+        std::lock_guard<std::mutex> lock{ queueMutex };
+        allScansPrepared = true;
+    }
+    scanAvailable.notify_all();
 
-    if (pView != nullptr)
+    // Write the results of the remaining scan-files, as they finish
     {
-        pView->PostMessage(WM_DONE);
+        std::unique_lock<std::mutex> lock{ queueMutex };
+        while (!stopped && !scansInFlight.empty())
+        {
+            if (!writeFinishedScans(lock))
+            {
+                stopped = true;
+            }
+            else if (!scansInFlight.empty())
+            {
+                scanFinished.wait(lock);
+            }
+        }
     }
 
-    fRun = false;
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
 
-    return true;
+    return !aborted;
 }
 
 /* Check the settings before we start */
@@ -264,13 +566,16 @@ bool CReEvaluator::WriteEvaluationLogHeader(int fitWindowIndex)
     const CFitWindow &window = m_window[fitWindowIndex];
 
     // Get the name of the evaluation log file
-    m_evalLog[fitWindowIndex] = m_outputDir + "\\ReEvaluationLog_" + CString(window.name.c_str()) + ".txt";
+    m_evalLog[fitWindowIndex] = EvaluationLogFileName(fitWindowIndex);
 
     // Try to open the log file
     FILE *f = fopen(m_evalLog[fitWindowIndex], "w");
     if (f == nullptr)
     {
-        MessageBox(NULL, "Could not create evaluation-log file, evaluation aborted", "FileError", MB_OK);
+        if (m_showDialogs)
+        {
+            MessageBox(NULL, "Could not create evaluation-log file, evaluation aborted", "FileError", MB_OK);
+        }
         return false; // failed to open the file, quit it
     }
 
@@ -347,6 +652,29 @@ bool CReEvaluator::WriteEvaluationLogHeader(int fitWindowIndex)
     return true;
 }
 
+CString CReEvaluator::EvaluationLogFileName(int fitWindowIndex) const
+{
+    return m_outputDir + "\\ReEvaluationLog_" + CString(m_window[fitWindowIndex].name.c_str()) + ".txt";
+}
+
+void CReEvaluator::WriteScanResult(CScanFileSource& source, const CString& scanFileName, const FileHandler::CScanFileHandler& scan, int fitWindowIndex, const CScanResult* result)
+{
+    if (source.IsEvaluated(scanFileName, fitWindowIndex))
+    {
+        return; // already in the evaluation log
+    }
+
+    if (result != nullptr && result->GetEvaluatedNum() > 0)
+    {
+        if (!AppendResultToEvaluationLog(*result, scan, fitWindowIndex))
+        {
+            return; // not written, the scan is evaluated again the next time
+        }
+    }
+
+    source.MarkEvaluated(scanFileName, fitWindowIndex);
+}
+
 bool CReEvaluator::AppendResultToEvaluationLog(const Evaluation::CScanResult& result, const FileHandler::CScanFileHandler& scan, int fitWindowIndex)
 {
     CSpectrum skySpec;
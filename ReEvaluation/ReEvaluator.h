@@ -7,12 +7,39 @@
 #include <SpectralEvaluation/Spectra/Spectrum.h>
 #include <SpectralEvaluation/File/ScanFileHandler.h>
 #include "../Configuration/Configuration.h"
+#include <atomic>
 
-#define MAX_N_SCANFILES 64
-
+namespace Evaluation
+{
+    class CScanEvaluation;
+}
 
 namespace ReEvaluation
 {
+    /** <b>CScanFileSource</b> provides the scan-files to reevaluate, one at a time and
+        in the order in which they should be evaluated. This makes it possible to reevaluate
+        more scan-files than can reasonably be listed in memory, e.g. a whole archive. */
+    class CScanFileSource
+    {
+    public:
+        virtual ~CScanFileSource() = default;
+
+        /** Retrieves the next scan-file to evaluate.
+            @return false if there are no more scan-files. */
+        virtual bool NextScanFile(CString& fileName) = 0;
+
+        /** @return the (approximate) fraction of the scan-files which have been retrieved so far, in the range [0, 1] */
+        virtual double FractionRetrieved() const = 0;
+
+        /** @return true if the result of the given scan-file in the given fit window has already been
+            written to the evaluation log, e.g. by an earlier run which was stopped. */
+        virtual bool IsEvaluated(const CString& /*fileName*/, int /*fitWindowIndex*/) const { return false; }
+
+        /** Called when the given scan-file has been evaluated in the given fit window,
+            and the result (if any) has been written to the evaluation log. */
+        virtual void MarkEvaluated(const CString& /*fileName*/, int /*fitWindowIndex*/) { }
+    };
+
     class CReEvaluator
     {
     public:
@@ -25,14 +52,16 @@ namespace ReEvaluation
             value will be treated as dark. */
         static const long MINIMUM_CREDIBLE_INTENSITY = 600;
 
-        /**  this is true if the reevaluation is running, else false */
-        bool  fRun;
+        /**  this is true if the reevaluation is running, else false.
+            Cleared by the user interface to stop the reevaluation, and read by the reevaluation thread,
+            by the worker threads of the parallel reevaluation and by those of each CScanEvaluation. */
+        std::atomic<bool> fRun;
 
         /** If this is true then the reevaluator will sleep beteween each spectrum evaluation */
         int   m_pause;
 
-        /** True if the thread is currently sleeping */
-        bool  m_sleeping;
+        /** True if the thread is currently sleeping, read by the user interface to know if it should be woken up */
+        std::atomic<bool> m_sleeping;
 
         /** The pak-files to reevaluate */
         CArray <CString, CString&> m_scanFile;
@@ -52,6 +81,18 @@ namespace ReEvaluation
         /** True if the spectra that we're treating are averaged, not summed */
         bool        m_averagedSpectra;
 
+        /** The number of scan-files to evaluate concurrently. With more than one thread are the
+            scan-files evaluated by a pool of worker threads, each with its own CScanEvaluation,
+            and the results are written to the evaluation logs in the order of the scan-files.
+            The evaluation logs are then identical to the ones from the sequential evaluation,
+            but the result of each spectrum is not shown and the evaluation cannot be paused. */
+        int         m_threadNum;
+
+        /** If this is false then no dialogs are shown and the user is never asked anything,
+            unreadable scan-files are skipped and scans with saturated sky spectra are evaluated.
+            Used when reevaluating from the command line. */
+        bool        m_showDialogs;
+
         /** a string that is updated with information about progres in the calculations.
             every time the string is changed a message is sent to 'pView' */
         CString     m_statusMsg;
@@ -91,6 +132,12 @@ namespace ReEvaluation
         /** This function takes care of the actual evaluation */
         bool DoEvaluation();
 
+        /** Evaluates the scan-files from the given source and appends the results to the
+            evaluation logs. The fit windows must be prepared and the evaluation logs created
+            before this is called, this is what DoEvaluation does for the scan-files in 'm_scanFile'.
+            @return true if all the scan-files were evaluated, false if the evaluation was aborted or stopped. */
+        bool EvaluateScanFiles(CScanFileSource& source);
+
         /** Checks the settings before the evaluation */
         bool MakeInitialSanityCheck();
 
@@ -101,6 +148,9 @@ namespace ReEvaluation
             the current scan file and the current fit window. */
         bool  WriteEvaluationLogHeader(int fitWindowIndex);
 
+        /** @return the name and path of the evaluation log of the given fit window, in the m_outputDir directory */
+        CString EvaluationLogFileName(int fitWindowIndex) const;
+
         /** Appends the evaluation result to the evaluation log */
         bool AppendResultToEvaluationLog(const Evaluation::CScanResult& result, const FileHandler::CScanFileHandler& scan, int fitWindowIndex);
 
@@ -109,8 +159,39 @@ namespace ReEvaluation
 
     private:
 
+        /** The outcome of preparing one scan-file for the evaluation */
+        enum class ScanPreparation
+        {
+            Evaluate,   // the scan-file should be evaluated
+            Skip,       // the scan-file could not be read, or the user chose not to evaluate it
+            Abort       // the evaluation must be aborted
+        };
+
         /** Prepares for evaluation */
         bool PrepareEvaluation();
 
+        /** Sets the options of the CScanEvaluation from the settings of this reevaluator */
+        void SetupScanEvaluation(Evaluation::CScanEvaluation& ev) const;
+
+        /** Checks the given scan-file and adapts the fit windows to the spectra in it.
+            The adaptations are kept in 'm_window' for the following scan-files, as the scan-files are
+            prepared in order this is the same in the sequential and the parallel evaluation.
+            @param scanNumber The number of the scan-file in the evaluation, shown to the user.
+            @param scan Will on return be opened for the scan-file.
+            @param windows Will on return be filled with the fit windows to use for this scan-file. */
+        ScanPreparation PrepareScan(const CString& scanFileName, int scanNumber, FileHandler::CScanFileHandler& scan, std::vector<Evaluation::CFitWindow>& windows);
+
+        /** Evaluates the scan-files one at a time, on the calling thread.
+            @return false if the evaluation had to be aborted. */
+        bool EvaluateScans(CScanFileSource& source);
+
+        /** Evaluates the scan-files using 'm_threadNum' worker threads.
+            @return false if the evaluation had to be aborted. */
+        bool EvaluateScansInParallel(CScanFileSource& source);
+
+        /** Appends the result of one scan-file in one fit window to the evaluation log, unless
+            the source tells that it is already there, and tells the source that it has been written. */
+        void WriteScanResult(CScanFileSource& source, const CString& scanFileName, const FileHandler::CScanFileHandler& scan, int fitWindowIndex, const Evaluation::CScanResult* result);
+
     };
 }
\ No newline at end of file
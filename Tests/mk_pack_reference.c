@@ -0,0 +1,177 @@
+/* The MKZY codec as it was before Common/mk_pack.c packed and unpacked whole words,
+   kept unchanged apart from the names, which are prefixed with 'ref_', and the
+   'chunks.txt' debug file which UnPack wrote on every call.
+   This is the reference which mk_pack_test.c compares the current codec to. */
+
+#define headsiz 12
+
+static void ref_WriteBits(short a,short curr,long *inpek,unsigned char *utpek,long bitnr)
+{
+  short jj,j;
+  long utwrd;
+  long kk;
+  unsigned short utlng=0x80;
+
+  utwrd=(unsigned long)( (a<<5) | (curr & 0x1f) );
+  kk=1L<<(headsiz-1);
+  for(j=0;j<headsiz;j++)
+    {
+      if( utwrd & kk ) utpek[(bitnr>>3)]|=(utlng>>(bitnr&7));
+      bitnr++;
+      kk=kk>>1;
+    }
+
+  for(jj=0;jj<a;jj++)             /* spara undan alla */
+    {
+      kk=(1L<<(curr-1));
+      utwrd=*inpek++;
+      for(j=0;j<curr;j++)
+	{
+	  if( utwrd & kk ) utpek[(bitnr>>3)]|=(utlng>>(bitnr&7));
+	  bitnr++;
+	  kk=kk>>1;
+	}
+    }
+}
+
+static short ref_BitsPrec(long i)
+{
+short j=1;
+if(!i) return(0);
+if(i<0)
+        {
+        if(i == -1) return(1);
+        while(i != -1 )
+                {
+                j++;
+                i=(i>>1);
+                }
+        }
+else
+while( i )
+        {
+        j++;
+        i=(i>>1);
+        }
+return(j);
+}
+
+static long ref_bitnr;
+static long *ref_strt;
+
+static void ref_PackSeg(unsigned char *utpek, long *kvar )
+{
+  short len[33];
+  long j;
+  long *incpy;
+  short curr,i,a;
+
+  for(j=0;j<33;j++) len[j]=0;
+  incpy=ref_strt;
+
+  i=ref_BitsPrec(*incpy++);
+  curr=i;
+  a=0;
+  do {
+    a++;
+    for(j=0;j<curr;j++)
+      {
+        if(i>j) len[j]=0;
+        else {
+          len[j]++;
+          if( len[j]*(curr-j)>headsiz*2)
+            {
+              a-=len[j];
+              goto Fixat;
+            }
+        }
+      }
+    i=ref_BitsPrec(*incpy++);
+    if(i>curr)
+      {
+        if( a*(i-curr)>headsiz ) goto Fixat;
+
+        while(curr!=i)
+          {
+            len[curr]=a;
+            curr++;
+          }
+      }
+  } while( a<*kvar && a<127 );
+ Fixat:
+
+  ref_WriteBits(a,curr,ref_strt,utpek,ref_bitnr);
+  *kvar -=a;
+  ref_strt += a;
+  ref_bitnr += a*curr+headsiz;
+}
+
+unsigned short ref_mk_compress(long *in,unsigned char *ut,unsigned short size)
+{
+  long kvar;
+  unsigned short outsize;
+
+  ref_strt=in;
+  kvar=size;
+  ref_bitnr=0;
+  do {
+    ref_PackSeg(ut,&kvar);
+  } while( kvar>0);
+
+  outsize=(ref_bitnr+7)>>3;
+  return(outsize);
+}
+
+long ref_UnPack(unsigned char *inpek,long kvar,long *ut )
+{
+  long *utpek;
+  short len,curr;
+  short j,jj;
+  long a;
+  unsigned short lentofile=0;
+  long bit=0;
+
+  utpek=ut;
+  lentofile=0;
+  while(kvar>0)
+    {
+      len=0;
+      for(j=0;j<7;j++)
+        {
+          len+=len;
+          len|=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
+          bit++;
+        }
+      curr=0;
+      for(j=0;j<5;j++)
+        {
+          curr+=curr;
+          curr|=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
+          bit++;
+        }
+      if(curr)
+        {
+          for(jj=0;jj<len;jj++)
+            {
+              a=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
+              if(a) a=-1;
+              bit++;
+              for(j=1;j<curr;j++)
+                {
+                  a+=a;
+                  a|=inpek[(bit>>3)]>>(7-(bit&0x7))&1;
+                  bit++;
+                }
+              *utpek++=a;
+            }
+        }
+      else for(jj=0;jj<len;jj++) *utpek++=0;
+      kvar-=len;
+      lentofile+=len;
+    }
+  for(jj=1;jj<lentofile;jj++)
+    {
+      ut[jj]+=ut[jj-1];
+    }
+  return(lentofile);
+}
@@ -0,0 +1,173 @@
+/* Compares the MKZY codec in Common/mk_pack.c to the original byte-wise codec in
+   mk_pack_reference.c, on random spectra of different lengths and value ranges.
+   The compressed bytes must be identical, and both codecs must decompress them to the input.
+   UnPackChecked must decompress them to the input too, and must reject data which is cut short.
+   Spectra with differences of 31 bits, the most a group can store, are tested on their own.
+
+   Build and run with any C compiler, e.g.
+       cc -O2 -o mk_pack_test mk_pack_test.c mk_pack_reference.c ../Common/mk_pack.c && ./mk_pack_test
+   @return 0 if all spectra agree. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Common/mk_pack.h"
+
+unsigned short ref_mk_compress(long *in, unsigned char *ut, unsigned short size);
+long ref_UnPack(unsigned char *inpek, long kvar, long *ut);
+
+#define MAX_PIXELS 4096
+#define SPECTRUM_NUM 20000
+#define WIDE_SPECTRUM_NUM 200
+
+/* The original codec looks at the value after the last one, which must be zero to not change the result */
+#define PADDING 1
+
+/* Room for the worst case: every value stored with 32 bits in groups of one value */
+#define MAX_COMPRESSED_SIZE (MAX_PIXELS * 6 + 16)
+
+static unsigned long long s_seed = 88172645463325252ULL;
+
+static unsigned long NextRandom(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 7;
+    s_seed ^= s_seed << 17;
+    return (unsigned long)(s_seed >> 16);
+}
+
+/** Fills 'spectrum' with differentiated values, as the spectra are when they are compressed.
+    The kind of spectrum changes with 'round', to cover flat, noisy and saturated spectra. */
+static void MakeSpectrum(long *spectrum, long pixels, int round)
+{
+    /* the largest range keeps the integrated values within 32 bits */
+    static const long ranges[] = { 1, 2, 16, 255, 4096, 65535, 1L << 17, 1L << 18 };
+    const long range = ranges[round % (sizeof(ranges) / sizeof(ranges[0]))];
+    long k;
+
+    for (k = 0; k < pixels; ++k)
+    {
+        switch ((round / 8) % 3)
+        {
+        case 0: /* uniform noise around zero */
+            spectrum[k] = (long)(NextRandom() % (2 * (unsigned long)range + 1)) - range;
+            break;
+        case 1: /* mostly small differences with occasional large steps */
+            spectrum[k] = (NextRandom() % 64 == 0) ? (long)(NextRandom() % (unsigned long)range) - range / 2 : (long)(NextRandom() % 7) - 3;
+            break;
+        default: /* runs of zeros, as from a saturated or dark detector */
+            spectrum[k] = (NextRandom() % 4 == 0) ? (long)(NextRandom() % (unsigned long)range) - range / 2 : 0;
+            break;
+        }
+    }
+}
+
+/** Fills 'spectrum' with differences which need 31 bits each, alternating in sign such that
+    the integrated values stay within 32 bits. The extreme values are included. */
+static void MakeWideSpectrum(long *spectrum, long pixels)
+{
+    long k;
+
+    for (k = 0; k < pixels; ++k)
+    {
+        const long magnitude = (1L << 29) + (long)(NextRandom() % (1UL << 29));
+        switch (k % 4)
+        {
+        case 0: spectrum[k] = (k % 8 == 0) ? (1L << 30) - 1 : magnitude; break;
+        case 1: spectrum[k] = (k % 8 == 1) ? -(1L << 30) : -magnitude; break;
+        case 2: spectrum[k] = magnitude / 2; break;
+        default: spectrum[k] = -(magnitude / 2); break;
+        }
+    }
+}
+
+static long s_spectrum[MAX_PIXELS + PADDING];
+static long s_integrated[MAX_PIXELS];
+static unsigned char s_compressed[MAX_COMPRESSED_SIZE];
+static unsigned char s_referenceCompressed[MAX_COMPRESSED_SIZE];
+static long s_decompressed[MAX_PIXELS + 128];
+static long s_referenceDecompressed[MAX_PIXELS + 128];
+
+/** Compresses and decompresses the first 'pixels' values of s_spectrum with both codecs.
+    @return 0 if the results agree, 1 if they do not. */
+static int CheckSpectrum(long pixels, int round)
+{
+    unsigned short size, referenceSize;
+    long k;
+
+    memset(s_spectrum + pixels, 0, PADDING * sizeof(long));
+
+    s_integrated[0] = s_spectrum[0];
+    for (k = 1; k < pixels; ++k)
+    {
+        s_integrated[k] = s_integrated[k - 1] + s_spectrum[k];
+    }
+
+    memset(s_compressed, 0, sizeof(s_compressed));
+    memset(s_referenceCompressed, 0, sizeof(s_referenceCompressed));
+    size = mk_compress(s_spectrum, s_compressed, (unsigned short)pixels);
+    referenceSize = ref_mk_compress(s_spectrum, s_referenceCompressed, (unsigned short)pixels);
+    if (size != referenceSize || 0 != memcmp(s_compressed, s_referenceCompressed, size))
+    {
+        printf("Spectrum %d (%ld pixels): compressed data differs from the reference\n", round, pixels);
+        return 1;
+    }
+
+    if (pixels != UnPack(s_compressed, pixels, s_decompressed) ||
+        pixels != ref_UnPack(s_compressed, pixels, s_referenceDecompressed))
+    {
+        printf("Spectrum %d (%ld pixels): wrong number of decompressed values\n", round, pixels);
+        return 1;
+    }
+
+    if (0 != memcmp(s_decompressed, s_integrated, pixels * sizeof(long)) ||
+        0 != memcmp(s_referenceDecompressed, s_integrated, pixels * sizeof(long)))
+    {
+        printf("Spectrum %d (%ld pixels): decompressed data differs from the input\n", round, pixels);
+        return 1;
+    }
+
+    /* the checked decompression must give the same values, and must detect that the data is cut short */
+    memset(s_decompressed, 0, sizeof(s_decompressed));
+    if (pixels != UnPackChecked(s_compressed, size, pixels, s_decompressed, pixels) ||
+        0 != memcmp(s_decompressed, s_integrated, pixels * sizeof(long)) ||
+        -1 != UnPackChecked(s_compressed, size - 2, pixels, s_decompressed, pixels) ||
+        -1 != UnPackChecked(s_compressed, size, pixels, s_decompressed, pixels - 1))
+    {
+        printf("Spectrum %d (%ld pixels): checked decompression failed\n", round, pixels);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+    int round;
+
+    for (round = 0; round < SPECTRUM_NUM; ++round)
+    {
+        const long pixels = 1 + (long)(NextRandom() % MAX_PIXELS);
+        MakeSpectrum(s_spectrum, pixels, round);
+        failures += CheckSpectrum(pixels, round);
+    }
+
+    /* differences of 31 bits, which are sign-extended from the highest bit a group can store */
+    for (round = 0; round < WIDE_SPECTRUM_NUM; ++round)
+    {
+        const long pixels = 1 + (long)(NextRandom() % MAX_PIXELS);
+        MakeWideSpectrum(s_spectrum, pixels);
+        failures += CheckSpectrum(pixels, SPECTRUM_NUM + round);
+    }
+
+    /* damaged data consisting of empty groups must not make the checked decompression loop forever */
+    memset(s_compressed, 0, sizeof(s_compressed));
+    if (-1 != UnPackChecked(s_compressed, 64, MAX_PIXELS, s_decompressed, MAX_PIXELS))
+    {
+        printf("Empty groups were not rejected\n");
+        ++failures;
+    }
+
+    printf("%d of %d spectra differ\n", failures, SPECTRUM_NUM + WIDE_SPECTRUM_NUM);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/* Compares the correlation search of the wind-speed evaluation, in WindMeasurement/WindCorrelation.h
+   which CWindSpeedCalculator::CalculateDelay uses, to how it was done before the window sums were
+   reused between the shifts, and times the two. The correlations and shifts must be identical.
+
+   The search over all offsets is done here as in CalculateDelay, which needs MFC.
+   The search as it was before is kept here, with the names prefixed with 'Reference'.
+
+   Build and run with any C++ compiler, e.g.
+       c++ -O2 -Wall -Wextra -o wind_correlation_test wind_correlation_test.cpp && ./wind_correlation_test
+   @return 0 if all the results agree. */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "../WindMeasurement/WindCorrelation.h"
+
+/* The length of the time series, the comparison length and the maximum shift, in samples */
+#define SERIES_LENGTH 3000
+#define COMPARISON_LENGTH 300
+#define MAXIMUM_SHIFT 200
+#define ROUNDS 5
+
+static unsigned long long s_seed = 88172645463325252ULL;
+
+static double NextRandom()
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 7;
+    s_seed ^= s_seed << 17;
+    return (double)(s_seed >> 11) / (double)(1ULL << 53);
+}
+
+/* ---------------- As before the window sums were reused ---------------- */
+
+static double ReferenceCorrelation(const double *x, const double *y, long length)
+{
+    double s_xy = 0, s_x2 = 0, s_x = 0, s_y = 0, s_y2 = 0;
+    double c = 0;
+    double eps = 1e-5;
+
+    if (length <= 0)
+        return 0;
+
+    for (long k = 0; k < length; ++k)
+    {
+        s_xy += x[k] * y[k];
+        s_x2 += x[k] * x[k];
+        s_x += x[k];
+        s_y += y[k];
+        s_y2 += y[k] * y[k];
+    }
+
+    double nom = (length * s_xy - s_x * s_y);
+    double denom = sqrt(((length * s_x2 - s_x * s_x) * (length * s_y2 - s_y * s_y)));
+
+    if ((fabs(nom - denom) < eps) && (fabs(denom) < eps))
+        c = 1.0;
+    else
+        c = nom / denom;
+
+    return c;
+}
+
+static void ReferenceFindBestCorrelation(const double *longVector, unsigned long longLength, const double *shortVector, unsigned long shortLength,
+    unsigned int maximumShift, double &highestCorr, int &bestShift)
+{
+    highestCorr = 0;
+    bestShift = 0;
+    unsigned long left = 0;
+    while ((left + shortLength) < longLength && left < maximumShift)
+    {
+        double C = ReferenceCorrelation(shortVector, longVector + left, (long)shortLength);
+        if (C > highestCorr)
+        {
+            highestCorr = C;
+            bestShift = (int)left;
+        }
+        ++left;
+    }
+}
+
+/* ---------------- The search over all offsets, as in CalculateDelay ---------------- */
+
+struct Result
+{
+    std::vector<double> corr;
+    std::vector<int> shift;
+};
+
+static Result CalculateDelay(const std::vector<double> &upWind, const std::vector<double> &downWind, bool reference)
+{
+    const long length = (long)downWind.size();
+    Result result;
+    result.corr.assign(length, 0.0);
+    result.shift.assign(length, 0);
+
+    std::vector<double> upWindSum, upWindSum2, downWindSum, downWindSum2;
+    if (!reference)
+    {
+        WindSpeedMeasurement::CalculateWindowSums(upWind.data(), (long)upWind.size(), COMPARISON_LENGTH, upWindSum, upWindSum2);
+        WindSpeedMeasurement::CalculateWindowSums(downWind.data(), length, COMPARISON_LENGTH, downWindSum, downWindSum2);
+    }
+
+    for (int offset = 0; offset < length - MAXIMUM_SHIFT - COMPARISON_LENGTH; ++offset)
+    {
+        const double *series1 = upWind.data() + offset;
+        const double *series2 = downWind.data() + offset;
+        const unsigned int series1Length = (unsigned int)upWind.size() - offset;
+        const int midPoint = offset + COMPARISON_LENGTH / 2;
+
+        double highestCorr = 0.0;
+        int bestShift = 0;
+        if (reference)
+        {
+            ReferenceFindBestCorrelation(series1, series1Length, series2, COMPARISON_LENGTH, MAXIMUM_SHIFT, highestCorr, bestShift);
+        }
+        else
+        {
+            WindSpeedMeasurement::FindBestCorrelation(series1, series1Length, upWindSum.data() + offset, upWindSum2.data() + offset,
+                series2, COMPARISON_LENGTH, downWindSum[offset], downWindSum2[offset], MAXIMUM_SHIFT, highestCorr, bestShift);
+        }
+        result.corr[midPoint] = highestCorr;
+        result.shift[midPoint] = bestShift;
+    }
+    return result;
+}
+
+int main()
+{
+    double referenceTime = 0.0;
+    double currentTime = 0.0;
+    int failures = 0;
+
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        /* a plume passing the down wind direction some samples after the up wind direction, with noise */
+        const int delay = 10 + round * 30;
+        std::vector<double> plume(SERIES_LENGTH + delay);
+        double value = 100.0;
+        for (size_t k = 0; k < plume.size(); ++k)
+        {
+            value = std::fabs(value + 20.0 * (NextRandom() - 0.5));
+            plume[k] = value;
+        }
+        std::vector<double> upWind(SERIES_LENGTH), downWind(SERIES_LENGTH);
+        for (int k = 0; k < SERIES_LENGTH; ++k)
+        {
+            downWind[k] = plume[k + delay] + 5.0 * NextRandom();
+            upWind[k] = plume[k] + 5.0 * NextRandom();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        const Result reference = CalculateDelay(upWind, downWind, true);
+        auto middle = std::chrono::steady_clock::now();
+        const Result current = CalculateDelay(upWind, downWind, false);
+        auto stop = std::chrono::steady_clock::now();
+
+        referenceTime += std::chrono::duration<double>(middle - start).count();
+        currentTime += std::chrono::duration<double>(stop - middle).count();
+
+        if (reference.corr != current.corr || reference.shift != current.shift)
+        {
+            printf("Round %d: the correlations or shifts differ from the reference\n", round);
+            ++failures;
+        }
+    }
+
+    printf("%d of %d rounds differ\n", failures, ROUNDS);
+    printf("Before reusing the window sums: %.3f s, now: %.3f s (%d samples, comparison length %d, maximum shift %d, %d rounds)\n",
+        referenceTime, currentTime, SERIES_LENGTH, COMPARISON_LENGTH, MAXIMUM_SHIFT, ROUNDS);
+    return (failures == 0) ? 0 : 1;
+}
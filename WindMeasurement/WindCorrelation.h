@@ -0,0 +1,129 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <vector>
+
+namespace WindSpeedMeasurement{
+
+	/** The correlation calculations used by CWindSpeedCalculator. These depend on nothing but 
+			the standard library, such that Tests/wind_correlation_test.cpp can compile and time them. */
+
+	/** Calculates the correlation between two vectors of length 'length' given the dot-product
+			of the two 's_xy', the sums of their elements 's_x' and 's_y' and the dot-products 
+			of each vector with itself 's_x2' and 's_y2'. */
+	inline double Correlation(long length, double s_xy, double s_x, double s_x2, double s_y, double s_y2){
+		double c		= 0; // <-- the final correlation
+		double eps = 1e-5;
+
+		double nom = (length * s_xy - s_x*s_y);
+		double denom = sqrt(( (length*s_x2 - s_x*s_x) * (length*s_y2 - s_y*s_y) ));
+
+		if((fabs(nom - denom) < eps) && (fabs(denom) < eps))
+				c = 1.0;
+		else
+				c = nom / denom;
+
+		return c;
+	}
+
+	/** Calculates the correlation between the two vectors 'x' and 'y', both of length 'length' 
+			@return - the correlation between the two vectors. */
+	inline double Correlation(const double *x, const double *y, long length){
+		double s_xy = 0; // <-- the dot-product X*Y
+		double s_x2 = 0; // <-- the dot-product X*X
+		double s_x  = 0; // <-- sum of all elements in X
+		double s_y	= 0; // <-- sum of all elements in Y
+		double s_y2 = 0; // <-- the dot-product Y*Y
+
+		if(length <= 0)
+			return 0;
+
+		for(long k = 0; k < length; ++k){
+			s_xy += x[k] * y[k];
+			s_x2 += x[k] * x[k];
+			s_x  += x[k];
+			s_y  += y[k];
+			s_y2 += y[k] * y[k];
+		}
+
+		return Correlation(length, s_xy, s_x, s_x2, s_y, s_y2);
+	}
+
+	/** Calculates the sum, and the sum of the squares, of the 'windowLength' values
+			starting at each position in 'values'. The sums are added up in the same order as
+			in 'Correlation' such that the correlations calculated from them are identical.
+			On return is 'sum' and 'sum2' of length 'length - windowLength + 1'. */
+	inline void CalculateWindowSums(const double *values, long length, long windowLength, std::vector<double> &sum, std::vector<double> &sum2){
+		sum.clear();
+		sum2.clear();
+		if(windowLength <= 0 || length < windowLength)
+			return;
+
+		sum.resize(length - windowLength + 1);
+		sum2.resize(length - windowLength + 1);
+		for(long start = 0; start <= length - windowLength; ++start){
+			double s  = 0; // <-- sum of all elements in the window
+			double s2 = 0; // <-- the dot-product of the window with itself
+			for(long k = start; k < start + windowLength; ++k){
+				s  += values[k];
+				s2 += values[k] * values[k];
+			}
+			sum[start]  = s;
+			sum2[start] = s2;
+		}
+	}
+
+	/** Shifts the vector 'shortVector' against the vector 'longVector' and finds the
+				shift for which the correlation between the two is highest. 
+				The length of the longVector must be larger than the length of the short vector! 
+				@param longWindowSum - the sum of the 'shortLength' values in 'longVector' starting at each position,
+					as calculated by CalculateWindowSums.
+				@param longWindowSum2 - the sum of the squares of the same values.
+				@param shortSum - the sum of the values in 'shortVector'.
+				@param shortSum2 - the sum of the squares of the values in 'shortVector'. 
+				@return false if the input is not valid. */
+	inline bool FindBestCorrelation(
+		const double *longVector, unsigned long longLength, 
+		const double *longWindowSum, const double *longWindowSum2,
+		const double *shortVector, unsigned long shortLength,
+		double shortSum, double shortSum2,
+		unsigned int maximumShift, 
+		double &highestCorr, int &bestShift){
+
+		// 0. Check for errors in the input
+		if(longLength == 0 || shortLength == 0)
+			return false;
+		if(longVector == NULL || shortVector == NULL || longWindowSum == NULL || longWindowSum2 == NULL)
+			return false;
+		if(longLength <= shortLength)
+			return false;
+
+		// Reset
+		highestCorr = 0;
+		bestShift = 0;
+
+		// To calculate the correlation, we need to pick out a subvector (with length 'shortLength)
+		//	from the longVector and compare this with 'shortVector' and calculate the correlation.
+		// left is the startingpoint of this subvector
+		unsigned long left	= 0;
+
+		// 1. Start shifting, only the dot-product between the two vectors
+		//		changes in a way which needs to be recalculated for each shift
+		while((left+shortLength) < longLength && left < maximumShift ){
+			const double *y = longVector + left;
+			double s_xy = 0;
+			for(unsigned long k = 0; k < shortLength; ++k){
+				s_xy += shortVector[k] * y[k];
+			}
+			double C = Correlation((long)shortLength, s_xy, shortSum, shortSum2, longWindowSum[left], longWindowSum2[left]);
+			if(C > highestCorr){
+				highestCorr = C;
+				bestShift		= (int)left;
+			}
+			++left;
+		}
+
+		return true;
+	}
+}
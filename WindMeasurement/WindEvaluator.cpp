@@ -6,6 +6,7 @@
 
 // We must be able to read the evaluation-log files
 #include "../Common/EvaluationLogFileHandler.h"
+#include "../Common/LogTail.h"
 
 // we need the settings for the scanners
 #include "../Configuration/Configuration.h"
@@ -16,6 +17,7 @@
 extern CConfigurationSetting g_settings;	// <-- The settings
 extern CFormView *pView;									// <-- The screen
 extern CMeteorologicalData g_metData;			// <-- The meteorological data
+extern FileHandler::CLogTail g_logTails;		// <-- The evaluation-logs read so far
 
 using namespace WindSpeedMeasurement;
 
@@ -86,11 +88,11 @@ void CWindEvaluator::OnEvaluatedWindMeasurement(WPARAM wp, LPARAM lp){
 	// 4. If this is a wind-measurement made with a Heidelberg instrument, 
 	//		then it does not have to be matched with any other log-file
 	//		the wind-speed can be calculated directly.
-	FileHandler::CEvaluationLogFileHandler reader;
-	reader.m_evaluationLog.Format("%s", (LPCTSTR)fileName);
-	if(SUCCESS != reader.ReadEvaluationLog())
+	//		The log is kept by g_logTails, such that it is not read again when it is correlated below.
+	std::shared_ptr<const FileHandler::CEvaluationLogView> logView = g_logTails.FollowEvaluationLog(fileName);
+	if(logView == nullptr || logView->m_scans.empty())
 		return;
-	const std::string serialNumber = reader.m_scan[0].GetSerial();
+	const std::string serialNumber = logView->m_scans[0]->scan.GetSerial();
 
 	// 5. Find matching evaluation-logs, to make wind-speed measurements
 	CString match[MAX_MATCHING_FILES];
@@ -156,7 +158,7 @@ int	CWindEvaluator::FindMatchingEvalLog(const CString &evalLog, CString match[MA
 		given evaluation-files. */
 RETURN_CODE CWindEvaluator::CalculateCorrelation(const CString &evalLog1, const CString &evalLog2, int volcanoIndex){
 	WindSpeedMeasurement::CWindSpeedCalculator	calc; // <-- The actual calculator
-	FileHandler::CEvaluationLogFileHandler reader[2];
+	std::shared_ptr<const FileHandler::CEvaluationLogView> logView[2];
 	CDateTime startTime_dt, stopTime;
 	CWindField wf;
 	WindSpeedMeasurement::CWindSpeedCalculator::CMeasurementSeries *series[2];
@@ -165,24 +167,23 @@ RETURN_CODE CWindEvaluator::CalculateCorrelation(const CString &evalLog1, const
 	// information about the measurement
 	unsigned short date[3];
 
-	// 1. Read the evaluation-logs
-	reader[0].m_evaluationLog.Format("%s", (LPCTSTR)evalLog1);
-	reader[1].m_evaluationLog.Format("%s", (LPCTSTR)evalLog2);
-	if(SUCCESS != reader[0].ReadEvaluationLog())
-		return FAIL;
-	if(SUCCESS != reader[1].ReadEvaluationLog())
+	// 1. Read the evaluation-logs, only what has been appended since they were last read
+	logView[0] = g_logTails.FollowEvaluationLog(evalLog1);
+	logView[1] = g_logTails.FollowEvaluationLog(evalLog2);
+	if(logView[0] == nullptr || logView[1] == nullptr)
 		return FAIL;
 
 	// 2. Find the wind-speed measurement series in the log-files
 	for(k = 0; k < 2; ++k){
-		for(scanIndex[k] = 0; scanIndex[k] < reader[k].m_scanNum; ++scanIndex[k])
-			if(reader[k].IsWindSpeedMeasurement(scanIndex[k]))
+		const int scanNum = (int)logView[k]->m_scans.size();
+		for(scanIndex[k] = 0; scanIndex[k] < scanNum; ++scanIndex[k])
+			if(logView[k]->m_scans[scanIndex[k]]->scan.IsWindMeasurement())
 				break;
-		if(scanIndex[k] == reader[k].m_scanNum)
+		if(scanIndex[k] == scanNum)
 			return FAIL;		// <-- no wind-speed measurement found
 	}
 	// 2a. Find the start and stop-time of the measurement
-	Evaluation::CScanResult &scan = reader[0].m_scan[scanIndex[0]];
+	const Evaluation::CScanResult &scan = logView[0]->m_scans[scanIndex[0]]->scan;
 	scan.GetStartTime(0, startTime_dt);
 	scan.GetStopTime(scan.GetEvaluatedNum()- 1, stopTime);
 
@@ -194,7 +195,7 @@ RETURN_CODE CWindEvaluator::CalculateCorrelation(const CString &evalLog1, const
 	// 3. Create the wind-speed measurement series
 	for(k = 0; k < 2; ++k){
 		// 3a. The scan we're looking at
-		Evaluation::CScanResult &scan = reader[k].m_scan[scanIndex[k]];
+		const Evaluation::CScanResult &scan = logView[k]->m_scans[scanIndex[k]]->scan;
 
 		// 3b. The start-time of the whole measurement
 		const CDateTime *startTime = scan.GetStartTime(0);
@@ -227,7 +228,7 @@ RETURN_CODE CWindEvaluator::CalculateCorrelation(const CString &evalLog1, const
 		ShowMessage("Failed to correlate time-series, no windspeed could be derived");
 
 		// Tell the world that we've tried to make a correlation calculation but failed
-		Evaluation::CScanResult &scan = reader[0].m_scan[scanIndex[0]];
+		const Evaluation::CScanResult &scan = logView[0]->m_scans[scanIndex[0]]->scan;
 		scan.GetDate(0, date);
 		PostWindMeasurementResult(0, 0, 0, startTime_dt, stopTime, scannerSerialNumber);
 
@@ -244,7 +245,7 @@ RETURN_CODE CWindEvaluator::CalculateCorrelation(const CString &evalLog1, const
 		ShowMessage("Failed to correlate time-series, no windspeed could be derived");
 
 		// Tell the world that we've tried to make a correlation calculation but failed
-		Evaluation::CScanResult &scan = reader[0].m_scan[scanIndex[0]];
+		const Evaluation::CScanResult &scan = logView[0]->m_scans[scanIndex[0]]->scan;
 		scan.GetDate(0, date);
 		PostWindMeasurementResult(0, 0, 0, startTime_dt, stopTime, scannerSerialNumber);
 
@@ -267,7 +268,7 @@ RETURN_CODE CWindEvaluator::CalculateCorrelation(const CString &evalLog1, const
 	}
 
 	// 5. Write the results of our calculations to file
-	WriteWindMeasurementLog(calc, evalLog1, reader[0].m_scan[scanIndex[0]], volcanoIndex);
+	WriteWindMeasurementLog(calc, evalLog1, logView[0]->m_scans[scanIndex[0]]->scan, volcanoIndex);
 
 	// 6. Clean up a little bit.
 	delete series[0];
@@ -123,6 +123,12 @@ RETURN_CODE CWindSpeedCalculator::CalculateDelay(
 	// The number of datapoints skipped because we cannot see the plume.
 	int skipped = 0;
 
+	// 2b. The sums over the up wind series and over the down wind series are the same for
+	//		many of the correlations calculated below, calculate them once here.
+	std::vector<double> upWindSum, upWindSum2, downWindSum, downWindSum2;
+	CalculateWindowSums(modifiedUpWind.column, modifiedUpWind.length, comparisonLength, upWindSum, upWindSum2);
+	CalculateWindowSums(modifiedDownWind.column, modifiedDownWind.length, comparisonLength, downWindSum, downWindSum2);
+
 	// 3. Iterate over the set of sub-arrays in the down-wind data series
 	//		Offset is the starting-point in this sub-array whos length is 'comparisonLength'
 	for(int offset = 0; offset < m_length-(int)maximumShift - comparisonLength; ++offset){
@@ -146,7 +152,11 @@ RETURN_CODE CWindSpeedCalculator::CalculateDelay(
 		}
 
 		// 3d. Do a shifting...
-		FindBestCorrelation(series1, series1Length, series2, series2Length, maximumShift, highestCorr, bestShift);
+		if((long)upWindSum.size() <= offset)
+			continue; // <-- the up wind series is too short
+		FindBestCorrelation(series1, series1Length, upWindSum.data() + offset, upWindSum2.data() + offset, 
+			series2, series2Length, downWindSum[offset], downWindSum2[offset], 
+			maximumShift, highestCorr, bestShift);
 
 		// 3e. Calculate the time-shift
 		delays[midPoint]			= bestShift * sampleInterval;
@@ -234,77 +244,6 @@ RETURN_CODE CWindSpeedCalculator::LowPassFilter(const CMeasurementSeries *series
 	return SUCCESS;
 }
 
-/** Shifts the vector 'shortVector' against the vector 'longVector' and returns the
-			shift for which the correlation between the two is highest. */
-RETURN_CODE CWindSpeedCalculator::FindBestCorrelation(
-	const double *longVector, unsigned long longLength, 
-	const double *shortVector, unsigned long shortLength,
-	unsigned int maximumShift, 
-	double &highestCorr, int &bestShift){
-
-	// 0. Check for errors in the input
-	if(longLength == 0 || shortLength == 0)
-		return FAIL;
-	if(longVector == NULL || shortVector == NULL)
-		return FAIL;
-	if(longLength <= shortLength)
-		return FAIL;
-
-	// Reset
-	highestCorr = 0;
-	bestShift = 0;
-
-	// To calculate the correlation, we need to pick out a subvector (with length 'shortLength)
-	//	from the longVector and compare this with 'shortVector' and calculate the correlation.
-	// left is the startingpoint of this subvector
-	int left	= 0;
-
-	// 1. Start shifting
-	while((left+shortLength) < (int)longLength && left < (int)maximumShift ){
-		double C = correlation(shortVector, longVector + left, shortLength);
-		if(C > highestCorr){
-			highestCorr = C;
-			bestShift		= left;
-		}
-		++left;
-	}
-
-	return SUCCESS;
-}
-
-/** Calculates the correlation between the two vectors 'x' and 'y', both of length 'length' 
-		@return - the correlation between the two vectors. */
-double CWindSpeedCalculator::correlation(const double *x, const double *y, long length){
-	double s_xy = 0; // <-- the dot-product X*Y
-	double s_x2 = 0; // <-- the dot-product X*X
-	double s_x  = 0; // <-- sum of all elements in X
-	double s_y	= 0; // <-- sum of all elements in Y
-	double s_y2 = 0; // <-- the dot-product Y*Y
-	double c		= 0; // <-- the final correlation
-	double eps = 1e-5;
-
-	if(length <= 0)
-		return 0;
-
-	for(int k = 0; k < length; ++k){
-		s_xy += x[k] * y[k];
-		s_x2 += x[k] * x[k];
-		s_x  += x[k];
-		s_y  += y[k];
-		s_y2 += y[k] * y[k];
-	}
-
-	double nom = (length * s_xy - s_x*s_y);
-	double denom = sqrt(( (length*s_x2 - s_x*s_x) * (length*s_y2 - s_y*s_y) ));
-
-	if((fabs(nom - denom) < eps) && (fabs(denom) < eps))
-			c = 1.0;
-	else
-			c = nom / denom;
-	
-	return c;
-}
-
 void CWindSpeedCalculator::InitializeArrays(){
 	delete[]	shift, corr, used, delays;
 	shift				= new double[m_length];
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../Common/Common.h"
+#include <vector>
 #include "windspeedmeassettings.h"
+#include "WindCorrelation.h"
 
 namespace WindSpeedMeasurement{
 
@@ -58,21 +60,5 @@ namespace WindSpeedMeasurement{
 				The number of iterations in the filtering is given by 'nIterations'
 				if nIterations is zero, nothing will be done. */
 		static RETURN_CODE LowPassFilter(const CMeasurementSeries *series, CMeasurementSeries *result, unsigned int nIterations);
-
-	protected:
-
-		/** Shifts the vector 'shortVector' against the vector 'longVector' and returns the
-					shift for which the correlation between the two is highest. 
-					The length of the longVector must be larger than the length of the short vector! */
-		static RETURN_CODE FindBestCorrelation(
-			const double *longVector, unsigned long longLength, 
-			const double *shortVector, unsigned long shortLength,
-			unsigned int maximumShift,
-			double &highestCorr, int &bestShift);
-
-
-		/** Calculates the correlation between the two vectors 'x' and 'y', both of length 'length' 
-				@return - the correlation between the two vectors. */
-		static double	correlation(const double *x, const double *y, long length);
 	};
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "FTPHandler.h"
 #include "SerialControllerWithTx.h"
 #include "NodeControlInfo.h"
+#include <map>
 
 #ifdef _MSC_VER
 // Make sure to use warning level 4
@@ -15,6 +16,7 @@ using namespace Communication;
 #define SMALL_NODE_SUM 5
 
 UINT ConnectBySerialWithTX(LPVOID pParam);
+UINT PollSerialPort(LPVOID pParam);
 UINT ConnectByFTP(LPVOID pParam);
 void Pause(double startTime, double stopTime, int serialID);
 
@@ -37,6 +39,21 @@ bool g_runFlag;
 //	of the file to upload to instrument with mainIndex=i
 CArray <CString, CString &> g_fileToUpload;
 
+namespace
+{
+    /** The instruments which are polled through one serial port, by one thread */
+    struct CSerialPortPolling
+    {
+        Communication::CCommunicationController* mainController = nullptr;
+
+        /** The number of the COM port */
+        int port = 0;
+
+        /** The indices of the instruments in CCommunicationController::m_serialList */
+        std::vector<int> serialIndices;
+    };
+}
+
 CCommunicationController::CCommunicationController()
 {
     //the sum of the serial connections
@@ -368,35 +385,67 @@ void UploadFile_FTP(int mainIndex, CFTPHandler& ftpHandler)
 
 UINT ConnectBySerialWithTX(LPVOID pParam)
 {
-    CString msg, timetxt;
-    long sleepPeriod;
-    int i, j, nRound, mainIndex;
-    CArray <clock_t, clock_t> cStart;
-    CArray <clock_t, clock_t> cPrevStart;
-    cStart.SetSize(SMALL_NODE_SUM);
-    cPrevStart.SetSize(SMALL_NODE_SUM);
-
-    bool allSleep = true;
-
-
     CCommunicationController* mainController = (CCommunicationController*)pParam;
 
     // ------- SETUP THE CONNECTIONS ------------
     mainController->SetupSerialConnections();
 
+    // ------- GROUP THE CONNECTIONS BY SERIAL PORT ------------
+    //  Instruments sharing one port (through a radio modem) must be polled one at a time,
+    //  but every port is polled by its own thread such that a slow link only delays its own instruments.
+    std::map<int, CSerialPortPolling*> ports;
+    for (int i = 0; i < mainController->m_totalSerialConnection; i++)
+    {
+        const int mainIndex = mainController->m_serialList[i]->m_mainIndex;
+        const int port = g_settings.scanner[mainIndex].comm.port;
+
+        CSerialPortPolling*& polling = ports[port];
+        if (polling == nullptr)
+        {
+            polling = new CSerialPortPolling();
+            polling->mainController = mainController;
+            polling->port = port;
+        }
+        polling->serialIndices.push_back(i);
+    }
+
     // --------------- RUNNING ----------------
-    nRound = 0;
+    for (auto& port : ports)
+    {
+        AfxBeginThread(PollSerialPort, port.second, THREAD_PRIORITY_NORMAL, 0, 0, nullptr);
+    }
+
+    return 0;
+}
+
+/** Polls the instruments connected to one serial port.
+*@param pParam - a CSerialPortPolling, which is deleted when the thread quits.
+*/
+UINT PollSerialPort(LPVOID pParam)
+{
+    std::unique_ptr<CSerialPortPolling> polling((CSerialPortPolling*)pParam);
+    CCommunicationController* mainController = polling->mainController;
+
+    const size_t instrumentNum = polling->serialIndices.size();
+
+    CString msg;
+    msg.Format("<COM%d>: polling %d instrument(s)", polling->port, (int)instrumentNum);
+    ShowMessage(msg);
+
+    std::vector<clock_t> cStart(instrumentNum, 0);
+    std::vector<clock_t> cPrevStart(instrumentNum, 0);
+    int nRound = 0;
 
     CSerialControllerWithTx *cable = nullptr;
 
-    while (1)
+    while (g_runFlag)
     {
-        for (j = 0; j < mainController->m_totalSerialConnection; j++)
+        for (size_t j = 0; j < instrumentNum; j++)
         {
-            i = j;
+            const int i = polling->serialIndices[j];
 
             // mainIndex is the connection-ID (instrument-number) that we're currently at...
-            mainIndex = mainController->m_serialList[i]->m_mainIndex;
+            const int mainIndex = mainController->m_serialList[i]->m_mainIndex;
 
             // Get a handle to the serial-controller...
             cable = mainController->m_SerialControllerTx[i];
@@ -406,18 +455,18 @@ UINT ConnectBySerialWithTX(LPVOID pParam)
                 cable->SetModem(g_settings.scanner[mainIndex].comm.radioID);
 
             // Check wheather the scanning instrument is sleeping/should be sleeping
-            cStart.SetAtGrow(i, clock());
-            sleepPeriod = GetSleepTime(g_settings.scanner[mainIndex].comm.sleepTime,
+            cStart[j] = clock();
+            const long sleepPeriod = GetSleepTime(g_settings.scanner[mainIndex].comm.sleepTime,
                 g_settings.scanner[mainIndex].comm.wakeupTime);
 
             // Check if we should go to sleep or not...
             if (sleepPeriod > 0)
             {
                 // Make the instrument go to sleep...
-                if (mainController->m_SerialControllerTx[i]->GoToSleep())
+                if (cable->GoToSleep())
                 {
                     nRound = 0;
-                    mainController->m_serialList[i]->m_sleepFlag = true;
+                    mainController->SetSerialSleeping(i, true);
                 }
                 continue; // continue with the next instrument
             }
@@ -426,16 +475,16 @@ UINT ConnectBySerialWithTX(LPVOID pParam)
                 if (mainController->m_serialList[i]->m_sleepFlag)
                 {
                     cable->WakeUp();
-                    mainController->m_nodeControl->SetNodeStatus(i, DeviceMode::Run);
-                    mainController->m_serialList[i]->m_sleepFlag = false;
+                    mainController->m_nodeControl->SetNodeStatus(mainIndex, DeviceMode::Run);
+                    mainController->SetSerialSleeping(i, false);
                 }
             }
 
             // Ok, we're not sleeping. check if we should upload something to the
             //  instrument...
-            if (mainController->m_nodeControl->GetNodeStatus(i) == DeviceMode::FileUpload)
+            if (mainController->m_nodeControl->GetNodeStatus(mainIndex) == DeviceMode::FileUpload)
             {
-                UploadFile_SerialTx(i, mainController, cable);
+                UploadFile_SerialTx(mainIndex, mainController, cable);
             }
 
             // Download data...
@@ -443,23 +492,23 @@ UINT ConnectBySerialWithTX(LPVOID pParam)
 
             nRound++;
 
-            if (nRound > 0 && mainController->m_nodeControl->GetNodeStatus(i) != DeviceMode::FileUpload)
+            if (nRound > 0 && mainController->m_nodeControl->GetNodeStatus(mainIndex) != DeviceMode::FileUpload)
             {
                 //calculate pause time and pause
-                Pause((double)cPrevStart[i], (double)cStart[i], i);
+                Pause((double)cPrevStart[j], (double)cStart[j], mainIndex);
             }
-            cPrevStart.SetAtGrow(i, cStart[i]);
+            cPrevStart[j] = cStart[j];
         }// end for
 
-        // Check if all instruments are sleeping.
-        allSleep = true;
-        for (i = 0; i < mainController->m_totalSerialConnection; i++)
+        // Check if all instruments on this port are sleeping.
+        bool allSleep = true;
+        for (int i : polling->serialIndices)
         {
             allSleep = allSleep && mainController->m_serialList[i]->m_sleepFlag;
         }
         if (allSleep)
         {
-            mainController->SleepAllNodes(SERIAL_CONNECTION);
+            mainController->SleepUntilWakeUp(polling->serialIndices);
         }
 
         // Go back and check all the instruments again...
@@ -483,37 +532,64 @@ void Pause(double startTime, double stopTime, int serialID)
             Sleep((int)(interval - elapsedTime) * 1000);
     }
 }
-void CCommunicationController::SleepAllNodes(int connectionType)
+
+void CCommunicationController::SetSerialSleeping(int serialIndex, bool sleeping)
 {
-    CString msg;
-    long allSleepPeriod;
-    int i;
-    int sleepPeriodArray[MAX_NUMBER_OF_SCANNING_INSTRUMENTS];
+    std::lock_guard<std::mutex> lock{ m_serialSleepMutex };
 
-    int connectionNumber[3] = { m_totalSerialConnection,m_totalFTPConnection,
-                                                        m_totalHttpConnection };
+    m_serialList[serialIndex]->m_sleepFlag = sleeping;
+    if (!sleeping)
+    {
+        m_allSerialSleepReported = false;
+    }
+}
+
+void CCommunicationController::SleepUntilWakeUp(const std::vector<int>& serialIndices)
+{
+    CString msg;
 
-    //assume all scanners sleep period is same
-    allSleepPeriod = GetSleepTime(g_settings.scanner[0].comm.sleepTime,
-        g_settings.scanner[0].comm.wakeupTime);
-    for (i = 0; i < connectionNumber[connectionType]; i++)
+    // The instrument which wakes up first decides how long to sleep
+    long sleepPeriod = 0;
+    int firstToWakeUp = 0;
+    for (int i : serialIndices)
     {
-        sleepPeriodArray[i] = GetSleepTime(g_settings.scanner[i].comm.sleepTime,
-            g_settings.scanner[i].comm.wakeupTime);
+        const int mainIndex = m_serialList[i]->m_mainIndex;
+        const long period = GetSleepTime(g_settings.scanner[mainIndex].comm.sleepTime,
+            g_settings.scanner[mainIndex].comm.wakeupTime);
 
-        if ((sleepPeriodArray[i] < allSleepPeriod) && (sleepPeriodArray[i] > 0))
-            allSleepPeriod = sleepPeriodArray[i];
+        if (period > 0 && (sleepPeriod == 0 || period < sleepPeriod))
+        {
+            sleepPeriod = period;
+            firstToWakeUp = mainIndex;
+        }
     }
-    if (allSleepPeriod > 0)
+    if (sleepPeriod <= 0)
     {
-        msg.Format("All instruments sleep for %.2lf hours. The scanner will start working at %02d:%02d:%02d ", allSleepPeriod / 3600000.0,
-            g_settings.scanner[0].comm.wakeupTime.hour,
-            g_settings.scanner[0].comm.wakeupTime.minute,
-            g_settings.scanner[0].comm.wakeupTime.second);
-        ShowMessage(msg);
+        return;
+    }
+
+    // Tell the user once when all the instruments have gone to sleep
+    {
+        std::lock_guard<std::mutex> lock{ m_serialSleepMutex };
 
-        Sleep(allSleepPeriod);
+        bool allSleep = true;
+        for (int i = 0; i < m_totalSerialConnection; i++)
+        {
+            allSleep = allSleep && m_serialList[i]->m_sleepFlag;
+        }
+
+        if (allSleep && !m_allSerialSleepReported)
+        {
+            msg.Format("All instruments sleep for %.2lf hours. The scanner will start working at %02d:%02d:%02d ", sleepPeriod / 3600000.0,
+                g_settings.scanner[firstToWakeUp].comm.wakeupTime.hour,
+                g_settings.scanner[firstToWakeUp].comm.wakeupTime.minute,
+                g_settings.scanner[firstToWakeUp].comm.wakeupTime.second);
+            ShowMessage(msg);
+            m_allSerialSleepReported = true;
+        }
     }
+
+    Sleep(sleepPeriod);
 }
 
 void CCommunicationController::SetupSerialConnections()
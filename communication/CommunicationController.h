@@ -1,6 +1,8 @@
 #pragma once
 #include "afxwin.h"
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Communication
 {
@@ -65,7 +67,16 @@ namespace Communication
         /**set parameters for all the serial connections*/
         void SetupSerialConnections();
 
-        void SleepAllNodes(int connectionType);
+        /** Sets if the instrument with the given index in m_serialList is sleeping or not.
+            This is called by the threads polling the serial ports, each of which handles
+            the instruments connected to one port. */
+        void SetSerialSleeping(int serialIndex, bool sleeping);
+
+        /** Called by the thread polling one serial port when all the instruments on that port
+            are sleeping. Waits until the first of these instruments should wake up again.
+            The user is told when all the instruments connected by serial cable are sleeping.
+            @param serialIndices the indices in m_serialList of the instruments on the port. */
+        void SleepUntilWakeUp(const std::vector<int>& serialIndices);
 
         /**start ftp connections for polling scanners*/
         void StartFTP();
@@ -102,5 +113,11 @@ namespace Communication
         //the sum of the http connections
         int m_totalHttpConnection;
 
+        /** Protects the sleep flags in m_serialList, which are set by the threads polling the serial ports */
+        std::mutex m_serialSleepMutex;
+
+        /** True when the user has been told that all the instruments connected by serial cable are sleeping */
+        bool m_allSerialSleepReported = false;
+
     };
 }
\ No newline at end of file
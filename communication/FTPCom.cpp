@@ -194,6 +194,102 @@ bool CFTPCom::DownloadAFile(LPCTSTR remoteFile, LPCTSTR fileFullName)
     return result;
 }
 
+bool CFTPCom::ResumeDownload(LPCTSTR remoteFile, LPCTSTR fileFullName, long restartAt)
+{
+    CString msg;
+
+    // Check that we're connected...
+    if (m_FtpConnection == nullptr) {
+        ShowMessage("ERROR: Attempted to download file using FTP while not connected!");
+        return false;
+    }
+
+    CFile localFile;
+    if (!localFile.Open(fileFullName, CFile::modeCreate | CFile::modeNoTruncate | CFile::modeWrite | CFile::shareDenyWrite | CFile::typeBinary))
+    {
+        msg.Format("Can not open file %s", fileFullName);
+        ShowMessage(msg);
+        return false;
+    }
+
+    CInternetFile* remote = nullptr;
+    try
+    {
+        // Keep only the part of the local file which we continue from
+        localFile.SetLength(restartAt);
+        localFile.SeekToEnd();
+
+        if (restartAt > 0)
+        {
+            CString restCommand;
+            restCommand.Format("REST %ld", restartAt);
+
+            // The server answers 350 if the next transfer can start at the given position
+            if (FtpCommand((HINTERNET)*m_FtpConnection, FALSE, FTP_TRANSFER_TYPE_BINARY, restCommand, 0, nullptr))
+            {
+                msg.Format("Resuming download of %s at byte %ld", remoteFile, restartAt);
+                ShowMessage(msg);
+            }
+            else
+            {
+                msg.Format("%s does not support resuming downloads, downloading all of %s", (LPCSTR)m_FTPSite, remoteFile);
+                ShowMessage(msg);
+                restartAt = 0;
+                localFile.SetLength(0);
+            }
+        }
+        else
+        {
+            msg.Format("Trying to download %s", fileFullName);
+            ShowMessage(msg);
+        }
+
+        remote = m_FtpConnection->OpenFile(remoteFile, GENERIC_READ, FTP_TRANSFER_TYPE_BINARY);
+
+        char buffer[4096];
+        UINT bytesRead;
+        while ((bytesRead = remote->Read(buffer, sizeof(buffer))) > 0)
+        {
+            localFile.Write(buffer, bytesRead);
+        }
+
+        remote->Close();
+        delete remote;
+        localFile.Close();
+
+        msg.Format("Finish downloading %s", fileFullName);
+        ShowMessage(msg);
+        return true;
+    }
+    catch (CInternetException* pEx)
+    {
+        // catch errors from WinINet, the data received so far is kept in the local file
+        TCHAR szErr[255];
+        if (pEx->GetErrorMessage(szErr, 255))
+        {
+            m_ErrorMsg.Format("FTP error happened when downloading %s from %s: %s", fileFullName, (LPCSTR)m_FTPSite, (LPCSTR)szErr);
+            ShowMessage(m_ErrorMsg);
+        }
+        else
+        {
+            m_ErrorMsg.Format("FTP exception");
+            ShowMessage(m_ErrorMsg);
+        }
+        pEx->Delete();
+        delete remote;
+
+        m_FtpConnection = nullptr;
+    }
+    catch (CFileException* pEx)
+    {
+        msg.Format("Error writing to %s when downloading from %s", fileFullName, (LPCSTR)m_FTPSite);
+        ShowMessage(msg);
+        pEx->Delete();
+        delete remote;
+    }
+    return false;
+}
+
 int CFTPCom::UploadFile(LPCTSTR localFile, LPCTSTR remoteFile)
 {
     int result;
@@ -27,6 +27,15 @@ namespace Communication
 
         // ------------------------ Implementation of FTP data upload and download ------------------------
 
+        /** Downloads the remote file into the local file, continuing a download which was interrupted.
+            The first 'restartAt' bytes of the local file are kept and the server is asked (using REST)
+            to send the rest of the file only. If the server does not support this then the whole file is downloaded.
+            The data received is written to the local file as it arrives, such that the local file
+            holds everything received so far also if the transfer is interrupted.
+            @param restartAt The number of bytes of the remote file which are already in the local file.
+            @return true if the transfer was completed. */
+        bool ResumeDownload(LPCTSTR remoteFile, LPCTSTR fileFullName, long restartAt);
+
         /** Sends a local file to the FTP-server, this will skip the upload if the remove file exists.
             @return 0 on success
             @return 1 if the file already exists. */
@@ -137,6 +137,8 @@ bool CFTPHandler::DownloadPakFiles(const CString& folder)
         const CScannerFileInfo& fileInfo = m_fileInfoList.GetTail();
         AppendPakFileExtension(fileInfo.fileName, m_electronicsBox, fileName);
         m_remoteFileSize = fileInfo.fileSize;
+        m_remoteFolder = folder;
+        m_remoteFileTime.Format("%s %s", (LPCSTR)fileInfo.date, (LPCSTR)fileInfo.time);
 
         if ((Equals(fileName, workPak) || Equals(fileName, uploadPak)) && folder.GetLength() == 0)
         {
@@ -261,6 +263,7 @@ bool CFTPHandler::DownloadOldPak(long interval)
 
     pakFileInfo = &m_fileInfoList.GetTail();
     m_remoteFileSize = pakFileInfo->fileSize;
+    m_remoteFileTime.Format("%s %s", (LPCSTR)pakFileInfo->date, (LPCSTR)pakFileInfo->time);
     estimatedTime = (int)((m_remoteFileSize * 1024.0) / m_dataSpeed);
     time(&startTime);
     AppendPakFileExtension(pakFileInfo->fileName, m_electronicsBox, fileFullName);
@@ -522,7 +525,17 @@ bool CFTPHandler::DownloadSpectra(const CString& remoteFile, const CString& save
 
     // Check that the size on disk is same as the size in the remote computer
     if (Common::RetrieveFileSize(m_localFileFullPath) != m_remoteFileSize)
-        return false;
+    {
+        if (!m_resumedDownload)
+            return false;
+
+        // The resumed download does not add up to the remote file, download all of it again.
+        //  There is no partial file left now, so this starts from the beginning.
+        msg.Format("The resumed download of %s has the wrong size. Will download all of it again", (LPCSTR)remoteFile);
+        ShowMessage(msg);
+        if (!DownloadFile(remoteFile, savetoPath) || Common::RetrieveFileSize(m_localFileFullPath) != m_remoteFileSize)
+            return false;
+    }
 
     // Check the contents of the file and make sure it's an ok file
     if (1 == m_pakFileHandler.ReadDownloadedFile(m_localFileFullPath))
@@ -603,6 +616,7 @@ bool CFTPHandler::DownloadFile(const CString &remoteFileName, const CString &sav
 
     // The filename
     fileFullName.Format("%s%s", (LPCSTR)savetoPath, (LPCSTR)remoteFileName);
+    const CString partialFileName = fileFullName + ".part";
 
     //check local file,if a file with same name exists, delete it
     if (IsExistingFile(fileFullName))
@@ -610,6 +624,10 @@ bool CFTPHandler::DownloadFile(const CString &remoteFileName, const CString &sav
         DeleteFile(fileFullName);
     }
 
+    // Continue where an earlier download of the same file was interrupted, if any
+    const long restartAt = GetPartialDownloadSize(remoteFileName, fileFullName);
+    m_resumedDownload = (restartAt > 0);
+
     msg.Format("Begin to download file from %s", (LPCSTR)m_ftpInfo.hostName);
     ShowMessage(msg);
 
@@ -619,10 +637,24 @@ bool CFTPHandler::DownloadFile(const CString &remoteFileName, const CString &sav
     timing_Start = clock(); // <-- timing...
     useHighResolutionCounter = QueryPerformanceCounter(&timingStart);
 
-    if (!DownloadAFile(remoteFileName, fileFullName))
+    // Only the missing part of the file is transferred. The partial file is kept if this fails.
+    if (restartAt == 0 || restartAt < m_remoteFileSize)
     {
+        if (!ResumeDownload(remoteFileName, partialFileName, restartAt))
+        {
+            return false;
+        }
+    }
+
+    // The transfer is complete, from now on the file is checked as a whole
+    if (!MoveFileEx(partialFileName, fileFullName, MOVEFILE_REPLACE_EXISTING))
+    {
+        msg.Format("Could not rename %s to %s", (LPCSTR)partialFileName, (LPCSTR)fileFullName);
+        ShowMessage(msg);
+        DiscardPartialDownload(fileFullName);
         return false;
     }
+    DiscardPartialDownload(fileFullName);
 
     // Timing...
     useHighResolutionCounter = QueryPerformanceCounter(&timingStop);
@@ -633,10 +665,11 @@ bool CFTPHandler::DownloadFile(const CString &remoteFileName, const CString &sav
     double elapsedTime = max(1.0 / clocksPerSec, (double)(timing_Stop - timing_Start) / clocksPerSec);
     double elapsedTime2 = ((double)timingStop.LowPart - (double)timingStart.LowPart) / (double)lpFrequency.LowPart;
 
+    const long bytesTransferred = max(m_remoteFileSize - restartAt, 1L);
     if (useHighResolutionCounter)
-        m_dataSpeed = m_remoteFileSize / (elapsedTime * 1024.0);
+        m_dataSpeed = bytesTransferred / (elapsedTime * 1024.0);
     else
-        m_dataSpeed = m_remoteFileSize / (elapsedTime2 * 1024.0);
+        m_dataSpeed = bytesTransferred / (elapsedTime2 * 1024.0);
 
     m_statusMsg.Format("Finished downloading file %s from %s @ %.1lf kb/s", (LPCSTR)fileFullName, (LPCSTR)m_spectrometerSerialID, m_dataSpeed);
     ShowMessage(m_statusMsg);
@@ -644,6 +677,57 @@ bool CFTPHandler::DownloadFile(const CString &remoteFileName, const CString &sav
     return true;
 }
 
+long CFTPHandler::GetPartialDownloadSize(const CString& remoteFileName, const CString& fileFullName)
+{
+    CString partialFileName = fileFullName + ".part";
+    const CString stateFileName = fileFullName + ".partinfo";
+
+    // Identifies the remote file, the partial file is only continued if this has not changed
+    CString remoteFileId;
+    remoteFileId.Format("%s\t%s\t%s\t%ld\t%s", (LPCSTR)m_ftpInfo.hostName, (LPCSTR)m_remoteFolder, (LPCSTR)remoteFileName, m_remoteFileSize, (LPCSTR)m_remoteFileTime);
+
+    if (IsExistingFile(partialFileName))
+    {
+        CString savedFileId;
+        FILE* f = fopen(stateFileName, "r");
+        if (f != nullptr)
+        {
+            char buffer[1024];
+            if (nullptr != fgets(buffer, sizeof(buffer), f))
+            {
+                buffer[strcspn(buffer, "\r\n")] = 0;
+                savedFileId = buffer;
+            }
+            fclose(f);
+        }
+
+        const long partialSize = Common::RetrieveFileSize(partialFileName);
+        if (savedFileId == remoteFileId && partialSize > 0 && partialSize <= m_remoteFileSize)
+        {
+            return partialSize;
+        }
+
+        // The partial file belongs to another file, or to an earlier version of this file
+        DeleteFile(partialFileName);
+    }
+
+    // Start a new download, remember which file it is
+    FILE* f = fopen(stateFileName, "w");
+    if (f != nullptr)
+    {
+        fprintf(f, "%s\n", (LPCSTR)remoteFileId);
+        fclose(f);
+    }
+
+    return 0;
+}
+
+void CFTPHandler::DiscardPartialDownload(const CString& fileFullName)
+{
+    DeleteFile(fileFullName + ".part");
+    DeleteFile(fileFullName + ".partinfo");
+}
+
 bool CFTPHandler::MakeCommandFile(char* cmdString)
 {
     CString fileName;
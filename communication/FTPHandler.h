@@ -67,7 +67,10 @@ namespace Communication
 
         // --------------- DOWNLOADING OF THE SPECTRA ---------------------
 
-        /** Download a file in the remote computer */
+        /** Download a file in the remote computer.
+            The file is first downloaded to a partial file, '.part', next to the local file. If the download
+            is interrupted then the partial file is kept and the next download of the same remote file
+            continues from where this one stopped. */
         bool DownloadFile(const CString &remoteFileName, const CString &savetoPath);
 
         /**download upload.pak, Uxxx.pak files and evaluate*/
@@ -157,5 +160,25 @@ namespace Communication
 
         /** speed to download file, in kilo-bytes/second*/
         double m_dataSpeed;
+
+        /** The folder of the remote file being downloaded, empty for the root folder */
+        CString m_remoteFolder;
+
+        /** The date and time of the remote file being downloaded, as listed by the instrument */
+        CString m_remoteFileTime;
+
+    private:
+
+        /** True if the last call to DownloadFile continued an earlier, interrupted, download */
+        bool m_resumedDownload = false;
+
+        /** Finds the partial file of an earlier download of the current remote file, if there is one.
+            The partial file is only continued if the state file saved with it shows that it belongs to
+            the same remote file (host, folder, name, size and time), otherwise it is removed.
+            @return the number of bytes already downloaded, zero if the download should start from the beginning. */
+        long GetPartialDownloadSize(const CString& remoteFileName, const CString& fileFullName);
+
+        /** Removes the partial file of the given local file, and its state file */
+        static void DiscardPartialDownload(const CString& fileFullName);
     };
 }
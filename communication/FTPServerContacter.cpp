@@ -33,17 +33,23 @@ CFTPServerContacter::CFTPServerContacter()
 {
     m_listLogFile.Format("%s\\Temp\\UploadFileList.txt", (LPCSTR)g_settings.outputDirectory);
     m_listLogFile_Temp.Format("%s\\Temp\\UploadFileList_Temp.txt", (LPCSTR)g_settings.outputDirectory);
+    m_journalFile.Format("%s\\Temp\\UploadJournal.txt", (LPCSTR)g_settings.outputDirectory);
+    m_journalFile_Temp.Format("%s\\Temp\\UploadJournal_Temp.txt", (LPCSTR)g_settings.outputDirectory);
 
     m_nTimerID = 0;
     m_hasReadInFileList = false;
-    time(&m_lastExportTime);
 }
 
 CFTPServerContacter::~CFTPServerContacter()
 {
     m_ftp.reset();
 
-    ExportList();
+    CompactJournal();
+    if (m_journal != nullptr)
+    {
+        fclose(m_journal);
+        m_journal = nullptr;
+    }
 }
 
 /** Quits the thread */
@@ -53,23 +59,13 @@ void CFTPServerContacter::OnQuit(WPARAM /*wp*/, LPARAM /*lp*/)
     //Close ftp connection
     m_ftp.reset();
 
-    ExportList();
+    CompactJournal();
 }
 
-/**When the thread is started, copy the UploadFileList.txt's content into m_fileList*/
+/**When the thread is started, restore the queue of files to upload*/
 void CFTPServerContacter::OnStartFTP(WPARAM /*wp*/, LPARAM /*lp*/)
 {
-    if (!IsExistingFile(m_listLogFile)) {
-        // If we have a temporary-file, then parse that instead
-        if (IsExistingFile(m_listLogFile_Temp)) {
-            ParseAFile(m_listLogFile_Temp);
-        }
-        m_hasReadInFileList = true;
-        return;
-    }
-    ParseAFile(m_listLogFile);
-
-    m_hasReadInFileList = true;
+    ReadQueue();
 }
 
 void CFTPServerContacter::OnTimer(UINT /*nIDEvent*/, LPARAM /*lp*/) {
@@ -98,29 +94,8 @@ void CFTPServerContacter::OnArrivedFile(WPARAM wp, LPARAM lp)
         return; // quit, error in input-data
     }
 
-    // Check if the file already exists in the list, if so then don't add it
-    POSITION listPos = m_fileList.GetHeadPosition();
-    while (listPos != nullptr) {
-        UploadFile &f = m_fileList.GetNext(listPos);
-
-        if (Equals(f.fileName, *fileName) && (f.volcanoIndex == volcanoIndex)) {
-            delete fileName;
-            delete options;
-            return; // don't add the file to the list
-        }
-    }
-
-    // A new UploadFile - struct
-    UploadFile file;
-    file.fileName.Format(*fileName);
-    file.volcanoIndex = volcanoIndex;
-    file.deleteFile = options->deleteFile;
-
-    //add the file name to the file list
-    m_fileList.AddTail(file);
-
-    // Save the list to be sure we don't loose anything
-    ExportList();
+    // Add the file to the queue, unless it is already there. This is saved in the journal to be sure we don't loose anything
+    QueueFile(*fileName, volcanoIndex, options->deleteFile, true);
 
     // Reset the string and the options structure to avoid memory leaks
     delete fileName;
@@ -128,22 +103,15 @@ void CFTPServerContacter::OnArrivedFile(WPARAM wp, LPARAM lp)
 }
 
 BOOL CFTPServerContacter::OnIdle(LONG /*lCount*/) {
-    CString localFile, remoteFile, volcano, message;
-    CString dateText, timeText;
+    CString volcano, message, dateText;
     double linkSpeed;
-    int ret = 0;
-
-    // High resolution counter
-    LARGE_INTEGER lpFrequency, timingStart, timingStop;
-    BOOL useHighResolutionCounter = QueryPerformanceFrequency(&lpFrequency);
-
-    // Low resolution counter, used as a backup
-    clock_t timing_Stop, timing_Start; // <-- timing of the upload speed
 
     if (m_fileList.GetCount() == 0)
     {
         if (m_hasReadInFileList) {
-            DeleteFile(m_listLogFile);
+            if (m_journalRecords > 0) {
+                CompactJournal(); // removes the journal
+            }
             return FALSE; // don't need more idle time
         }
         else {
@@ -186,118 +154,132 @@ BOOL CFTPServerContacter::OnIdle(LONG /*lCount*/) {
 
     if (m_ftp->Connect(g_settings.ftpSetting.ftpAddress, g_settings.ftpSetting.userName, g_settings.ftpSetting.password, 60, TRUE) == 1)
     {
+        const int parallelUploads = max(1, g_settings.ftpSetting.parallelUploads);
+        const int batchSize = 4 * parallelUploads;
+
+        // The files are uploaded to the directory volcanoName/yyyy.mm.dd
+        Common::GetDateText(dateText);
+
+        // The copies of the files which may be changed while they are uploaded are made here
+        CString snapshotDirectory;
+        snapshotDirectory.Format("%sTemp\\UploadCopies\\", (LPCSTR)g_settings.outputDirectory);
+        CreateDirectoryStructure(snapshotDirectory);
+
         while (m_fileList.GetCount() > 0)
         {
-            // The file to upload
-            UploadFile &upload = m_fileList.GetTail();
+            // Collect the next batch of files to upload, starting with the latest
+            std::vector<IFTPDataUpload::UploadRequest> batch;
+            std::vector<POSITION> batchPositions;
+            std::vector<double> fileSizes_kB;
+            bool failedCopy = false;
+            POSITION listPos = m_fileList.GetTailPosition();
+            while (listPos != nullptr && (int)batch.size() < batchSize)
+            {
+                POSITION filePos = listPos;
+                UploadFile &upload = m_fileList.GetPrev(listPos);
 
-            // The name of the file to upload
-            localFile.Format("%s", (LPCSTR)upload.fileName);
+                // Make sure that the file does exist...
+                if (!IsExistingFile(upload.fileName)) {
+                    DequeueFile(filePos);
+                    continue;
+                }
 
-            // Make sure that the file does exist...
-            if (!IsExistingFile(localFile)) {
-                m_fileList.RemoveTail();
-                continue;
-            }
+                // The name of the volcano
+                if (upload.volcanoIndex >= 0 && upload.volcanoIndex < (int)g_volcanoes.m_volcanoNum) {
+                    volcano.Format("%s", (LPCSTR)g_volcanoes.m_simpleName[upload.volcanoIndex]);
+                }
+                else {
+                    volcano.Format("unknown");
+                }
 
-            // The name of the volcano
-            if (upload.volcanoIndex >= 0 && upload.volcanoIndex < g_volcanoes.m_volcanoNum) {
-                volcano.Format("%s", (LPCSTR)g_volcanoes.m_simpleName[upload.volcanoIndex]);
-            }
-            else {
-                volcano.Format("unknown");
-            }
+                IFTPDataUpload::UploadRequest request;
+                request.localFile = upload.fileName;
+                if (!upload.deleteFile) {
+                    // The file may still be appended to, e.g. an evaluation log. Upload a copy of it
+                    //  such that the file is only locked while it is copied and not during the upload.
+                    CString name = upload.fileName;
+                    Common::GetFileName(name);
+                    request.localFile.Format("%s%d_%s", (LPCSTR)snapshotDirectory, (int)batch.size(), (LPCSTR)name);
+                    CSingleLock singleLock(&g_evalLogCritSect, TRUE);
+                    if (!CopyFile(upload.fileName, request.localFile, FALSE)) {
+                        failedCopy = true;
+                        continue; // try again later
+                    }
+                }
+                request.remoteDirectory.Format("%s/%s", (LPCSTR)volcano, (LPCSTR)dateText);
 
-            // Change the current directory on the FTP-Server
-            SetRemoteDirectory(volcano);
+                // The name of the file on the remote ftp-server
+                request.remoteFile = upload.fileName;
+                Common::GetFileName(request.remoteFile);
 
-            // The name of the file on the remote ftp-server
-            remoteFile.Format("%s", (LPCSTR)upload.fileName);
-            Common::GetFileName(remoteFile);
+                batch.push_back(request);
+                batchPositions.push_back(filePos);
 
-            // Get the size of the file, to be able to calculate the size of the link
-            const double fileSize_kB = Common::RetrieveFileSize(localFile) / 1024.0;
+                // Get the size of the file, to be able to calculate the size of the link
+                fileSizes_kB.push_back(Common::RetrieveFileSize(upload.fileName) / 1024.0);
+            }
+            if (batch.empty()) {
+                if (failedCopy) {
+                    break; // only files which could not be copied are left, try again later
+                }
+                continue;
+            }
 
-            // Make sure that no-one else is trying to access this file...
-            CSingleLock singleLock(&g_evalLogCritSect);
-            singleLock.Lock();
+            m_ftp->UploadFiles(batch, parallelUploads);
 
-            if (singleLock.IsLocked()) {
-                // Upload the file!
-                timing_Start = clock(); // <-- timing...
-                useHighResolutionCounter = QueryPerformanceCounter(&timingStart);
-                ret = m_ftp->UpdateRemoteFile(localFile, remoteFile);
+            // The copies are not needed any more
+            for (size_t k = 0; k < batch.size(); ++k)
+            {
+                if (!m_fileList.GetAt(batchPositions[k]).deleteFile) {
+                    ::DeleteFile(batch[k].localFile);
+                }
             }
 
-            singleLock.Unlock();
-
-            if (ret != 0)
+            // Handle the result of each upload. The uploaded files are removed from the queue, and from the journal.
+            bool failedUpload = false;
+            for (size_t k = 0; k < batch.size(); ++k)
             {
-                useHighResolutionCounter = QueryPerformanceCounter(&timingStop);
-                timing_Stop = clock();
+                const IFTPDataUpload::UploadRequest &request = batch[k];
+                if (!request.succeeded) {
+                    // Failed to upload the file, or it was not tried...
+                    if (request.errorMessage.GetLength() > 0) {
+                        ShowMessage(request.errorMessage);
+                        m_linkStatistics.AppendFailedUpload();
+                    }
+                    failedUpload = true;
+                    continue;
+                }
 
                 // Remember the speed of the upload
-                double clocksPerSec = CLOCKS_PER_SEC;
-                double elapsedTime = max(1.0 / clocksPerSec, (double)(timing_Stop - timing_Start) / clocksPerSec);
-                double elapsedTime2 = ((double)timingStop.LowPart - (double)timingStart.LowPart) / (double)lpFrequency.LowPart;
-
-                if (useHighResolutionCounter)
-                    linkSpeed = fileSize_kB / elapsedTime;
-                else
-                    linkSpeed = fileSize_kB / elapsedTime2;
-
+                linkSpeed = fileSizes_kB[k] / max(0.001, request.elapsedTime);
                 m_linkStatistics.AppendDownloadSpeed(linkSpeed);
 
                 // The file is uploaded!!
-                if (upload.deleteFile) {
-                    ::DeleteFile(localFile);
+                if (m_fileList.GetAt(batchPositions[k]).deleteFile) {
+                    ::DeleteFile(m_fileList.GetAt(batchPositions[k]).fileName);
                 }
                 // remove the file from the list
-                m_fileList.RemoveTail();
+                DequeueFile(batchPositions[k]);
 
                 // Tell the world!
-                message.Format("Finished uploading file %s to FTP-Server @ %.1lf kB/s", (LPCSTR)remoteFile, linkSpeed);
+                message.Format("Finished uploading file %s to FTP-Server @ %.1lf kB/s", (LPCSTR)request.remoteFile, linkSpeed);
                 ShowMessage(message);
 
                 pView->PostMessage(WM_FINISH_UPLOAD, (WPARAM)linkSpeed);
             }
-            else {
-                // Failed to upload the file...
-                ShowMessage(m_ftp->m_ErrorMsg);
-                m_linkStatistics.AppendFailedUpload();
-                break;
-            }
 
-            // Go to the directory two steps up
-            m_ftp->SetCurDirectory("..");
-            m_ftp->SetCurDirectory("..");
+            if (failedUpload) {
+                break; // try again later
+            }
         }
         m_ftp->Disconnect();
 
-        ExportList(); //export file list to log file UploadFileList.txt
+        CompactJournalIfNeeded();
     }
 
     return 0; // no more time is needed
 }
 
-void CFTPServerContacter::SetRemoteDirectory(const CString &volcanoName)
-{
-    CString dateText;
-    Common::GetDateText(dateText);
-
-    // The directory on the remote server
-    CString rootDirectory;
-    rootDirectory.Format("%s", (LPCSTR)volcanoName);
-
-    // Create the volcano-directory and set it as the current directory
-    m_ftp->CreateDirectory(rootDirectory);
-    m_ftp->SetCurDirectory(rootDirectory);
-
-    // Create the date sub-directory and set it as the current directory
-    m_ftp->CreateDirectory(dateText);
-    m_ftp->SetCurDirectory(dateText);
-}
-
 BOOL CFTPServerContacter::InitInstance() {
     CWinThread::InitInstance();
 
@@ -321,10 +303,7 @@ bool CFTPServerContacter::ParseAFile(const CString& fileName)
 {
     CStdioFile fileRef;
     CFileException exceFile;
-    CString line, token;
-    int lastVolcanoIndex = -1;
-    bool duplicates = false; // true if there are duplicates in the list...
-
+    CString line;
 
     if (!fileRef.Open(fileName, CFile::modeRead | CFile::typeText, &exceFile))
     {
@@ -337,156 +316,249 @@ bool CFTPServerContacter::ParseAFile(const CString& fileName)
 
     while (fileRef.ReadString(line))
     {
-        char* szToken = (char*)(LPCSTR)line;
-
-        while (szToken = strtok(szToken, "\n"))
-        {
-            CString fileName, volcanoName;
-            int			volcanoIndex, deleteFile;
-
-            // find the tab which separates the file-name and the volcano index
-            char *pt = strstr(szToken, "\t");
-            if (pt != 0) {
-                volcanoIndex = -1; // reset
-
-                pt[0] = 0; // remove the tab
-                fileName.Format("%s", szToken);
-
-                // The rest of the string is; 
-                // 1) the volcano-name, either as an index (old) or as a string (new)...
-                // 2) the 'deleteFlag'
-                volcanoName.Format("%s", pt + 1);
-                int tabIndex = volcanoName.Find("\t");
-                if (-1 != tabIndex) {
-                    volcanoName = volcanoName.Left(tabIndex);
-
-                    // First compare with the last volcano-index, to save some time...
-                    if (lastVolcanoIndex >= 0 && Equals(g_volcanoes.m_simpleName[lastVolcanoIndex], volcanoName)) {
-                        volcanoIndex = lastVolcanoIndex;
-                    }
-                    else {
-                        for (unsigned int k = 0; k < g_volcanoes.m_volcanoNum; ++k) {
-                            if (Equals(volcanoName, g_volcanoes.m_simpleName[k])) {
-                                volcanoIndex = k;
-                                lastVolcanoIndex = k;
-                                break;
-                            }
-                        }
-                    }
-
-                    if (0 == sscanf(pt + 1 + tabIndex, "%d", &deleteFile)) {
-                        deleteFile = 0;
-                    }
-                }
-
-                if (volcanoIndex == -1) {
-                    if (0 == sscanf(pt + 1, "%d\t", &volcanoIndex)) {
-                        volcanoIndex = -1;
-                        deleteFile = 0;
-                    }
+        CString uploadFileName;
+        int volcanoIndex = -1;
+        int deleteFile = 0;
+
+        // find the tab which separates the file-name and the volcano
+        int tabIndex = line.Find('\t');
+        if (tabIndex < 0) {
+            uploadFileName = line;
+        }
+        else {
+            uploadFileName = line.Left(tabIndex);
+
+            // The rest of the string is; 
+            // 1) the volcano-name, either as an index (old) or as a string (new)...
+            // 2) the 'deleteFlag'
+            CString rest = line.Mid(tabIndex + 1);
+            tabIndex = rest.Find('\t');
+            if (-1 != tabIndex) {
+                volcanoIndex = VolcanoIndex(rest.Left(tabIndex));
+                if (0 == sscanf((LPCSTR)rest + tabIndex + 1, "%d", &deleteFile)) {
+                    deleteFile = 0;
                 }
             }
-            else {
-                fileName.Format(szToken);
+            if (volcanoIndex == -1 && 0 == sscanf((LPCSTR)rest, "%d", &volcanoIndex)) {
                 volcanoIndex = -1;
-                deleteFile = 0;
-            }
-
-            // Check if the file already exists in the list, if so then don't add it
-            bool isAlreadyInList = false;
-            POSITION listPos = m_fileList.GetHeadPosition();
-            while (listPos != nullptr) {
-                UploadFile &f = m_fileList.GetNext(listPos);
-                if (Equals(f.fileName, fileName)) {
-                    // don't add this to the list
-                    isAlreadyInList = true;
-                    duplicates = true;
-                    break;
-                }
-            }
-
-            // Add the file to the list of files, if not already there...
-            if (!isAlreadyInList) {
-                UploadFile upload;
-                upload.fileName.Format(fileName);
-                upload.volcanoIndex = volcanoIndex;
-                upload.deleteFile = (deleteFile == 1) ? true : false;
-                m_fileList.AddTail(upload);
             }
+        }
 
-            // init to get next token
-            szToken = nullptr;
+        if (uploadFileName.GetLength() > 0) {
+            QueueFile(uploadFileName, volcanoIndex, deleteFile == 1, false);
         }
     }
     fileRef.Close();
 
-    // If there were duplicates in the file, then write it again now without duplicated
-    if (duplicates) {
-        ExportList();
-    }
-
     // Restore the priority of this thread. 
     SetThreadPriority(THREAD_PRIORITY_ABOVE_NORMAL);
 
     return true;
 }
 
-void CFTPServerContacter::ExportList()
+bool CFTPServerContacter::QueueFile(const CString& fileName, int volcanoIndex, bool deleteFile, bool writeToJournal)
 {
-    POSITION	listPos;
-    CString line;
-    int nLines = 0;
-    time_t now;
-
-    time(&now);
-    double timeSinceLastExport = difftime(now, m_lastExportTime);
-    m_lastExportTime = now;
-    if (timeSinceLastExport < 10) {
-        return; // <-- no need to update the file within less than 10 seconds
+    const std::string key = QueueKey(fileName, volcanoIndex);
+    if (m_queueIndex.find(key) != m_queueIndex.end()) {
+        return false; // already in the queue
     }
 
-    if (m_fileList.GetCount() == 0)
-    {
-        if (!m_hasReadInFileList) {
-            ParseAFile(m_listLogFile_Temp);
-        }
-        else {
-            DeleteFile(m_listLogFile);
-        }
+    UploadFile file;
+    file.fileName = fileName;
+    file.volcanoIndex = volcanoIndex;
+    file.deleteFile = deleteFile;
+
+    m_queueIndex[key] = m_fileList.AddTail(file);
+
+    if (writeToJournal) {
+        AppendToJournal('+', file);
+    }
+    return true;
+}
+
+void CFTPServerContacter::DequeueFile(POSITION listPos)
+{
+    if (listPos == nullptr) {
         return;
     }
 
-    //write log file into output directory \\temp\\fileList_temp.txt
-    FILE *f = fopen(m_listLogFile_Temp, "w");
-    if (f != nullptr) {
-        listPos = m_fileList.GetHeadPosition();
-        while (listPos != nullptr)
-        {
-            UploadFile &upload = m_fileList.GetNext(listPos);
+    const UploadFile& file = m_fileList.GetAt(listPos);
+    AppendToJournal('-', file);
+    m_queueIndex.erase(QueueKey(file.fileName, file.volcanoIndex));
+    m_fileList.RemoveAt(listPos);
+}
+
+void CFTPServerContacter::ReadQueue()
+{
+    // The file-list written by earlier versions of the program
+    if (IsExistingFile(m_listLogFile)) {
+        ParseAFile(m_listLogFile);
+    }
+    else if (IsExistingFile(m_listLogFile_Temp)) {
+        ParseAFile(m_listLogFile_Temp);
+    }
+
+    ReplayJournal(m_journalFile);
+    m_hasReadInFileList = true;
+
+    // Start over with a journal holding only the files still queued, this replaces the old file-list
+    CompactJournal();
+    DeleteFile(m_listLogFile);
+    DeleteFile(m_listLogFile_Temp);
+}
 
-            // Write to file only every 50 lines, to create fewer writing events
-            if (nLines == 0) {
-                line.Format("%s\t%s\t%d\n", (LPCSTR)upload.fileName, (LPCSTR)g_volcanoes.m_simpleName[upload.volcanoIndex], upload.deleteFile);
-                ++nLines;
+bool CFTPServerContacter::ReplayJournal(const CString& fileName)
+{
+    // The journal may be open for appending, if files have arrived before the queue was read
+    if (m_journal != nullptr) {
+        fflush(m_journal);
+    }
+
+    FILE* f = fopen(fileName, "r");
+    if (f == nullptr) {
+        return false; // no journal, nothing to upload
+    }
+
+    // Each record is one line: the operation ('+' or '-'), the file-name, the volcano and the 'deleteFlag', separated by tabs.
+    //  A line which was not completely written when the program stopped is ignored.
+    char buffer[4096];
+    long records = 0;
+    while (nullptr != fgets(buffer, sizeof(buffer), f))
+    {
+        const size_t length = strcspn(buffer, "\r\n");
+        if (buffer[length] == 0) {
+            continue; // incomplete line
+        }
+        buffer[length] = 0;
+        ++records;
+
+        char* fields[4] = { buffer, nullptr, nullptr, nullptr };
+        for (int k = 1; k < 4; ++k) {
+            char* separator = strchr(fields[k - 1], '\t');
+            if (separator == nullptr) {
+                break;
             }
-            else {
-                line.AppendFormat("%s\t%s\t%d\n", (LPCSTR)upload.fileName, (LPCSTR)g_volcanoes.m_simpleName[upload.volcanoIndex], upload.deleteFile);
-                ++nLines;
-                if (nLines == 50) {
-                    fprintf(f, "%s", (LPCSTR)line);
-                    nLines = 0;
-                }
+            *separator = 0;
+            fields[k] = separator + 1;
+        }
+        if (fields[2] == nullptr) {
+            continue;
+        }
+
+        const CString file(fields[1]);
+        const CString volcanoName(fields[2]);
+        int volcanoIndex = VolcanoIndex(volcanoName);
+        if (volcanoIndex == -1 && 0 == sscanf(fields[2], "%d", &volcanoIndex)) {
+            volcanoIndex = -1;
+        }
+
+        if (fields[0][0] == '+') {
+            QueueFile(file, volcanoIndex, fields[3] != nullptr && atoi(fields[3]) == 1, false);
+        }
+        else if (fields[0][0] == '-') {
+            auto entry = m_queueIndex.find(QueueKey(file, volcanoIndex));
+            if (entry != m_queueIndex.end()) {
+                m_fileList.RemoveAt(entry->second);
+                m_queueIndex.erase(entry);
             }
         }
-        if (nLines) {
-            fprintf(f, "%s", (LPCSTR)line); // <-- write the last portion of the file
+    }
+    fclose(f);
+
+    m_journalRecords += records;
+    return true;
+}
+
+void CFTPServerContacter::CompactJournal()
+{
+    if (!m_hasReadInFileList) {
+        return; // the journal has not been read yet, rewriting it now would loose its contents
+    }
+
+    if (m_journal != nullptr) {
+        fclose(m_journal);
+        m_journal = nullptr;
+    }
+
+    if (m_fileList.GetCount() == 0) {
+        DeleteFile(m_journalFile);
+        m_journalRecords = 0;
+        return;
+    }
+
+    // Write the files still queued to a temporary file and move it in place of the journal,
+    //  such that there always is a complete journal on disk
+    FILE* f = fopen(m_journalFile_Temp, "w");
+    if (f == nullptr) {
+        return;
+    }
+
+    long records = 0;
+    POSITION listPos = m_fileList.GetHeadPosition();
+    while (listPos != nullptr) {
+        const UploadFile& upload = m_fileList.GetNext(listPos);
+        fprintf(f, "+\t%s\t%s\t%d\n", (LPCSTR)upload.fileName, (LPCSTR)VolcanoName(upload.volcanoIndex), upload.deleteFile);
+        ++records;
+    }
+    fclose(f);
+
+    if (MoveFileEx(m_journalFile_Temp, m_journalFile, MOVEFILE_REPLACE_EXISTING)) {
+        m_journalRecords = records;
+    }
+}
+
+void CFTPServerContacter::CompactJournalIfNeeded()
+{
+    // Compact when most of the records are of files which have already been uploaded
+    if (m_journalRecords > 1000 && m_journalRecords > 2 * m_fileList.GetCount()) {
+        CompactJournal();
+    }
+}
+
+void CFTPServerContacter::AppendToJournal(char operation, const UploadFile& file)
+{
+    if (m_journal == nullptr) {
+        m_journal = fopen(m_journalFile, "a");
+        if (m_journal == nullptr) {
+            return;
         }
-        fclose(f);
     }
 
-    // Delete the old file-list and move the new one to it's place
-    //	(move the file fileList_temp.txt to fileList.txt)
-    DeleteFile(m_listLogFile);
-    MoveFile(m_listLogFile_Temp, m_listLogFile);
+    if (operation == '+') {
+        fprintf(m_journal, "+\t%s\t%s\t%d\n", (LPCSTR)file.fileName, (LPCSTR)VolcanoName(file.volcanoIndex), file.deleteFile);
+    }
+    else {
+        fprintf(m_journal, "%c\t%s\t%s\n", operation, (LPCSTR)file.fileName, (LPCSTR)VolcanoName(file.volcanoIndex));
+    }
+    fflush(m_journal);
+    ++m_journalRecords;
+}
+
+std::string CFTPServerContacter::QueueKey(const CString& fileName, int volcanoIndex)
+{
+    CString key;
+    key.Format("%s\t%d", (LPCSTR)fileName, volcanoIndex);
+    key.MakeLower();
+    return std::string((LPCSTR)key);
+}
+
+CString CFTPServerContacter::VolcanoName(int volcanoIndex)
+{
+    if (volcanoIndex >= 0 && volcanoIndex < (int)g_volcanoes.m_volcanoNum) {
+        return g_volcanoes.m_simpleName[volcanoIndex];
+    }
+
+    CString name;
+    name.Format("%d", volcanoIndex);
+    return name;
 }
 
+int CFTPServerContacter::VolcanoIndex(const CString& volcanoName)
+{
+    for (unsigned int k = 0; k < g_volcanoes.m_volcanoNum; ++k) {
+        if (Equals(volcanoName, g_volcanoes.m_simpleName[k])) {
+            return (int)k;
+        }
+    }
+    return -1;
+}
@@ -2,6 +2,8 @@
 
 #include <afxtempl.h>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "../Common/Common.h"
 #include "LinkStatistics.h"
@@ -16,7 +18,12 @@ namespace Communication
 
     /** The class CFTPServerContacter is responsible for the uploading of
             spectra and results to the data-server. 
-        This is designed as a soliton class and there must be only one instance of this class running. */
+        This is designed as a soliton class and there must be only one instance of this class running.
+
+        The files waiting to be uploaded are kept in a queue, with an index to quickly find out
+        if a file is already queued. Every file added to or removed from the queue is recorded
+        in a journal on disk, such that the queue can be restored when the program is started again.
+        The journal is rewritten with only the files still queued when it has grown large. */
 
     class CFTPServerContacter : public CWinThread
     {
@@ -54,14 +61,29 @@ namespace Communication
         /** Called when there's nothing else to do. */
         virtual BOOL OnIdle(LONG lCount);
 
-        /**set the current directory to volcanoName\yyyy.mm.dd*/
-        void SetRemoteDirectory(const CString &volcanoName);
-
-        /**parse a file by \n, fill in m_fileList*/
+        /** Parses a file-list written by earlier versions of the program (UploadFileList.txt),
+            adding the files to the queue. */
         bool ParseAFile(const CString& fileName);
 
-        /**export the  file list to UploadFileList.txt*/
-        void ExportList();
+        /** Adds a file to the upload queue, unless it is already queued for the same volcano.
+            @param writeToJournal True if the addition should be recorded in the journal.
+            @return true if the file was added. */
+        bool QueueFile(const CString& fileName, int volcanoIndex, bool deleteFile, bool writeToJournal);
+
+        /** Removes the file at the given position in m_fileList from the queue, and records this in the journal */
+        void DequeueFile(POSITION listPos);
+
+        /** Restores the queue from the journal, and from the file-list of earlier versions of the program */
+        void ReadQueue();
+
+        /** Replays the journal in the given file, filling in m_fileList */
+        bool ReplayJournal(const CString& fileName);
+
+        /** Rewrites the journal with only the files which are still queued */
+        void CompactJournal();
+
+        /** Compacts the journal if it has grown much larger than the queue */
+        void CompactJournalIfNeeded();
 
         // ----------------------------------------------------------------------
         // --------------------- PUBLIC VARIABLES --------------------------------
@@ -79,10 +101,14 @@ namespace Communication
         /** Error message */
         CString m_ErrorMsg;
 
-        /** log file (with path) to record file list */
+        /** The file-list (with path) written by earlier versions of the program */
         CString m_listLogFile;
         CString m_listLogFile_Temp;
 
+        /** The journal (with path) of the upload queue */
+        CString m_journalFile;
+        CString m_journalFile_Temp;
+
         /** The ftp-communciation handler */
         std::unique_ptr<IFTPDataUpload> m_ftp;
 
@@ -93,11 +119,31 @@ namespace Communication
                 old list of files to upload. */
         bool m_hasReadInFileList;
 
-        /** The time of the last exporting of the file-list. This is
-                to prevent the program from writing too often to disk. */
-        time_t m_lastExportTime;
-
         /** The statistics of the upload-link */
         CLinkStatistics	m_linkStatistics;
+
+    private:
+
+        /** The position in m_fileList of each queued file, the key is given by QueueKey() */
+        std::unordered_map<std::string, POSITION> m_queueIndex;
+
+        /** The journal, opened for appending. Null until the first record is written. */
+        FILE* m_journal = nullptr;
+
+        /** The number of records in the journal */
+        long m_journalRecords = 0;
+
+        /** Appends one record to the journal.
+            @param operation '+' when the file is added to the queue, '-' when it is removed. */
+        void AppendToJournal(char operation, const UploadFile& file);
+
+        /** @return the key of the given file in m_queueIndex */
+        static std::string QueueKey(const CString& fileName, int volcanoIndex);
+
+        /** @return the name of the volcano with the given index, as written to the journal */
+        static CString VolcanoName(int volcanoIndex);
+
+        /** @return the index of the volcano with the given name, as written to the journal, or -1 if not found */
+        static int VolcanoIndex(const CString& volcanoName);
     };
 }
\ No newline at end of file
@@ -646,7 +646,6 @@ int CFTPSocket::DownloadFile(CString remoteFileName,CString localFileName)
 	DWORD bytesWritten;
 	int bytesRecv;
 	long errorNum;
-	DWORD lastBytesWritten;
 	// check file existence in remote ftp server  - to be done
 	if(!OpenFileHandle(localFileName))
 		return -1;
@@ -656,14 +655,19 @@ int CFTPSocket::DownloadFile(CString remoteFileName,CString localFileName)
 	SendCommand("TYPE","I");
 	
 	if(!EnterPassiveMode())
+	{
+		CloseHandle(m_hDownloadedFile);
 		return 0;
+	}
 	
 	SendCommand("RETR",remoteFileName);
 	//check file existence
 	ReadResponse();
 	if(!IsFTPCommandDone())
+	{
+		CloseHandle(m_hDownloadedFile);
 		return 0;
-	lastBytesWritten = 0;
+	}
 	do
 	{
 		bytesRecv = recv( m_dataSocket, buf, DOWNLOAD_BUF_SIZE, 0 );
@@ -675,17 +679,15 @@ int CFTPSocket::DownloadFile(CString remoteFileName,CString localFileName)
 		else
 		{
 			fileSize+= bytesRecv;
-			WriteFile(m_hDownloadedFile,buf + lastBytesWritten,bytesRecv,&bytesWritten,NULL);
-			lastBytesWritten = bytesWritten;
+			WriteFile(m_hDownloadedFile,buf,bytesRecv,&bytesWritten,NULL);
 		}
-	}while( bytesRecv!= 0 ) ;
+	}while( bytesRecv > 0 ) ;
 
 	CloseHandle(m_hDownloadedFile);  //close the downloaded file handle so that it can be used.
 	if ( bytesRecv == SOCKET_ERROR )
 	{
-		m_msg.Format("recv failed: %d ", WSAGetLastError());
-		ShowMessage(m_msg);  // for test
-		CloseHandle(m_hDownloadedFile);
+		m_msg.Format("recv failed: %ld, %ld bytes received", errorNum, fileSize);
+		ShowMessage(m_msg);
 		return -1;
 	}
 	//show time duration
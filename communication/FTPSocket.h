@@ -140,8 +140,17 @@ namespace Communication
 		*/
 		bool IsFTPCommandDone();
 		
+		/**Download a file from the current directory of the FTP server
+		*@remoteFileName - the remote file name
+		*@localFileName - the local file, the data is written to it as it arrives
+		*return 1 if the whole file was received
+		*return 0 if the transfer could not be started
+		*return -1 if the local file could not be opened or the transfer was interrupted,
+		*	the local file then holds the data received so far
+		*/
 		int DownloadFile(CString remoteFileName,CString localFileName);
 		
+		/**Open the local file to download to, any earlier contents are discarded */
 		bool OpenFileHandle(CString& fileName);
 		
 		/**Makes the given directory to be the current directory in the FTP server
@@ -19,4 +19,47 @@ namespace Communication
         }
         return result;
     }
+
+    void IFTPDataUpload::UploadFiles(std::vector<UploadRequest>& files, int /*maxParallelTransfers*/)
+    {
+        CString currentDirectory = "";
+        int currentDepth = 0;
+
+        for (UploadRequest& upload : files)
+        {
+            // Change the current directory, if this file goes to another directory than the last one
+            if (!Equals(upload.remoteDirectory, currentDirectory))
+            {
+                for (; currentDepth > 0; --currentDepth)
+                {
+                    SetCurDirectory("..");
+                }
+
+                int position = 0;
+                CString level = upload.remoteDirectory.Tokenize("/", position);
+                while (level.GetLength() > 0)
+                {
+                    CreateDirectory(level);
+                    SetCurDirectory(level);
+                    ++currentDepth;
+                    level = upload.remoteDirectory.Tokenize("/", position);
+                }
+                currentDirectory = upload.remoteDirectory;
+            }
+
+            const clock_t start = clock();
+            upload.succeeded = (0 != UpdateRemoteFile(upload.localFile, upload.remoteFile));
+            upload.elapsedTime = max(1.0, (double)(clock() - start)) / CLOCKS_PER_SEC;
+
+            if (!upload.succeeded)
+            {
+                upload.errorMessage.Format("Failed to upload file %s: %s", (LPCSTR)upload.localFile, (LPCSTR)m_ErrorMsg);
+            }
+        }
+
+        for (; currentDepth > 0; --currentDepth)
+        {
+            SetCurDirectory("..");
+        }
+    }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 namespace Communication
 {
@@ -49,5 +50,26 @@ namespace Communication
         virtual bool SetCurDirectory(CString curDirName) = 0;
 
         virtual int CreateDirectory(LPCTSTR remoteDirectory) = 0;
+
+        /** One file to upload with UploadFiles */
+        struct UploadRequest
+        {
+            CString localFile;          // the local file to read the data from, this must be the full path
+            CString remoteDirectory;    // the directory on the server, relative to the top directory, with the levels separated by '/'
+            CString remoteFile;         // the file name of the remote file, not including any path
+
+            bool    succeeded = false;  // set by UploadFiles, true if the file was uploaded
+            double  elapsedTime = 0.0;  // set by UploadFiles, the time the upload took in seconds
+            CString errorMessage;       // set by UploadFiles if the upload failed
+        };
+
+        /** Uploads a batch of files to the server, any existing remote files are overwritten.
+            The remote directories are created as needed. The result of each upload is filled in.
+            This implementation uploads one file at a time, starting from the top directory.
+            A file which fails to upload does not stop the upload of the remaining files,
+            the error message of each failed file tells which file it was.
+            @param maxParallelTransfers The largest number of files to upload at the same time,
+                if the implementation is able to upload more than one file at a time. */
+        virtual void UploadFiles(std::vector<UploadRequest>& files, int maxParallelTransfers);
     };
 }
\ No newline at end of file
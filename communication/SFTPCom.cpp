@@ -2,6 +2,8 @@
 #include "SFTPCom.h"
 #include "../Common/common.h"
 #include <curl/curl.h>
+#include <algorithm>
+#include <set>
 #include <sstream>
 #include <assert.h>
 
@@ -60,12 +62,17 @@ namespace Communication
         SftpConnection()
         {
             this->curlHandle = curl_easy_init();
+            this->multiHandle = curl_multi_init();
         }
 
         ~SftpConnection()
         {
             curl_easy_cleanup(curlHandle);
             curlHandle = nullptr;
+
+            // this closes the connections kept open by the uploads
+            curl_multi_cleanup(multiHandle);
+            multiHandle = nullptr;
         }
 
         // This object manages a connection and is thus not trivially copyable
@@ -73,6 +80,12 @@ namespace Communication
         SftpConnection& operator=(const SftpConnection&) = delete;
 
         CURL *curlHandle = nullptr;
+
+        /** The handle used by UploadFiles, this keeps the connections to the server open between the uploads */
+        CURLM *multiHandle = nullptr;
+
+        /** The remote directories which are known to exist, these don't have to be created again */
+        std::set<std::string> createdDirectories;
     };
 
     CSFTPCom::CSFTPCom()
@@ -96,68 +109,82 @@ namespace Communication
         }
         m_FtpConnection = new SftpConnection();
 
+        m_userName = userName;
+        m_password = password;
+        m_timeout = (long)timeout;
+
+        if (!SetConnectionOptions(m_FtpConnection->curlHandle, true))
+        {
+            return 0;
+        }
+
+        {
+            std::stringstream site;
+            char *urlEscapedPwd = curl_easy_escape(m_FtpConnection->curlHandle, password, strlen(password));
+            // site << "sftp://" << userName << ":" << urlEscapedPwd << "@" << siteName;
+            site << "sftp://" << siteName;
+            m_site = site.str();
+
+            curl_free(urlEscapedPwd);
+        }
+
+        return 1;
+    }
+
+    bool CSFTPCom::SetConnectionOptions(void* curlHandle, bool createMissingDirectories)
+    {
         CURLcode returnCode;
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_USERNAME, (const char*)userName);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_USERNAME, m_userName.c_str());
         assert(returnCode == CURLE_OK);
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_PASSWORD, (const char*)password);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_PASSWORD, m_password.c_str());
         assert(returnCode == CURLE_OK);
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_FTP_CREATE_MISSING_DIRS, CURLFTP_CREATE_DIR_RETRY);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_FTP_CREATE_MISSING_DIRS, createMissingDirectories ? CURLFTP_CREATE_DIR_RETRY : CURLFTP_CREATE_DIR_NONE);
         if (returnCode != CURLE_OK) {
             m_ErrorMsg.Format("Failed to set directory flag: %s", curl_easy_strerror(returnCode));
-            return 0;
+            return false;
         }
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_FTP_RESPONSE_TIMEOUT, (long)timeout);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_FTP_RESPONSE_TIMEOUT, m_timeout);
         if (returnCode != CURLE_OK) {
             m_ErrorMsg.Format("Failed to set timeout: %s", curl_easy_strerror(returnCode));
-            return 0;
+            return false;
         }
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_PORT, 22);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_PORT, 22);
         if (returnCode != CURLE_OK) {
             m_ErrorMsg.Format("Failed to set port: %s", curl_easy_strerror(returnCode));
-            return 0;
+            return false;
         }
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_PROTOCOLS, CURLPROTO_SFTP);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_PROTOCOLS, CURLPROTO_SFTP);
         if (returnCode != CURLE_OK) {
             m_ErrorMsg.Format("Failed to set SFTP-protocol: %s", curl_easy_strerror(returnCode));
-            return 0;
+            return false;
         }
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_SSH_AUTH_TYPES, CURLSSH_AUTH_PASSWORD);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_SSH_AUTH_TYPES, CURLSSH_AUTH_PASSWORD);
         if (returnCode != CURLE_OK) {
             m_ErrorMsg.Format("Failed to enable password authentication: %s", curl_easy_strerror(returnCode));
-            return 0;
+            return false;
         }
 
         /* Switch on full protocol/debug output */
 #ifdef DEBUG
         // enable progress report function
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_NOPROGRESS, FALSE);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_NOPROGRESS, FALSE);
         assert(returnCode == CURLE_OK);
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_XFERINFOFUNCTION, libcurl_transfer_progress_callback);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_XFERINFOFUNCTION, libcurl_transfer_progress_callback);
         assert(returnCode == CURLE_OK);
 
-        returnCode = curl_easy_setopt(m_FtpConnection->curlHandle, CURLOPT_VERBOSE, 1L);
+        returnCode = curl_easy_setopt(curlHandle, CURLOPT_VERBOSE, 1L);
         assert(returnCode == CURLE_OK);
 #endif
 
-        {
-            std::stringstream site;
-            char *urlEscapedPwd = curl_easy_escape(m_FtpConnection->curlHandle, password, strlen(password));
-            // site << "sftp://" << userName << ":" << urlEscapedPwd << "@" << siteName;
-            site << "sftp://" << siteName;
-            m_site = site.str();
-
-            curl_free(urlEscapedPwd);
-        }
-
-        return 1;
+        return true;
     }
 
     int CSFTPCom::Disconnect()
@@ -249,6 +276,196 @@ namespace Communication
         }
     }
 
+    void CSFTPCom::UploadFiles(std::vector<UploadRequest>& files, int maxParallelTransfers)
+    {
+        if (nullptr == m_FtpConnection || nullptr == m_FtpConnection->multiHandle)
+        {
+            ShowMessage("ERROR: Attempted to upload files using SFTP while not connected!");
+            return;
+        }
+        maxParallelTransfers = std::max(1, maxParallelTransfers);
+
+        CURLM* multiHandle = m_FtpConnection->multiHandle;
+        std::set<std::string>& createdDirectories = m_FtpConnection->createdDirectories;
+
+        // keep one connection open for each of the parallel uploads, such that they are reused by the following uploads
+        curl_multi_setopt(multiHandle, CURLMOPT_MAXCONNECTS, (long)maxParallelTransfers);
+        curl_multi_setopt(multiHandle, CURLMOPT_MAX_HOST_CONNECTIONS, (long)maxParallelTransfers);
+
+        // One upload in progress
+        struct Transfer
+        {
+            CURL* handle = nullptr;
+            FILE* file = nullptr;
+            size_t fileIndex = 0;
+            bool createsDirectory = false;
+        };
+        std::vector<Transfer> transfers(maxParallelTransfers);
+        std::vector<Transfer*> idleTransfers;
+        for (Transfer& transfer : transfers)
+        {
+            idleTransfers.push_back(&transfer);
+        }
+
+        std::vector<bool> started(files.size(), false);
+        std::set<std::string> directoriesBeingCreated;
+        size_t firstNotStarted = 0;
+
+        // Starts the next file which can be started, returns false if there is none
+        auto startNextUpload = [&]() -> bool
+        {
+            while (firstNotStarted < files.size() && started[firstNotStarted])
+            {
+                ++firstNotStarted;
+            }
+
+            for (size_t k = firstNotStarted; k < files.size(); ++k)
+            {
+                if (started[k])
+                {
+                    continue;
+                }
+
+                UploadRequest& upload = files[k];
+                CString directory = upload.remoteDirectory;
+                directory.Trim("/");
+                const std::string directoryName((LPCSTR)directory);
+
+                // wait until the upload which creates the directory is done
+                const bool directoryExists = directory.GetLength() == 0 || createdDirectories.find(directoryName) != createdDirectories.end();
+                if (!directoryExists && directoriesBeingCreated.find(directoryName) != directoriesBeingCreated.end())
+                {
+                    continue;
+                }
+
+                started[k] = true;
+
+                Transfer* transfer = idleTransfers.back();
+                transfer->fileIndex = k;
+                transfer->createsDirectory = !directoryExists;
+                transfer->file = fopen(upload.localFile, "rb");
+                if (nullptr == transfer->file)
+                {
+                    upload.errorMessage.Format("Failed to upload file '%s'. Cannot open file for reading", (LPCSTR)upload.localFile);
+                    continue;
+                }
+
+                if (nullptr == transfer->handle)
+                {
+                    transfer->handle = curl_easy_init();
+                }
+
+                CString remoteUrl;
+                if (directory.GetLength() > 0)
+                {
+                    remoteUrl.Format("%s/%s/%s", m_site.c_str(), (LPCSTR)directory, (LPCSTR)upload.remoteFile);
+                }
+                else
+                {
+                    remoteUrl.Format("%s/%s", m_site.c_str(), (LPCSTR)upload.remoteFile);
+                }
+
+                if (!SetConnectionOptions(transfer->handle, transfer->createsDirectory) ||
+                    CURLE_OK != curl_easy_setopt(transfer->handle, CURLOPT_UPLOAD, 1L) ||
+                    CURLE_OK != curl_easy_setopt(transfer->handle, CURLOPT_URL, (const char*)remoteUrl) ||
+                    CURLE_OK != curl_easy_setopt(transfer->handle, CURLOPT_READFUNCTION, readfunc) ||
+                    CURLE_OK != curl_easy_setopt(transfer->handle, CURLOPT_READDATA, transfer->file) ||
+                    CURLE_OK != curl_easy_setopt(transfer->handle, CURLOPT_PRIVATE, (void*)transfer) ||
+                    CURLM_OK != curl_multi_add_handle(multiHandle, transfer->handle))
+                {
+                    upload.errorMessage.Format("Error while uploading, failed to set up the upload of '%s'", (LPCSTR)upload.localFile);
+                    fclose(transfer->file);
+                    transfer->file = nullptr;
+                    continue;
+                }
+
+                if (transfer->createsDirectory)
+                {
+                    directoriesBeingCreated.insert(directoryName);
+                }
+                idleTransfers.pop_back();
+                return true;
+            }
+            return false;
+        };
+
+        int runningTransfers = 0;
+        do
+        {
+            while (!idleTransfers.empty() && startNextUpload())
+            {
+                ++runningTransfers;
+            }
+
+            int stillRunning = 0;
+            if (CURLM_OK != curl_multi_perform(multiHandle, &stillRunning))
+            {
+                break;
+            }
+
+            // Collect the uploads which are done
+            int messagesLeft = 0;
+            CURLMsg* message = nullptr;
+            while (nullptr != (message = curl_multi_info_read(multiHandle, &messagesLeft)))
+            {
+                if (message->msg != CURLMSG_DONE)
+                {
+                    continue;
+                }
+
+                Transfer* transfer = nullptr;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char**)&transfer);
+                const CURLcode result = message->data.result;
+                curl_multi_remove_handle(multiHandle, message->easy_handle);
+
+                fclose(transfer->file);
+                transfer->file = nullptr;
+
+                UploadRequest& upload = files[transfer->fileIndex];
+                upload.succeeded = (result == CURLE_OK);
+                curl_easy_getinfo(transfer->handle, CURLINFO_TOTAL_TIME, &upload.elapsedTime);
+                if (!upload.succeeded)
+                {
+                    upload.errorMessage.Format("Error while uploading, failed to upload file: %s", curl_easy_strerror(result));
+                }
+
+                if (transfer->createsDirectory)
+                {
+                    CString directory = upload.remoteDirectory;
+                    directory.Trim("/");
+                    directoriesBeingCreated.erase(std::string((LPCSTR)directory));
+                    if (upload.succeeded)
+                    {
+                        createdDirectories.insert(std::string((LPCSTR)directory));
+                    }
+                }
+
+                idleTransfers.push_back(transfer);
+                --runningTransfers;
+            }
+
+            if (runningTransfers > 0)
+            {
+                curl_multi_wait(multiHandle, nullptr, 0, 1000, nullptr);
+            }
+        } while (runningTransfers > 0 || firstNotStarted < files.size());
+
+        // Clean up, after an error in curl_multi_perform there may still be uploads in progress
+        for (Transfer& transfer : transfers)
+        {
+            if (nullptr != transfer.file)
+            {
+                curl_multi_remove_handle(multiHandle, transfer.handle);
+                fclose(transfer.file);
+                files[transfer.fileIndex].errorMessage = "Error while uploading, the upload was interrupted";
+            }
+            if (nullptr != transfer.handle)
+            {
+                curl_easy_cleanup(transfer.handle);
+            }
+        }
+    }
+
     int CSFTPCom::UploadFile(LPCTSTR localFile, LPCTSTR remoteFile)
     {
         // Check the size of the file on the remote server. This returns -1 if the file doesn't exist.
@@ -2,6 +2,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 #include "IFTPDataUpload.h"
 
 namespace Communication
@@ -25,6 +26,11 @@ namespace Communication
 
         virtual bool DownloadAFile(LPCTSTR remoteFile, LPCTSTR fileFullName) override;
 
+        /** Uploads the files using the libcurl multi interface, with up to 'maxParallelTransfers' uploads
+            running at the same time. The connections to the server are kept open and reused by the following
+            uploads, also in later batches, until Disconnect() is called. The missing directories are created
+            by the first upload to each directory, the other uploads to the same directory wait until this is done. */
+        virtual void UploadFiles(std::vector<UploadRequest>& files, int maxParallelTransfers) override;
 
         // ------------------------ Implementation of SFTP data upload ------------------------
 
@@ -58,6 +64,15 @@ namespace Communication
         /** The path to the SFTP-site, this will also hold the username and password... */
         std::string m_site;
 
+        /** The login, used for each of the connections made by UploadFiles */
+        std::string m_userName;
+        std::string m_password;
+        long m_timeout = 60;
+
+        /** Sets the login and protocol options on the given handle.
+            @return false, and sets m_ErrorMsg, if any option could not be set. */
+        bool SetConnectionOptions(void* curlHandle, bool createMissingDirectories);
+
         /** Uploads a file.
             @param localFile the full filename and path of the local file.
             @param remoteFile the filename (excluding path) of the remote file.
@@ -87,6 +87,7 @@ void CSerialControllerWithTx::SetSerialPort(int serialID,int COMPort,int baudrat
 	m_connectionID.Format("Serial %d",m_mainIndex);
 	m_spectrometerSerialNumber.Format("%s", (LPCSTR)g_settings.scanner[m_mainIndex].spec[0].serialNumber);
 	m_timeout  = g_settings.scanner[m_mainIndex].comm.timeout;
+	m_pipelinedTransfer = (0 != g_settings.scanner[m_mainIndex].comm.pipelinedDownload);
 	m_interval = g_settings.scanner[m_mainIndex].comm.queryPeriod;
 	
 	// Make one directory for each instrument...
@@ -240,13 +241,9 @@ RETURN_CODE CSerialControllerWithTx::GetFile(char* fileName,CString filePath,cha
 	}else{
 		maxchunk = 8192;
 	}
-	long tmp;
-	unsigned char *mem,ok;
-	unsigned long size,retries, sendlen,start,rstart;
-	unsigned short rlen, chksum1,chksum2; 
-	time_t startTime,stopTime;
-	CString timeTxt;
-	double downloadedSize;
+	unsigned char *mem;
+	unsigned long size,start;
+	time_t startTime;
 	char fullfileName[64];
 	//set the name of the file which will be downloaded
 	if(diskName=='A' && m_electronicsBox != BOX_VERSION_2)
@@ -259,7 +256,6 @@ RETURN_CODE CSerialControllerWithTx::GetFile(char* fileName,CString filePath,cha
 	// The number of downloaded chunks, used to calculate the average speed
 	int nChunks			= 0;
 	m_avgDownloadSpeed	= 0;
-	double curSpeed		= 0.0;
 
 	time(&startTime);
 
@@ -298,129 +294,258 @@ RETURN_CODE CSerialControllerWithTx::GetFile(char* fileName,CString filePath,cha
 		ShowMessage("Could not allocate memory to save file"); 
 		return FAIL; 
 	}
-	retries=0;
 
-	//---- loop to download data -----//
-	for(start=0;start<size;)
+	//---- download the data -----//
+	start = 0;
+	RETURN_CODE result = FAIL;
+	if(m_pipelinedTransfer)
+	{
+		result = GetFileData_Pipelined(mem, size, maxchunk, start, startTime, nChunks);
+	}
+	if(!m_pipelinedTransfer)
+	{
+		// the instrument cannot handle several requests at a time, continue with one chunk at a time
+		result = GetFileData_StopAndWait(mem, size, maxchunk, start, startTime, nChunks);
+	}
+	if(result != SUCCESS)
+	{
+		free(mem);
+		m_linkStatistics.AppendFailedDownload();
+		return FAIL;
+	}
+	//---- end of the download -----// 
+	WriteSpectraFile(mem,size,filePath);
+	free(mem);
+
+	// Calculate the average download speed
+	m_avgDownloadSpeed /= nChunks;
+
+	// Remember the link-speed
+	m_linkStatistics.AppendDownloadSpeed(m_avgDownloadSpeed);
+
+	return SUCCESS;
+}
+
+RETURN_CODE CSerialControllerWithTx::GetFileData_StopAndWait(unsigned char *mem, unsigned long size, unsigned long maxchunk, unsigned long &start, time_t startTime, int &nChunks)
+{
+	unsigned long retries = 0, sendlen;
+
+	for(;start<size;)
 	{
 	//send start point and data block size to remote PC
 		sendlen = size-start;
 		if(sendlen > maxchunk) 
 			sendlen = maxchunk;
-		rlen = sendlen;
 
 		FlushSerialPort(100); 
-		SendCommand(TX_GET);
-		if(!WriteSerial(&start,4))
-			ShowMessage("Serial communication may be broken, please check");
-		if(!WriteSerial(&rlen,2))
-			ShowMessage("Serial communication may be broken, please check");
-
-		rstart = rlen = 0;
-		ok = 1;
-		//FlushSerialPort(1);
-		// check remote PC's reply
-		if(GetSerialData(&rstart,4,m_timeout)!=4) 
-		{
-			ShowMessage("No rstart"); 
-			ok=0; 
-		}
-		else if(GetSerialData(&rlen,2,m_timeout)!=2) 
-		{
-			ShowMessage("No rlen"); 
-			ok=0; 
-		}
-		else
-		{
-			tmp=GetSerialData(&mem[start],sendlen,m_timeout);//100);
-			if(tmp!=sendlen)
-			{
-				ok=0;
-				m_ErrorMsg.Format("get data size %d", tmp);
-				ShowMessage(m_ErrorMsg);
-			}
-			else if(GetSerialData(&chksum1,2,m_timeout)!=2)
-			{ 
-				ShowMessage("No checksum"); 
-				ok=0; 
-			}
-		}
-		if(start!=rstart)
-		{
-			m_ErrorMsg.Format("Start does not match requested %d!= %d",start,rstart);
-			ShowMessage(m_ErrorMsg);
-			ok=0;
-		}
-		if(rlen!=sendlen)
-		{ 
-			m_ErrorMsg.Format("Length does not match requested %d!= %d",rlen,sendlen);
-			ShowMessage(m_ErrorMsg);
-			ok=0; 
-		}
+		RequestChunk(start, (unsigned short)sendlen);
+
 		// Resyncronize communication when error happens, max 5 times
-		if(!ok)
+		if(!ReceiveChunk(mem, start, (unsigned short)sendlen))
 		{
 			retries++;
 			if(retries==5)
 			{
-				/*if(Resync()== SUCCESS)
-				{
-					SetName(fullfileName);
-					retries=0;
-				}
-				else*///get out of loop 2007.5.14
-
-				m_linkStatistics.AppendFailedDownload();
 				return FAIL;	//get out of loop 2007.4.30
 			}
 		}
 		else
 		{
-			m_ErrorMsg.Format("start=%d len=%d ",rstart,rlen);
-			UpdateMessage(m_ErrorMsg);
-			// compare checksum to check data validity
-			chksum2=CalcChecksum(sendlen,&mem[start]);
-			if(chksum1!=chksum2)
-			{ 
-				m_ErrorMsg.Format("Checksum not correct 0x%0x!=0x%0x",chksum1,chksum2);
-				ShowMessage(m_ErrorMsg);
-				ok=0; 
-			}
 			// No error in data transfer
-			if(ok)
-			{
-				start+=sendlen;
-				time(&stopTime);
-				
-				m_common.GetDateTimeText(timeTxt);
-				downloadedSize = start/1024.0;
-				if(stopTime - startTime > 0.01){
-					curSpeed			 = downloadedSize/(stopTime - startTime);
-				}
-				m_ErrorMsg.Format("<%s>:%s Have downloaded %.1lfKBytes data at %.1f KBytes/second. Duration is %d seconds. %.1lf percent is finished",
-					(LPCSTR)m_connectionID, (LPCSTR)timeTxt, downloadedSize, curSpeed, static_cast<int>(stopTime-startTime), 100.0*start/size);
-				if(nChunks == 0)
-					ShowMessage(m_ErrorMsg);
-				else
-					UpdateMessage(m_ErrorMsg);
+			start+=sendlen;
+			ShowDownloadProgress(start, size, startTime, nChunks);
+		}
+	}
+	return SUCCESS;
+}
 
-				m_avgDownloadSpeed += curSpeed;
-				++nChunks;
+RETURN_CODE CSerialControllerWithTx::GetFileData_Pipelined(unsigned char *mem, unsigned long size, unsigned long maxchunk, unsigned long &start, time_t startTime, int &nChunks)
+{
+	unsigned long chunkStart[PIPELINE_WINDOW];
+	unsigned short chunkLength[PIPELINE_WINDOW];
+	int failedWindows = 0;
+	int failedPipelinedWindows = 0;
+	int cleanWindows = 0;
+
+	if(m_chunkSize < MIN_CHUNK_SIZE || m_chunkSize > maxchunk)
+		m_chunkSize = maxchunk;
+
+	// throw away anything left from earlier commands. Between the windows the link is 
+	//	quiet when all the chunks have arrived, and is drained after a failed window
+	FlushSerialPort(100);
+
+	while(start < size)
+	{
+		// ask for a window of chunks at once, such that the link is kept busy
+		int chunkNum = 0;
+		for(unsigned long next = start; next < size && chunkNum < PIPELINE_WINDOW; ++chunkNum)
+		{
+			chunkStart[chunkNum]  = next;
+			chunkLength[chunkNum] = (unsigned short)min(m_chunkSize, size - next);
+			RequestChunk(chunkStart[chunkNum], chunkLength[chunkNum]);
+			next += chunkLength[chunkNum];
+		}
+
+		// receive the chunks in the order they were asked for. Each chunk is verified
+		//	while the chunks after it are still arriving over the link
+		int received = 0;
+		while(received < chunkNum && ReceiveChunk(mem, chunkStart[received], chunkLength[received]))
+		{
+			start += chunkLength[received];
+			ShowDownloadProgress(start, size, startTime, nChunks);
+			++received;
+		}
+
+		if(received == chunkNum)
+		{
+			if(chunkNum > 1)
+				m_pipelineConfirmed = true;
+
+			// use larger chunks on a clean link
+			if(++cleanWindows >= 2 && m_chunkSize < maxchunk)
+			{
+				m_chunkSize = min(2 * m_chunkSize, maxchunk);
+				cleanWindows = 0;
 			}
+			continue;
 		}
-	}
-	//---- end of the loop to download data -----// 
-	WriteSpectraFile(mem,size,filePath);
-	free(mem);
 
-	// Calculate the average download speed
-	m_avgDownloadSpeed /= nChunks;
+		// Something went wrong, the chunks which did arrive are kept and the rest are asked for again.
+		//	The replies to the requests still in flight are waited for and thrown away, such that 
+		//	they are not taken as the replies to the next window
+		unsigned long bytesInFlight = 0;
+		for(int k = received; k < chunkNum; ++k)
+			bytesInFlight += CHUNK_REPLY_OVERHEAD + chunkLength[k];
+		DiscardSerialData(bytesInFlight);
+
+		cleanWindows = 0;
+		++failedWindows;
+		if(chunkNum > 1)
+			++failedPipelinedWindows;
+
+		// Instruments with older firmware only handle one request at a time. If several requests 
+		//	have never succeeded with this instrument, and have failed repeatedly, then fall back to one at a time.
+		if(!m_pipelineConfirmed && failedPipelinedWindows >= PIPELINE_FAILURES_BEFORE_STOP_AND_WAIT)
+		{
+			m_pipelinedTransfer = false;
+			m_ErrorMsg.Format("Instrument does not handle several requests at a time, will download one chunk at a time");
+			ShowMessage(m_ErrorMsg, m_connectionID);
+			return FAIL;
+		}
 
-	// Remember the link-speed
-	m_linkStatistics.AppendDownloadSpeed(m_avgDownloadSpeed);
+		if(failedWindows == 5)
+			return FAIL;
+
+		// use smaller chunks on a noisy link
+		m_chunkSize = max(m_chunkSize / 2, MIN_CHUNK_SIZE);
+	}
 
 	return SUCCESS;
 }
+
+void CSerialControllerWithTx::DiscardSerialData(unsigned long maxBytes)
+{
+	unsigned char buffer[512];
+	while(maxBytes > 0)
+	{
+		const int length = (int)min(maxBytes, (unsigned long)sizeof(buffer));
+		const int read = GetSerialData(buffer, length, m_timeout);
+		if(read < length)
+			return; // nothing more arrived within the timeout
+		maxBytes -= read;
+	}
+}
+
+void CSerialControllerWithTx::RequestChunk(unsigned long start, unsigned short length)
+{
+	SendCommand(TX_GET);
+	if(!WriteSerial(&start,4))
+		ShowMessage("Serial communication may be broken, please check");
+	if(!WriteSerial(&length,2))
+		ShowMessage("Serial communication may be broken, please check");
+}
+
+bool CSerialControllerWithTx::ReceiveChunk(unsigned char *mem, unsigned long start, unsigned short length)
+{
+	unsigned long rstart = 0;
+	unsigned short rlen = 0, chksum1 = 0, chksum2;
+	long tmp;
+
+	// check remote PC's reply
+	if(GetSerialData(&rstart,4,m_timeout)!=4) 
+	{
+		ShowMessage("No rstart"); 
+		return false;
+	}
+	if(GetSerialData(&rlen,2,m_timeout)!=2) 
+	{
+		ShowMessage("No rlen"); 
+		return false;
+	}
+	if(start!=rstart)
+	{
+		m_ErrorMsg.Format("Start does not match requested %d!= %d",start,rstart);
+		ShowMessage(m_ErrorMsg);
+		return false;
+	}
+	if(rlen!=length)
+	{ 
+		m_ErrorMsg.Format("Length does not match requested %d!= %d",rlen,length);
+		ShowMessage(m_ErrorMsg);
+		return false;
+	}
+
+	tmp=GetSerialData(&mem[start],length,m_timeout);
+	if(tmp!=length)
+	{
+		m_ErrorMsg.Format("get data size %d", tmp);
+		ShowMessage(m_ErrorMsg);
+		return false;
+	}
+	if(GetSerialData(&chksum1,2,m_timeout)!=2)
+	{ 
+		ShowMessage("No checksum"); 
+		return false;
+	}
+
+	m_ErrorMsg.Format("start=%d len=%d ",rstart,rlen);
+	UpdateMessage(m_ErrorMsg);
+
+	// compare checksum to check data validity
+	chksum2=CalcChecksum(length,&mem[start]);
+	if(chksum1!=chksum2)
+	{ 
+		m_ErrorMsg.Format("Checksum not correct 0x%0x!=0x%0x",chksum1,chksum2);
+		ShowMessage(m_ErrorMsg);
+		return false;
+	}
+	return true;
+}
+
+void CSerialControllerWithTx::ShowDownloadProgress(unsigned long downloaded, unsigned long size, time_t startTime, int &nChunks)
+{
+	time_t stopTime;
+	CString timeTxt;
+	double curSpeed = 0.0;
+
+	time(&stopTime);
+	
+	m_common.GetDateTimeText(timeTxt);
+	double downloadedSize = downloaded/1024.0;
+	if(stopTime - startTime > 0.01){
+		curSpeed			 = downloadedSize/(stopTime - startTime);
+	}
+	m_ErrorMsg.Format("<%s>:%s Have downloaded %.1lfKBytes data at %.1f KBytes/second. Duration is %d seconds. %.1lf percent is finished",
+		(LPCSTR)m_connectionID, (LPCSTR)timeTxt, downloadedSize, curSpeed, static_cast<int>(stopTime-startTime), 100.0*downloaded/size);
+	if(nChunks == 0)
+		ShowMessage(m_ErrorMsg);
+	else
+		UpdateMessage(m_ErrorMsg);
+
+	m_avgDownloadSpeed += curSpeed;
+	++nChunks;
+}
+
 // Write the received data into a file
 
 RETURN_CODE CSerialControllerWithTx::WriteSpectraFile(BYTE* mem, long fileSize,CString filePath)
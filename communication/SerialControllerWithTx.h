@@ -320,8 +320,66 @@ namespace Communication
 
 		/** The statistics for this link */
 		CLinkStatistics	m_linkStatistics;
+
+		/** True if GetFile should keep several requests for chunks of the file in flight at the same time,
+			instead of waiting for each chunk to arrive before asking for the next one. 
+			This is taken from the 'pipelinedDownload' communication setting of the instrument.
+			It is set to false if it turns out that the instrument cannot handle this, the
+			files are then downloaded one chunk at a time. */
+		bool m_pipelinedTransfer = false;
 		
 	private:
+
+		/** The number of requests for chunks of the file kept in flight at the same time by GetFile */
+		static const int PIPELINE_WINDOW = 4;
+
+		/** The smallest size of the chunks asked for by GetFile */
+		static const unsigned long MIN_CHUNK_SIZE = 512;
+
+		/** The number of bytes in the reply to a request for a chunk, in addition to the data: 
+			the start (4 bytes), the length (2 bytes) and the checksum (2 bytes) */
+		static const unsigned long CHUNK_REPLY_OVERHEAD = 8;
+
+		/** The number of failed windows of several requests, before it is decided that the instrument
+			cannot handle several requests at a time. Not used once several requests have succeeded. */
+		static const int PIPELINE_FAILURES_BEFORE_STOP_AND_WAIT = 3;
+
+		/** The size of the chunks asked for when several requests are in flight. This is 
+			increased when the link is good and decreased when there are errors. */
+		unsigned long m_chunkSize = 0;
+
+		/** True when several requests in flight have succeeded with this instrument */
+		bool m_pipelineConfirmed = false;
+
+		/** Downloads the data of a file, asking for one chunk at a time and waiting for each 
+			chunk to arrive before asking for the next one. 
+			@param mem - will be filled with the data of the file
+			@param start - the position in the file to start at, updated as the data arrives
+			@return SUCCESS if all the data has been downloaded */
+		RETURN_CODE GetFileData_StopAndWait(unsigned char *mem, unsigned long size, unsigned long maxchunk, unsigned long &start, time_t startTime, int &nChunks);
+
+		/** Downloads the data of a file, keeping PIPELINE_WINDOW requests for chunks in flight 
+			at the same time. If the instrument turns out not to handle this, then 
+			m_pipelinedTransfer is set to false and FAIL is returned. 
+			@param mem - will be filled with the data of the file
+			@param start - the position in the file to start at, updated as the data arrives
+			@return SUCCESS if all the data has been downloaded */
+		RETURN_CODE GetFileData_Pipelined(unsigned char *mem, unsigned long size, unsigned long maxchunk, unsigned long &start, time_t startTime, int &nChunks);
+
+		/** Reads and throws away at most 'maxBytes' bytes from the serial port,
+			stopping when nothing has arrived for m_timeout milliseconds */
+		void DiscardSerialData(unsigned long maxBytes);
+
+		/** Asks the remote PC for one chunk of the file being downloaded */
+		void RequestChunk(unsigned long start, unsigned short length);
+
+		/** Receives one chunk of the file being downloaded, which has been asked for 
+			using RequestChunk, and verifies its checksum.
+			@return true if the chunk has been received correctly */
+		bool ReceiveChunk(unsigned char *mem, unsigned long start, unsigned short length);
+
+		/** Tells the user how the download proceeds */
+		void ShowDownloadProgress(unsigned long downloaded, unsigned long size, time_t startTime, int &nChunks);
 	
 		/** This function tries to download cfg.txt from this instrument. 
 				The cfg.txt file can be used to assess e.g. the motorstepscomp